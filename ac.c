@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <math.h>
+#include "ac.h"
+
+// ============================================
+// Helpers
+// ============================================
+
+// RC has no L, RL has no C, and a probe must name a component that exists
+int ac_probe_valid(int type, AcProbe probe) {
+    if (probe == AC_PROBE_R) return 1;
+    if (probe == AC_PROBE_C) return type != RLC_TYPE_RL;
+    if (probe == AC_PROBE_L) return type != RLC_TYPE_RC;
+    return 0;
+}
+
+const char *ac_probe_name(AcProbe probe) {
+    return probe == AC_PROBE_C ? "Vc" : probe == AC_PROBE_L ? "Vl" : "Vr";
+}
+
+// Centres the sweep on the corner (RC, RL) or resonant (LC, RLC) frequency
+void ac_auto_range(const RlcCircuit *ckt, double *f_lo, double *f_hi) {
+    double fc;
+    if (ckt->type == RLC_TYPE_RC) fc = 1.0 / (2 * M_PI * ckt->r * ckt->c);
+    else if (ckt->type == RLC_TYPE_RL) fc = ckt->r / (2 * M_PI * ckt->l);
+    else fc = 1.0 / (2 * M_PI * sqrt(ckt->l * ckt->c));
+    double span = pow(10, AC_DEFAULT_DECADES);
+    *f_lo = fc / span;
+    *f_hi = fc * span;
+}
+
+int ac_sweep_alloc(AcSweep *sw, int n) {
+    sw->n = n;
+    sw->f = malloc((size_t)n * sizeof(double));
+    sw->re = malloc((size_t)n * sizeof(double));
+    sw->im = malloc((size_t)n * sizeof(double));
+    sw->mag_db = malloc((size_t)n * sizeof(double));
+    sw->phase_deg = malloc((size_t)n * sizeof(double));
+    if (!sw->f || !sw->re || !sw->im || !sw->mag_db || !sw->phase_deg) { ac_sweep_free(sw); return -1; }
+    return 0;
+}
+
+void ac_sweep_free(AcSweep *sw) {
+    free(sw->f); free(sw->re); free(sw->im); free(sw->mag_db); free(sw->phase_deg);
+    sw->f = sw->re = sw->im = sw->mag_db = sw->phase_deg = NULL;
+    sw->n = 0;
+}
+
+// ============================================
+// Kernels
+// ============================================
+
+// f[i] = f_lo * ratio^i, restarted from an exact pow() every block so rounding cannot drift
+static void log_space(double f_lo, double f_hi, int n, double *f) {
+    double lr = (n > 1) ? log(f_hi / f_lo) / (n - 1) : 0, ratio = exp(lr);
+    for (int base = 0; base < n; base += 256) {
+        double x = f_lo * exp(lr * base);
+        int end = base + 256 < n ? base + 256 : n;
+        for (int i = base; i < end; i++) { f[i] = x; x *= ratio; }
+    }
+    f[n - 1] = f_hi;
+}
+
+/**
+ * @brief H(jw) for every frequency, with no branches or libm calls in the loop.
+ *
+ * Z_loop = R + jX, X = w*L - 1/(w*C) (absent parts contribute 0), and the probe impedance is
+ * pr + j*pi(w) with pi = gl*w*L - gc/(w*C). Then H = (pr + j pi)(R - jX) / (R^2 + X^2).
+ * The loop runs over plain double arrays so the compiler can vectorise it.
+ */
+static void ac_kernel(double r, double l, double c_inv, double pr, double gl, double gc,
+                      const double *restrict f, double *restrict re, double *restrict im, int n) {
+    const double two_pi = 2 * M_PI;
+    for (int i = 0; i < n; i++) {
+        double w = two_pi * f[i], w_inv = 1.0 / w;
+        double x = w * l - c_inv * w_inv;
+        double pi = gl * w * l - gc * c_inv * w_inv;
+        double d_inv = 1.0 / (r * r + x * x);
+        re[i] = (pr * r + pi * x) * d_inv;
+        im[i] = (pi * r - pr * x) * d_inv;
+    }
+}
+
+// Magnitude in dB and phase in degrees, unwrapped so it is continuous across +-180
+static void ac_mag_phase(const double *re, const double *im, int n, double *mag_db, double *phase_deg) {
+    for (int i = 0; i < n; i++) mag_db[i] = 10.0 * log10(re[i] * re[i] + im[i] * im[i]);
+    double offset = 0, prev = 0;
+    for (int i = 0; i < n; i++) {
+        double p = atan2(im[i], re[i]) * (180.0 / M_PI);
+        if (i > 0) {
+            if (p + offset - prev > 180) offset -= 360;
+            else if (p + offset - prev < -180) offset += 360;
+        }
+        phase_deg[i] = prev = p + offset;
+    }
+}
+
+// ============================================
+// Public API
+// ============================================
+
+/**
+ * @brief Log-spaced sweep of sw->n points from f_lo to f_hi (buffers from ac_sweep_alloc).
+ * @return 0 on success, -1 on bad parameters.
+ */
+int ac_run(const RlcCircuit *ckt, AcProbe probe, double f_lo, double f_hi, AcSweep *sw) {
+    if (sw->n < 2 || !(f_lo > 0) || !(f_hi > f_lo)) return -1;
+    if (ckt->type < RLC_TYPE_RC || ckt->type > RLC_TYPE_RLC || !ac_probe_valid(ckt->type, probe)) return -1;
+
+    double l = (ckt->type == RLC_TYPE_RC) ? 0 : ckt->l;
+    double c_inv = (ckt->type == RLC_TYPE_RL) ? 0 : 1.0 / ckt->c;
+    double pr = (probe == AC_PROBE_R) ? ckt->r : 0;
+    double gl = (probe == AC_PROBE_L), gc = (probe == AC_PROBE_C);
+
+    log_space(f_lo, f_hi, sw->n, sw->f);
+    ac_kernel(ckt->r, l, c_inv, pr, gl, gc, sw->f, sw->re, sw->im, sw->n);
+    ac_mag_phase(sw->re, sw->im, sw->n, sw->mag_db, sw->phase_deg);
+    return 0;
+}
+
+// Frequency where mag crosses level between points i and i + 1 (interpolated in log f)
+static double cross_freq(const AcSweep *sw, int i, double level) {
+    double a = sw->mag_db[i], b = sw->mag_db[i + 1];
+    double frac = (b != a) ? (level - a) / (b - a) : 0;
+    return sw->f[i] * pow(sw->f[i + 1] / sw->f[i], frac);
+}
+
+/**
+ * @brief Peak, -3 dB points relative to the peak, bandwidth and Q of a finished sweep.
+ *        For a low-pass response the peak is at the low end and only f_hi3 exists.
+ */
+void ac_summarize(const AcSweep *sw, AcSummary *sum) {
+    int n = sw->n, k = 0;
+    for (int i = 1; i < n; i++) if (sw->mag_db[i] > sw->mag_db[k]) k = i;
+    sum->f_peak = sw->f[k];
+    sum->peak_db = sw->mag_db[k];
+    sum->resonant = k > 0 && k < n - 1;
+
+    double level = sum->peak_db - 3.0103;   // half power
+    sum->f_lo3 = sum->f_hi3 = -1;
+    for (int i = k - 1; i >= 0; i--) {
+        if (sw->mag_db[i] < level) { sum->f_lo3 = cross_freq(sw, i, level); break; }
+    }
+    for (int i = k; i < n - 1; i++) {
+        if (sw->mag_db[i + 1] < level) { sum->f_hi3 = cross_freq(sw, i, level); break; }
+    }
+    sum->bandwidth = (sum->f_lo3 > 0 && sum->f_hi3 > 0) ? sum->f_hi3 - sum->f_lo3 : -1;
+    sum->q = (sum->resonant && sum->bandwidth > 0) ? sum->f_peak / sum->bandwidth : -1;
+}
@@ -0,0 +1,41 @@
+#ifndef AC_H
+#define AC_H
+
+// ============================================
+// AC small-signal analysis (Bode sweep) of the series RC / RL / LC / RLC loop
+// ============================================
+
+#include "rlc.h"
+
+#define AC_DEFAULT_POINTS 100000
+#define AC_MAX_POINTS 10000000
+#define AC_DEFAULT_DECADES 3     // auto range: this many decades either side of the corner
+
+// Which component voltage is the output: H(jw) = Z_probe / Z_loop
+typedef enum { AC_PROBE_C = 1, AC_PROBE_R, AC_PROBE_L } AcProbe;
+
+// Structure-of-arrays sweep buffers, all of length n
+typedef struct {
+    int n;
+    double *f;              // Hz, log spaced
+    double *re, *im;        // H(j 2 pi f)
+    double *mag_db, *phase_deg;
+} AcSweep;
+
+typedef struct {
+    double f_peak, peak_db; // largest |H|
+    int resonant;           // the peak lies inside the sweep (not at an end)
+    double f_lo3, f_hi3;    // -3 dB (from the peak) crossings either side of it, -1 if none
+    double bandwidth;       // f_hi3 - f_lo3 when both exist, else -1
+    double q;               // f_peak / bandwidth when resonant with both crossings, else -1
+} AcSummary;
+
+int ac_probe_valid(int type, AcProbe probe);
+const char *ac_probe_name(AcProbe probe);
+void ac_auto_range(const RlcCircuit *ckt, double *f_lo, double *f_hi);
+int ac_sweep_alloc(AcSweep *sw, int n);
+void ac_sweep_free(AcSweep *sw);
+int ac_run(const RlcCircuit *ckt, AcProbe probe, double f_lo, double f_hi, AcSweep *sw);
+void ac_summarize(const AcSweep *sw, AcSummary *sum);
+
+#endif
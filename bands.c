@@ -0,0 +1,263 @@
+#include <string.h>
+#include <math.h>
+#include "bands.h"
+
+#define NONE 127
+
+typedef struct {
+    const char *name, *abbrev;
+    unsigned char name_len;
+    signed char digit, mult;    // NONE if the colour cannot be that band
+    double tol_pct;             // 0 = not a tolerance colour
+    short tempco_ppm;           // 0 = not a tempco colour
+} BandInfo;
+
+static const BandInfo INFO[BAND_COLOURS] = {
+    [BAND_BLACK]  = { "Black",  "Blk", 5, 0, 0, 0, 250 },
+    [BAND_BROWN]  = { "Brown",  "Brn", 5, 1, 1, 1, 100 },
+    [BAND_RED]    = { "Red",    "Red", 3, 2, 2, 2, 50 },
+    [BAND_ORANGE] = { "Orange", "Org", 6, 3, 3, 0.05, 15 },
+    [BAND_YELLOW] = { "Yellow", "Yel", 6, 4, 4, 0.02, 25 },
+    [BAND_GREEN]  = { "Green",  "Grn", 5, 5, 5, 0.5, 20 },
+    [BAND_BLUE]   = { "Blue",   "Blu", 4, 6, 6, 0.25, 10 },
+    [BAND_VIOLET] = { "Violet", "Vio", 6, 7, 7, 0.1, 5 },
+    [BAND_GREY]   = { "Grey",   "Gry", 4, 8, 8, 0.01, 1 },
+    [BAND_WHITE]  = { "White",  "Wht", 5, 9, 9, 0, 0 },
+    [BAND_GOLD]   = { "Gold",   "Gld", 4, NONE, -1, 5, 0 },
+    [BAND_SILVER] = { "Silver", "Slv", 6, NONE, -2, 10, 0 },
+    [BAND_PINK]   = { "Pink",   "Pnk", 4, NONE, -3, 0, 0 },
+};
+
+// Multiplier exponent -> colour
+static const unsigned char MULT_COLOUR[BANDS_MULT_MAX - BANDS_MULT_MIN + 1] = {
+    BAND_PINK, BAND_SILVER, BAND_GOLD, BAND_BLACK, BAND_BROWN, BAND_RED, BAND_ORANGE,
+    BAND_YELLOW, BAND_GREEN, BAND_BLUE, BAND_VIOLET, BAND_GREY, BAND_WHITE
+};
+
+static const double POW10[16] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+// Accepted spellings, lower case. Every spelling has its own (first letter, last letter,
+// length) key apart from grey/gray, so a name is found with one table load and checked
+// against at most four words.
+static const char *ALIASES[BAND_COLOURS][4] = {
+    [BAND_BLACK]  = { "black", "blk" },
+    [BAND_BROWN]  = { "brown", "brn" },
+    [BAND_RED]    = { "red" },
+    [BAND_ORANGE] = { "orange", "org", "orn" },
+    [BAND_YELLOW] = { "yellow", "yel" },
+    [BAND_GREEN]  = { "green", "grn" },
+    [BAND_BLUE]   = { "blue", "blu" },
+    [BAND_VIOLET] = { "violet", "vio", "vlt", "purple" },
+    [BAND_GREY]   = { "grey", "gray", "gry" },
+    [BAND_WHITE]  = { "white", "wht" },
+    [BAND_GOLD]   = { "gold", "gld" },
+    [BAND_SILVER] = { "silver", "slv", "sil" },
+    [BAND_PINK]   = { "pink", "pnk" },
+};
+
+#define KEY(f, l, n) ((((f) - 'a') * 26 + ((l) - 'a')) * 8 + (n))
+
+// Colour + 1 by key (0 = no colour)
+static const unsigned char BY_KEY[26 * 26 * 8] = {
+    [KEY('b', 'k', 5)] = BAND_BLACK + 1,  [KEY('b', 'k', 3)] = BAND_BLACK + 1,
+    [KEY('b', 'n', 5)] = BAND_BROWN + 1,  [KEY('b', 'n', 3)] = BAND_BROWN + 1,
+    [KEY('r', 'd', 3)] = BAND_RED + 1,
+    [KEY('o', 'e', 6)] = BAND_ORANGE + 1, [KEY('o', 'g', 3)] = BAND_ORANGE + 1,
+    [KEY('o', 'n', 3)] = BAND_ORANGE + 1,
+    [KEY('y', 'w', 6)] = BAND_YELLOW + 1, [KEY('y', 'l', 3)] = BAND_YELLOW + 1,
+    [KEY('g', 'n', 5)] = BAND_GREEN + 1,  [KEY('g', 'n', 3)] = BAND_GREEN + 1,
+    [KEY('b', 'e', 4)] = BAND_BLUE + 1,   [KEY('b', 'u', 3)] = BAND_BLUE + 1,
+    [KEY('v', 't', 6)] = BAND_VIOLET + 1, [KEY('v', 'o', 3)] = BAND_VIOLET + 1,
+    [KEY('v', 't', 3)] = BAND_VIOLET + 1, [KEY('p', 'e', 6)] = BAND_VIOLET + 1,
+    [KEY('g', 'y', 4)] = BAND_GREY + 1,   [KEY('g', 'y', 3)] = BAND_GREY + 1,
+    [KEY('w', 'e', 5)] = BAND_WHITE + 1,  [KEY('w', 't', 3)] = BAND_WHITE + 1,
+    [KEY('g', 'd', 4)] = BAND_GOLD + 1,   [KEY('g', 'd', 3)] = BAND_GOLD + 1,
+    [KEY('s', 'r', 6)] = BAND_SILVER + 1, [KEY('s', 'v', 3)] = BAND_SILVER + 1,
+    [KEY('s', 'l', 3)] = BAND_SILVER + 1,
+    [KEY('p', 'k', 4)] = BAND_PINK + 1,   [KEY('p', 'k', 3)] = BAND_PINK + 1,
+};
+
+static const char *ERRORS[] = {
+    "ok", "value outside the colour-code range", "no band for that tolerance",
+    "no band for that tempco", "unknown colour", "a code has 3 to 6 bands",
+    "colour not allowed in that band"
+};
+
+const char *band_name(int colour) {
+    return colour >= 0 && colour < BAND_COLOURS ? INFO[colour].name : "?";
+}
+
+const char *band_abbrev(int colour) {
+    return colour >= 0 && colour < BAND_COLOURS ? INFO[colour].abbrev : "?";
+}
+
+const char *bands_strerror(int rc) {
+    return rc <= 0 && rc >= BANDS_ERR_POSITION ? ERRORS[-rc] : "?";
+}
+
+static int lower_alpha(char c) {
+    c = (char)(c | 0x20);
+    return c >= 'a' && c <= 'z' ? c : 0;
+}
+
+/**
+ * @brief Colour from a name or abbreviation in any case: "Yellow", "yel", "GRY", "gray".
+ * @return BandColour, or -1 if unknown.
+ */
+int band_from_name(const char *s, size_t len) {
+    if (len < 3 || len > 7) return -1;
+    int f = lower_alpha(s[0]), l = lower_alpha(s[len - 1]);
+    if (!f || !l) return -1;
+    int c = BY_KEY[KEY(f, l, (int)len)] - 1;
+    if (c < 0) return -1;
+    for (int k = 0; k < 4 && ALIASES[c][k]; k++) {
+        const char *w = ALIASES[c][k];
+        size_t i = 0;
+        while (i < len && w[i] && lower_alpha(s[i]) == w[i]) i++;
+        if (i == len && w[i] == '\0') return c;
+    }
+    return -1;
+}
+
+// ============================================
+// Encode / decode
+// ============================================
+
+// x * 10^k for |k| <= 15, one correctly rounded operation
+static double scale10(double x, int k) {
+    return k >= 0 ? x * POW10[k] : x / POW10[-k];
+}
+
+/**
+ * @brief Colour code for a value, rounded to 2 significant digits (3/4 bands) or 3 (5/6 bands).
+ * @param tol_pct Tolerance band (ignored for 3 bands, which mean 20%).
+ * @param tempco_ppm Tempco band (6 bands only).
+ * @return BANDS_OK, or BANDS_ERR_COUNT / RANGE / TOL / TEMPCO.
+ */
+int bands_encode(double ohms, int n, double tol_pct, int tempco_ppm, BandCode *out) {
+    if (n < BANDS_MIN || n > BANDS_MAX) return BANDS_ERR_COUNT;
+    if (!(ohms > 0) || isinf(ohms)) return BANDS_ERR_RANGE;
+    int nd = n <= 4 ? 2 : 3;
+    long lo = nd == 2 ? 10 : 100, hi = lo * 10;
+    int m = (int)floor(log10(ohms)) - nd + 1;
+    if (m < BANDS_MULT_MIN - 1 || m > BANDS_MULT_MAX + 1) return BANDS_ERR_RANGE;
+    long d = lround(scale10(ohms, -m));
+    if (d < lo) {                   // log10 came out one high
+        m--;
+        d = lround(scale10(ohms, -m));
+    }
+    if (d >= hi) {                  // 99.6 -> 100: rounded up into one more digit
+        m++;
+        d = lround(scale10(ohms, -m));
+    }
+    if (m < BANDS_MULT_MIN || m > BANDS_MULT_MAX) return BANDS_ERR_RANGE;
+
+    int k = 0;
+    if (nd == 3) out->c[k++] = (unsigned char)(d / 100);
+    out->c[k++] = (unsigned char)(d / 10 % 10);
+    out->c[k++] = (unsigned char)(d % 10);
+    out->c[k++] = MULT_COLOUR[m - BANDS_MULT_MIN];
+    if (n >= 4) {
+        int t = 0;
+        while (t < BAND_COLOURS && !(INFO[t].tol_pct > 0 && fabs(INFO[t].tol_pct - tol_pct) < 1e-9)) t++;
+        if (t == BAND_COLOURS) return BANDS_ERR_TOL;
+        out->c[k++] = (unsigned char)t;
+    }
+    if (n == 6) {
+        int t = 0;
+        while (t < BAND_COLOURS && !(INFO[t].tempco_ppm > 0 && INFO[t].tempco_ppm == tempco_ppm)) t++;
+        if (t == BAND_COLOURS) return BANDS_ERR_TEMPCO;
+        out->c[k++] = (unsigned char)t;
+    }
+    out->n = n;
+    return BANDS_OK;
+}
+
+/**
+ * @brief Value, tolerance and tempco of a code.
+ * @return BANDS_OK, BANDS_ERR_COUNT, or BANDS_ERR_POSITION if a colour cannot sit in its band.
+ */
+int bands_decode(const BandCode *code, BandValue *out) {
+    int n = code->n;
+    if (n < BANDS_MIN || n > BANDS_MAX) return BANDS_ERR_COUNT;
+    int nd = n <= 4 ? 2 : 3;
+    long d = 0;
+    for (int k = 0; k < nd; k++) {
+        if (code->c[k] >= BAND_COLOURS || INFO[code->c[k]].digit == NONE) return BANDS_ERR_POSITION;
+        d = d * 10 + INFO[code->c[k]].digit;
+    }
+    const BandInfo *mult = code->c[nd] < BAND_COLOURS ? &INFO[code->c[nd]] : NULL;
+    if (!mult || mult->mult == NONE) return BANDS_ERR_POSITION;
+    double tol = 20;
+    int tempco = 0;
+    if (n >= 4) {
+        if (code->c[nd + 1] >= BAND_COLOURS || !(INFO[code->c[nd + 1]].tol_pct > 0)) return BANDS_ERR_POSITION;
+        tol = INFO[code->c[nd + 1]].tol_pct;
+    }
+    if (n == 6) {
+        if (code->c[5] >= BAND_COLOURS || INFO[code->c[5]].tempco_ppm == 0) return BANDS_ERR_POSITION;
+        tempco = INFO[code->c[5]].tempco_ppm;
+    }
+    out->ohms = scale10((double)d, mult->mult);
+    out->tol_pct = tol;
+    out->tempco_ppm = tempco;
+    return BANDS_OK;
+}
+
+// ============================================
+// Text
+// ============================================
+
+static int is_band_sep(char c) {
+    return c == '-' || c == ' ' || c == ',' || c == ';' || c == '/' || c == '_' || c == '|' ||
+           c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Reads a code like "Yel-Vio-Red-Gld" or "brown black black red brown" from s[0 .. len).
+ *        Bands are separated by any of "- ,;/_|" or tabs; names as for band_from_name().
+ * @return BANDS_OK, BANDS_ERR_COLOUR or BANDS_ERR_COUNT (only the colours are checked here;
+ *         bands_decode() checks their positions).
+ */
+int bands_parse(const char *s, size_t len, BandCode *out) {
+    const char *p = s, *end = s + len;
+    int n = 0;
+    for (;;) {
+        while (p < end && is_band_sep(*p)) p++;
+        if (p == end) break;
+        const char *w = p;
+        while (p < end && !is_band_sep(*p)) p++;
+        if (n >= BANDS_MAX) return BANDS_ERR_COUNT;
+        int c = band_from_name(w, (size_t)(p - w));
+        if (c < 0) return BANDS_ERR_COLOUR;
+        out->c[n++] = (unsigned char)c;
+    }
+    if (n < BANDS_MIN) return BANDS_ERR_COUNT;
+    out->n = n;
+    return BANDS_OK;
+}
+
+/**
+ * @brief Writes the code as "Yellow-Violet-Red-Gold", or "Yel-Vio-Red-Gld" when abbrev is set.
+ * @return Length written, or -1 if it does not fit in cap (buf set to "").
+ */
+int bands_format(const BandCode *code, int abbrev, char *buf, size_t cap) {
+    char tmp[BANDS_TEXT_LEN], *p = tmp;
+    for (int k = 0; k < code->n && k < BANDS_MAX; k++) {
+        int c = code->c[k] < BAND_COLOURS ? code->c[k] : BAND_BLACK;
+        size_t n = abbrev ? 3 : INFO[c].name_len;
+        if (k) *p++ = '-';
+        memcpy(p, abbrev ? INFO[c].abbrev : INFO[c].name, n);
+        p += n;
+    }
+    size_t n = (size_t)(p - tmp);
+    if (n + 1 > cap) {
+        if (cap) buf[0] = '\0';
+        return -1;
+    }
+    memcpy(buf, tmp, n);
+    buf[n] = '\0';
+    return (int)n;
+}
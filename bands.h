@@ -0,0 +1,61 @@
+#ifndef BANDS_H
+#define BANDS_H
+
+// ============================================
+// Resistor colour codes (IEC 60062), 3 to 6 bands
+// ============================================
+//   3 bands: digit digit multiplier               (20%, no tolerance band)
+//   4 bands: digit digit multiplier tolerance
+//   5 bands: digit digit digit multiplier tolerance
+//   6 bands: digit digit digit multiplier tolerance tempco
+// Multipliers run from Pink x0.001, Silver x0.01 and Gold x0.1 up to White x1G. Everything
+// is looked up in constant tables; nothing here allocates.
+
+#include <stddef.h>
+
+// Digit colours are their own digit value
+typedef enum {
+    BAND_BLACK = 0, BAND_BROWN, BAND_RED, BAND_ORANGE, BAND_YELLOW,
+    BAND_GREEN, BAND_BLUE, BAND_VIOLET, BAND_GREY, BAND_WHITE,
+    BAND_GOLD, BAND_SILVER, BAND_PINK,
+    BAND_COLOURS
+} BandColour;
+
+#define BANDS_MIN 3
+#define BANDS_MAX 6
+#define BANDS_MULT_MIN -3       // Pink
+#define BANDS_MULT_MAX 9        // White
+#define BANDS_TEXT_LEN 48       // longest full-name code plus NUL
+
+// Result codes (0 = OK)
+enum {
+    BANDS_OK = 0,
+    BANDS_ERR_RANGE = -1,     // value outside Pink x0.001 .. White x1G
+    BANDS_ERR_TOL = -2,       // no band for that tolerance
+    BANDS_ERR_TEMPCO = -3,    // no band for that temperature coefficient
+    BANDS_ERR_COLOUR = -4,    // unknown colour name
+    BANDS_ERR_COUNT = -5,     // not 3 .. 6 bands
+    BANDS_ERR_POSITION = -6   // colour cannot be used in that band (e.g. Gold as a digit)
+};
+
+typedef struct {
+    int n;                          // BANDS_MIN .. BANDS_MAX
+    unsigned char c[BANDS_MAX];     // BandColour per band, left to right
+} BandCode;
+
+typedef struct {
+    double ohms;
+    double tol_pct;     // 20 for 3 bands
+    int tempco_ppm;     // 6 bands only, otherwise 0
+} BandValue;
+
+const char *band_name(int colour);
+const char *band_abbrev(int colour);
+int band_from_name(const char *s, size_t len);
+const char *bands_strerror(int rc);
+int bands_encode(double ohms, int n, double tol_pct, int tempco_ppm, BandCode *out);
+int bands_decode(const BandCode *code, BandValue *out);
+int bands_parse(const char *s, size_t len, BandCode *out);
+int bands_format(const BandCode *code, int abbrev, char *buf, size_t cap);
+
+#endif
@@ -0,0 +1,1101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "batch.h"
+#include "circuits.h"
+#include "rlc.h"
+#include "sweep.h"
+#include "montecarlo.h"
+#include "opamp.h"
+#include "rnet.h"
+#include "wave.h"
+#include "rlcstream.h"
+#include "ac.h"
+#include "fft.h"
+#include "netlist.h"
+#include "bom.h"
+#include "prof.h"
+#include <time.h>
+#include <math.h>
+
+// ============================================
+// BATCH MODE
+// ============================================
+// One command per line, e.g.
+//     divider vin=12 r1=10k r2=4.7k
+//     rlc type=rlc vs=5 r=10 l=1m c=1u
+// Blank lines and lines starting with '#' are skipped.
+// Every command produces exactly one key=value output line on stdout:
+//     line=1 tool=divider vin=12 r1=10000 r2=4700 vout=3.83784
+//     line=2 tool=led error="missing parameter 'vf'"
+
+#define BATCH_MAX_ARGS 16
+
+typedef struct {
+    const char *key;
+    const char *val;
+    int used;
+} BatchArg;
+
+typedef struct {
+    BatchArg arg[BATCH_MAX_ARGS];
+    int n;
+    char err[96];
+    Session *session;   // session the commands run in (history tool reads it)
+    int flags;          // BATCH_NO_FILES, BATCH_ONE_THREAD
+} BatchArgs;
+
+typedef int (*batch_handler)(BatchArgs *args, char *out, int len);
+
+// ============================================
+// Argument helpers
+// ============================================
+
+static const char *arg_find(BatchArgs *args, const char *key) {
+    for (int i = 0; i < args->n; i++) {
+        if (strcmp(args->arg[i].key, key) == 0) {
+            args->arg[i].used = 1;
+            return args->arg[i].val;
+        }
+    }
+    return NULL;
+}
+
+// Returns 1 if present and valid, 0 if absent, -1 if malformed (err set)
+static int arg_eng(BatchArgs *args, const char *key, double *out) {
+    const char *s = arg_find(args, key);
+    if (!s) return 0;
+    if (parse_eng_value(s, out) != ENG_OK) {
+        snprintf(args->err, sizeof(args->err), "bad value for '%s'", key);
+        return -1;
+    }
+    return 1;
+}
+
+// Same as arg_eng() but a missing key is an error
+static int need_eng(BatchArgs *args, const char *key, double *out) {
+    int rc = arg_eng(args, key, out);
+    if (rc == 0) snprintf(args->err, sizeof(args->err), "missing parameter '%s'", key);
+    return rc == 1 ? 0 : -1;
+}
+
+static int need_digit(BatchArgs *args, const char *key, int max, int *out) {
+    double v;
+    if (need_eng(args, key, &v) != 0) return -1;
+    if (v < 0 || v > max || v != (int)v) {
+        snprintf(args->err, sizeof(args->err), "'%s' must be an integer 0-%d", key, max);
+        return -1;
+    }
+    *out = (int)v;
+    return 0;
+}
+
+// Optional file name: *out is NULL if absent. -1 (err set) if the caller allows no files.
+static int arg_path(BatchArgs *args, const char *key, const char **out) {
+    *out = arg_find(args, key);
+    if (*out && (args->flags & BATCH_NO_FILES)) {
+        snprintf(args->err, sizeof(args->err), "file parameter '%s' is not allowed here", key);
+        return -1;
+    }
+    return 0;
+}
+
+// Optional threads=0 .. BATCH_MAX_THREADS (def if absent); always 1 under BATCH_ONE_THREAD
+static int arg_threads(BatchArgs *args, int def, int *out) {
+    double v = def;
+    if (arg_eng(args, "threads", &v) < 0) return -1;
+    if (v < 0 || v > BATCH_MAX_THREADS || v != (int)v) {
+        snprintf(args->err, sizeof(args->err), "threads must be an integer 0-%d", BATCH_MAX_THREADS);
+        return -1;
+    }
+    *out = (args->flags & BATCH_ONE_THREAD) ? 1 : (int)v;
+    return 0;
+}
+
+// Optional series=E6..E192 (default E24)
+static int arg_series(BatchArgs *args, ESeries *out) {
+    const char *s = arg_find(args, "series");
+    *out = ESERIES_E24;
+    if (!s) return 0;
+    int k = eseries_from_name(s);
+    if (k < 0) {
+        snprintf(args->err, sizeof(args->err), "series must be one of E6, E12, E24, E48, E96, E192");
+        return -1;
+    }
+    *out = k;
+    return 0;
+}
+
+// ============================================
+// Tool handlers (write "key=value ..." results into out)
+// ============================================
+
+// bands=Yel-Vio-Red-Gld (3 to 6 bands), or the digits b1 b2 and mult (0-9) of a 4-band code
+static int batch_decode(BatchArgs *args, char *out, int len) {
+    BandCode code;
+    const char *b = arg_find(args, "bands");
+    if (b) {
+        int rc = bands_parse(b, strlen(b), &code);
+        if (rc != BANDS_OK) { snprintf(args->err, sizeof(args->err), "bad bands: %s", bands_strerror(rc)); return -1; }
+    } else {
+        int b1, b2, mult;
+        if (need_digit(args, "b1", 9, &b1) || need_digit(args, "b2", 9, &b2) ||
+            need_digit(args, "mult", 9, &mult)) return -1;
+        code = (BandCode){ 4, { b1, b2, mult, BAND_GOLD } };
+    }
+    BandValue val;
+    int rc = bands_decode(&code, &val);
+    if (rc != BANDS_OK) { snprintf(args->err, sizeof(args->err), "bad bands: %s", bands_strerror(rc)); return -1; }
+
+    char bands[BANDS_TEXT_LEN];
+    bands_format(&code, 0, bands, sizeof(bands));
+    int n = snprintf(out, len, "r=%.6g tol=%g%% bands=%s", val.ohms, val.tol_pct, bands);
+    if (val.tempco_ppm && n < len) snprintf(out + n, len - n, " tempco_ppm=%d", val.tempco_ppm);
+    return 0;
+}
+
+// Snaps r to the series (default E24) and codes it with the series tolerance; tempco= makes a
+// 6-band code. The result key is the series name, e.g. e24=4700.
+static int batch_encode(BatchArgs *args, char *out, int len) {
+    double r, tempco = 0;
+    ESeries series;
+    if (need_eng(args, "r", &r) || arg_series(args, &series)) return -1;
+    if (arg_eng(args, "tempco", &tempco) < 0) return -1;
+    if (r <= 0) { snprintf(args->err, sizeof(args->err), "resistance must be positive"); return -1; }
+
+    double r_std = eseries_nearest(series, r);
+    BandCode code;
+    int rc = tempco > 0 ? bands_encode(r_std, 6, eseries_tolerance_pct(series), (int)tempco, &code)
+                        : resistor_code(r_std, series, &code);
+    if (rc != BANDS_OK) { snprintf(args->err, sizeof(args->err), "%s", bands_strerror(rc)); return -1; }
+
+    char name[8], bands[BANDS_TEXT_LEN];
+    snprintf(name, sizeof(name), "%s", eseries_name(series));
+    name[0] = 'e';
+    bands_format(&code, 0, bands, sizeof(bands));
+    snprintf(out, len, "r=%.6g %s=%.6g tol=%g%% bands=%s", r, name, r_std, eseries_tolerance_pct(series), bands);
+    return 0;
+}
+
+// Shared by bom and bands: runs one file through the pipeline, err set on failure
+static int batch_bom_file(BatchArgs *args, int decode, ESeries series, BomStats *st, double *secs) {
+    const char *in_path, *out_path;
+    if (arg_path(args, "in", &in_path) || arg_path(args, "out", &out_path)) return -1;
+    if (!in_path) { snprintf(args->err, sizeof(args->err), "missing parameter 'in'"); return -1; }
+    if (!out_path) { snprintf(args->err, sizeof(args->err), "missing parameter 'out'"); return -1; }
+    int threads;
+    if (arg_threads(args, sweep_default_threads(), &threads)) return -1;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int rc = decode ? bom_decode_file(in_path, out_path, threads, st)
+                    : bom_normalise_file(in_path, out_path, series, threads, st);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    *secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    if (rc == BOM_ERR_INPUT) { snprintf(args->err, sizeof(args->err), "cannot read '%s'", in_path); return -1; }
+    if (rc == BOM_ERR_OUTPUT) { snprintf(args->err, sizeof(args->err), "cannot write '%s'", out_path); return -1; }
+    if (rc == BOM_ERR_MEMORY) { snprintf(args->err, sizeof(args->err), "out of memory"); return -1; }
+    return 0;
+}
+
+// Whole BOM file: every value snapped to the series with its colour code, into a CSV file
+static int batch_bom(BatchArgs *args, char *out, int len) {
+    ESeries series;
+    BomStats st;
+    double secs;
+    if (arg_series(args, &series) || batch_bom_file(args, 0, series, &st, &secs)) return -1;
+    snprintf(out, len, "series=%s lines=%ld ok=%ld no_value=%ld range=%ld max_dev_pct=%.4g secs=%.3f out=%s",
+             eseries_name(series), st.lines, st.ok, st.no_value, st.out_of_range, st.max_dev_pct,
+             secs, arg_find(args, "out"));
+    return 0;
+}
+
+// File of band strings (one code per line) decoded into a CSV file
+static int batch_bands(BatchArgs *args, char *out, int len) {
+    BomStats st;
+    double secs;
+    if (batch_bom_file(args, 1, ESERIES_E24, &st, &secs)) return -1;
+    snprintf(out, len, "lines=%ld ok=%ld invalid=%ld secs=%.3f out=%s",
+             st.lines, st.ok, st.invalid, secs, arg_find(args, "out"));
+    return 0;
+}
+
+// Solves for whichever of v, i, r is missing (R is snapped to the series as in the menu)
+static int batch_ohm(BatchArgs *args, char *out, int len) {
+    double v = 0, i = 0, r = 0;
+    ESeries series;
+    if (arg_series(args, &series)) return -1;
+    int hv = arg_eng(args, "v", &v), hi = arg_eng(args, "i", &i), hr = arg_eng(args, "r", &r);
+    if (hv < 0 || hi < 0 || hr < 0) return -1;
+
+    if (!hv && hi && hr) {
+        r = eseries_nearest(series, r);
+        snprintf(out, len, "i=%.6g r=%.6g v=%.6g", i, r, i * r);
+    } else if (hv && !hi && hr) {
+        r = eseries_nearest(series, r);
+        snprintf(out, len, "v=%.6g r=%.6g i=%.6g", v, r, v / r);
+    } else if (hv && hi && !hr) {
+        if (i == 0) { snprintf(args->err, sizeof(args->err), "current cannot be zero"); return -1; }
+        snprintf(out, len, "v=%.6g i=%.6g r=%.6g", v, i, v / i);
+    } else {
+        snprintf(args->err, sizeof(args->err), "give exactly two of v, i, r");
+        return -1;
+    }
+    return 0;
+}
+
+static int batch_power(BatchArgs *args, char *out, int len) {
+    double v, i;
+    if (need_eng(args, "v", &v) || need_eng(args, "i", &i)) return -1;
+    snprintf(out, len, "v=%.6g i=%.6g p=%.6g", v, i, v * i);
+    return 0;
+}
+
+static int batch_divider(BatchArgs *args, char *out, int len) {
+    double vin, r1, r2;
+    ESeries series;
+    if (need_eng(args, "vin", &vin) || need_eng(args, "r1", &r1) || need_eng(args, "r2", &r2)) return -1;
+    if (arg_series(args, &series)) return -1;
+    r1 = eseries_nearest(series, r1);
+    r2 = eseries_nearest(series, r2);
+    snprintf(out, len, "vin=%.6g r1=%.6g r2=%.6g vout=%.6g", vin, r1, r2, divider_vout(vin, r1, r2));
+    return 0;
+}
+
+static const char *RLC_TYPE_NAMES[] = { "", "rc", "rl", "lc", "rlc" };
+
+// type=rc|rl|lc|rlc plus the components it has (r snapped to the series); vs only if need_vs
+static int arg_circuit(BatchArgs *args, RlcCircuit *ckt, int need_vs) {
+    *ckt = (RlcCircuit){ 0, 1.0, 0, 0, 0 };
+    const char *t = arg_find(args, "type");
+    if (!t) { snprintf(args->err, sizeof(args->err), "missing parameter 'type'"); return -1; }
+    for (int k = RLC_TYPE_RC; k <= RLC_TYPE_RLC; k++) {
+        if (strcmp(t, RLC_TYPE_NAMES[k]) == 0 || (t[0] == '0' + k && t[1] == '\0')) ckt->type = k;
+    }
+    if (!ckt->type) { snprintf(args->err, sizeof(args->err), "type must be rc, rl, lc or rlc"); return -1; }
+
+    if (need_vs && need_eng(args, "vs", &ckt->vs)) return -1;
+    if (ckt->type != RLC_TYPE_LC) {
+        ESeries series;
+        if (need_eng(args, "r", &ckt->r) || arg_series(args, &series)) return -1;
+        ckt->r = eseries_nearest(series, ckt->r);
+    }
+    if (ckt->type != RLC_TYPE_RC && need_eng(args, "l", &ckt->l)) return -1;
+    if (ckt->type != RLC_TYPE_RL && need_eng(args, "c", &ckt->c)) return -1;
+    rlc_apply_safety(ckt);
+    return 0;
+}
+
+static int batch_rlc(BatchArgs *args, char *out, int len) {
+    RlcCircuit ckt;
+    if (arg_circuit(args, &ckt, 1)) return -1;
+
+    double t_total = rlc_auto_time(&ckt);
+    if (arg_eng(args, "t", &t_total) < 0) return -1;
+    if (!(t_total > 0) || isinf(t_total)) { snprintf(args->err, sizeof(args->err), "t must be > 0"); return -1; }
+
+    // method=euler (default), method=exact, method=rk45 with optional rtol/atol,
+    // or method=stream with optional steps (constant memory, waveform metrics)
+    static const char *METHOD_NAMES[] = { "euler", "rk45", "exact", "stream" };
+    int method = 0;
+    double rtol = RK45_DEFAULT_RTOL, atol = RK45_DEFAULT_ATOL;
+    const char *m = arg_find(args, "method");
+    if (m) {
+        if (strcmp(m, "rk45") == 0) method = 1;
+        else if (strcmp(m, "exact") == 0) method = 2;
+        else if (strcmp(m, "stream") == 0) method = 3;
+        else if (strcmp(m, "euler") != 0) {
+            snprintf(args->err, sizeof(args->err), "method must be euler, rk45, exact or stream");
+            return -1;
+        }
+    }
+    if (arg_eng(args, "rtol", &rtol) < 0 || arg_eng(args, "atol", &atol) < 0) return -1;
+    if (!rlc_rk45_tolerance_ok(rtol, atol)) {
+        snprintf(args->err, sizeof(args->err), "need atol > 0 and rtol >= %.3g", RK45_MIN_RTOL);
+        return -1;
+    }
+
+    if (method == 3) {
+        double steps = (double)RLC_STREAM_DEFAULT_STEPS;
+        if (arg_eng(args, "steps", &steps) < 0) return -1;
+        if (steps < 1 || steps > RLC_STREAM_MAX_STEPS) {
+            snprintf(args->err, sizeof(args->err), "steps must be 1 .. %lld", RLC_STREAM_MAX_STEPS);
+            return -1;
+        }
+        RlcMetrics mt;
+        if (rlc_stream(&ckt, t_total, (long long)steps, NULL, &mt) != 0) {
+            snprintf(args->err, sizeof(args->err), "invalid simulation parameters");
+            return -1;
+        }
+        snprintf(out, len, "type=%s method=stream t=%.6g steps=%lld max_vc=%.6g max_il=%.6g max_ec=%.6g max_el=%.6g "
+                 "final_energy=%.6g peak=%.6g t_peak=%.6g overshoot=%.6g rise=%.6g settle=%.6g zc=%lld fd=%.6g zeta=%.6g",
+                 RLC_TYPE_NAMES[ckt.type], t_total, (long long)steps, mt.stats.max_vc, mt.stats.max_il, mt.stats.max_ec,
+                 mt.stats.max_el, mt.stats.final_energy, mt.peak, mt.t_peak, mt.overshoot_pct, mt.t_rise,
+                 mt.t_settle, mt.current_crossings, mt.freq_est, mt.zeta_est);
+        return 0;
+    }
+
+    // samples=N stored samples (default SIM_STEPS); wave=<file.csv|file.bin> exports all of them
+    double samples = SIM_STEPS;
+    if (arg_eng(args, "samples", &samples) < 0) return -1;
+    if (samples < 1 || samples > SIM_MAX_STEPS) {
+        snprintf(args->err, sizeof(args->err), "samples must be 1 .. %d", SIM_MAX_STEPS);
+        return -1;
+    }
+    int steps = (int)samples;
+    const char *wave;
+    if (arg_path(args, "wave", &wave)) return -1;
+
+    RlcTrace trace = { NULL, NULL, NULL, NULL }, *tp = NULL;
+    double *buf = NULL;
+    if (wave) {
+        buf = malloc((size_t)steps * 4 * sizeof(double));
+        if (!buf) { snprintf(args->err, sizeof(args->err), "out of memory"); return -1; }
+        trace.vc = buf; trace.il = buf + steps; trace.ec = buf + 2 * (size_t)steps; trace.el = buf + 3 * (size_t)steps;
+        tp = &trace;
+    }
+
+    RlcStats stats;
+    long evals = (long)steps * SIM_SUBSTEPS;
+    int rc = 0;
+    if (method == 1) {
+        RlcSolverInfo info;
+        int rk = rlc_simulate_rk45(&ckt, t_total, steps, rtol, atol, tp, &stats, &info);
+        if (rk != RK45_OK) {
+            snprintf(args->err, sizeof(args->err), "%s", rlc_rk45_strerror(rk));
+            free(buf);
+            return -1;
+        }
+        evals = info.n_evals;
+    } else if (method == 2) {
+        rlc_simulate_analytic(&ckt, t_total, steps, tp, &stats);
+        evals = 0;
+    } else {
+        rlc_simulate_euler(&ckt, t_total, steps, tp, &stats);
+    }
+    int n = snprintf(out, len, "type=%s method=%s t=%.6g max_vc=%.6g max_il=%.6g max_ec=%.6g max_el=%.6g final_energy=%.6g evals=%ld",
+                     RLC_TYPE_NAMES[ckt.type], METHOD_NAMES[method], t_total, stats.max_vc, stats.max_il,
+                     stats.max_ec, stats.max_el, stats.final_energy, evals);
+    if (wave) {
+        // Only the traces that exist for this circuit type
+        if (ckt.type == RLC_TYPE_RL) trace.vc = trace.ec = NULL;
+        if (ckt.type == RLC_TYPE_RC) trace.el = NULL;
+        if (wave_export(wave, wave_format_from_path(wave), &ckt, METHOD_NAMES[method], t_total, steps, &trace) < 0) {
+            snprintf(args->err, sizeof(args->err), "cannot write '%.60s'", wave);
+            rc = -1;
+        } else if (n < len) {
+            snprintf(out + n, len - n, " samples=%d wave=\"%s\"", steps, wave);
+        }
+    }
+    free(buf);
+    return rc;
+}
+
+// AC sweep: probe=c|r|l (default c, or r for RL), fmin/fmax (default auto), points, wave=<file>
+static int batch_ac(BatchArgs *args, char *out, int len) {
+    RlcCircuit ckt;
+    if (arg_circuit(args, &ckt, 0)) return -1;
+
+    AcProbe probe = (ckt.type == RLC_TYPE_RL) ? AC_PROBE_R : AC_PROBE_C;
+    const char *p = arg_find(args, "probe");
+    if (p) {
+        probe = strcmp(p, "c") == 0 ? AC_PROBE_C : strcmp(p, "r") == 0 ? AC_PROBE_R : strcmp(p, "l") == 0 ? AC_PROBE_L : 0;
+        if (!ac_probe_valid(ckt.type, probe)) {
+            snprintf(args->err, sizeof(args->err), "probe must be c, r or l (and exist in the circuit)");
+            return -1;
+        }
+    }
+    double f_lo, f_hi, points = AC_DEFAULT_POINTS;
+    ac_auto_range(&ckt, &f_lo, &f_hi);
+    if (arg_eng(args, "fmin", &f_lo) < 0 || arg_eng(args, "fmax", &f_hi) < 0 || arg_eng(args, "points", &points) < 0) return -1;
+    if (points < 2 || points > AC_MAX_POINTS || !(f_lo > 0) || !(f_hi > f_lo)) {
+        snprintf(args->err, sizeof(args->err), "need 0 < fmin < fmax and points 2 .. %d", AC_MAX_POINTS);
+        return -1;
+    }
+    const char *wave;
+    if (arg_path(args, "wave", &wave)) return -1;
+
+    AcSweep sw;
+    if (ac_sweep_alloc(&sw, (int)points) != 0) { snprintf(args->err, sizeof(args->err), "out of memory"); return -1; }
+    ac_run(&ckt, probe, f_lo, f_hi, &sw);
+    AcSummary sum;
+    ac_summarize(&sw, &sum);
+    int n = snprintf(out, len, "type=%s probe=%s fmin=%.6g fmax=%.6g points=%d f_peak=%.6g peak_db=%.6g resonant=%d "
+                     "f_lo3=%.6g f_hi3=%.6g bw=%.6g q=%.6g",
+                     RLC_TYPE_NAMES[ckt.type], ac_probe_name(probe), f_lo, f_hi, sw.n, sum.f_peak, sum.peak_db,
+                     sum.resonant, sum.f_lo3, sum.f_hi3, sum.bandwidth, sum.q);
+
+    int rc = 0;
+    if (wave) {
+        WaveColumn cols[5] = { { "f", "Hz", sw.f }, { "mag", "dB", sw.mag_db }, { "phase", "deg", sw.phase_deg },
+                               { "re", "1", sw.re }, { "im", "1", sw.im } };
+        char meta[256];
+        snprintf(meta, sizeof(meta), "kind=ac\ntype=%s\nprobe=%s\nr=%.17g\nl=%.17g\nc=%.17g\n",
+                 RLC_TYPE_NAMES[ckt.type], ac_probe_name(probe), ckt.r, ckt.l, ckt.c);
+        if (wave_write(wave, wave_format_from_path(wave), cols, 5, sw.n, 0, meta) < 0) {
+            snprintf(args->err, sizeof(args->err), "cannot write '%.60s'", wave);
+            rc = -1;
+        } else if (n < len) {
+            snprintf(out + n, len - n, " wave=\"%s\"", wave);
+        }
+    }
+    ac_sweep_free(&sw);
+    return rc;
+}
+
+// Spectrum of a simulated transient: method (default exact), samples (default 64k), t,
+// signal=i|vc, window=rect|hann|hamming|blackman|flattop, peaks and harmonics (1 .. 8)
+#define BATCH_FFT_MAX_LIST 8
+static int batch_fft(BatchArgs *args, char *out, int len) {
+    static const char *WINDOW_NAMES[] = { "", "rect", "hann", "hamming", "blackman", "flattop" };
+    RlcCircuit ckt;
+    if (arg_circuit(args, &ckt, 1)) return -1;
+    double t_total = rlc_auto_time(&ckt), samples = 65536, n_peaks = 3, n_harm = 5;
+    if (arg_eng(args, "t", &t_total) < 0 || arg_eng(args, "samples", &samples) < 0 ||
+        arg_eng(args, "peaks", &n_peaks) < 0 || arg_eng(args, "harmonics", &n_harm) < 0) return -1;
+    if (samples < 16 || samples > SIM_MAX_STEPS || !(t_total > 0)) {
+        snprintf(args->err, sizeof(args->err), "need t > 0 and samples 16 .. %d", SIM_MAX_STEPS);
+        return -1;
+    }
+    if (n_peaks < 1 || n_peaks > BATCH_FFT_MAX_LIST || n_harm < 1 || n_harm > BATCH_FFT_MAX_LIST) {
+        snprintf(args->err, sizeof(args->err), "peaks and harmonics must be 1 .. %d", BATCH_FFT_MAX_LIST);
+        return -1;
+    }
+
+    const char *m = arg_find(args, "method"), *sig = arg_find(args, "signal"), *w = arg_find(args, "window");
+    int method = 3;   // same numbering as the menu
+    if (m) {
+        method = strcmp(m, "euler") == 0 ? 1 : strcmp(m, "rk45") == 0 ? 2 : strcmp(m, "exact") == 0 ? 3 : 0;
+        if (!method) { snprintf(args->err, sizeof(args->err), "method must be euler, rk45 or exact"); return -1; }
+    }
+    int use_vc = ckt.type != RLC_TYPE_RL;   // Vc where there is a capacitor, else I
+    if (sig) {
+        use_vc = strcmp(sig, "vc") == 0 ? 1 : strcmp(sig, "i") == 0 ? 0 : -1;
+        if (use_vc < 0 || (use_vc && ckt.type == RLC_TYPE_RL)) {
+            snprintf(args->err, sizeof(args->err), "signal must be i or vc (and exist in the circuit)");
+            return -1;
+        }
+    }
+    FftWindow win = FFT_WIN_HANN;
+    if (w) {
+        win = 0;
+        for (int k = FFT_WIN_RECT; k <= FFT_WIN_FLATTOP; k++) if (strcmp(w, WINDOW_NAMES[k]) == 0) win = k;
+        if (!win) { snprintf(args->err, sizeof(args->err), "window must be rect, hann, hamming, blackman or flattop"); return -1; }
+    }
+
+    int n = (int)samples, nb = n / 2 + 1;
+    double *buf = malloc(((size_t)n + nb) * sizeof(double));
+    if (!buf) { snprintf(args->err, sizeof(args->err), "out of memory"); return -1; }
+    double *x = buf, *amp = buf + n;
+    RlcTrace trace = { use_vc ? x : NULL, use_vc ? NULL : x, NULL, NULL };
+    RlcStats stats;
+    RlcSolverInfo info;
+    int rk = RK45_OK;
+    if (method == 1) rlc_simulate_euler(&ckt, t_total, n, &trace, &stats);
+    else if (method == 3) rlc_simulate_analytic(&ckt, t_total, n, &trace, &stats);
+    else rk = rlc_simulate_rk45(&ckt, t_total, n, RK45_DEFAULT_RTOL, RK45_DEFAULT_ATOL, &trace, &stats, &info);
+    if (rk != RK45_OK) {
+        snprintf(args->err, sizeof(args->err), "%s", rlc_rk45_strerror(rk));
+        free(buf);
+        return -1;
+    }
+    if (fft_amplitude_spectrum(x, n, win, amp) < 0) {
+        snprintf(args->err, sizeof(args->err), "fft failed");
+        free(buf);
+        return -1;
+    }
+
+    double df = 1.0 / t_total, thd = -1;
+    FftPeak peaks[BATCH_FFT_MAX_LIST], harm[BATCH_FFT_MAX_LIST];
+    int np = fft_peaks(amp, nb, df, fft_window_lobe_bins(win) + 1, peaks, (int)n_peaks), nh = 0;
+    if (np > 0) nh = fft_harmonics(amp, nb, df, peaks[0].freq, (int)n_harm, harm, &thd);
+    int pos = snprintf(out, len, "type=%s signal=%s window=%s samples=%d fs=%.6g df=%.6g npeaks=%d",
+                       RLC_TYPE_NAMES[ckt.type], use_vc ? "vc" : "i", WINDOW_NAMES[win], n, n / t_total, df, np);
+    for (int k = 0; k < np && pos < len; k++)
+        pos += snprintf(out + pos, len - pos, " f%d=%.6g a%d=%.6g", k + 1, peaks[k].freq, k + 1, peaks[k].amp);
+    for (int k = 0; k < nh && pos < len; k++)
+        pos += snprintf(out + pos, len - pos, "%s%.6g", k ? "," : " harm=", harm[k].amp);
+    if (pos < len) snprintf(out + pos, len - pos, " thd=%.6g", thd);
+    free(buf);
+    return 0;
+}
+
+// Netlist solve: file=<netlist>, probe=<node or element> (default: first node), analysis=op|dc|tran
+// (dc / tran as given by the netlist's directives), wave=<file> for the dc / tran points
+static int batch_netlist(BatchArgs *args, char *out, int len) {
+    const char *path, *wave, *probe_name = arg_find(args, "probe"), *analysis = arg_find(args, "analysis");
+    if (arg_path(args, "file", &path) || arg_path(args, "wave", &wave)) return -1;
+    if (!path) { snprintf(args->err, sizeof(args->err), "missing parameter 'file'"); return -1; }
+    int mode = 0;   // 0 op, 1 dc, 2 tran
+    if (analysis) {
+        mode = strcmp(analysis, "op") == 0 ? 0 : strcmp(analysis, "dc") == 0 ? 1 : strcmp(analysis, "tran") == 0 ? 2 : -1;
+        if (mode < 0) { snprintf(args->err, sizeof(args->err), "analysis must be op, dc or tran"); return -1; }
+    }
+
+    Netlist nl;
+    netlist_init(&nl);
+    int rc = netlist_load(&nl, path);
+    if (rc != NL_OK) {
+        snprintf(args->err, sizeof(args->err), "%s", rc == NL_ERR_MEMORY ? "out of memory" : nl.err);
+        netlist_free(&nl);
+        return -1;
+    }
+    if ((mode == 1 && !nl.dir.has_dc) || (mode == 2 && !nl.dir.has_tran)) {
+        snprintf(args->err, sizeof(args->err), "netlist has no .%s directive", mode == 1 ? "dc" : "tran");
+        netlist_free(&nl);
+        return -1;
+    }
+    int node = probe_name ? netlist_find_node(&nl, probe_name) : (nl.n_nodes > 1 ? 1 : -1);
+    int elem = (probe_name && node < 0) ? netlist_find_element(&nl, probe_name) : -1;
+    if (node < 0 && elem < 0) {
+        snprintf(args->err, sizeof(args->err), "no node or element '%.40s'", probe_name ? probe_name : "");
+        netlist_free(&nl);
+        return -1;
+    }
+    if (mode == 1 && node < 0) {
+        snprintf(args->err, sizeof(args->err), "dc probe must be a node");
+        netlist_free(&nl);
+        return -1;
+    }
+
+    MnaSystem sys;
+    if (mna_build(&sys, &nl) != NL_OK) { snprintf(args->err, sizeof(args->err), "out of memory"); netlist_free(&nl); return -1; }
+    double *x = malloc((size_t)sys.n * sizeof(double)), *v = NULL;
+    rc = x ? mna_op(&sys, x) : NL_ERR_MEMORY;
+    const char *qty = node >= 0 ? "v" : "i";
+    const char *pname = node >= 0 ? nl.node_names[node] : nl.el[elem].name;
+    int n = 0;
+    if (rc == NL_OK) {
+        n = snprintf(out, len, "file=%s nodes=%d elements=%d unknowns=%d nnz=%d lu_nnz=%d ",
+                     path, nl.n_nodes, nl.n_el, sys.n, sys.a.nnz, sys.lu.lnz + sys.lu.unz);
+    }
+    long points = 0;
+    double step = 0;
+    WaveColumn cols[2];
+    if (rc == NL_OK && mode == 0) {
+        snprintf(out + n, len - n, "%s(%s)=%.6g", qty, pname,
+                 node >= 0 ? mna_node_voltage(&sys, x, node) : mna_element_current(&sys, x, elem));
+    } else if (rc == NL_OK && mode == 1) {
+        int e = netlist_find_element(&nl, nl.dir.dc_elem);
+        points = nl.dir.dc_points;
+        v = (e >= 0) ? malloc((size_t)points * 2 * sizeof(double)) : NULL;
+        if (e < 0) { snprintf(args->err, sizeof(args->err), ".dc element '%s' not found", nl.dir.dc_elem); rc = NL_ERR_SYNTAX; }
+        else if (!v) rc = NL_ERR_MEMORY;
+        else rc = mna_dc_sweep(&sys, &nl, e, nl.dir.dc_start, nl.dir.dc_stop, (int)points, node, v);
+        if (rc == NL_OK) {
+            double lo = v[0], hi = v[0];
+            for (long k = 0; k < points; k++) {
+                v[points + k] = points > 1 ? nl.dir.dc_start + (nl.dir.dc_stop - nl.dir.dc_start) * k / (points - 1) : nl.dir.dc_start;
+                if (v[k] < lo) lo = v[k];
+                if (v[k] > hi) hi = v[k];
+            }
+            snprintf(out + n, len - n, "sweep=%s points=%ld v(%s)_first=%.6g v(%s)_last=%.6g min=%.6g max=%.6g refactors=%d",
+                     nl.el[e].name, points, pname, v[0], pname, v[points - 1], lo, hi, sys.n_refactor);
+            cols[0] = (WaveColumn){ nl.el[e].name, "1", v + points };
+            cols[1] = (WaveColumn){ "v", "V", v };
+        }
+    } else if (rc == NL_OK && mode == 2) {
+        step = nl.dir.tran_step;
+        long steps = lround(nl.dir.tran_stop / step);
+        if (wave) {
+            if (steps > SIM_MAX_STEPS) { snprintf(args->err, sizeof(args->err), "too many steps to export"); rc = NL_ERR_SYNTAX; }
+            else if (!(v = malloc(((size_t)steps + 1) * sizeof(double)))) rc = NL_ERR_MEMORY;
+        }
+        NlTranStats st;
+        long done = (rc == NL_OK) ? mna_tran(&sys, step, nl.dir.tran_stop, node, elem, v, &st) : 0;
+        if (done < 0) rc = (int)done;
+        if (rc == NL_OK) {
+            points = done + 1;
+            snprintf(out + n, len - n, "steps=%ld %s(%s)_final=%.6g min=%.6g max=%.6g factors=%d",
+                     done, qty, pname, st.final_value, st.min_value, st.max_value, sys.n_factor + sys.n_refactor);
+            cols[0] = (WaveColumn){ qty, node >= 0 ? "V" : "A", v };
+        }
+    }
+
+    if (rc == NL_OK && wave && mode > 0) {
+        char meta[128];
+        snprintf(meta, sizeof(meta), "kind=netlist_%s\nprobe=%s\n", mode == 1 ? "dc" : "tran", pname);
+        if (wave_write(wave, wave_format_from_path(wave), cols, mode == 1 ? 2 : 1, (int)points, mode == 2 ? step : 0, meta) < 0) {
+            snprintf(args->err, sizeof(args->err), "cannot write '%.60s'", wave);
+            rc = NL_ERR_IO;
+        } else {
+            size_t used = strlen(out);
+            snprintf(out + used, len - used, " wave=\"%s\"", wave);
+        }
+    }
+    if (rc == NL_ERR_SINGULAR) snprintf(args->err, sizeof(args->err), "singular matrix");
+    else if (rc == NL_ERR_MEMORY) snprintf(args->err, sizeof(args->err), "out of memory");
+    free(x); free(v);
+    mna_free(&sys);
+    netlist_free(&nl);
+    return rc == NL_OK ? 0 : -1;
+}
+
+// Parameter grid: axes use the sweep syntax (e.g. r=e24:10:1k c=10n:1u:20log)
+static int batch_sweep(BatchArgs *args, char *out, int len) {
+    static const char *METHOD_NAMES[] = { "", "euler", "rk45", "exact" };
+    static const char *AXIS_KEYS[] = { "vs", "r", "l", "c" };
+    SweepSpec spec;
+    memset(&spec, 0, sizeof(spec));
+    SweepAxis *axes[4] = { &spec.vs, &spec.r, &spec.l, &spec.c };
+    SweepPoint *pts = NULL;
+    int rc = -1;
+
+    const char *t = arg_find(args, "type");
+    for (int k = RLC_TYPE_RC; t && k <= RLC_TYPE_RLC; k++)
+        if (strcmp(t, RLC_TYPE_NAMES[k]) == 0) spec.type = k;
+    if (!spec.type) { snprintf(args->err, sizeof(args->err), "type must be rc, rl, lc or rlc"); return -1; }
+
+    spec.method = SWEEP_EULER;
+    const char *m = arg_find(args, "method");
+    if (m) {
+        spec.method = 0;
+        for (int k = SWEEP_EULER; k <= SWEEP_EXACT; k++)
+            if (strcmp(m, METHOD_NAMES[k]) == 0) spec.method = k;
+        if (!spec.method) { snprintf(args->err, sizeof(args->err), "method must be euler, rk45 or exact"); return -1; }
+    }
+
+    for (int a = 0; a < 4; a++) {
+        int needed = (a == 0) || (a == 1 && spec.type != RLC_TYPE_LC) ||
+                     (a == 2 && spec.type != RLC_TYPE_RC) || (a == 3 && spec.type != RLC_TYPE_RL);
+        if (!needed) continue;
+        const char *s = arg_find(args, AXIS_KEYS[a]);
+        if (!s) { snprintf(args->err, sizeof(args->err), "missing parameter '%s'", AXIS_KEYS[a]); goto done; }
+        if (sweep_parse_axis(s, axes[a]) != 0) {
+            snprintf(args->err, sizeof(args->err), "bad axis for '%s'", AXIS_KEYS[a]); goto done;
+        }
+    }
+    if (arg_eng(args, "t", &spec.t_total) < 0) goto done;
+
+    int threads;
+    if (arg_threads(args, sweep_default_threads(), &threads)) goto done;
+    const char *csv;
+    if (arg_path(args, "csv", &csv)) goto done;
+
+    long n = sweep_point_count(&spec);
+    if (n <= 0) { snprintf(args->err, sizeof(args->err), "grid exceeds %ld points", SWEEP_MAX_POINTS); goto done; }
+    pts = malloc(n * sizeof(SweepPoint));
+    if (!pts) { snprintf(args->err, sizeof(args->err), "out of memory"); goto done; }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (sweep_run(&spec, threads, pts) != 0) { snprintf(args->err, sizeof(args->err), "sweep failed"); goto done; }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double il_lo = pts[0].stats.max_il, il_hi = il_lo, os_max = 0;
+    for (long i = 0; i < n; i++) {
+        if (pts[i].stats.max_il < il_lo) il_lo = pts[i].stats.max_il;
+        if (pts[i].stats.max_il > il_hi) il_hi = pts[i].stats.max_il;
+        double os = sweep_overshoot_pct(spec.type, &pts[i]);
+        if (os > os_max) os_max = os;
+    }
+    if (csv && sweep_write_csv(csv, spec.type, pts, n) != 0) {
+        snprintf(args->err, sizeof(args->err), "cannot write '%s'", csv); goto done;
+    }
+    snprintf(out, len, "type=%s method=%s points=%ld secs=%.3f max_il_min=%.6g max_il_max=%.6g overshoot_max_pct=%.4g%s%s",
+             RLC_TYPE_NAMES[spec.type], METHOD_NAMES[spec.method], n,
+             (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9,
+             il_lo, il_hi, os_max, csv ? " csv=" : "", csv ? csv : "");
+    rc = 0;
+
+done:
+    free(pts);
+    for (int a = 0; a < 4; a++) sweep_free_axis(axes[a]);
+    return rc;
+}
+
+// Tolerance analysis: mc design=divider|led|noninv|inv <design values> tol= dist= trials= lo= hi=
+static int batch_mc(BatchArgs *args, char *out, int len) {
+    static const char *DESIGN_NAMES[] = { "", "divider", "led", "noninv", "inv" };
+    static const char *DESIGN_KEYS[][3] = {
+        { 0 }, { "vin", "r1", "r2" }, { "vs", "vf", "r" }, { "r1", "r2" }, { "r1", "r2" }
+    };
+    McSpec spec;
+    memset(&spec, 0, sizeof(spec));
+
+    const char *d = arg_find(args, "design");
+    for (int k = MC_DIVIDER; d && k <= MC_OPAMP_INV; k++)
+        if (strcmp(d, DESIGN_NAMES[k]) == 0) spec.design = k;
+    if (!spec.design) { snprintf(args->err, sizeof(args->err), "design must be divider, led, noninv or inv"); return -1; }
+
+    for (int i = 0; i < 3 && DESIGN_KEYS[spec.design][i]; i++)
+        if (need_eng(args, DESIGN_KEYS[spec.design][i], &spec.p[i])) return -1;
+
+    double trials = 1e6, seed = 1;
+    spec.tol_pct = 5.0;
+    spec.dist = MC_DIST_UNIFORM;
+    const char *dist = arg_find(args, "dist");
+    if (dist && strcmp(dist, "gauss") == 0) spec.dist = MC_DIST_GAUSSIAN;
+    else if (dist && strcmp(dist, "uniform") != 0) {
+        snprintf(args->err, sizeof(args->err), "dist must be uniform or gauss"); return -1;
+    }
+    if (arg_eng(args, "tol", &spec.tol_pct) < 0 || arg_eng(args, "trials", &trials) < 0 ||
+        arg_threads(args, 0, &spec.n_threads) || arg_eng(args, "seed", &seed) < 0) return -1;
+
+    if (!(spec.tol_pct >= 0 && spec.tol_pct < 100)) {
+        snprintf(args->err, sizeof(args->err), "tol must be 0 .. < 100 (%%)"); return -1;
+    }
+
+    // Default spec window: nominal +/- 2%
+    double nominal = mc_nominal(&spec);
+    spec.spec_lo = nominal - fabs(nominal) * 0.02;
+    spec.spec_hi = nominal + fabs(nominal) * 0.02;
+    if (arg_eng(args, "lo", &spec.spec_lo) < 0 || arg_eng(args, "hi", &spec.spec_hi) < 0) return -1;
+    spec.trials = (long)trials;
+    spec.seed = (unsigned long long)seed;
+
+    McResult res;
+    if (mc_run(&spec, &res) != 0) { snprintf(args->err, sizeof(args->err), "invalid Monte Carlo settings"); return -1; }
+    snprintf(out, len, "design=%s trials=%ld nominal=%.6g mean=%.6g sigma=%.4g min=%.6g max=%.6g "
+             "p1=%.6g p5=%.6g p50=%.6g p95=%.6g p99=%.6g yield_pct=%.4f",
+             DESIGN_NAMES[spec.design], res.trials, res.nominal, res.mean, res.sigma, res.min, res.max,
+             res.pct[0], res.pct[1], res.pct[2], res.pct[3], res.pct[4], res.yield_pct);
+    return 0;
+}
+
+static int batch_led(BatchArgs *args, char *out, int len) {
+    double vs, vf, i;
+    ESeries series;
+    if (need_eng(args, "vs", &vs) || need_eng(args, "vf", &vf) || need_eng(args, "i", &i)) return -1;
+    if (arg_series(args, &series)) return -1;
+
+    LedDesign led;
+    int rc = led_design(vs, vf, i, series, &led);
+    if (rc == -1) { snprintf(args->err, sizeof(args->err), "vs must be greater than vf"); return -1; }
+    if (rc == -2) { snprintf(args->err, sizeof(args->err), "current must be positive"); return -1; }
+    snprintf(out, len, "r_ideal=%.6g r_std=%.6g i_act=%.6g", led.r_ideal, led.r_std, led.i_actual);
+    return 0;
+}
+
+static int batch_opamp(BatchArgs *args, char *out, int len) {
+    double gain;
+    int mode = OPAMP_NON_INVERTING;
+    const char *m = arg_find(args, "mode");
+    if (m) {
+        if (strcmp(m, "inv") == 0 || strcmp(m, "2") == 0) mode = OPAMP_INVERTING;
+        else if (strcmp(m, "noninv") != 0 && strcmp(m, "1") != 0) {
+            snprintf(args->err, sizeof(args->err), "mode must be noninv or inv");
+            return -1;
+        }
+    }
+    ESeries series;
+    if (need_eng(args, "gain", &gain) || arg_series(args, &series)) return -1;
+    if (gain < 1.0 && mode == OPAMP_NON_INVERTING) {
+        snprintf(args->err, sizeof(args->err), "non-inverting gain must be >= 1");
+        return -1;
+    }
+
+    // Optional search limits: rmin/rmax per part, rtot_min/rtot_max on R1+R2, vout+ifb_max, top
+    OpAmpSearch spec = { mode, gain, series, 0, 0, 0, 0, 0, 0, 1 };
+    double top = 1;
+    if (arg_eng(args, "rmin", &spec.r_min) < 0 || arg_eng(args, "rmax", &spec.r_max) < 0 ||
+        arg_eng(args, "rtot_min", &spec.rtot_min) < 0 || arg_eng(args, "rtot_max", &spec.rtot_max) < 0 ||
+        arg_eng(args, "vout", &spec.vout) < 0 || arg_eng(args, "ifb_max", &spec.ifb_max) < 0 ||
+        arg_eng(args, "top", &top) < 0) return -1;
+    if (top < 1 || top > 10 || top != (int)top) {
+        snprintf(args->err, sizeof(args->err), "top must be an integer 1-10");
+        return -1;
+    }
+    spec.top_k = (int)top;
+
+    OpAmpDesign pairs[OPAMP_MAX_TOP];
+    int n = opamp_search(&spec, pairs);
+    if (n < 0 && mode == OPAMP_NON_INVERTING && gain == 1.0) {
+        snprintf(args->err, sizeof(args->err), "gain of 1 is a voltage follower (no resistors)");
+        return -1;
+    }
+    if (n < 0) { snprintf(args->err, sizeof(args->err), "invalid search range"); return -1; }
+    if (n == 0) { snprintf(args->err, sizeof(args->err), "no resistor pair found"); return -1; }
+
+    int w = snprintf(out, len, "mode=%s r1=%.6g r2=%.6g gain=%.6g error_pct=%.6g",
+                     mode == OPAMP_INVERTING ? "inv" : "noninv",
+                     pairs[0].r1, pairs[0].r2, pairs[0].gain, pairs[0].error_pct);
+    // Runners-up as r1/r2/error_pct triples
+    for (int k = 1; k < n && w < len; k++)
+        w += snprintf(out + w, len - w, "%s%.6g/%.6g/%.4g", k == 1 ? " alt=" : ",",
+                      pairs[k].r1, pairs[k].r2, pairs[k].error_pct);
+    return 0;
+}
+
+static int batch_synth(BatchArgs *args, char *out, int len) {
+    RnetSpec spec = { 0, ESERIES_E24, 3, 0, 0 };
+    double parts = 3;
+    if (need_eng(args, "target", &spec.target) || arg_series(args, &spec.series)) return -1;
+    if (arg_eng(args, "parts", &parts) < 0 || arg_eng(args, "tol", &spec.tol_pct) < 0 ||
+        arg_threads(args, 0, &spec.n_threads)) return -1;
+    if (parts < 1 || parts > RNET_MAX_PARTS || parts != (int)parts) {
+        snprintf(args->err, sizeof(args->err), "parts must be an integer 1-%d", RNET_MAX_PARTS);
+        return -1;
+    }
+    spec.max_parts = (int)parts;
+
+    RnetResult nets[RNET_MAX_PARTS];
+    int n = rnet_synthesize(&spec, nets);
+    int k = n > 0 ? rnet_pick(nets, n, spec.tol_pct) : -1;
+    if (k < 0) {
+        snprintf(args->err, sizeof(args->err), "target must be %g .. %g", RNET_MIN_TARGET, RNET_MAX_TARGET);
+        return -1;
+    }
+
+    char expr[RNET_EXPR_LEN];
+    rnet_format(&nets[k], expr, sizeof(expr));
+    snprintf(out, len, "target=%.6g parts=%d value=%.9g error_pct=%.4g net=\"%s\"",
+             spec.target, nets[k].n_parts, nets[k].value, nets[k].error_pct, expr);
+    return 0;
+}
+
+// Writes the session history (including a loaded journal). '_' in tool= stands for a space.
+static int batch_export(BatchArgs *args, char *out, int len) {
+    static const char *FORMATS[] = { "", "csv", "tsv", "jsonl" };
+    const char *path;
+    if (arg_path(args, "path", &path)) return -1;
+    const char *fmt = arg_find(args, "format");
+    const char *tool = arg_find(args, "tool");
+    const char *fl = arg_find(args, "fields");
+    if (!path) { snprintf(args->err, sizeof(args->err), "missing parameter 'path'"); return -1; }
+    if (!args->session) { snprintf(args->err, sizeof(args->err), "no session"); return -1; }
+
+    int format = HISTORY_FMT_CSV;
+    if (fmt) {
+        format = 0;
+        for (int k = HISTORY_FMT_CSV; k <= HISTORY_FMT_JSONL; k++) if (strcmp(fmt, FORMATS[k]) == 0) format = k;
+        if (!format) { snprintf(args->err, sizeof(args->err), "format must be csv, tsv or jsonl"); return -1; }
+    }
+    unsigned fields = 0;
+    for (const char *c = fl ? fl : ""; *c; c++) {
+        const char *pos = strchr("itnr", *c);
+        if (!pos) { snprintf(args->err, sizeof(args->err), "fields must use i, t, n, r"); return -1; }
+        fields |= 1u << (pos - "itnr");
+    }
+    char filter[MAX_STR_LEN] = "";
+    if (tool) {
+        snprintf(filter, sizeof(filter), "%s", tool);
+        for (char *c = filter; *c; c++) if (*c == '_') *c = ' ';
+    }
+
+    long rows = history_export(&args->session->history, path, format, fields, filter);
+    if (rows < 0) { snprintf(args->err, sizeof(args->err), "cannot write '%s'", path); return -1; }
+    snprintf(out, len, "path=%s format=%s rows=%ld", path, FORMATS[format], rows);
+    return 0;
+}
+
+// Sets any of v= r= c= i= vf= l= series= in the session workbench, then reports all of it
+static int batch_wb(BatchArgs *args, char *out, int len) {
+    static const char *KEYS[] = { "v", "r", "c", "i", "vf", "l" };
+    if (!args->session) { snprintf(args->err, sizeof(args->err), "no session"); return -1; }
+    Workbench wb = args->session->wb;
+    double *vals[] = { &wb.voltage, &wb.resistor, &wb.capacitor, &wb.current, &wb.vf, &wb.inductor };
+    for (int k = 0; k < 6; k++) {
+        double v;
+        int rc = arg_eng(args, KEYS[k], &v);
+        if (rc < 0) return -1;
+        if (rc == 0) continue;
+        if (v <= 0) { snprintf(args->err, sizeof(args->err), "'%s' must be positive", KEYS[k]); return -1; }
+        *vals[k] = v;
+    }
+    if (arg_find(args, "series") && arg_series(args, &wb.series) != 0) return -1;
+
+    args->session->wb = wb;
+    snprintf(out, len, "v=%.6g r=%.6g c=%.6g i=%.6g vf=%.6g l=%.6g series=%s",
+             wb.voltage, wb.resistor, wb.capacitor, wb.current, wb.vf, wb.inductor, eseries_name(wb.series));
+    return 0;
+}
+
+static const struct {
+    const char *name;
+    const char *history_name;
+    batch_handler fn;
+    int heavy;          // long-running: the server hands it to a worker thread
+} BATCH_TOOLS[] = {
+    { "decode",  "Colour Decode",     batch_decode,  0 },
+    { "encode",  "Colour Encode",     batch_encode,  0 },
+    { "bom",     "Bulk BOM",          batch_bom,     1 },
+    { "bands",   "Bulk Decode",       batch_bands,   1 },
+    { "ohm",     "Ohm's Law",         batch_ohm,     0 },
+    { "power",   "Power Calc (P)",    batch_power,   0 },
+    { "divider", "Voltage Divider",   batch_divider, 0 },
+    { "rlc",     "RLC Analyser",      batch_rlc,     1 },
+    { "ac",      "RLC Analyser",      batch_ac,      1 },
+    { "fft",     "RLC Analyser",      batch_fft,     1 },
+    { "sweep",   "RLC Sweep",         batch_sweep,   1 },
+    { "mc",      "Monte Carlo",       batch_mc,      1 },
+    { "led",     "LED Resistor Calc", batch_led,     0 },
+    { "opamp",   "Op-Amp Designer",   batch_opamp,   1 },
+    { "synth",   "R Network Synth",   batch_synth,   1 },
+    { "netlist", "Netlist Solver",    batch_netlist, 1 },
+    { "export",  NULL,                batch_export,  0 },   // not itself recorded
+    { "wb",      NULL,                batch_wb,      0 },
+};
+#define BATCH_TOOL_COUNT (int)(sizeof(BATCH_TOOLS)/sizeof(BATCH_TOOLS[0]))
+
+// ============================================
+// Driver
+// ============================================
+
+// Splits "tool k=v k=v" in place. Returns the tool name or NULL for a blank/comment line.
+static char *tokenise_line(char *line, BatchArgs *args) {
+    args->n = 0; args->err[0] = '\0';
+    char *p = line, *save;
+    while (isspace((unsigned char)*p)) p++;
+    if (*p == '\0' || *p == '#') return NULL;
+
+    char *tool = strtok_r(p, " \t\r\n", &save);
+    char *tok;
+    while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+        if (tok[0] == '#') break;   // trailing comment
+        char *eq = strchr(tok, '=');
+        if (!eq || eq == tok) {
+            snprintf(args->err, sizeof(args->err), "expected key=value, got '%s'", tok);
+            break;
+        }
+        if (args->n == BATCH_MAX_ARGS) {
+            snprintf(args->err, sizeof(args->err), "too many parameters");
+            break;
+        }
+        *eq = '\0';
+        args->arg[args->n].key = tok;
+        args->arg[args->n].val = eq + 1;
+        args->arg[args->n].used = 0;
+        args->n++;
+    }
+    return tool;
+}
+
+// Index of the line's tool in BATCH_TOOLS, BATCH_TOOL_COUNT if unknown, -1 for a blank line.
+// *name_len receives the length of the tool name as typed.
+static int find_tool(const char *line, int *name_len) {
+    while (isspace((unsigned char)*line)) line++;
+    int n = (int)strcspn(line, " \t\r\n");
+    *name_len = n;
+    if (n == 0 || line[0] == '#') return -1;
+    int t = 0;
+    while (t < BATCH_TOOL_COUNT &&
+           (strncmp(BATCH_TOOLS[t].name, line, n) != 0 || BATCH_TOOLS[t].name[n] != '\0')) t++;
+    return t;
+}
+
+/**
+ * @brief Runs one command line ("tool k=v ..."). Writes the reply, "tool=<name> <results>"
+ *        or "tool=<name> error=\"...\"", into out. Thread-safe; session may be NULL for tools
+ *        that do not use it (every heavy one), and is only read or changed by export and wb.
+ * @param flags 0, or BATCH_NO_FILES to refuse file parameters and BATCH_ONE_THREAD to keep
+ *        threaded tools to the calling thread (the server's workers).
+ * @return BATCH_OK, BATCH_FAILED, or BATCH_SKIP for a blank / comment line (out set to "").
+ */
+int batch_exec(Session *session, const char *line, char *out, size_t cap, int flags) {
+    char buf[BATCH_LINE_LEN];
+    BatchArgs args;
+    args.session = session;
+    args.flags = flags;
+    snprintf(buf, sizeof(buf), "%s", line);
+    if (cap) out[0] = '\0';
+
+    char *tool = tokenise_line(buf, &args);
+    if (!tool) return BATCH_SKIP;
+    int name_len;
+    int t = find_tool(line, &name_len);
+
+    // Results go after the "tool=<name> " prefix
+    int pre = snprintf(out, cap, "tool=%.32s ", tool);
+    if (pre < 0 || (size_t)pre >= cap) return BATCH_FAILED;
+    int rc = -1;
+    if (args.err[0] == '\0') {
+        if (t == BATCH_TOOL_COUNT) snprintf(args.err, sizeof(args.err), "unknown tool");
+        else rc = BATCH_TOOLS[t].fn(&args, out + pre, (int)(cap - pre));
+    }
+    // Reject typos such as "R1=" instead of silently ignoring them
+    for (int k = 0; rc == 0 && k < args.n; k++) {
+        if (!args.arg[k].used) {
+            snprintf(args.err, sizeof(args.err), "unknown parameter '%s'", args.arg[k].key);
+            rc = -1;
+        }
+    }
+    if (rc != 0) {
+        snprintf(out + pre, cap - pre, "error=\"%s\"", args.err);
+        return BATCH_FAILED;
+    }
+    return BATCH_OK;
+}
+
+/**
+ * @brief Records a successful batch_exec() reply in the session history (tools such as
+ *        export are not recorded). Kept apart from batch_exec() so a reply computed on another
+ *        thread is recorded by the thread that owns the session.
+ * @return 0 if recorded or not recordable, else history_append()'s error (-1 not recorded,
+ *         -2 recorded but the journal write failed).
+ */
+int batch_record(Session *session, const char *line, const char *reply) {
+    int name_len;
+    int t = find_tool(line, &name_len);
+    if (t < 0 || t == BATCH_TOOL_COUNT || !BATCH_TOOLS[t].history_name) return 0;
+
+    // The raw "k=v ..." text after the tool name is the record's inputs
+    const char *params = line;
+    while (isspace((unsigned char)*params)) params++;
+    params += name_len;
+    while (isspace((unsigned char)*params)) params++;
+    char inputs[MAX_STR_LEN];
+    snprintf(inputs, sizeof(inputs), "%.*s", (int)strcspn(params, "\r\n"), params);
+
+    // Skip the "tool=<name> " prefix of the reply
+    const char *results = strchr(reply, ' ');
+    return history_append(&session->history, BATCH_TOOLS[t].history_name, inputs,
+                          results ? results + 1 : reply);
+}
+
+/**
+ * @brief 1 if the line's tool is a long-running one (simulations, searches, file work) that
+ *        the server runs on a worker thread, 0 otherwise.
+ */
+int batch_heavy(const char *line) {
+    int name_len;
+    int t = find_tool(line, &name_len);
+    return t >= 0 && t < BATCH_TOOL_COUNT && BATCH_TOOLS[t].heavy;
+}
+
+// After fgets() filled the buffer without a '\n': 1 if the line ends right there (at the
+// newline or end of file), else 0 with the rest of the line consumed so it is not read as more
+// commands
+static int line_fits(FILE *fp) {
+    int ch = getc(fp);
+    if (ch == EOF || ch == '\n') return 1;
+    while (ch != EOF && ch != '\n') ch = getc(fp);
+    return 0;
+}
+
+int run_batch(const char *path, Session *session) {
+    FILE *fp = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if (!fp) { fprintf(stderr, "Error opening batch file '%s'.\n", path); return 1; }
+
+    // Results go out in large blocks rather than one write per line
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+
+    char line[BATCH_LINE_LEN], reply[BATCH_REPLY_LEN];
+    int line_no = 0, errors = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+        if (!strchr(line, '\n') && !line_fits(fp)) {
+            printf("line=%d error=\"line too long\"\n", line_no);
+            errors++;
+            continue;
+        }
+        PROF_BEGIN(span);
+        int rc = batch_exec(session, line, reply, sizeof(reply), 0);
+        PROF_END(PROF_BATCH, span);
+        if (rc == BATCH_SKIP) continue;
+        printf("line=%d %s\n", line_no, reply);
+        if (rc != BATCH_OK) errors++;
+        else if ((rc = batch_record(session, line, reply)) != 0) {
+            fprintf(stderr, "[Batch] Line %d %s.\n", line_no, rc == -2
+                    ? "was recorded, but the journal write failed (journal detached)"
+                    : "could not be recorded in the history (out of memory)");
+            errors++;
+        }
+    }
+
+    if (fp != stdin) fclose(fp);
+    fflush(stdout);
+    return errors;
+}
@@ -0,0 +1,29 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include "funcs.h"
+
+#define BATCH_LINE_LEN 512                  // longest command line
+#define BATCH_OUT_LEN 512                   // longest tool result
+#define BATCH_REPLY_LEN (BATCH_OUT_LEN + 48) // "tool=<name> " + result or error
+
+// batch_exec() results
+enum { BATCH_OK = 0, BATCH_FAILED = -1, BATCH_SKIP = 1 };
+
+// batch_exec() flags
+enum {
+    BATCH_NO_FILES = 1,     // reject parameters naming a file (in, out, wave, csv, path, file)
+    BATCH_ONE_THREAD = 2,   // threaded tools (bom, bands, sweep, mc, synth) run on one thread
+};
+#define BATCH_MAX_THREADS 64                // largest threads= accepted
+
+// Runs every command in `path` ("-" for stdin) without prompting, recording into the session.
+// Returns the number of lines that failed (too long, rejected, or not recorded).
+int run_batch(const char *path, Session *session);
+
+int batch_exec(Session *session, const char *line, char *out, size_t cap, int flags);
+int batch_record(Session *session, const char *line, const char *reply);
+int batch_heavy(const char *line);
+
+#endif
@@ -0,0 +1,478 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include "circuits.h"
+#include "eseries.h"
+#include "opamp.h"
+#include "rlc.h"
+#include "history.h"
+#include "bom.h"
+
+// ============================================
+// Microbenchmarks for the calculation cores ("make bench").
+// Each case is calibrated until one trial takes at least BENCH_MIN_TRIAL_NS, run a few times
+// untimed to warm caches and the branch predictor, then timed over repeated trials. Per-op
+// times are summarised as min / p10 / median / p90 / max and written to a CSV file so runs
+// can be diffed before and after a change.
+// ============================================
+
+#define BENCH_MIN_TRIAL_NS 20e6     // calibrate iterations to at least 20 ms per trial
+#define BENCH_MAX_ITERS (1L << 26)
+#define BENCH_WARMUP 3
+#define BENCH_TRIALS 21
+#define BENCH_MAX_TRIALS 1000
+#define BENCH_DEFAULT_OUT "bench.csv"
+#define BENCH_POOL 4096             // inputs per case, cycled through (power of two)
+
+// Every case returns the elapsed time of `iters` operations in nanoseconds, so setup and
+// teardown that are not part of the operation stay outside the measurement.
+typedef double (*BenchFn)(long iters);
+
+typedef struct {
+    const char *name;
+    const char *what;       // one line for the table
+    BenchFn fn;
+} BenchCase;
+
+static volatile double g_sink;  // results land here so the work cannot be optimised away
+
+static double g_values[BENCH_POOL];         // log-uniform 1 .. 10M (resistances)
+static double g_wide[BENCH_POOL];           // log-uniform 1p .. 1T (format_eng range)
+static char g_inputs[BENCH_POOL][32];       // typed engineering strings, newline included
+static char g_bom[BENCH_POOL * 12];         // BOM value column: BENCH_POOL values, one per line
+static size_t g_bom_len;
+static char g_codes[BENCH_POOL][BANDS_TEXT_LEN];   // band strings, 4/5/6 bands, full and short names
+static char g_code_file[BENCH_POOL * (BANDS_TEXT_LEN + 1)];
+static size_t g_code_file_len;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Fixed-seed xorshift so every run sees the same inputs
+static unsigned long long g_rng = 0x9E3779B97F4A7C15ULL;
+
+static double rand_unit(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 7; g_rng ^= g_rng << 17;
+    return (g_rng >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void make_inputs(void) {
+    static const char *suffixes[] = { "", "k", "M", "m", "u", "n", "p", "G" };
+    for (int i = 0; i < BENCH_POOL; i++) {
+        g_values[i] = pow(10.0, 7.0 * rand_unit());
+        g_wide[i] = pow(10.0, -12.0 + 24.0 * rand_unit());
+        // What people actually type: "4.7k", "100n", " 2200", "1e3", with the odd typo
+        int kind = (int)(rand_unit() * 16);
+        double mant = floor(rand_unit() * 1000.0) / 10.0;
+        if (kind == 0) snprintf(g_inputs[i], sizeof(g_inputs[i]), "%gq\n", mant);
+        else if (kind == 1) snprintf(g_inputs[i], sizeof(g_inputs[i]), "%.0fe%d\n", mant, (int)(rand_unit() * 6));
+        else if (kind == 2) snprintf(g_inputs[i], sizeof(g_inputs[i]), "  %g \r\n", mant);
+        else snprintf(g_inputs[i], sizeof(g_inputs[i]), "%g%s\n", mant, suffixes[kind & 7]);
+    }
+    // Forms both the old and the new parser accept, so the bulk cases do the same work
+    g_bom_len = 0;
+    for (int i = 0; i < BENCH_POOL; i++) {
+        double mant = floor(rand_unit() * 1000.0) / 10.0;
+        g_bom_len += snprintf(g_bom + g_bom_len, sizeof(g_bom) - g_bom_len, "%g%s\n",
+                              mant, suffixes[(int)(rand_unit() * 8)]);
+    }
+    g_code_file_len = 0;
+    for (int i = 0; i < BENCH_POOL; i++) {
+        BandCode code;
+        int n = 4 + (i % 3);
+        bands_encode(g_values[i], n, n == 4 ? 5 : 1, 50, &code);
+        int len = bands_format(&code, i & 1, g_codes[i], BANDS_TEXT_LEN);
+        memcpy(g_code_file + g_code_file_len, g_codes[i], len);
+        g_code_file_len += len;
+        g_code_file[g_code_file_len++] = '\n';
+    }
+}
+
+// ============================================
+// Cases
+// ============================================
+
+// The parse path of get_eng_input_with_default(): strip the line ending fgets() left, then
+// parse_eng_value(). The prompt and stdin read are left out.
+static double bench_parse_eng(long iters) {
+    char buf[64];
+    double acc = 0, v;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        const char *src = g_inputs[i & (BENCH_POOL - 1)];
+        strcpy(buf, src);
+        buf[strcspn(buf, "\r\n")] = '\0';
+        if (parse_eng_value(buf, &v) == ENG_OK) acc += v;
+    }
+    double t = now_ns() - t0;
+    g_sink = acc;
+    return t;
+}
+
+// The strtod-based parser parse_eng_value() used before engparse.c, as the bulk baseline
+static int legacy_parse(const char *s, double *out) {
+    while (isspace((unsigned char)*s)) s++;
+    if (*s == '\0') return ENG_EMPTY;
+    char *end;
+    double value = strtod(s, &end);
+    if (end == s) return ENG_INVALID;
+    while (isspace((unsigned char)*end)) end++;
+    double multiplier = 1.0;
+    if (*end != '\0') {
+        switch (*end) {
+            case 'p': multiplier = 1e-12; break; case 'n': multiplier = 1e-9; break;
+            case 'u': multiplier = 1e-6; break; case 'm': multiplier = 1e-3; break;
+            case 'k': case 'K': multiplier = 1e3; break; case 'M': multiplier = 1e6; break;
+            case 'G': multiplier = 1e9; break;
+            default: return ENG_BAD_SUFFIX;
+        }
+        if (end[1] != '\0') return ENG_TRAILING;
+    }
+    *out = value * multiplier;
+    return ENG_OK;
+}
+
+// One pass over the BOM column: split lines into NUL-terminated tokens, strtod + suffix
+static double bench_bulk_strtod(long iters) {
+    static double vals[BENCH_POOL];
+    char tok[32];
+    double acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        const char *p = g_bom, *end = g_bom + g_bom_len;
+        int n = 0;
+        while (p < end) {
+            const char *nl = memchr(p, '\n', (size_t)(end - p));
+            size_t len = nl ? (size_t)(nl - p) : (size_t)(end - p);
+            memcpy(tok, p, len); tok[len] = '\0';
+            if (legacy_parse(tok, &vals[n]) == ENG_OK) n++;
+            p += len + 1;
+        }
+        acc += vals[n - 1];
+    }
+    double t = now_ns() - t0;
+    g_sink = acc;
+    return t;
+}
+
+static double bench_bulk_eng(long iters) {
+    static double vals[BENCH_POOL];
+    double acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        long n = eng_parse_list(g_bom, g_bom_len, vals, BENCH_POOL, NULL);
+        acc += vals[n - 1];
+    }
+    double t = now_ns() - t0;
+    g_sink = acc;
+    return t;
+}
+
+static double bench_format_eng(long iters) {
+    char buf[32];
+    int acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        format_eng(g_wide[i & (BENCH_POOL - 1)], buf);
+        acc += buf[0];
+    }
+    double t = now_ns() - t0;
+    g_sink = acc;
+    return t;
+}
+
+// A 4096-value CSV column at %.9g: the wave/sweep export inner loop, old and new
+static char g_csv[BENCH_POOL * ENG_FMT_LEN];
+
+static double bench_csv_snprintf(long iters) {
+    size_t acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        size_t len = 0;
+        for (int k = 0; k < BENCH_POOL; k++)
+            len += snprintf(g_csv + len, sizeof(g_csv) - len, "%.9g,", g_wide[k]);
+        acc += len;
+    }
+    double t = now_ns() - t0;
+    g_sink = (double)acc;
+    return t;
+}
+
+static double bench_csv_eng(long iters) {
+    size_t acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++)
+        acc += eng_format_many(g_wide, BENCH_POOL, ENG_FMT_G, 9, ',', g_csv, sizeof(g_csv), NULL);
+    double t = now_ns() - t0;
+    g_sink = (double)acc;
+    return t;
+}
+
+// A text file through one of the bulk pipelines (one worker), file in, /dev/null out
+static double run_bulk(long iters, const char *text, size_t len, int decode) {
+    char path[64];
+    snprintf(path, sizeof(path), "bench_bulk_%d.txt", (int)getpid());
+    int in = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    int out = open("/dev/null", O_WRONLY);
+    if (in < 0 || out < 0 || write(in, text, len) != (ssize_t)len) {
+        fprintf(stderr, "bench: cannot set up %s\n", path);
+        exit(1);
+    }
+    BomStats st;
+    long acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        lseek(in, 0, SEEK_SET);
+        if (decode) bom_decode(in, out, 1, &st);
+        else bom_normalise(in, out, ESERIES_E24, 1, &st);
+        acc += st.ok;
+    }
+    double t = now_ns() - t0;
+    close(in); close(out);
+    unlink(path);
+    g_sink = (double)acc;
+    return t;
+}
+
+static double bench_bom(long iters) { return run_bulk(iters, g_bom, g_bom_len, 0); }
+static double bench_bulk_bands(long iters) { return run_bulk(iters, g_code_file, g_code_file_len, 1); }
+
+static double bench_e24(long iters) {
+    double acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) acc += find_closest_e24_resistor(g_values[i & (BENCH_POOL - 1)]);
+    double t = now_ns() - t0;
+    g_sink = acc;
+    return t;
+}
+
+static double bench_bands(long iters) {
+    int acc = 0;
+    BandCode code;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        if (bands_encode(g_values[i & (BENCH_POOL - 1)], 4, 5, 0, &code) == BANDS_OK) acc += code.c[2];
+    }
+    double t = now_ns() - t0;
+    g_sink = acc;
+    return t;
+}
+
+static double bench_band_decode(long iters) {
+    double acc = 0;
+    BandCode code;
+    BandValue val;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        const char *s = g_codes[i & (BENCH_POOL - 1)];
+        if (bands_parse(s, strlen(s), &code) == BANDS_OK && bands_decode(&code, &val) == BANDS_OK)
+            acc += val.ohms;
+    }
+    double t = now_ns() - t0;
+    g_sink = acc;
+    return t;
+}
+
+// One interactive RLC run: SIM_STEPS samples with SIM_SUBSTEPS Euler steps each, all four traces
+static double bench_rlc_euler(long iters) {
+    RlcCircuit ckt = { RLC_TYPE_RLC, 5.0, 10.0, 1e-3, 1e-6 };
+    rlc_apply_safety(&ckt);
+    double t_total = rlc_auto_time(&ckt);
+    double *buf = malloc(4 * SIM_STEPS * sizeof(double));
+    if (!buf) return 0;
+    RlcTrace trace = { buf, buf + SIM_STEPS, buf + 2 * SIM_STEPS, buf + 3 * SIM_STEPS };
+    RlcStats st;
+    double acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        rlc_simulate_euler(&ckt, t_total, SIM_STEPS, &trace, &st);
+        acc += st.max_vc;
+    }
+    double t = now_ns() - t0;
+    free(buf);
+    g_sink = acc;
+    return t;
+}
+
+// Menu item 6 defaults over the full 10 Ohm .. 10 MOhm range: E24 and the densest series
+static double run_opamp(long iters, ESeries series) {
+    OpAmpSearch spec = { OPAMP_NON_INVERTING, 0, series, 0, 0, 0, 0, 0, 0, 5 };
+    OpAmpDesign out[5];
+    double acc = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        spec.gain = 1.5 + (i & 63) * 0.73;
+        if (opamp_search(&spec, out) > 0) acc += out[0].error_pct;
+    }
+    double t = now_ns() - t0;
+    g_sink = acc;
+    return t;
+}
+
+static double bench_opamp_e24(long iters) { return run_opamp(iters, ESERIES_E24); }
+static double bench_opamp_e192(long iters) { return run_opamp(iters, ESERIES_E192); }
+
+// add_record_to_history() minus its console message: format the strings the way the tools do
+// and append. The history is rebuilt every trial so chunk and arena growth is included.
+static double run_history(long iters, const char *journal) {
+    History h = HISTORY_INIT;
+    if (journal && history_open_journal(&h, journal, NULL) < 0) return 0;
+    char details[128], result[64], r1[32], r2[32], vout[32];   // room for 31-char values
+    double t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        double a = g_values[i & (BENCH_POOL - 1)], b = g_values[(i + 1) & (BENCH_POOL - 1)];
+        format_eng(a, r1); format_eng(b, r2); format_eng(12.0 * b / (a + b), vout);
+        snprintf(details, sizeof(details), "Vin=12.00V, R1=%sOhm, R2=%sOhm", r1, r2);
+        snprintf(result, sizeof(result), "Vout=%sV", vout);
+        history_append(&h, "Voltage Divider", details, result);
+    }
+    double t = now_ns() - t0;
+    g_sink = h.count;
+    history_free(&h);
+    if (journal) unlink(journal);
+    return t;
+}
+
+static double bench_history(long iters) { return run_history(iters, NULL); }
+
+static double bench_history_journal(long iters) {
+    char path[64];
+    snprintf(path, sizeof(path), "bench_journal_%d.bin", (int)getpid());
+    unlink(path);
+    return run_history(iters, path);
+}
+
+static const BenchCase CASES[] = {
+    { "parse_eng",       "strip + parse_eng_value of typed input", bench_parse_eng },
+    { "bulk_strtod",     "4096-value BOM column, strtod + suffix", bench_bulk_strtod },
+    { "bulk_eng",        "4096-value BOM column, eng_parse_list",  bench_bulk_eng },
+    { "format_eng",      "format_eng over 1p .. 1T",               bench_format_eng },
+    { "csv_snprintf",    "4096-value CSV column, snprintf %.9g",    bench_csv_snprintf },
+    { "csv_eng",         "4096-value CSV column, eng_format_many",  bench_csv_eng },
+    { "bom_e24",         "4096-line BOM, bom_normalise E24",      bench_bom },
+    { "e24_nearest",     "find_closest_e24_resistor",              bench_e24 },
+    { "band_encode",     "bands_encode, 4 bands",                  bench_bands },
+    { "band_decode",     "bands_parse + bands_decode, 4-6 bands",  bench_band_decode },
+    { "bulk_bands",      "4096-line band file, bom_decode",        bench_bulk_bands },
+    { "rlc_euler",       "rlc_simulate_euler, 1000 x 10 steps",    bench_rlc_euler },
+    { "opamp_e24",       "opamp_search E24, top 5",                bench_opamp_e24 },
+    { "opamp_e192",      "opamp_search E192, top 5",               bench_opamp_e192 },
+    { "history_append",  "format + history_append (memory)",       bench_history },
+    { "history_journal", "format + history_append (journal)",      bench_history_journal },
+};
+#define N_CASES ((int)(sizeof(CASES) / sizeof(CASES[0])))
+
+// ============================================
+// Driver
+// ============================================
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Linear interpolation between order statistics of a sorted array
+static double percentile(const double *s, int n, double p) {
+    double pos = p * (n - 1);
+    int i = (int)pos;
+    if (i >= n - 1) return s[n - 1];
+    return s[i] + (pos - i) * (s[i + 1] - s[i]);
+}
+
+// Formats a duration in ns with the unit that keeps it readable
+static void format_ns(double ns, char *buf, int len) {
+    if (ns < 1e3) snprintf(buf, len, "%.1f ns", ns);
+    else if (ns < 1e6) snprintf(buf, len, "%.2f us", ns / 1e3);
+    else if (ns < 1e9) snprintf(buf, len, "%.2f ms", ns / 1e6);
+    else snprintf(buf, len, "%.2f s", ns / 1e9);
+}
+
+static int selected(const char *name, int argc, char **argv, int first) {
+    if (first >= argc) return 1;
+    for (int i = first; i < argc; i++) {
+        if (strstr(name, argv[i])) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    // Options: --trials N   timed trials per case (default 21)
+    //          --out FILE   CSV results (default bench.csv, "-" = none)
+    //          NAME ...     only cases whose name contains one of these
+    int trials = BENCH_TRIALS;
+    const char *out_path = BENCH_DEFAULT_OUT;
+    int first = 1;
+    while (first < argc && strncmp(argv[first], "--", 2) == 0) {
+        if (strcmp(argv[first], "--trials") == 0 && first + 1 < argc) trials = atoi(argv[++first]);
+        else if (strcmp(argv[first], "--out") == 0 && first + 1 < argc) out_path = argv[++first];
+        else {
+            fprintf(stderr, "Usage: %s [--trials N] [--out FILE|-] [case ...]\n", argv[0]);
+            return 2;
+        }
+        first++;
+    }
+    if (trials < 1 || trials > BENCH_MAX_TRIALS) {
+        fprintf(stderr, "Trials must be 1 .. %d.\n", BENCH_MAX_TRIALS);
+        return 2;
+    }
+
+    FILE *csv = NULL;
+    if (strcmp(out_path, "-") != 0) {
+        csv = fopen(out_path, "w");
+        if (!csv) { perror(out_path); return 1; }
+        fprintf(csv, "case,iters,trials,min_ns,p10_ns,median_ns,p90_ns,max_ns,ops_per_sec\n");
+    }
+
+    make_inputs();
+    double *per_op = malloc((size_t)trials * sizeof(double));
+    if (!per_op) { if (csv) fclose(csv); return 1; }
+
+    printf("%-16s %-40s %10s %10s %10s %8s\n", "case", "operation", "min", "median", "p90", "spread");
+    int ran = 0;
+    for (int c = 0; c < N_CASES; c++) {
+        const BenchCase *bc = &CASES[c];
+        if (!selected(bc->name, argc, argv, first)) continue;
+
+        // Calibrate (doubles as the first warmup)
+        long iters = 1;
+        while (iters < BENCH_MAX_ITERS && bc->fn(iters) < BENCH_MIN_TRIAL_NS) iters *= 2;
+        for (int w = 0; w < BENCH_WARMUP; w++) bc->fn(iters);
+        for (int t = 0; t < trials; t++) per_op[t] = bc->fn(iters) / iters;
+        qsort(per_op, trials, sizeof(double), cmp_double);
+
+        double p10 = percentile(per_op, trials, 0.10), med = percentile(per_op, trials, 0.50);
+        double p90 = percentile(per_op, trials, 0.90);
+        char s_min[24], s_med[24], s_p90[24];
+        format_ns(per_op[0], s_min, sizeof(s_min));
+        format_ns(med, s_med, sizeof(s_med));
+        format_ns(p90, s_p90, sizeof(s_p90));
+        // Spread: (p90 - p10) / median, a quick noise check for the run
+        printf("%-16s %-40s %10s %10s %10s %7.1f%%\n", bc->name, bc->what, s_min, s_med, s_p90,
+               med > 0 ? 100.0 * (p90 - p10) / med : 0.0);
+        fflush(stdout);
+        if (csv) {
+            fprintf(csv, "%s,%ld,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n", bc->name, iters, trials,
+                    per_op[0], p10, med, p90, per_op[trials - 1], med > 0 ? 1e9 / med : 0.0);
+        }
+        ran++;
+    }
+    free(per_op);
+
+    if (csv) {
+        fclose(csv);
+        if (ran) printf("\nResults written to %s\n", out_path);
+    }
+    if (!ran) {
+        fprintf(stderr, "No case matches.\n");
+        return 1;
+    }
+    return 0;
+}
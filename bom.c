@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "bom.h"
+#include "circuits.h"
+
+static char *put_str(char *p, const char *s) {
+    size_t n = strlen(s);
+    memcpy(p, s, n);
+    return p + n;
+}
+
+// ============================================
+// Rows (run on the worker threads)
+// ============================================
+// A row function turns one input line [s, end) into at most BOM_ROW_MAX bytes at p and
+// returns the new end.
+
+typedef char *(*BomRowFn)(const char *s, const char *end, ESeries series, char *p, BomStats *st);
+
+enum { SLOT_FREE = 0, SLOT_FILLED, SLOT_BUSY, SLOT_DONE };
+
+typedef struct {
+    char *in;
+    size_t in_len;
+    char *out;
+    size_t out_len, out_cap;
+    long seq;
+    int state;
+    int failed;     // output buffer could not grow
+    BomStats st;
+} BomSlot;
+
+static int is_sep(char c) { return c == ',' || c == ';' || c == '\t'; }
+
+// Trims blanks and one pair of double quotes from [*s, *e)
+static void trim_field(const char **s, const char **e) {
+    while (*s < *e && (**s == ' ' || **s == '\r')) (*s)++;
+    while (*e > *s && ((*e)[-1] == ' ' || (*e)[-1] == '\r')) (*e)--;
+    if (*e - *s >= 2 && **s == '"' && (*e)[-1] == '"') { (*s)++; (*e)--; }
+}
+
+// BOM line -> ref,value_ohm,std_ohm,dev_pct,tol_pct,bands,status
+static char *bom_line(const char *s, const char *end, ESeries series, char *p, BomStats *st) {
+    const char *ref = NULL, *ref_end = NULL;
+    double v = 0;
+    int found = 0, fields = 0;
+    for (const char *f = s; f <= end && !found; fields++) {
+        const char *fe = f;
+        while (fe < end && !is_sep(*fe)) fe++;
+        const char *a = f, *b = fe;
+        trim_field(&a, &b);
+        // With more than one field the first is the reference, even if it looks like a value
+        int is_ref = fields == 0 && fe < end;
+        if (is_ref) { ref = a; ref_end = b; }
+        else found = b > a && eng_parse(a, (size_t)(b - a), &v) == ENG_OK && v > 0;
+        f = fe + 1;
+    }
+
+    st->lines++;
+    if (ref) {
+        size_t n = (size_t)(ref_end - ref);
+        if (n > BOM_REF_MAX) n = BOM_REF_MAX;
+        memcpy(p, ref, n);
+        p += n;
+    }
+    *p++ = ',';
+    if (!found) {
+        st->no_value++;
+        return put_str(p, ",,,,,no_value\n");
+    }
+
+    double std = eseries_nearest(series, v);
+    double dev = (v - std) / std * 100.0;
+    if (fabs(dev) < 1e-9) dev = 0;      // series tables are not exact in binary
+    if (fabs(dev) > st->max_dev_pct) st->max_dev_pct = fabs(dev);
+    p += eng_format_g(v, 6, p, ENG_FMT_LEN);
+    *p++ = ',';
+    p += eng_format_g(std, 6, p, ENG_FMT_LEN);
+    *p++ = ',';
+    p += eng_format_g(dev, 4, p, ENG_FMT_LEN);
+    *p++ = ',';
+    p += eng_format_g(eseries_tolerance_pct(series), 3, p, ENG_FMT_LEN);
+    *p++ = ',';
+    BandCode code;
+    if (resistor_code(std, series, &code) != BANDS_OK) {
+        st->out_of_range++;
+        return put_str(p, ",range\n");
+    }
+    st->ok++;
+    p += bands_format(&code, 0, p, BANDS_TEXT_LEN);
+    return put_str(p, ",ok\n");
+}
+
+// Band string line -> bands,value_ohm,tol_pct,tempco_ppm,status. A line that does not decode
+// keeps its text (separators made safe for CSV) and says why in status.
+static char *decode_line(const char *s, const char *end, ESeries series, char *p, BomStats *st) {
+    (void)series;
+    BandCode code;
+    BandValue val;
+    st->lines++;
+    int rc = bands_parse(s, (size_t)(end - s), &code);
+    if (rc == BANDS_OK) rc = bands_decode(&code, &val);
+    if (rc != BANDS_OK) {
+        st->invalid++;
+        const char *a = s, *b = end;
+        trim_field(&a, &b);
+        if (b - a > BOM_REF_MAX) b = a + BOM_REF_MAX;
+        for (; a < b; a++) *p++ = (*a == ',' || *a == '"') ? '-' : *a;
+        return put_str(p, rc == BANDS_ERR_COLOUR ? ",,,,bad_colour\n" :
+                          rc == BANDS_ERR_COUNT ? ",,,,bad_count\n" : ",,,,bad_position\n");
+    }
+    st->ok++;
+    p += bands_format(&code, 0, p, BANDS_TEXT_LEN);
+    *p++ = ',';
+    p += eng_format_g(val.ohms, 6, p, ENG_FMT_LEN);
+    *p++ = ',';
+    p += eng_format_g(val.tol_pct, 3, p, ENG_FMT_LEN);
+    *p++ = ',';
+    if (val.tempco_ppm) p += eng_format_g(val.tempco_ppm, 3, p, ENG_FMT_LEN);
+    return put_str(p, ",ok\n");
+}
+
+static void bom_chunk(BomSlot *s, BomRowFn row, ESeries series) {
+    memset(&s->st, 0, sizeof(s->st));
+    s->st.bytes_in = (long long)s->in_len;
+    s->out_len = 0;
+
+    size_t rows = 1;
+    for (size_t i = 0; i < s->in_len; i++) rows += s->in[i] == '\n';
+    if (rows * BOM_ROW_MAX > s->out_cap) {
+        char *grown = realloc(s->out, rows * BOM_ROW_MAX);
+        if (!grown) { s->failed = 1; return; }
+        s->out = grown;
+        s->out_cap = rows * BOM_ROW_MAX;
+    }
+
+    char *p = s->out;
+    const char *line = s->in, *end = s->in + s->in_len;
+    while (line < end) {
+        const char *nl = memchr(line, '\n', (size_t)(end - line));
+        const char *le = nl ? nl : end;
+        const char *a = line;
+        while (a < le && (*a == ' ' || *a == '\t' || *a == '\r')) a++;
+        if (a < le && *a != '#') p = row(line, le, series, p, &s->st);
+        line = le + 1;
+    }
+    s->out_len = (size_t)(p - s->out);
+}
+
+// ============================================
+// Ordered pipeline
+// ============================================
+// The calling thread reads chunks into a ring of slots and writes finished slots back in
+// sequence; the workers take whichever filled slot is oldest. A slot is only touched by its
+// owner: the reader while FREE, a worker while BUSY, the writer once DONE.
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work, done;
+    BomSlot *slots;
+    int n_slots;
+    BomRowFn row;
+    ESeries series;
+    int quit;
+} BomJob;
+
+static void *bom_worker(void *arg) {
+    BomJob *job = arg;
+    pthread_mutex_lock(&job->lock);
+    for (;;) {
+        BomSlot *s = NULL;
+        for (int i = 0; i < job->n_slots; i++) {
+            BomSlot *c = &job->slots[i];
+            if (c->state == SLOT_FILLED && (!s || c->seq < s->seq)) s = c;
+        }
+        if (!s) {
+            if (job->quit) break;
+            pthread_cond_wait(&job->work, &job->lock);
+            continue;
+        }
+        s->state = SLOT_BUSY;
+        pthread_mutex_unlock(&job->lock);
+        bom_chunk(s, job->row, job->series);
+        pthread_mutex_lock(&job->lock);
+        s->state = SLOT_DONE;
+        pthread_cond_broadcast(&job->done);
+    }
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+// Reads up to BOM_CHUNK bytes behind the partial line carried over from the last chunk, and
+// carries everything after the last newline on to the next one (nothing at end of input).
+static int bom_fill(int fd, BomSlot *s, char *carry, size_t *carry_len, int *eof) {
+    size_t len = *carry_len;
+    memcpy(s->in, carry, len);
+    while (len < BOM_CHUNK && !*eof) {
+        ssize_t r = read(fd, s->in + len, BOM_CHUNK - len);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) return -1;
+        if (r == 0) *eof = 1;
+        len += (size_t)r;
+    }
+    size_t cut = len;
+    if (!*eof) {
+        while (cut > 0 && s->in[cut - 1] != '\n') cut--;
+        if (cut == 0) cut = len;    // one line longer than a chunk: split it
+    }
+    *carry_len = len - cut;
+    memcpy(carry, s->in + cut, *carry_len);
+    s->in_len = cut;
+    return 0;
+}
+
+static int write_all(int fd, const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w; len -= (size_t)w;
+    }
+    return 0;
+}
+
+static void merge_stats(BomStats *to, const BomStats *from) {
+    to->lines += from->lines;
+    to->ok += from->ok;
+    to->no_value += from->no_value;
+    to->out_of_range += from->out_of_range;
+    to->invalid += from->invalid;
+    to->bytes_in += from->bytes_in;
+    if (from->max_dev_pct > to->max_dev_pct) to->max_dev_pct = from->max_dev_pct;
+}
+
+// Runs every line of in_fd through row, header first, in input order
+static int bom_run(int in_fd, int out_fd, const char *header, BomRowFn row, ESeries series,
+                   int n_threads, BomStats *st) {
+    memset(st, 0, sizeof(*st));
+    if (n_threads < 1) n_threads = 1;
+
+    BomJob job;
+    memset(&job, 0, sizeof(job));
+    job.row = row;
+    job.series = series;
+    job.n_slots = 2 * n_threads;
+    job.slots = calloc(job.n_slots, sizeof(BomSlot));
+    char *carry = malloc(BOM_CHUNK);
+    pthread_t *threads = malloc(n_threads * sizeof(pthread_t));
+    int rc = 0;
+    if (!job.slots || !carry || !threads) rc = BOM_ERR_MEMORY;
+    for (int i = 0; rc == 0 && i < job.n_slots; i++)
+        if (!(job.slots[i].in = malloc(BOM_CHUNK))) rc = BOM_ERR_MEMORY;
+    if (rc == 0 && write_all(out_fd, header, strlen(header)) != 0) rc = BOM_ERR_OUTPUT;
+    if (rc != 0) goto done;
+
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.work, NULL);
+    pthread_cond_init(&job.done, NULL);
+    int started = 0;
+    for (int i = 0; i < n_threads; i++, started++)
+        if (pthread_create(&threads[i], NULL, bom_worker, &job) != 0) break;
+
+    long next_fill = 0, next_write = 0;
+    size_t carry_len = 0;
+    int eof = 0;
+    while (rc == 0 && (!eof || next_write < next_fill)) {
+        while (!eof && next_fill - next_write < job.n_slots) {
+            BomSlot *s = &job.slots[next_fill % job.n_slots];
+            if (bom_fill(in_fd, s, carry, &carry_len, &eof) != 0) { rc = BOM_ERR_INPUT; break; }
+            if (s->in_len == 0) break;
+            if (!started) bom_chunk(s, row, series);    // no threads: work inline
+            pthread_mutex_lock(&job.lock);
+            s->seq = next_fill++;
+            s->state = started ? SLOT_FILLED : SLOT_DONE;
+            pthread_cond_signal(&job.work);
+            pthread_mutex_unlock(&job.lock);
+        }
+        if (rc != 0 || next_write == next_fill) continue;
+
+        BomSlot *s = &job.slots[next_write % job.n_slots];
+        pthread_mutex_lock(&job.lock);
+        while (s->state != SLOT_DONE) pthread_cond_wait(&job.done, &job.lock);
+        pthread_mutex_unlock(&job.lock);
+        if (s->failed) rc = BOM_ERR_MEMORY;
+        else if (write_all(out_fd, s->out, s->out_len) != 0) rc = BOM_ERR_OUTPUT;
+        else merge_stats(st, &s->st);
+        pthread_mutex_lock(&job.lock);
+        s->state = SLOT_FREE;
+        pthread_mutex_unlock(&job.lock);
+        next_write++;
+    }
+
+    // Workers finish whatever is still queued, then see quit
+    pthread_mutex_lock(&job.lock);
+    job.quit = 1;
+    pthread_cond_broadcast(&job.work);
+    pthread_mutex_unlock(&job.lock);
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    pthread_cond_destroy(&job.work);
+    pthread_cond_destroy(&job.done);
+    pthread_mutex_destroy(&job.lock);
+
+done:
+    for (int i = 0; job.slots && i < job.n_slots; i++) { free(job.slots[i].in); free(job.slots[i].out); }
+    free(job.slots); free(carry); free(threads);
+    return rc;
+}
+
+/**
+ * @brief Normalises the BOM read from in_fd into CSV rows on out_fd (BOM_HEADER first), in
+ *        input order, using n_threads workers (< 1 = one) and two chunk slots per worker.
+ * @return 0 on success, or BOM_ERR_INPUT / BOM_ERR_OUTPUT / BOM_ERR_MEMORY. st is filled
+ *         either way with the rows written so far.
+ */
+int bom_normalise(int in_fd, int out_fd, ESeries series, int n_threads, BomStats *st) {
+    return bom_run(in_fd, out_fd, BOM_HEADER, bom_line, series, n_threads, st);
+}
+
+/**
+ * @brief Decodes one band string per line ("Yel-Vio-Red-Gld", 3 .. 6 bands) into CSV rows
+ *        (BOM_DECODE_HEADER first), with the same pipeline and results as bom_normalise().
+ */
+int bom_decode(int in_fd, int out_fd, int n_threads, BomStats *st) {
+    return bom_run(in_fd, out_fd, BOM_DECODE_HEADER, decode_line, ESERIES_E24, n_threads, st);
+}
+
+// Opens both files for bom_run()
+static int bom_run_file(const char *in_path, const char *out_path, const char *header, BomRowFn row,
+                        ESeries series, int n_threads, BomStats *st) {
+    memset(st, 0, sizeof(*st));
+    int in = open(in_path, O_RDONLY);
+    if (in < 0) return BOM_ERR_INPUT;
+    int out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) { close(in); return BOM_ERR_OUTPUT; }
+    int rc = bom_run(in, out, header, row, series, n_threads, st);
+    close(in);
+    if (close(out) != 0 && rc == 0) rc = BOM_ERR_OUTPUT;
+    return rc;
+}
+
+/**
+ * @brief bom_normalise() between two files (the output is created or truncated).
+ * @return As bom_normalise(); BOM_ERR_INPUT / BOM_ERR_OUTPUT also when a file will not open.
+ */
+int bom_normalise_file(const char *in_path, const char *out_path, ESeries series, int n_threads,
+                       BomStats *st) {
+    return bom_run_file(in_path, out_path, BOM_HEADER, bom_line, series, n_threads, st);
+}
+
+// bom_decode() between two files
+int bom_decode_file(const char *in_path, const char *out_path, int n_threads, BomStats *st) {
+    return bom_run_file(in_path, out_path, BOM_DECODE_HEADER, decode_line, ESERIES_E24, n_threads, st);
+}
@@ -0,0 +1,51 @@
+#ifndef BOM_H
+#define BOM_H
+
+#include "eseries.h"
+
+// ============================================
+// Bulk BOM resistor normaliser
+// ============================================
+// Reads a BOM one chunk at a time, snaps every resistor value to an E-series and writes one
+// CSV row per line with its colour code. Chunks are handed to a thread pool and written back
+// in input order; memory depends on BOM_CHUNK and the thread count, not on the file size.
+//
+// Input lines: fields split by ',', ';' or tab, optionally in double quotes. With one field
+// it is the value; otherwise the first field is the reference ("R12") and the value is the
+// first later field that parses ("4k7", "4.7 kOhm", "10R"). Blank lines and lines starting
+// with '#' are skipped.
+//
+// Output: ref,value_ohm,std_ohm,dev_pct,tol_pct,bands,status
+//   status ok | no_value | range (outside Pink x0.001 .. White x1G); bands "Yellow-Violet-Red-Gold"
+//
+// bom_decode() runs the same pipeline the other way, for incoming-inspection logs: one band
+// string per line ("Yel-Vio-Red-Gld", 3 .. 6 bands, see bands.h) in, and
+//   bands,value_ohm,tol_pct,tempco_ppm,status   (status ok | bad_colour | bad_count | bad_position)
+// out.
+
+#define BOM_CHUNK (64 * 1024)   // input bytes per chunk (a longer line is split)
+#define BOM_REF_MAX 48          // reference text kept per row
+#define BOM_ROW_MAX 192         // worst-case output row
+#define BOM_HEADER "ref,value_ohm,std_ohm,dev_pct,tol_pct,bands,status\n"
+#define BOM_DECODE_HEADER "bands,value_ohm,tol_pct,tempco_ppm,status\n"
+
+// bom_normalise() / bom_decode() results
+enum { BOM_ERR_INPUT = -1, BOM_ERR_OUTPUT = -2, BOM_ERR_MEMORY = -3 };
+
+typedef struct {
+    long lines;          // data lines (blank and comment lines excluded)
+    long ok;
+    long no_value;       // no field parsed as a positive value
+    long out_of_range;   // snapped, but outside the colour-code multipliers
+    long invalid;        // band strings that did not decode (bom_decode)
+    double max_dev_pct;  // largest |value - std| / std
+    long long bytes_in;
+} BomStats;
+
+int bom_normalise(int in_fd, int out_fd, ESeries series, int n_threads, BomStats *st);
+int bom_normalise_file(const char *in_path, const char *out_path, ESeries series, int n_threads,
+                       BomStats *st);
+int bom_decode(int in_fd, int out_fd, int n_threads, BomStats *st);
+int bom_decode_file(const char *in_path, const char *out_path, int n_threads, BomStats *st);
+
+#endif
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include "chart.h"
+#include "circuits.h"
+#include "prof.h"
+
+typedef struct {
+    char *buf;
+    size_t len, cap;
+    int full;
+} Frame;
+
+static void fr_printf(Frame *f, const char *fmt, ...) {
+    if (f->full) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(f->buf + f->len, f->cap - f->len, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= f->cap - f->len) { f->full = 1; return; }
+    f->len += (size_t)n;
+}
+
+// Same precision rule as the rest of the workbench: tiny values in scientific notation
+static void fr_value(Frame *f, double v) {
+    if (fabs(v) < 0.001 && v != 0) fr_printf(f, "%.3e", v);
+    else fr_printf(f, "%8.4f", v);
+}
+
+static int bar_pos(double v, double lo, double range, int width) {
+    int pos = (int)((v - lo) / range * width);
+    if (pos < 0) pos = 0;
+    if (pos >= width) pos = width - 1;
+    return pos;
+}
+
+/**
+ * @brief Upper bound on the frame size for chart_render().
+ */
+size_t chart_frame_bound(const ChartSpec *spec, const ChartTrace *traces, int n_traces) {
+    int rows = spec->rows > 0 ? spec->rows : CHART_DEFAULT_ROWS;
+    int width = spec->width > 0 ? spec->width : CHART_DEFAULT_WIDTH;
+    size_t text = strlen(spec->title);
+    for (int t = 0; t < n_traces; t++) text += strlen(traces[t].label) + strlen(traces[t].unit);
+    size_t line = (size_t)width + 64 + 16 * (size_t)n_traces;
+    return (size_t)(rows + 8 + n_traces) * line + 2 * text;
+}
+
+/**
+ * @brief Renders traces that share one time axis into buf.
+ *
+ * Samples are split into `rows` equal time buckets. Each row draws the min..max envelope of
+ * its bucket, so a spike anywhere in the bucket always shows. Every trace is scaled to its own
+ * range (they may have different units). A single trace keeps the classic "----O" bar and
+ * prints its bucket range; overlaid traces print each bucket's peak (largest magnitude) value.
+ * @return Bytes written, or 0 on bad arguments or if the frame does not fit in cap.
+ */
+size_t chart_render(const ChartSpec *spec, const ChartTrace *traces, int n_traces, int n_samples,
+                    char *buf, size_t cap) {
+    int rows = spec->rows > 0 ? spec->rows : CHART_DEFAULT_ROWS;
+    int width = spec->width > 0 ? spec->width : CHART_DEFAULT_WIDTH;
+    if (n_traces < 1 || n_traces > CHART_MAX_TRACES || n_samples < 1) return 0;
+    if (rows > CHART_MAX_ROWS || width < CHART_MIN_WIDTH || width > CHART_MAX_WIDTH) return 0;
+    if (rows > n_samples) rows = n_samples;
+
+    // Whole-trace ranges for scaling
+    double lo[CHART_MAX_TRACES], hi[CHART_MAX_TRACES], range[CHART_MAX_TRACES];
+    for (int t = 0; t < n_traces; t++) {
+        const double *d = traces[t].data;
+        double mn = d[0], mx = d[0];
+        for (int i = 1; i < n_samples; i++) {
+            if (d[i] < mn) mn = d[i];
+            if (d[i] > mx) mx = d[i];
+        }
+        lo[t] = mn; hi[t] = mx;
+        range[t] = (fabs(mx - mn) < 1e-9) ? 1.0 : mx - mn;  // flat lines
+    }
+
+    // Time axis unit
+    double t_scale = 1.0; const char *t_unit = "s";
+    if (spec->t_total < 1e-6) { t_scale = 1e9; t_unit = "ns"; }
+    else if (spec->t_total < 1e-3) { t_scale = 1e6; t_unit = "us"; }
+    else if (spec->t_total < 1.0) { t_scale = 1e3; t_unit = "ms"; }
+
+    Frame f = { buf, 0, cap, 0 };
+    char rule[CHART_MAX_WIDTH + 3];
+    memset(rule, '-', (size_t)width + 2);
+    rule[width + 2] = '\0';
+
+    fr_printf(&f, "\n=== %s ===\n", spec->title);
+    const char *x_name = spec->x_name ? spec->x_name : spec->x_unit ? "Frequency" : "Time";
+    fr_printf(&f, " %-9.9s |%-*s| %s\n", x_name, width + 2, n_traces == 1 ? " Waveform (Min->Max)" : " Envelopes (each trace Min->Max)",
+              n_traces == 1 ? "Bucket Min .. Max" : "Bucket Peak");
+    fr_printf(&f, "-----------|%s|-----------------\n", rule);
+
+    for (int r = 0; r < rows && !f.full; r++) {
+        long i0 = (long)r * n_samples / rows, i1 = (long)(r + 1) * n_samples / rows;
+        if (spec->x_unit) {
+            double frac = n_samples > 1 ? (double)i0 / (n_samples - 1) : 0, x;   // first sample of the row
+            if (spec->x_log) x = spec->x_min * pow(spec->x_max / spec->x_min, frac);
+            else x = spec->x_min + (spec->x_max - spec->x_min) * frac;
+            char lbl[32];
+            format_eng(x, lbl);
+            fr_printf(&f, " %7s%-3s| ", lbl, spec->x_unit);
+        } else {
+            fr_printf(&f, " %6.2f %-2s | ", i0 * (spec->t_total / n_samples) * t_scale, t_unit);
+        }
+        if (f.full || f.cap - f.len < (size_t)width + 1) { f.full = 1; break; }
+
+        char *bar = f.buf + f.len;
+        memset(bar, ' ', (size_t)width);
+        double bmin[CHART_MAX_TRACES], bmax[CHART_MAX_TRACES];
+        for (int t = 0; t < n_traces; t++) {
+            const double *d = traces[t].data;
+            double mn = d[i0], mx = d[i0];
+            for (long i = i0 + 1; i < i1; i++) {
+                if (d[i] < mn) mn = d[i];
+                if (d[i] > mx) mx = d[i];
+            }
+            bmin[t] = mn; bmax[t] = mx;
+            int p0 = bar_pos(mn, lo[t], range[t], width), p1 = bar_pos(mx, lo[t], range[t], width);
+            if (n_traces == 1) memset(bar, '-', (size_t)p0);
+            memset(bar + p0, traces[t].mark, (size_t)(p1 - p0 + 1));
+        }
+        f.len += (size_t)width;
+
+        fr_printf(&f, " | ");
+        if (n_traces == 1) {
+            fr_value(&f, bmin[0]);
+            if (bmax[0] != bmin[0]) { fr_printf(&f, " .. "); fr_value(&f, bmax[0]); }
+            fr_printf(&f, " %s\n", traces[0].unit);
+        } else {
+            for (int t = 0; t < n_traces; t++) {
+                double peak = fabs(bmax[t]) > fabs(bmin[t]) ? bmax[t] : bmin[t];
+                fr_printf(&f, "%c %10.3e  ", traces[t].mark, peak);
+            }
+            fr_printf(&f, "\n");
+        }
+    }
+    fr_printf(&f, "-----------|%s|-----------------\n", rule);
+    if (n_traces == 1) {
+        fr_printf(&f, " Range: [%.4e] to [%.4e] %s\n", lo[0], hi[0], traces[0].unit);
+    } else {
+        for (int t = 0; t < n_traces; t++)
+            fr_printf(&f, " %c  %s: [%.4e] to [%.4e] %s\n", traces[t].mark, traces[t].label, lo[t], hi[t], traces[t].unit);
+    }
+    return f.full ? 0 : f.len;
+}
+
+/**
+ * @brief Renders the chart and writes it to stdout in one write().
+ * @return 0 on success, -1 on bad arguments or allocation/write failure.
+ */
+int chart_print(const ChartSpec *spec, const ChartTrace *traces, int n_traces, int n_samples) {
+    PROF_BEGIN(span);
+    size_t cap = chart_frame_bound(spec, traces, n_traces);
+    char *buf = malloc(cap);
+    if (!buf) return -1;
+    size_t len = chart_render(spec, traces, n_traces, n_samples, buf, cap);
+    int rc = len ? 0 : -1;
+
+    fflush(stdout);   // keep earlier stdio output in order
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t w = write(STDOUT_FILENO, p, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) { rc = -1; break; }
+        p += w; len -= (size_t)w;
+    }
+    free(buf);
+    PROF_END(PROF_PLOT, span);
+    return rc;
+}
@@ -0,0 +1,43 @@
+#ifndef CHART_H
+#define CHART_H
+
+// ============================================
+// Vertical strip charts: time (or another x axis) runs down the page, one row per bucket.
+// The whole frame is built in memory and written with a single write().
+// ============================================
+
+#include <stddef.h>
+
+#define CHART_DEFAULT_ROWS 25
+#define CHART_DEFAULT_WIDTH 40
+#define CHART_MIN_WIDTH 10
+#define CHART_MAX_ROWS 500
+#define CHART_MAX_WIDTH 200
+#define CHART_MAX_TRACES 8
+
+typedef struct {
+    const double *data;   // n_samples values, sample i at t = i * t_total / n_samples
+    const char *label;    // legend text, e.g. "Loop Current I(t)"
+    const char *unit;     // e.g. "A"
+    char mark;            // glyph drawn for this trace's envelope
+} ChartTrace;
+
+typedef struct {
+    const char *title;
+    double t_total;       // span of the time axis in seconds
+    int rows;             // time buckets (0 = CHART_DEFAULT_ROWS)
+    int width;            // bar columns (0 = CHART_DEFAULT_WIDTH)
+    // Optional non-time axis (used when x_unit is set): rows run x_min .. x_max,
+    // log-spaced if x_log. Labels use engineering suffixes, e.g. "1.59kHz".
+    const char *x_unit;
+    double x_min, x_max;
+    int x_log;
+    const char *x_name;   // axis heading (NULL: "Frequency" with x_unit, else "Time")
+} ChartSpec;
+
+size_t chart_frame_bound(const ChartSpec *spec, const ChartTrace *traces, int n_traces);
+size_t chart_render(const ChartSpec *spec, const ChartTrace *traces, int n_traces, int n_samples,
+                    char *buf, size_t cap);
+int chart_print(const ChartSpec *spec, const ChartTrace *traces, int n_traces, int n_samples);
+
+#endif
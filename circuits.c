@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include "circuits.h"
+
+// ============================================
+// Engineering notation
+// ============================================
+
+/**
+ * @brief Value with an SI prefix and two decimals, e.g. 4700 -> "4.70k", -0.012 -> "-12.00m".
+ *        buf must hold ENG_FMT_LEN bytes; see eng_format_fixed() for the range rules.
+ */
+void format_eng(double val, char *buf) {
+    eng_format_fixed(val, 2, buf, ENG_FMT_LEN);
+}
+
+/**
+ * @brief Parses a NUL-terminated number with an optional engineering suffix (e.g. "4.7k",
+ *        "10u", "4k7", "100nF"); see eng_parse() for the full syntax.
+ * @return ENG_OK and *out set on success, otherwise one of the ENG_* error codes.
+ */
+int parse_eng_value(const char *s, double *out) {
+    return eng_parse(s, strlen(s), out);
+}
+
+// ============================================
+// Resistors
+// ============================================
+
+// Nearest E24 value (kept for the E24 tools; see eseries.c for other series)
+double find_closest_e24_resistor(double target_r) {
+    return eseries_nearest(ESERIES_E24, target_r);
+}
+
+/**
+ * @brief Colour code for a value of the given series, with the series tolerance band: 3 bands
+ *        for E6 (20%), 4 for E12/E24, 5 (three digits) for E48 .. E192.
+ * @return BANDS_OK, or BANDS_ERR_RANGE outside Pink x0.001 .. White x1G.
+ */
+int resistor_code(double r_std, ESeries series, BandCode *out) {
+    int n = series == ESERIES_E6 ? 3 : series <= ESERIES_E24 ? 4 : 5;
+    return bands_encode(r_std, n, eseries_tolerance_pct(series), 0, out);
+}
+
+// ============================================
+// Small circuit designs
+// ============================================
+
+double divider_vout(double vin, double r1, double r2) {
+    if ((r1 + r2) == 0) return 0.0;
+    return vin * (r2 / (r1 + r2));
+}
+
+/**
+ * @brief LED series resistor design with automatic standard-value selection.
+ * @return 0 on success, -1 if Vf >= Vs, -2 if the target current is not positive.
+ */
+int led_design(double vs, double vf, double target_i, ESeries series, LedDesign *out) {
+    if (vf >= vs) return -1;
+    if (target_i <= 0) return -2;
+
+    out->r_ideal = (vs - vf) / target_i;
+    out->r_std = eseries_nearest(series, out->r_ideal);
+    out->i_actual = (vs - vf) / out->r_std;
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef CIRCUITS_H
+#define CIRCUITS_H
+
+// ============================================
+// Calculation cores shared by the interactive menu and batch mode.
+// Nothing in here prompts or prints.
+// ============================================
+
+#include "eseries.h"
+#include "engparse.h"
+#include "engfmt.h"
+#include "bands.h"
+
+typedef struct {
+    double r_ideal;   // exact (Vs - Vf) / I
+    double r_std;     // nearest value in the chosen series
+    double i_actual;  // current with the standard value
+} LedDesign;
+
+void format_eng(double val, char *buf);
+int parse_eng_value(const char *s, double *out);
+
+double find_closest_e24_resistor(double target_r);
+int resistor_code(double r_std, ESeries series, BandCode *out);
+
+double divider_vout(double vin, double r1, double r2);
+int led_design(double vs, double vf, double target_i, ESeries series, LedDesign *out);
+
+#endif
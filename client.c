@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// ============================================
+// Client for the calculation server (main.out --serve SOCKET)
+//   ./client.out SOCKET                 stand-in: commands from stdin, responses on stdout
+//   ./client.out SOCKET --load [...]    load generator: requests/s and latency percentiles
+// Both pipeline: requests are written as fast as the socket takes them and the responses are
+// read as they come, matched up by their line=<n>.
+// ============================================
+
+#define CLIENT_BUF (64 * 1024)
+#define CLIENT_LINE_LEN 1024        // longest response line kept (longer ones are cut)
+#define CLIENT_CONNECT_TRIES 50     // 100 ms apart, for a server that is still starting
+#define LOAD_MAX_CLIENTS 1000
+#define LOAD_REQ_MAX 96            // longest generated request
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int connect_to(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path '%s' is too long.\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    for (int tries = 0; ; tries++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) { perror("socket"); return -1; }
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) return fd;
+        int err = errno;
+        close(fd);
+        if ((err != ENOENT && err != ECONNREFUSED && err != EAGAIN) || tries + 1 >= CLIENT_CONNECT_TRIES) {
+            fprintf(stderr, "Cannot connect to '%s': %s\n", path, strerror(err));
+            return -1;
+        }
+        struct timespec pause = { 0, 100000000L };
+        nanosleep(&pause, NULL);
+    }
+}
+
+// Splits incoming bytes into lines across reads
+typedef struct {
+    char line[CLIENT_LINE_LEN];
+    size_t len;
+} LineBuf;
+
+// Feeds n bytes; calls fn(line, ctx) for each complete line (newline removed)
+static void lines_feed(LineBuf *lb, const char *p, size_t n, void (*fn)(const char *, void *), void *ctx) {
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] == '\n') {
+            lb->line[lb->len] = '\0';
+            fn(lb->line, ctx);
+            lb->len = 0;
+        } else if (lb->len < CLIENT_LINE_LEN - 1) {
+            lb->line[lb->len++] = p[i];
+        }
+    }
+}
+
+// Writes all of buf to fd (blocking)
+static int write_all(int fd, const char *buf, size_t n) {
+    while (n) {
+        ssize_t w = write(fd, buf, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        buf += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+// ============================================
+// Stand-in: stdin -> server -> stdout
+// ============================================
+
+static void count_error(const char *line, void *ctx) {
+    if (strstr(line, " error=\"")) (*(long *)ctx)++;
+}
+
+// Exit status 1 if any response was an error, as with main.out --batch
+static int run_pipe(int fd) {
+    static char to_send[CLIENT_BUF], buf[CLIENT_BUF];
+    size_t send_off = 0, send_len = 0;
+    int stdin_open = 1;
+    long errors = 0;
+    LineBuf lb = { .len = 0 };
+
+    for (;;) {
+        // Read more of stdin only once the last block has gone out
+        struct pollfd pf[2] = {
+            { fd, POLLIN | (send_len > send_off ? POLLOUT : 0), 0 },
+            { 0, POLLIN, 0 }
+        };
+        int n_pf = stdin_open && send_len == send_off ? 2 : 1;
+        if (poll(pf, n_pf, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            return 1;
+        }
+        if (n_pf == 2 && pf[1].revents) {
+            ssize_t n = read(0, to_send, sizeof(to_send));
+            if (n > 0) { send_off = 0; send_len = (size_t)n; }
+            else if (n == 0 || errno != EINTR) { stdin_open = 0; shutdown(fd, SHUT_WR); }
+        }
+        if (pf[0].revents & POLLOUT) {
+            ssize_t n = send(fd, to_send + send_off, send_len - send_off, MSG_NOSIGNAL);
+            if (n < 0 && errno != EINTR && errno != EAGAIN) { perror("send"); return 1; }
+            if (n > 0) send_off += (size_t)n;
+        }
+        if (pf[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;      // server closed: every response is in
+            if (write_all(1, buf, (size_t)n) != 0) return 1;
+            lines_feed(&lb, buf, (size_t)n, count_error, &errors);
+        }
+    }
+    return errors ? 1 : 0;
+}
+
+// ============================================
+// Load generator
+// ============================================
+
+typedef struct {
+    int fd;
+    long sent, received;
+    double *t_sent;                 // per request, by line number - 1
+    unsigned char *heavy;           // per request
+    char out[CLIENT_BUF];
+    size_t out_off, out_len;
+    LineBuf lb;
+} LoadConn;
+
+typedef struct {
+    double *lat[2];                 // cheap, heavy latencies (ns)
+    long n_lat[2];
+    long errors, bad;               // error responses; responses that match no request
+    LoadConn *conn;                 // connection being read
+} LoadRun;
+
+static unsigned long long g_rng = 0x9E3779B97F4A7C15ULL;
+
+static unsigned long long rng_next(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+// The k-th request of a connection: a rotation of cheap tools with varying values, or a
+// 10000-step RLC transient
+static int make_request(char *buf, size_t cap, long k, int heavy) {
+    double v = 1 + (double)(k % 97);
+    if (heavy) return snprintf(buf, cap, "rlc type=rlc vs=%g r=10 l=1m c=1u t=2m\n", v);
+    switch (k % 5) {
+        case 0: return snprintf(buf, cap, "ohm v=%g r=%gk\n", v, 1 + (double)(k % 13));
+        case 1: return snprintf(buf, cap, "divider vin=%g r1=10k r2=%gk\n", v, 1 + (double)(k % 47));
+        case 2: return snprintf(buf, cap, "led vs=%g vf=2 i=10m\n", v + 2);
+        case 3: return snprintf(buf, cap, "encode r=%gk series=E96\n", v);
+        default: return snprintf(buf, cap, "decode bands=Yel-Vio-Red-Gld\n");
+    }
+}
+
+static void on_response(const char *line, void *ctx) {
+    LoadRun *run = ctx;
+    LoadConn *c = run->conn;
+    long n;
+    if (sscanf(line, "line=%ld", &n) != 1 || n < 1 || n > c->sent) { run->bad++; return; }
+    int h = c->heavy[n - 1];
+    run->lat[h][run->n_lat[h]++] = now_ns() - c->t_sent[n - 1];
+    if (strstr(line, " error=\"")) run->errors++;
+    c->received++;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *v, long n, double p) {
+    if (n == 0) return 0;
+    long i = (long)(p * (n - 1) + 0.5);
+    return v[i];
+}
+
+static void format_ns(double ns, char *buf, size_t cap) {
+    if (ns < 1e3) snprintf(buf, cap, "%.0f ns", ns);
+    else if (ns < 1e6) snprintf(buf, cap, "%.1f us", ns / 1e3);
+    else if (ns < 1e9) snprintf(buf, cap, "%.2f ms", ns / 1e6);
+    else snprintf(buf, cap, "%.2f s", ns / 1e9);
+}
+
+static void print_latency(const char *name, double *v, long n) {
+    static const double LEVELS[] = { 0.50, 0.90, 0.99, 0.999 };
+    if (n == 0) return;
+    qsort(v, (size_t)n, sizeof(double), cmp_double);
+    char s[24];
+    printf("%-8s %9ld", name, n);
+    for (int k = 0; k < 4; k++) {
+        format_ns(percentile(v, n, LEVELS[k]), s, sizeof(s));
+        printf(" %10s", s);
+    }
+    format_ns(v[n - 1], s, sizeof(s));
+    printf(" %10s\n", s);
+}
+
+static int run_load(const char *path, int n_clients, long n_requests, int depth, double heavy_pct) {
+    LoadConn *conns = calloc((size_t)n_clients, sizeof(LoadConn));
+    struct pollfd *pf = calloc((size_t)n_clients, sizeof(struct pollfd));
+    long total = (long)n_clients * n_requests;
+    LoadRun run = { { malloc(total * sizeof(double)), malloc(total * sizeof(double)) }, { 0, 0 }, 0, 0, NULL };
+    int rc = 1;
+    if (!conns || !pf || !run.lat[0] || !run.lat[1]) { fprintf(stderr, "Out of memory.\n"); goto done; }
+
+    for (int i = 0; i < n_clients; i++) conns[i].fd = -1;
+    for (int i = 0; i < n_clients; i++) {
+        LoadConn *c = &conns[i];
+        c->t_sent = malloc(n_requests * sizeof(double));
+        c->heavy = malloc((size_t)n_requests);
+        if (!c->t_sent || !c->heavy) { fprintf(stderr, "Out of memory.\n"); goto done; }
+        for (long k = 0; k < n_requests; k++) c->heavy[k] = (rng_next() % 100000) < heavy_pct * 1000;
+        if ((c->fd = connect_to(path)) < 0) goto done;
+    }
+
+    double t0 = now_ns();
+    long finished = 0;
+    while (finished < n_clients) {
+        // Top every connection up to `depth` requests in flight
+        for (int i = 0; i < n_clients; i++) {
+            LoadConn *c = &conns[i];
+            while (c->sent < n_requests && c->sent - c->received < depth &&
+                   c->out_len + LOAD_REQ_MAX <= sizeof(c->out)) {
+                int n = make_request(c->out + c->out_len, LOAD_REQ_MAX, c->sent, c->heavy[c->sent]);
+                c->out_len += (size_t)n;
+                c->t_sent[c->sent++] = now_ns();
+            }
+            if (c->out_len > c->out_off) {
+                ssize_t n = send(c->fd, c->out + c->out_off, c->out_len - c->out_off,
+                                 MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (n > 0) c->out_off += (size_t)n;
+                else if (n < 0 && errno != EAGAIN && errno != EINTR) { perror("send"); goto done; }
+                if (c->out_off == c->out_len) c->out_off = c->out_len = 0;
+            }
+            pf[i].fd = c->received < n_requests ? c->fd : -1;
+            pf[i].events = POLLIN | (c->out_len > c->out_off ? POLLOUT : 0);
+            pf[i].revents = 0;
+        }
+        if (poll(pf, (nfds_t)n_clients, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            goto done;
+        }
+        for (int i = 0; i < n_clients; i++) {
+            LoadConn *c = &conns[i];
+            if (!(pf[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            char buf[CLIENT_BUF];
+            ssize_t n = read(c->fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) { fprintf(stderr, "Server closed connection %d early.\n", i); goto done; }
+            run.conn = c;
+            lines_feed(&c->lb, buf, (size_t)n, on_response, &run);
+            if (c->received == n_requests) finished++;
+        }
+    }
+    double secs = (now_ns() - t0) * 1e-9;
+
+    printf("%d clients x %ld requests, pipeline depth %d, %.3g%% heavy (rlc)\n",
+           n_clients, n_requests, depth, heavy_pct);
+    printf("%ld requests in %.3f s: %.0f requests/s, %ld errors\n\n", total, secs, total / secs, run.errors);
+    printf("%-8s %9s %10s %10s %10s %10s %10s\n", "class", "count", "p50", "p90", "p99", "p99.9", "max");
+    print_latency("cheap", run.lat[0], run.n_lat[0]);
+    print_latency("heavy", run.lat[1], run.n_lat[1]);
+    rc = run.errors || run.bad ? 1 : 0;
+
+done:
+    for (int i = 0; conns && i < n_clients; i++) {
+        if (conns[i].fd >= 0) close(conns[i].fd);
+        free(conns[i].t_sent);
+        free(conns[i].heavy);
+    }
+    free(conns);
+    free(pf);
+    free(run.lat[0]);
+    free(run.lat[1]);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    // Options (load mode): --clients N    connections (default 16)
+    //                      --requests M   requests per connection (default 10000)
+    //                      --depth D      requests in flight per connection (default 8)
+    //                      --heavy P      percent of requests that are RLC transients (default 1)
+    if (argc < 2 || strncmp(argv[1], "--", 2) == 0) goto usage;
+    const char *path = argv[1];
+    int load = 0, n_clients = 16, depth = 8;
+    long n_requests = 10000;
+    double heavy_pct = 1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--load") == 0) load = 1;
+        else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) n_clients = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc) n_requests = atol(argv[++i]);
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--heavy") == 0 && i + 1 < argc) heavy_pct = atof(argv[++i]);
+        else goto usage;
+    }
+    if (n_clients < 1 || n_clients > LOAD_MAX_CLIENTS || n_requests < 1 || depth < 1 ||
+        heavy_pct < 0 || heavy_pct > 100) {
+        fprintf(stderr, "Need 1-%d clients, at least 1 request and depth 1, heavy 0-100.\n", LOAD_MAX_CLIENTS);
+        return 2;
+    }
+
+    if (load) return run_load(path, n_clients, n_requests, depth, heavy_pct);
+    int fd = connect_to(path);
+    if (fd < 0) return 1;
+    int rc = run_pipe(fd);
+    close(fd);
+    return rc;
+
+usage:
+    fprintf(stderr, "Usage: %s SOCKET                 (commands on stdin)\n"
+                    "       %s SOCKET --load [--clients N] [--requests M] [--depth D] [--heavy P]\n",
+            argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "engfmt.h"
+
+#define MAX_SIG ENG_FMT_MAX_DIGITS
+#define MIN_GROUP -4        // p
+#define MAX_GROUP 4         // T
+
+static const char PREFIX[] = "pnum kMGT";   // groups -4 .. 4; ' ' = none
+
+static const double POW10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t IPOW10[MAX_SIG + 1] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL
+};
+
+// ============================================
+// Digit generation
+// ============================================
+
+// a * 10^s, a single correctly rounded operation when |s| <= 22
+static double mul_pow10(double a, int s) {
+    while (s > 22) { a *= 1e22; s -= 22; }
+    while (s < -22) { a /= 1e22; s += 22; }
+    return s >= 0 ? a * POW10[s] : a / POW10[-s];
+}
+
+// floor(log10(a)) for finite a > 0, from the binary exponent plus one correction
+static int floor_log10(double a) {
+    int b;
+    frexp(a, &b);
+    int e = (int)floor((b - 1) * 0.30102999566398120);  // never too high, at most one low
+    if (mul_pow10(a, -(e + 1)) >= 1.0) e++;
+    return e;
+}
+
+// a * 10^s rounded to an integer the way printf rounds the exact decimal value. The product
+// (or quotient) is one correctly rounded operation, so it can only land on the wrong side of a
+// .5 when it lands exactly on it; fma() then gives the sign of the rounding error, and a true
+// tie goes to even. Returns -1 when one operation is not enough (|s| > 22 or >= 2^53).
+static int round_scaled(double a, int s, uint64_t *out) {
+    if (s > 22 || s < -22) return -1;
+    double p = s >= 0 ? a * POW10[s] : a / POW10[-s];
+    if (p >= 9007199254740992.0) return -1;
+    double f = floor(p), frac = p - f;
+    uint64_t d = (uint64_t)f;
+    if (frac > 0.5) {
+        d++;
+    } else if (frac == 0.5) {
+        double err = s >= 0 ? fma(a, POW10[s], -p) : fma(-p, POW10[-s], a);
+        if (err > 0 || (err == 0 && (d & 1))) d++;
+    }
+    *out = d;
+    return 0;
+}
+
+// Exact fallback through printf for what round_scaled() cannot do
+static int decompose_slow(double a, int sig, uint64_t *digits) {
+    char s[48];
+    snprintf(s, sizeof(s), "%.*e", sig - 1, a);
+    uint64_t d = 0;
+    const char *p = s;
+    for (; *p && *p != 'e'; p++) if (*p != '.') d = d * 10 + (uint64_t)(*p - '0');
+    *digits = d;
+    return atoi(p + 1);
+}
+
+// Rounds finite a > 0 to sig significant digits: a ~= *digits * 10^(e - sig + 1) with
+// 10^(sig-1) <= *digits < 10^sig. e is floor(log10(a)) or one less; returns the exponent of
+// the leading digit after rounding.
+static int decompose(double a, int sig, int e, uint64_t *digits) {
+    uint64_t d;
+    if (round_scaled(a, sig - 1 - e, &d) != 0) return decompose_slow(a, sig, digits);
+    if (d > IPOW10[sig]) {                      // e was one low
+        e++;
+        if (round_scaled(a, sig - 1 - e, &d) != 0) return decompose_slow(a, sig, digits);
+    }
+    if (d == IPOW10[sig]) { d /= 10; e++; }     // 9.99.. rounded up to 10.0..
+    *digits = d;
+    return e;
+}
+
+static int floor_div3(int e) {
+    return e >= 0 ? e / 3 : -((2 - e) / 3);
+}
+
+// Writes exactly n digits of d (leading zeros kept)
+static char *put_digits(char *p, uint64_t d, int n) {
+    for (int i = n - 1; i >= 0; i--) { p[i] = (char)('0' + d % 10); d /= 10; }
+    return p + n;
+}
+
+// sig digits of d with the point after the first intd of them (intd may exceed sig: zeros
+// are appended; intd <= 0: "0.000ddd")
+static char *put_fixed(char *p, uint64_t d, int sig, int intd) {
+    if (intd <= 0) {
+        *p++ = '0'; *p++ = '.';
+        for (int i = 0; i < -intd; i++) *p++ = '0';
+        return put_digits(p, d, sig);
+    }
+    if (intd >= sig) {
+        p = put_digits(p, d, sig);
+        for (int i = sig; i < intd; i++) *p++ = '0';
+        return p;
+    }
+    p = put_digits(p, d / IPOW10[sig - intd], intd);
+    *p++ = '.';
+    return put_digits(p, d % IPOW10[sig - intd], sig - intd);
+}
+
+// Copies the finished text out if it fits. Returns its length, or -1 ("" written) if not.
+static int finish(const char *tmp, const char *end, char *buf, size_t cap) {
+    size_t n = (size_t)(end - tmp);
+    if (n + 1 > cap) {
+        if (cap) buf[0] = '\0';
+        return -1;
+    }
+    memcpy(buf, tmp, n);
+    buf[n] = '\0';
+    return (int)n;
+}
+
+// nan / inf / 0, which never reach the digit code. Returns NULL for ordinary values.
+static char *put_special(char *p, double v) {
+    if (isnan(v)) { memcpy(p, "nan", 3); return p + 3; }
+    if (isinf(v)) {
+        if (v < 0) *p++ = '-';
+        memcpy(p, "inf", 3);
+        return p + 3;
+    }
+    if (v == 0) { *p++ = '0'; return p; }
+    return NULL;
+}
+
+// ============================================
+// Styles
+// ============================================
+
+/**
+ * @brief Printf-style "%.*g": fixed notation for exponents -4 .. sig-1, otherwise d.ddde+XX,
+ *        trailing zeros removed.
+ * @return Length written, or -1 if it does not fit in cap (buf set to "").
+ */
+int eng_format_g(double v, int sig, char *buf, size_t cap) {
+    char tmp[ENG_FMT_LEN + 8], *p = tmp, *q;
+    if (sig < 1) sig = 1;
+    if (sig > MAX_SIG) sig = MAX_SIG;
+    if (v != 0 && signbit(v) && !isnan(v)) { *p++ = '-'; v = -v; }
+    if ((q = put_special(p, v))) return finish(tmp, q, buf, cap);
+
+    uint64_t d;
+    int e = decompose(v, sig, floor_log10(v), &d);
+    // Trailing zeros carry no information in %g
+    int keep = sig;
+    while (keep > 1 && d % 10 == 0) { d /= 10; keep--; }
+
+    if (e < -4 || e >= sig) {
+        p = put_fixed(p, d, keep, 1);
+        *p++ = 'e';
+        *p++ = e < 0 ? '-' : '+';
+        int ae = e < 0 ? -e : e;
+        p = put_digits(p, (uint64_t)ae, ae >= 100 ? 3 : 2);
+    } else {
+        p = put_fixed(p, d, keep, e + 1);
+    }
+    return finish(tmp, p, buf, cap);
+}
+
+/**
+ * @brief Value with sig significant digits and an SI prefix p .. T, e.g. 4700 -> "4.70k" (sig 3),
+ *        -0.012 -> "-12.0m". Outside 1p .. 1000T falls back to eng_format_g().
+ * @return Length written, or -1 if it does not fit in cap (buf set to "").
+ */
+int eng_format(double v, int sig, char *buf, size_t cap) {
+    char tmp[ENG_FMT_LEN + 8], *p = tmp, *q;
+    if (sig < 1) sig = 1;
+    if (sig > MAX_SIG) sig = MAX_SIG;
+    if ((q = put_special(p, v))) return finish(tmp, q, buf, cap);
+    double a = fabs(v);
+    uint64_t d;
+    int e = decompose(a, sig, floor_log10(a), &d);
+    int g = floor_div3(e);
+    if (g < MIN_GROUP || g > MAX_GROUP) return eng_format_g(v, sig, buf, cap);
+
+    if (v < 0) *p++ = '-';
+    p = put_fixed(p, d, sig, e - 3 * g + 1);
+    if (g) *p++ = PREFIX[g - MIN_GROUP];
+    return finish(tmp, p, buf, cap);
+}
+
+/**
+ * @brief Fixed decimals after an SI prefix p .. T, the look of format_eng(): 4700 -> "4.70k",
+ *        470 -> "470.00" (decimals 2). The prefix is picked after rounding, so 999.999 -> "1.00k".
+ *        Above 1000T the integer part grows; below 1p falls back to eng_format_g().
+ * @return Length written, or -1 if it does not fit in cap (buf set to "").
+ */
+int eng_format_fixed(double v, int decimals, char *buf, size_t cap) {
+    char tmp[ENG_FMT_LEN + 8], *p = tmp, *q;
+    if (decimals < 0) decimals = 0;
+    if ((q = put_special(p, v))) return finish(tmp, q, buf, cap);
+    double a = fabs(v);
+    int e = floor_log10(a), g = 0, sig = 0;
+    uint64_t d = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        g = floor_div3(e);
+        if (g > MAX_GROUP) g = MAX_GROUP;
+        sig = e - 3 * g + 1 + decimals;
+        if (g < MIN_GROUP || sig > MAX_SIG) return eng_format_g(v, decimals + 3, buf, cap);
+        int e2 = decompose(a, sig, e, &d);
+        if (e2 == e) break;
+        e = e2;     // rounding carried into the next digit; re-pick the prefix
+    }
+
+    if (v < 0) *p++ = '-';
+    p = put_fixed(p, d, sig, sig - decimals);
+    if (g) *p++ = PREFIX[g - MIN_GROUP];
+    return finish(tmp, p, buf, cap);
+}
+
+/**
+ * @brief Formats n values into one contiguous buffer, separated by sep (no trailing separator),
+ *        NUL-terminated. Stops before the first value that would not fit.
+ * @param style ENG_FMT_SI / ENG_FMT_FIXED / ENG_FMT_G; digits is sig digits or decimals.
+ * @param n_done Receives the number of values written (may be NULL).
+ * @return Bytes written, NUL excluded.
+ */
+size_t eng_format_many(const double *v, long n, int style, int digits, char sep,
+                       char *buf, size_t cap, long *n_done) {
+    int (*fmt)(double, int, char *, size_t) =
+        style == ENG_FMT_G ? eng_format_g : style == ENG_FMT_FIXED ? eng_format_fixed : eng_format;
+    size_t len = 0;
+    long i = 0;
+    if (cap) buf[0] = '\0';
+    for (; i < n; i++) {
+        size_t at = len + (i > 0);      // leave room for the separator
+        if (at >= cap) break;
+        int w = fmt(v[i], digits, buf + at, cap - at);
+        if (w < 0) { buf[len] = '\0'; break; }
+        if (i > 0) buf[len] = sep;
+        len = at + (size_t)w;
+    }
+    if (n_done) *n_done = i;
+    return len;
+}
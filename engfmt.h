@@ -0,0 +1,29 @@
+#ifndef ENGFMT_H
+#define ENGFMT_H
+
+// ============================================
+// Engineering-notation formatter (the output side of engparse.c).
+// Bounded (never writes more than cap bytes), no heap, no printf on the common path.
+// Digits come from one scaled multiply and a 64-bit integer, rounded exactly like printf
+// (ties to even); only beyond 15-16 digits or far outside p .. T does it fall back to printf.
+// ============================================
+
+#include <stddef.h>
+
+#define ENG_FMT_LEN 32      // room for any single value in every style, NUL included
+#define ENG_FMT_MAX_DIGITS 17
+
+// Styles for eng_format_many()
+enum {
+    ENG_FMT_SI = 0,     // significant digits + SI prefix: "4.70k", "-12.0m", "470"
+    ENG_FMT_FIXED,      // fixed decimals + SI prefix (format_eng's look): "4.70k", "470.00"
+    ENG_FMT_G           // same text as printf("%.*g"): "4700", "1.5e-07"; for CSV and reports
+};
+
+int eng_format(double v, int sig, char *buf, size_t cap);
+int eng_format_fixed(double v, int decimals, char *buf, size_t cap);
+int eng_format_g(double v, int sig, char *buf, size_t cap);
+size_t eng_format_many(const double *v, long n, int style, int digits, char sep,
+                       char *buf, size_t cap, long *n_done);
+
+#endif
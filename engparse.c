@@ -0,0 +1,183 @@
+#include <math.h>
+#include <stdint.h>
+#include "engparse.h"
+
+#define NO_MULT 127
+#define MAX_DIGITS 19       // significant digits kept; 10^19 - 1 still fits in 64 bits
+#define MAX_EXP 5000        // exponents beyond this are over/underflow anyway
+
+// Exact powers of ten: a mantissa below 2^53 times one of these is correctly rounded
+static const double POW10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Character classes; the separators are the ones eng_parse_list() splits on
+enum { C_DIGIT = 1, C_SPACE = 2, C_SEP = 4, C_ALPHA = 8 };
+static const unsigned char CLASS[256] = {
+    ['0' ... '9'] = C_DIGIT,
+    [' '] = C_SPACE | C_SEP, ['\t' ... '\r'] = C_SPACE | C_SEP, [','] = C_SEP, [';'] = C_SEP,
+    ['a' ... 'z'] = C_ALPHA, ['A' ... 'Z'] = C_ALPHA
+};
+#define IS(c, cls) (CLASS[(unsigned char)(c)] & (cls))
+#define lower(c) ((char)((c) | 0x20))
+
+// Multiplier at p: its power of ten (NO_MULT if none) and its length in bytes
+static int mult_at(const char *p, const char *end, int *width) {
+    *width = 1;
+    switch (*p) {
+        case 'p': return -12;
+        case 'n': return -9;
+        case 'u': return -6;
+        case 'm': return -3;
+        case 'R': case 'r': return 0;
+        case 'k': case 'K': return 3;
+        case 'M': return 6;
+        case 'G': return 9;
+        case 'T': return 12;
+        default: break;
+    }
+    // Micro sign U+00B5 and Greek mu U+03BC in UTF-8
+    if (end - p >= 2 && (((unsigned char)p[0] == 0xC2 && (unsigned char)p[1] == 0xB5) ||
+                         ((unsigned char)p[0] == 0xCE && (unsigned char)p[1] == 0xBC))) {
+        *width = 2;
+        return -6;
+    }
+    return NO_MULT;
+}
+
+// Unit after the multiplier: a known word in any case, or an ohm sign. Returns its length, -1 if unknown.
+static int unit_len(const char *p, const char *end) {
+    static const char *UNITS[] = { "f", "h", "v", "a", "w", "s", "hz", "ohm", "ohms" };
+    const unsigned char *u = (const unsigned char *)p;
+    if (end - p >= 2 && u[0] == 0xCE && u[1] == 0xA9) return 2;                  // Greek omega
+    if (end - p >= 3 && u[0] == 0xE2 && u[1] == 0x84 && u[2] == 0xA6) return 3;  // ohm sign
+    int n = 0;
+    while (p + n < end && IS(p[n], C_ALPHA)) n++;
+    if (n == 0) return 0;
+    for (int k = 0; k < (int)(sizeof(UNITS) / sizeof(UNITS[0])); k++) {
+        const char *w = UNITS[k];
+        int i = 0;
+        while (i < n && w[i] && lower(p[i]) == w[i]) i++;
+        if (i == n && w[i] == '\0') return n;
+    }
+    return -1;
+}
+
+// mant * 10^e10. Exact (one correctly rounded operation) for the usual short inputs; otherwise
+// scaled in long double, which is at most an ulp away.
+static double scale10(uint64_t mant, int e10) {
+    if (mant == 0) return 0.0;
+    if (mant <= (1ULL << 53) && e10 >= -22 && e10 <= 22)
+        return e10 >= 0 ? (double)mant * POW10[e10] : (double)mant / POW10[-e10];
+    long double r = (long double)mant;
+    while (e10 > 22) { r *= 1e22L; e10 -= 22; }
+    while (e10 < -22) { r /= 1e22L; e10 += 22; }
+    return (double)(e10 >= 0 ? r * POW10[e10] : r / POW10[-e10]);
+}
+
+// Parses one value starting at *pp and leaves *pp where it stopped. In list mode a separator
+// ends the token, so there is no whitespace between the number and its suffix.
+static int parse_value(const char **pp, const char *end, int list, double *out) {
+    const char *p = *pp;
+    int neg = 0;
+    if (p < end && (*p == '+' || *p == '-')) { neg = (*p == '-'); p++; }
+
+    uint64_t mant = 0;
+    int nd = 0, e10 = 0, digits = 0, mult = NO_MULT, w;
+    for (; p < end && IS(*p, C_DIGIT); p++, digits++) {
+        if (nd < MAX_DIGITS) { mant = mant * 10 + (uint64_t)(*p - '0'); nd += (mant != 0); }
+        else e10++;
+    }
+    int frac = 0;
+    if (p < end && *p == '.') {
+        p++;
+        frac = 1;
+    } else if (p < end && (digits || *p == 'R' || *p == 'r')) {
+        // RKM: "4k7", "2R2", "R47" - the multiplier stands in for the decimal point
+        int m = mult_at(p, end, &w);
+        if (m != NO_MULT && p + w < end && IS(p[w], C_DIGIT)) { mult = m; p += w; frac = 1; }
+    }
+    if (frac) {
+        for (; p < end && IS(*p, C_DIGIT); p++, digits++) {
+            if (nd < MAX_DIGITS) { mant = mant * 10 + (uint64_t)(*p - '0'); nd += (mant != 0); e10--; }
+        }
+    }
+    *pp = p;
+    if (digits == 0) return ENG_INVALID;
+
+    // Exponent, only when digits follow ("1e3", "2.5E-6"); not with RKM codes
+    if (mult == NO_MULT && p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int eneg = 0, ev = 0;
+        if (q < end && (*q == '+' || *q == '-')) { eneg = (*q == '-'); q++; }
+        if (q < end && IS(*q, C_DIGIT)) {
+            for (; q < end && IS(*q, C_DIGIT); q++) if (ev < MAX_EXP) ev = ev * 10 + (*q - '0');
+            e10 += eneg ? -ev : ev;
+            p = q;
+        }
+    }
+
+    if (!list) while (p < end && IS(*p, C_SPACE)) p++;
+    if (mult == NO_MULT && p < end && !IS(*p, C_SEP)) {
+        if (end - p >= 3 && lower(p[0]) == 'm' && lower(p[1]) == 'e' && lower(p[2]) == 'g') {
+            mult = 6; p += 3;
+        } else {
+            int m = mult_at(p, end, &w);
+            if (m != NO_MULT) { mult = m; p += w; }
+        }
+    }
+    if (p < end && !IS(*p, C_SEP)) {
+        int u = unit_len(p, end);
+        if (u < 0) return ENG_BAD_SUFFIX;
+        p += u;
+    }
+    *pp = p;
+
+    double v = scale10(mant, e10 + (mult == NO_MULT ? 0 : mult));
+    if (isinf(v)) return ENG_INVALID;
+    *out = neg ? -v : v;
+    return ENG_OK;
+}
+
+/**
+ * @brief Parses exactly one value spanning s[0 .. len), surrounding whitespace allowed.
+ *        Whitespace may also separate the number from its multiplier/unit ("100 nF").
+ * @return ENG_OK with *out set, otherwise an ENG_* error code (*out untouched).
+ */
+int eng_parse(const char *s, size_t len, double *out) {
+    const char *p = s, *end = s + len;
+    while (p < end && IS(*p, C_SPACE)) p++;
+    if (p == end) return ENG_EMPTY;
+    double v;
+    int rc = parse_value(&p, end, 0, &v);
+    if (rc != ENG_OK) return rc;
+    while (p < end && IS(*p, C_SPACE)) p++;
+    if (p != end) return ENG_TRAILING;
+    *out = v;
+    return ENG_OK;
+}
+
+/**
+ * @brief Parses a whole buffer of values separated by whitespace, ',' or ';'.
+ *        A token that does not parse is stored as NAN and counted, so output stays aligned
+ *        with the input.
+ * @param n_bad Receives the number of bad tokens (may be NULL).
+ * @return Number of values written (stops early when max_out is reached).
+ */
+long eng_parse_list(const char *buf, size_t len, double *out, long max_out, long *n_bad) {
+    const char *p = buf, *end = buf + len;
+    long n = 0, bad = 0;
+    while (n < max_out) {
+        while (p < end && IS(*p, C_SEP)) p++;
+        if (p == end) break;
+        if (parse_value(&p, end, 1, &out[n]) != ENG_OK || (p < end && !IS(*p, C_SEP))) {
+            out[n] = NAN;
+            bad++;
+            while (p < end && !IS(*p, C_SEP)) p++;
+        }
+        n++;
+    }
+    if (n_bad) *n_bad = bad;
+    return n;
+}
@@ -0,0 +1,28 @@
+#ifndef ENGPARSE_H
+#define ENGPARSE_H
+
+// ============================================
+// Engineering-notation parser for typed input, BOMs and netlists.
+// Locale-independent (always '.'), never allocates, works on length-delimited buffers.
+//   plain / exponent   "2200", "-1.5e-3", ".47"
+//   multiplier         p n u (or µ) m k K M G T, and SPICE "meg"      "4.7k", "10meg"
+//   RKM code           multiplier in place of the point, R = x1      "4k7", "2R2", "R47", "1M5"
+//   unit               F H V A W s Hz Ohm(s) Ω, any case, optional  "100nF", "4.7 kOhm", "2u2H"
+// Like the rest of the workbench, "m" is milli and "M" is mega.
+// ============================================
+
+#include <stddef.h>
+
+// Result codes (also returned by parse_eng_value)
+enum {
+    ENG_OK = 0,
+    ENG_EMPTY,        // only whitespace
+    ENG_INVALID,      // no leading number, or out of double range
+    ENG_BAD_SUFFIX,   // unknown multiplier / unit letters
+    ENG_TRAILING      // characters after the suffix
+};
+
+int eng_parse(const char *s, size_t len, double *out);
+long eng_parse_list(const char *buf, size_t len, double *out, long max_out, long *n_bad);
+
+#endif
@@ -0,0 +1,165 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "eseries.h"
+
+// ============================================
+// CONSTANTS & DEFINITIONS
+// ============================================
+// E24 (and its E12/E6 subsets) has historical values that don't follow the
+// 10^(i/24) rule, so it is listed explicitly. Codes are value x 10.
+static const unsigned char E24_CODES[24] = {
+    10, 11, 12, 13, 15, 16, 18, 20, 22, 24, 27, 30,
+    33, 36, 39, 43, 47, 51, 56, 62, 68, 75, 82, 91
+};
+
+// E192 (value x 100). E96 is every 2nd entry and E48 every 4th.
+static const unsigned short E192_CODES[192] = {
+    100, 101, 102, 104, 105, 106, 107, 109, 110, 111, 113, 114,
+    115, 117, 118, 120, 121, 123, 124, 126, 127, 129, 130, 132,
+    133, 135, 137, 138, 140, 142, 143, 145, 147, 149, 150, 152,
+    154, 156, 158, 160, 162, 164, 165, 167, 169, 172, 174, 176,
+    178, 180, 182, 184, 187, 189, 191, 193, 196, 198, 200, 203,
+    205, 208, 210, 213, 215, 218, 221, 223, 226, 229, 232, 234,
+    237, 240, 243, 246, 249, 252, 255, 258, 261, 264, 267, 271,
+    274, 277, 280, 284, 287, 291, 294, 298, 301, 305, 309, 312,
+    316, 320, 324, 328, 332, 336, 340, 344, 348, 352, 357, 361,
+    365, 370, 374, 379, 383, 388, 392, 397, 402, 407, 412, 417,
+    422, 427, 432, 437, 442, 448, 453, 459, 464, 470, 475, 481,
+    487, 493, 499, 505, 511, 517, 523, 530, 536, 542, 549, 556,
+    562, 569, 576, 583, 590, 597, 604, 612, 619, 626, 634, 642,
+    649, 657, 665, 673, 681, 690, 698, 706, 715, 723, 732, 741,
+    750, 759, 768, 777, 787, 796, 806, 816, 825, 835, 845, 856,
+    866, 876, 887, 898, 909, 920, 931, 942, 953, 965, 976, 988
+};
+
+static const char *SERIES_NAMES[ESERIES_COUNT] = { "E6", "E12", "E24", "E48", "E96", "E192" };
+static const int SERIES_SIZES[ESERIES_COUNT] = { 6, 12, 24, 48, 96, 192 };
+static const double SERIES_TOL_PCT[ESERIES_COUNT] = { 20, 10, 5, 2, 1, 0.5 };
+
+// Buckets over the mantissa range [1, 10). 9/4096 is narrower than half the
+// smallest E192 gap, so each bucket holds at most one decision boundary.
+#define ES_BUCKETS 4096
+
+// Decades handled by the table path (1e-18 .. 1e18); anything else uses libm
+#define ES_DEC_MIN (-18)
+#define ES_DEC_MAX 18
+
+typedef struct {
+    int n;
+    double val[ESERIES_MAX_SIZE + 1];       // mantissas, plus 10.0 as the wrap-around entry
+    double mid[ESERIES_MAX_SIZE + 1];       // decision point between val[i] and val[i+1]
+    unsigned char bucket[ES_BUCKETS];       // nearest index at the bottom of each bucket
+} ESeriesTable;
+
+static ESeriesTable g_tables[ESERIES_COUNT];
+static double g_pow10[ES_DEC_MAX - ES_DEC_MIN + 2];
+static pthread_once_t g_tables_once = PTHREAD_ONCE_INIT;
+
+// ============================================
+// Table construction (runs once)
+// ============================================
+
+static void build_tables(void) {
+    for (int d = ES_DEC_MIN; d <= ES_DEC_MAX + 1; d++) g_pow10[d - ES_DEC_MIN] = pow(10, d);
+
+    for (int s = 0; s < ESERIES_COUNT; s++) {
+        ESeriesTable *t = &g_tables[s];
+        t->n = SERIES_SIZES[s];
+        for (int i = 0; i < t->n; i++) {
+            if (s <= ESERIES_E24) t->val[i] = E24_CODES[i * (24 / t->n)] / 10.0;
+            else                  t->val[i] = E192_CODES[i * (192 / t->n)] / 100.0;
+        }
+        t->val[t->n] = 10.0;
+        for (int i = 0; i < t->n; i++) t->mid[i] = 0.5 * (t->val[i] + t->val[i + 1]);
+        t->mid[t->n] = INFINITY;
+
+        int idx = 0;
+        for (int b = 0; b < ES_BUCKETS; b++) {
+            double lo = 1.0 + 9.0 * b / ES_BUCKETS;
+            while (lo > t->mid[idx]) idx++;
+            t->bucket[b] = (unsigned char)idx;
+        }
+    }
+}
+
+static inline void ensure_tables(void) {
+    pthread_once(&g_tables_once, build_tables);
+}
+
+// ============================================
+// Lookup
+// ============================================
+
+const char *eseries_name(ESeries s) {
+    return (s >= 0 && s < ESERIES_COUNT) ? SERIES_NAMES[s] : "?";
+}
+
+// Tolerance the series is made for (E6 20% .. E192 0.5%)
+double eseries_tolerance_pct(ESeries s) {
+    return (s >= 0 && s < ESERIES_COUNT) ? SERIES_TOL_PCT[s] : 0;
+}
+
+// Accepts "E24", "e24" or "24". Returns -1 if unknown.
+int eseries_from_name(const char *name) {
+    if (name[0] == 'E' || name[0] == 'e') name++;
+    for (int s = 0; s < ESERIES_COUNT; s++)
+        if (strcmp(name, SERIES_NAMES[s] + 1) == 0) return s;
+    return -1;
+}
+
+// Mantissas of one decade in [1, 10). Returns the count.
+int eseries_values(ESeries s, const double **vals) {
+    ensure_tables();
+    *vals = g_tables[s].val;
+    return g_tables[s].n;
+}
+
+// Slow path for values outside the table's decade range
+static double nearest_libm(const ESeriesTable *t, double target) {
+    double magnitude = pow(10, floor(log10(target)));
+    double m = target / magnitude;
+    int i = 0;
+    while (m > t->mid[i]) i++;
+    return t->val[i] * magnitude;
+}
+
+// Hot path: no libm. The decade comes from the binary exponent and the index
+// from one bucket read plus a single compare against the next midpoint.
+static inline double nearest_fast(const ESeriesTable *t, double target) {
+    if (!(target > 0)) return t->val[0];
+
+    uint64_t bits;
+    memcpy(&bits, &target, sizeof(bits));
+    int e2 = (int)((bits >> 52) & 0x7ff) - 1023;
+    int d = (e2 * 1233) >> 12;                    // ~floor(e2 * log10(2)), off by at most one
+    if (d <= ES_DEC_MIN || d >= ES_DEC_MAX) return nearest_libm(t, target);
+
+    const double *p10 = &g_pow10[-ES_DEC_MIN];
+    double m = target / p10[d];
+    if (m >= 10.0) { d++; m = target / p10[d]; }
+    else if (m < 1.0) { d--; m = target / p10[d]; }
+
+    int b = (int)((m - 1.0) * (ES_BUCKETS / 9.0));
+    if (b > ES_BUCKETS - 1) b = ES_BUCKETS - 1;
+    int i = t->bucket[b];
+    i += (m > t->mid[i]);
+    return t->val[i] * p10[d];   // val[n] == 10.0 rolls into the next decade
+}
+
+/**
+ * @brief Nearest preferred value to target (linear distance within the decade).
+ *        Non-positive targets return 1 Ohm, as the original E24 helper did.
+ */
+double eseries_nearest(ESeries s, double target) {
+    ensure_tables();
+    return nearest_fast(&g_tables[s], target);
+}
+
+// Snaps n targets in one call (out may alias targets)
+void eseries_nearest_batch(ESeries s, const double *targets, double *out, int n) {
+    ensure_tables();
+    const ESeriesTable *t = &g_tables[s];
+    for (int i = 0; i < n; i++) out[i] = nearest_fast(t, targets[i]);
+}
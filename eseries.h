@@ -0,0 +1,27 @@
+#ifndef ESERIES_H
+#define ESERIES_H
+
+// ============================================
+// IEC 60063 preferred-value series (E6 .. E192)
+// ============================================
+
+typedef enum {
+    ESERIES_E6 = 0,
+    ESERIES_E12,
+    ESERIES_E24,
+    ESERIES_E48,
+    ESERIES_E96,
+    ESERIES_E192,
+    ESERIES_COUNT
+} ESeries;
+
+#define ESERIES_MAX_SIZE 192
+
+const char *eseries_name(ESeries s);
+double eseries_tolerance_pct(ESeries s);
+int eseries_from_name(const char *name);
+int eseries_values(ESeries s, const double **vals);
+double eseries_nearest(ESeries s, double target);
+void eseries_nearest_batch(ESeries s, const double *targets, double *out, int n);
+
+#endif
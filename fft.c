@@ -0,0 +1,494 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "fft.h"
+
+// ============================================
+// Plans
+// ============================================
+// A plan holds the factorisation of n and the twiddle table exp(-2 pi i t / n). Sizes with a
+// prime factor above FFT_MAX_RADIX are done with Bluestein's chirp-z convolution instead,
+// through a power-of-two sub-plan. Plans are kept for reuse in a cache of at most
+// FFT_PLAN_CACHE plans and FFT_PLAN_CACHE_BYTES, evicting the least recently used idle plan;
+// a larger plan is built for the call and freed after it.
+
+typedef struct FftPlan {
+    int n;
+    int n_fact, fact[32];
+    FftCpx *tw;             // exp(-2 pi i t / n), t = 0 .. n-1 (NULL when using Bluestein)
+    int m;                  // Bluestein convolution size (power of two), 0 if unused
+    FftCpx *chirp;          // exp(-i pi k^2 / n), k = 0 .. n-1
+    FftCpx *chirp_fft;      // FFT_m of the conjugate chirp filter, pre-scaled by 1 / m
+    struct FftPlan *sub;    // plan of size m (holds a reference on it)
+    FftCpx *rtw;            // exp(-2 pi i k / 2n), k = 0 .. n/2, for the real-input path (lazy)
+    size_t bytes;           // tables above, not counting sub
+    int refs;               // callers using it, plus Bluestein plans using it as their sub
+    int cached;             // in g_plans
+    unsigned long last_use; // g_tick at the last lookup, for LRU eviction
+} FftPlan;
+
+// All guarded by g_plan_lock, as are the refs / cached / last_use / rtw fields of every plan
+static FftPlan *g_plans[FFT_PLAN_CACHE];
+static int g_n_plans = 0;
+static size_t g_cache_bytes = 0;
+static unsigned long g_tick = 0;
+static pthread_mutex_t g_plan_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void stockham(const FftPlan *pl, FftCpx *x, FftCpx *work);
+
+static FftCpx cexp_neg(double angle) {
+    FftCpx w = { cos(angle), -sin(angle) };
+    return w;
+}
+
+// Radix 4 first (fewest passes), then 2, 3, 5 and other small primes. Returns the leftover
+// cofactor, which is 1 unless a prime factor exceeds FFT_MAX_RADIX.
+static int factorise(int n, int *fact, int *n_fact) {
+    *n_fact = 0;
+    while (n % 4 == 0) { fact[(*n_fact)++] = 4; n /= 4; }
+    for (int p = 2; p <= FFT_MAX_RADIX && n > 1; p++) {
+        while (n % p == 0) { fact[(*n_fact)++] = p; n /= p; }
+    }
+    return n;
+}
+
+static void plan_unref(FftPlan *pl);
+
+// Caller holds g_plan_lock
+static void plan_free(FftPlan *pl) {
+    if (!pl) return;
+    free(pl->tw); free(pl->chirp); free(pl->chirp_fft); free(pl->rtw);
+    plan_unref(pl->sub);
+    free(pl);
+}
+
+// Drops one reference; a plan outside the cache goes with its last one. Caller holds g_plan_lock.
+static void plan_unref(FftPlan *pl) {
+    if (pl && --pl->refs == 0 && !pl->cached) plan_free(pl);
+}
+
+static FftPlan *plan_lookup(int n);
+
+static FftPlan *plan_build(int n) {
+    FftPlan *pl = calloc(1, sizeof(FftPlan));
+    if (!pl) return NULL;
+    pl->n = n;
+
+    if (factorise(n, pl->fact, &pl->n_fact) == 1) {
+        pl->tw = malloc((size_t)n * sizeof(FftCpx));
+        if (!pl->tw) { plan_free(pl); return NULL; }
+        for (int t = 0; t < n; t++) pl->tw[t] = cexp_neg(2 * M_PI * t / n);
+        pl->bytes = (size_t)n * sizeof(FftCpx);
+        return pl;
+    }
+
+    // Bluestein: X_k = chirp_k * sum_j (x_j chirp_j) conj(chirp_{k-j}), a circular convolution
+    int m = 1;
+    while (m < 2 * n - 1) m <<= 1;
+    pl->m = m;
+    pl->sub = plan_lookup(m);
+    pl->chirp = malloc((size_t)n * sizeof(FftCpx));
+    pl->chirp_fft = calloc((size_t)m, sizeof(FftCpx));
+    FftCpx *work = malloc((size_t)m * sizeof(FftCpx));
+    if (!pl->sub || !pl->chirp || !pl->chirp_fft || !work) { free(work); plan_free(pl); return NULL; }
+    pl->bytes = ((size_t)n + m) * sizeof(FftCpx);
+
+    for (long long k = 0; k < n; k++) {
+        long long k2 = (k * k) % (2LL * n);   // keeps the angle exact for large k
+        pl->chirp[k] = cexp_neg(M_PI * (double)k2 / n);
+    }
+    double scale = 1.0 / m;
+    for (int k = 0; k < n; k++) {
+        FftCpx b = { pl->chirp[k].re * scale, -pl->chirp[k].im * scale };
+        pl->chirp_fft[k] = b;
+        if (k) pl->chirp_fft[m - k] = b;
+    }
+    stockham(pl->sub, pl->chirp_fft, work);
+    free(work);
+    return pl;
+}
+
+// Caches pl if it fits, evicting least recently used idle plans. Plans still in use stay, so
+// pl may end up uncached. Caller holds g_plan_lock.
+static void cache_insert(FftPlan *pl) {
+    if (pl->bytes > FFT_PLAN_CACHE_BYTES) return;
+    while (g_n_plans == FFT_PLAN_CACHE || g_cache_bytes + pl->bytes > FFT_PLAN_CACHE_BYTES) {
+        int victim = -1;
+        for (int i = 0; i < g_n_plans; i++) {
+            if (g_plans[i]->refs == 0 && (victim < 0 || g_plans[i]->last_use < g_plans[victim]->last_use))
+                victim = i;
+        }
+        if (victim < 0) return;
+        FftPlan *v = g_plans[victim];
+        g_plans[victim] = g_plans[--g_n_plans];
+        g_cache_bytes -= v->bytes;
+        v->cached = 0;
+        plan_free(v);       // a cached sub-plan only loses a reference and is evictable next
+    }
+    pl->cached = 1;
+    g_plans[g_n_plans++] = pl;
+    g_cache_bytes += pl->bytes;
+}
+
+// The plan for n with one reference taken for the caller, built on first use. Caller holds
+// g_plan_lock.
+static FftPlan *plan_lookup(int n) {
+    FftPlan *pl = NULL;
+    for (int i = 0; i < g_n_plans && !pl; i++) if (g_plans[i]->n == n) pl = g_plans[i];
+    if (!pl) {
+        pl = plan_build(n);
+        if (!pl) return NULL;
+        cache_insert(pl);
+    }
+    pl->refs++;
+    pl->last_use = ++g_tick;
+    return pl;
+}
+
+// Every plan_get() is paired with a plan_put()
+static FftPlan *plan_get(int n) {
+    pthread_mutex_lock(&g_plan_lock);
+    FftPlan *pl = plan_lookup(n);
+    pthread_mutex_unlock(&g_plan_lock);
+    return pl;
+}
+
+static void plan_put(FftPlan *pl) {
+    pthread_mutex_lock(&g_plan_lock);
+    plan_unref(pl);
+    pthread_mutex_unlock(&g_plan_lock);
+}
+
+// ============================================
+// Stockham passes
+// ============================================
+// Self-sorting (no bit reversal), iterative over the factors. At a stage of radix r with
+// stride s and m = n / (s r), for every p < m and q < s:
+//     a_j = src[q + s (p + j m)],  dst[q + s (r p + k)] = (sum_j a_j w_r^(j k)) * w_n^(p k s)
+
+static inline FftCpx cmul(FftCpx a, FftCpx b) {
+    FftCpx c = { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+    return c;
+}
+
+static void pass2(const FftCpx *src, FftCpx *dst, int m, int s, const FftCpx *tw) {
+    for (int p = 0; p < m; p++) {
+        FftCpx w = tw[p * s];
+        for (int q = 0; q < s; q++) {
+            FftCpx a = src[q + s * p], b = src[q + s * (p + m)];
+            FftCpx d = { a.re - b.re, a.im - b.im };
+            dst[q + s * 2 * p] = (FftCpx){ a.re + b.re, a.im + b.im };
+            dst[q + s * (2 * p + 1)] = cmul(d, w);
+        }
+    }
+}
+
+static void pass3(const FftCpx *src, FftCpx *dst, int m, int s, const FftCpx *tw) {
+    const double h = 0.86602540378443864676;   // sqrt(3) / 2
+    for (int p = 0; p < m; p++) {
+        FftCpx w1 = tw[p * s], w2 = tw[2 * p * s];
+        for (int q = 0; q < s; q++) {
+            FftCpx a0 = src[q + s * p], a1 = src[q + s * (p + m)], a2 = src[q + s * (p + 2 * m)];
+            FftCpx t1 = { a1.re + a2.re, a1.im + a2.im };
+            FftCpx t2 = { a0.re - 0.5 * t1.re, a0.im - 0.5 * t1.im };
+            FftCpx t3 = { h * (a1.im - a2.im), -h * (a1.re - a2.re) };   // -i (sqrt3/2)(a1 - a2)
+            dst[q + s * 3 * p] = (FftCpx){ a0.re + t1.re, a0.im + t1.im };
+            dst[q + s * (3 * p + 1)] = cmul((FftCpx){ t2.re + t3.re, t2.im + t3.im }, w1);
+            dst[q + s * (3 * p + 2)] = cmul((FftCpx){ t2.re - t3.re, t2.im - t3.im }, w2);
+        }
+    }
+}
+
+static void pass4(const FftCpx *src, FftCpx *dst, int m, int s, const FftCpx *tw) {
+    for (int p = 0; p < m; p++) {
+        FftCpx w1 = tw[p * s], w2 = tw[2 * p * s], w3 = tw[3 * p * s];
+        for (int q = 0; q < s; q++) {
+            FftCpx a0 = src[q + s * p], a1 = src[q + s * (p + m)];
+            FftCpx a2 = src[q + s * (p + 2 * m)], a3 = src[q + s * (p + 3 * m)];
+            FftCpx t0 = { a0.re + a2.re, a0.im + a2.im }, t1 = { a0.re - a2.re, a0.im - a2.im };
+            FftCpx t2 = { a1.re + a3.re, a1.im + a3.im };
+            FftCpx t3 = { a1.im - a3.im, -(a1.re - a3.re) };   // -i (a1 - a3)
+            dst[q + s * 4 * p] = (FftCpx){ t0.re + t2.re, t0.im + t2.im };
+            dst[q + s * (4 * p + 1)] = cmul((FftCpx){ t1.re + t3.re, t1.im + t3.im }, w1);
+            dst[q + s * (4 * p + 2)] = cmul((FftCpx){ t0.re - t2.re, t0.im - t2.im }, w2);
+            dst[q + s * (4 * p + 3)] = cmul((FftCpx){ t1.re - t3.re, t1.im - t3.im }, w3);
+        }
+    }
+}
+
+// Any radix: O(r^2) per butterfly, w_r^t read from the table at t * n / r
+static void pass_generic(const FftCpx *src, FftCpx *dst, int r, int m, int s, const FftCpx *tw, int n) {
+    FftCpx a[FFT_MAX_RADIX];
+    int step = n / r;
+    for (int p = 0; p < m; p++) {
+        for (int q = 0; q < s; q++) {
+            for (int j = 0; j < r; j++) a[j] = src[q + s * (p + j * m)];
+            for (int k = 0; k < r; k++) {
+                FftCpx b = a[0];
+                for (int j = 1, t = k; j < r; j++, t = (t + k) % r) {
+                    FftCpx c = cmul(a[j], tw[t * step]);
+                    b.re += c.re; b.im += c.im;
+                }
+                dst[q + s * (r * p + k)] = k ? cmul(b, tw[p * k * s]) : b;
+            }
+        }
+    }
+}
+
+static void stockham(const FftPlan *pl, FftCpx *x, FftCpx *work) {
+    int n = pl->n, s = 1, m = n;
+    FftCpx *src = x, *dst = work;
+    for (int f = 0; f < pl->n_fact; f++) {
+        int r = pl->fact[f];
+        m /= r;
+        switch (r) {
+            case 2: pass2(src, dst, m, s, pl->tw); break;
+            case 3: pass3(src, dst, m, s, pl->tw); break;
+            case 4: pass4(src, dst, m, s, pl->tw); break;
+            default: pass_generic(src, dst, r, m, s, pl->tw, n); break;
+        }
+        s *= r;
+        FftCpx *t = src; src = dst; dst = t;
+    }
+    if (src != x) memcpy(x, src, (size_t)n * sizeof(FftCpx));
+}
+
+static void bluestein(const FftPlan *pl, FftCpx *x, FftCpx *a, FftCpx *work) {
+    int n = pl->n, m = pl->m;
+    for (int k = 0; k < n; k++) a[k] = cmul(x[k], pl->chirp[k]);
+    memset(a + n, 0, (size_t)(m - n) * sizeof(FftCpx));
+    stockham(pl->sub, a, work);
+    // Pointwise product, then the inverse transform as conj(FFT(conj(.)))
+    for (int k = 0; k < m; k++) {
+        FftCpx c = cmul(a[k], pl->chirp_fft[k]);
+        a[k].re = c.re; a[k].im = -c.im;
+    }
+    stockham(pl->sub, a, work);
+    for (int k = 0; k < n; k++) x[k] = cmul((FftCpx){ a[k].re, -a[k].im }, pl->chirp[k]);
+}
+
+// ============================================
+// Public transforms
+// ============================================
+
+// Transforms x in place with pl. Returns 0, or -1 if the work buffer cannot be allocated.
+static int plan_exec(const FftPlan *pl, FftCpx *x) {
+    int rc = 0;
+    if (pl->m) {
+        FftCpx *buf = malloc(2 * (size_t)pl->m * sizeof(FftCpx));
+        if (buf) bluestein(pl, x, buf, buf + pl->m); else rc = -1;
+        free(buf);
+    } else {
+        FftCpx *work = malloc((size_t)pl->n * sizeof(FftCpx));
+        if (work) stockham(pl, x, work); else rc = -1;
+        free(work);
+    }
+    return rc;
+}
+
+/**
+ * @brief In-place forward DFT, X_k = sum_j x_j exp(-2 pi i j k / n), for any 1 <= n <= FFT_MAX_N.
+ * @return 0 on success, -1 on bad size or allocation failure.
+ */
+int fft_forward(FftCpx *x, int n) {
+    if (n < 1 || n > FFT_MAX_N) return -1;
+    if (n == 1) return 0;
+    FftPlan *pl = plan_get(n);
+    if (!pl) return -1;
+    int rc = plan_exec(pl, x);
+    plan_put(pl);
+    return rc;
+}
+
+/**
+ * @brief DFT of a real sequence: writes bins 0 .. n/2 (n/2 + 1 values) to out.
+ *
+ * For even n the samples are packed as n/2 complex values (even + i odd), transformed at half
+ * size and split with X_k = E_k + w^k O_k, X_(h-k) = conj(E_k - w^k O_k).
+ * @return 0 on success, -1 on bad size or allocation failure.
+ */
+int fft_real(const double *x, int n, FftCpx *out) {
+    if (n < 1 || n > FFT_MAX_N) return -1;
+    if (n % 2 || n < 4) {
+        FftCpx *tmp = malloc((size_t)n * sizeof(FftCpx));
+        if (!tmp) return -1;
+        for (int i = 0; i < n; i++) tmp[i] = (FftCpx){ x[i], 0 };
+        int rc = fft_forward(tmp, n);
+        if (rc == 0) memcpy(out, tmp, (size_t)(n / 2 + 1) * sizeof(FftCpx));
+        free(tmp);
+        return rc;
+    }
+
+    // One plan of size h serves the transform and holds the split twiddles
+    int h = n / 2;
+    FftPlan *pl = plan_get(h);
+    if (!pl) return -1;
+    for (int k = 0; k < h; k++) out[k] = (FftCpx){ x[2 * k], x[2 * k + 1] };
+    if (plan_exec(pl, out) != 0) { plan_put(pl); return -1; }
+
+    // Split twiddles w^k = exp(-2 pi i k / n), built on first use
+    pthread_mutex_lock(&g_plan_lock);
+    if (!pl->rtw) {
+        size_t bytes = (size_t)(h / 2 + 1) * sizeof(FftCpx);
+        FftCpx *rtw = malloc(bytes);
+        if (rtw) {
+            for (int k = 0; k <= h / 2; k++) rtw[k] = cexp_neg(2 * M_PI * k / n);
+            pl->bytes += bytes;
+            if (pl->cached) g_cache_bytes += bytes;
+        }
+        pl->rtw = rtw;
+    }
+    const FftCpx *rtw = pl->rtw;
+    pthread_mutex_unlock(&g_plan_lock);
+    if (!rtw) { plan_put(pl); return -1; }
+
+    FftCpx z0 = out[0];
+    out[0] = (FftCpx){ z0.re + z0.im, 0 };
+    out[h] = (FftCpx){ z0.re - z0.im, 0 };
+    for (int k = 1; k <= h / 2; k++) {
+        FftCpx zk = out[k], zc = out[h - k];
+        FftCpx e = { 0.5 * (zk.re + zc.re), 0.5 * (zk.im - zc.im) };
+        FftCpx o = { 0.5 * (zk.im + zc.im), -0.5 * (zk.re - zc.re) };   // (zk - conj(zc)) / 2i
+        FftCpx wo = cmul(rtw[k], o);
+        out[k] = (FftCpx){ e.re + wo.re, e.im + wo.im };
+        out[h - k] = (FftCpx){ e.re - wo.re, -(e.im - wo.im) };
+    }
+    plan_put(pl);
+    return 0;
+}
+
+// ============================================
+// Windows and spectrum analysis
+// ============================================
+
+const char *fft_window_name(FftWindow w) {
+    static const char *NAMES[] = { "", "Rectangular", "Hann", "Hamming", "Blackman", "Flat-top" };
+    return (w >= FFT_WIN_RECT && w <= FFT_WIN_FLATTOP) ? NAMES[w] : "?";
+}
+
+/**
+ * @brief Multiplies x by a periodic (DFT-even) window in place.
+ * @return Coherent gain (mean of the window), used to correct amplitudes.
+ */
+double fft_window_apply(double *x, int n, FftWindow w) {
+    // Cosine-sum coefficients a0 - a1 cos + a2 cos2 - a3 cos3 + a4 cos4
+    static const double COEF[][5] = {
+        { 1, 0, 0, 0, 0 },
+        { 1, 0, 0, 0, 0 },                                            // rectangular
+        { 0.5, 0.5, 0, 0, 0 },                                        // Hann
+        { 0.54, 0.46, 0, 0, 0 },                                      // Hamming
+        { 0.42, 0.5, 0.08, 0, 0 },                                    // Blackman
+        { 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 }   // flat-top
+    };
+    if (w < FFT_WIN_RECT || w > FFT_WIN_FLATTOP) w = FFT_WIN_RECT;
+    const double *a = COEF[w];
+    if (w == FFT_WIN_RECT) return 1.0;
+
+    double sum = 0, step = 2 * M_PI / n;
+    for (int i = 0; i < n; i++) {
+        double th = step * i;
+        double v = a[0] - a[1] * cos(th) + a[2] * cos(2 * th) - a[3] * cos(3 * th) + a[4] * cos(4 * th);
+        x[i] *= v;
+        sum += v;
+    }
+    return sum / n;
+}
+
+/**
+ * @brief Single-sided amplitude spectrum of n real samples: n/2 + 1 bins written to amp.
+ *        The mean is removed first, so a step response's DC level does not mask its ringing.
+ *        A sinusoid of amplitude A centred on a bin reads A (window gain corrected).
+ * @return Number of bins, or -1 on error.
+ */
+int fft_amplitude_spectrum(const double *x, int n, FftWindow w, double *amp) {
+    if (n < 2) return -1;
+    double *buf = malloc((size_t)n * sizeof(double));
+    FftCpx *spec = malloc((size_t)(n / 2 + 1) * sizeof(FftCpx));
+    if (!buf || !spec) { free(buf); free(spec); return -1; }
+
+    double mean = 0;
+    for (int i = 0; i < n; i++) mean += x[i];
+    mean /= n;
+    for (int i = 0; i < n; i++) buf[i] = x[i] - mean;
+    double cg = fft_window_apply(buf, n, w);
+
+    int nb = n / 2 + 1, rc = fft_real(buf, n, spec);
+    if (rc == 0) {
+        double scale = 2.0 / (n * cg);
+        for (int k = 0; k < nb; k++) amp[k] = hypot(spec[k].re, spec[k].im) * scale;
+        amp[0] *= 0.5;
+        if (n % 2 == 0) amp[nb - 1] *= 0.5;   // Nyquist bin is not doubled either
+    }
+    free(buf); free(spec);
+    return rc == 0 ? nb : -1;
+}
+
+// Refines a peak at bin k with a parabola through the log amplitudes of k-1, k, k+1
+static FftPeak refine_peak(const double *amp, int n_bins, int k, double df) {
+    FftPeak pk = { k * df, amp[k] };
+    if (k <= 0 || k >= n_bins - 1 || amp[k - 1] <= 0 || amp[k + 1] <= 0 || amp[k] <= 0) return pk;
+    double a = log(amp[k - 1]), b = log(amp[k]), c = log(amp[k + 1]);
+    double den = a - 2 * b + c;
+    if (den >= 0) return pk;
+    double d = 0.5 * (a - c) / den;
+    pk.freq = (k + d) * df;
+    pk.amp = exp(b - 0.25 * (a - c) * d);
+    return pk;
+}
+
+// Half-width of the window's main lobe in bins: a peak closer than this to DC is only leakage
+// of the (mean-removed) trend and cannot be resolved from it
+int fft_window_lobe_bins(FftWindow w) {
+    static const int LOBE[] = { 1, 1, 2, 2, 3, 5 };
+    return (w >= FFT_WIN_RECT && w <= FFT_WIN_FLATTOP) ? LOBE[w] : 1;
+}
+
+/**
+ * @brief The k largest local maxima of the spectrum at or above first_bin (strongest first),
+ *        frequency-refined.
+ * @return Number of peaks written (<= k).
+ */
+int fft_peaks(const double *amp, int n_bins, double df, int first_bin, FftPeak *out, int k) {
+    if (k > FFT_MAX_PEAKS) k = FFT_MAX_PEAKS;
+    int idx[FFT_MAX_PEAKS], found = 0;
+    double floor_amp = 0;   // maxima this far below the largest bin are round-off, not signal
+    for (int i = 0; i < n_bins; i++) if (amp[i] > floor_amp) floor_amp = amp[i];
+    floor_amp *= FFT_PEAK_FLOOR;
+    for (int i = first_bin > 1 ? first_bin : 1; i < n_bins - 1; i++) {
+        if (!(amp[i] > amp[i - 1] && amp[i] >= amp[i + 1]) || amp[i] <= floor_amp) continue;
+        if (found == k && amp[i] <= amp[idx[k - 1]]) continue;
+        int pos = found < k ? found++ : k - 1;
+        while (pos > 0 && amp[idx[pos - 1]] < amp[i]) { idx[pos] = idx[pos - 1]; pos--; }
+        idx[pos] = i;
+    }
+    for (int i = 0; i < found; i++) out[i] = refine_peak(amp, n_bins, idx[i], df);
+    return found;
+}
+
+/**
+ * @brief Amplitudes at f1, 2 f1, ... (largest bin near each, refined) and THD.
+ *        The fundamental must be at least FFT_MIN_FUND_BINS bins above DC, otherwise the
+ *        harmonics are not resolved and nothing is reported.
+ * @param thd_pct sqrt(sum of harmonic 2.. powers) / fundamental in percent, -1 if none found.
+ * @return Number of harmonics found (stops at Nyquist), including the fundamental.
+ */
+int fft_harmonics(const double *amp, int n_bins, double df, double f1, int n_harm,
+                  FftPeak *out, double *thd_pct) {
+    if (n_harm > FFT_MAX_HARMONICS) n_harm = FFT_MAX_HARMONICS;
+    int found = 0;
+    double power = 0, bins = f1 / df;
+    int reach = bins >= 2 * FFT_MIN_FUND_BINS ? 2 : 1;   // search +-reach bins, never into a neighbour
+    for (int h = 1; h <= n_harm && bins >= FFT_MIN_FUND_BINS; h++) {
+        int c = (int)lround(h * bins);
+        if (c >= n_bins - 1) break;
+        int best = c;
+        for (int i = c - reach; i <= c + reach; i++) {
+            if (i >= 1 && i < n_bins - 1 && amp[i] > amp[best]) best = i;
+        }
+        out[found++] = refine_peak(amp, n_bins, best, df);
+        if (h > 1) power += out[found - 1].amp * out[found - 1].amp;
+    }
+    *thd_pct = (found > 0 && out[0].amp > 0) ? sqrt(power) / out[0].amp * 100.0 : -1;
+    return found;
+}
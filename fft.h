@@ -0,0 +1,46 @@
+#ifndef FFT_H
+#define FFT_H
+
+// ============================================
+// In-tree FFT: self-sorting mixed-radix (4, 2, 3, 5, small primes), Bluestein for
+// sizes with a large prime factor, plans in a size-bounded LRU cache, real-input path, windows,
+// and spectrum helpers (dominant peaks, harmonics)
+// ============================================
+
+#define FFT_MAX_N (1 << 26)      // largest transform accepted
+#define FFT_PLAN_CACHE 16        // plans kept for reuse (by size)
+#define FFT_PLAN_CACHE_BYTES ((size_t)64 << 20)   // and their tables' total; larger plans are not kept
+#define FFT_MAX_RADIX 61         // larger prime factors go through Bluestein
+#define FFT_MAX_PEAKS 32
+#define FFT_MAX_HARMONICS 32
+#define FFT_MIN_FUND_BINS 4      // harmonic analysis needs the fundamental this many bins up
+#define FFT_PEAK_FLOOR 1e-10     // peaks below this fraction of the largest bin are ignored
+
+typedef struct {
+    double re, im;
+} FftCpx;
+
+typedef enum {
+    FFT_WIN_RECT = 1,
+    FFT_WIN_HANN,
+    FFT_WIN_HAMMING,
+    FFT_WIN_BLACKMAN,
+    FFT_WIN_FLATTOP
+} FftWindow;
+
+typedef struct {
+    double freq;    // Hz, refined between bins
+    double amp;     // peak amplitude in signal units
+} FftPeak;
+
+int fft_forward(FftCpx *x, int n);
+int fft_real(const double *x, int n, FftCpx *out);
+const char *fft_window_name(FftWindow w);
+double fft_window_apply(double *x, int n, FftWindow w);
+int fft_amplitude_spectrum(const double *x, int n, FftWindow w, double *amp);
+int fft_window_lobe_bins(FftWindow w);
+int fft_peaks(const double *amp, int n_bins, double df, int first_bin, FftPeak *out, int k);
+int fft_harmonics(const double *amp, int n_bins, double df, double f1, int n_harm,
+                  FftPeak *out, double *thd_pct);
+
+#endif
@@ -4,75 +4,52 @@
 #include <math.h>
 #include <ctype.h>
 #include "funcs.h"
+#include "circuits.h"
+#include "rlc.h"
+#include "sweep.h"
+#include "montecarlo.h"
+#include "opamp.h"
+#include "rnet.h"
+#include "wave.h"
+#include "chart.h"
+#include "rlcstream.h"
+#include "ac.h"
+#include "fft.h"
+#include "netlist.h"
+#include "bom.h"
+#include "prof.h"
+#include <time.h>
 
 // ============================================
 // CONSTANTS & DEFINITIONS
 // ============================================
-// Standard E24 Resistor Series Base Values
-static const double E24_BASE[] = {
-    1.0, 1.1, 1.2, 1.3, 1.5, 1.6, 1.8, 2.0, 2.2, 2.4, 2.7, 3.0,
-    3.3, 3.6, 3.9, 4.3, 4.7, 5.1, 5.6, 6.2, 6.8, 7.5, 8.2, 9.1
-};
-// Digit and multiplier colour names for printing
-static const char *COLOUR_DIGITS[10] = {
-    "Black", "Brown", "Red", "Orange", "Yellow",
-    "Green", "Blue", "Violet", "Grey", "White"
-};
-
-// Only 10^0 ~ 10^6
-static const char *COLOUR_MULTIPLIERS[7] = {
-    "Black",  // x1
-    "Brown",  // x10
-    "Red",    // x100
-    "Orange", // x1k
-    "Yellow", // x10k
-    "Green",  // x100k
-    "Blue"    // x1M
-};
-#define E24_COUNT (sizeof(E24_BASE)/sizeof(E24_BASE[0]))
-
 // Graph settings
 #define GRAPH_ROWS 20
 #define GRAPH_COLS 60
 #define MAX_INPUT_LEN 64
 
-// ============================================
-// WORKBENCH STATE (Interconnectivity Layer)
-// ============================================
-// Defaults set to 10.0V, 4.7k, 1mA, 0.7V
-static double g_wb_voltage = 10.0;     // Default voltage: 10.0V
-static double g_wb_resistor = 4700.0;  // Default resistor: 4.7k
-static double g_wb_capacitor = 1e-6;   // Default capacitor: 1uF
-static double g_wb_current = 0.001;    // Default current: 1mA
-static double g_wb_vf = 0.7;           // Default diode drop: 0.7V
-static double g_wb_inductor = 10e-3;   // Default inductor: 10mH
-
-// Helper to format engineering output
-static void format_eng(double val, char *buf) {
-    if (val == 0) { sprintf(buf, "0"); return; }
-    char *suffixes = "pnum kMG";
-    double magnitude = val; int s_idx = 4; // start at ' ' (base)
-    while (magnitude >= 1000.0 && s_idx < 7) { magnitude /= 1000.0; s_idx++; }
-    while (magnitude < 1.0 && magnitude > 0 && s_idx > 0) { magnitude *= 1000.0; s_idx--; }
-    char suffix = suffixes[s_idx];
-    if (suffix == ' ') sprintf(buf, "%.2f", magnitude);
-    else sprintf(buf, "%.2f%c", magnitude, suffix);
-}
-
 // ============================================
 // Internal Helper Function Prototypes
 // ============================================
 static double get_eng_input_with_default(const char *prompt_base, double *default_val_ptr, int use_eng_format);
 static int get_menu_selection(const char *prompt, int min, int max);
-static double find_closest_e24_resistor(double target_r);
-static double get_standard_resistor_input(const char *component_name, double initial_guess);
-static void add_record_to_history(CalcRecord **history, int *count, const char *tool, const char *details, const char *result_str);
-static void plot_vertical_strip_chart(double *data, int total_steps, double t_total, const char *title, const char *unit);
-static int resistor_to_bands(double r_ohms, int *d1, int *d2, int *mult_idx);
+static double get_standard_resistor_input(Session *session, const char *component_name, double initial_guess);
+static void get_series_input(Session *session);
+static void get_string_input(const char *prompt, char *buf, int len);
+static void add_record_to_history(Session *session, const char *tool, const char *details, const char *result_str);
+static void get_chart_layout(Session *session, int *overlay);
 // ============================================
 // Internal Helper Function Implementations
 // ============================================
 
+// fgets() from stdin; the wait is left out of the open tool span, which times the tool's work
+static char *read_input(char *buf, int len) {
+    PROF_WAIT_BEGIN(wait);
+    char *line = fgets(buf, len, stdin);
+    PROF_WAIT_END(wait);
+    return line;
+}
+
 /**
  * @brief Reads engineering input.
  * @param use_eng_format If 1, formats default value like "3.40k". If 0, like "3400.00".
@@ -92,29 +69,22 @@ static double get_eng_input_with_default(const char *prompt_base, double *defaul
         if (default_val_ptr) printf("%s [default: %s]: ", prompt_base, default_str);
         else printf("%s: ", prompt_base);
 
-        if (!fgets(buf, sizeof(buf), stdin)) exit(1);
+        if (!read_input(buf, sizeof(buf))) exit(1);
         buf[strcspn(buf, "\r\n")] = '\0';
         
         if (strlen(buf) == 0 && default_val_ptr) return *default_val_ptr;
 
         // --- Standard Engineering Parsing Logic ---
-        char *startptr = buf; while (isspace((unsigned char)*startptr)) startptr++;
-        if (*startptr == '\0') continue;
-        char *endptr; value = strtod(startptr, &endptr);
-        if (endptr == startptr) { printf("Invalid input.\n"); continue; }
-        char *suffix_ptr = endptr; while (isspace((unsigned char)*suffix_ptr)) suffix_ptr++;
-        double multiplier = 1.0; int suffix_found = 0;
-        if (*suffix_ptr != '\0') {
-            switch (*suffix_ptr) {
-                case 'p': multiplier = 1e-12; suffix_found=1; break; case 'n': multiplier = 1e-9;  suffix_found=1; break;
-                case 'u': multiplier = 1e-6;  suffix_found=1; break; case 'm': multiplier = 1e-3;  suffix_found=1; break;
-                case 'k': case 'K': multiplier = 1e3; suffix_found=1; break; case 'M': multiplier = 1e6;   suffix_found=1; break;
-                case 'G': multiplier = 1e9;   suffix_found=1; break;
-                default: printf("Unknown suffix.\n"); suffix_found = -1; break;
-            }
-            if (suffix_found == 1 && *(suffix_ptr + 1) != '\0') { printf("Trailing characters.\n"); suffix_found = -1; }
+        PROF_BEGIN(parse);
+        int rc = parse_eng_value(buf, &value);
+        PROF_END(PROF_INPUT, parse);
+        switch (rc) {
+            case ENG_OK: valid = 1; break;
+            case ENG_INVALID: printf("Invalid input.\n"); break;
+            case ENG_BAD_SUFFIX: printf("Unknown suffix.\n"); break;
+            case ENG_TRAILING: printf("Trailing characters.\n"); break;
+            default: break; // ENG_EMPTY: just ask again
         }
-        if (suffix_found != -1) { value *= multiplier; valid = 1; }
     } while (!valid);
 
     if (default_val_ptr && value > 0) *default_val_ptr = value;
@@ -133,262 +103,301 @@ static int get_menu_selection(const char *prompt, int min, int max) {
     return value;
 }
 
-// Core logic to find closest E24 resistor value
-static double find_closest_e24_resistor(double target_r) {
-    if (target_r <= 0) return 1.0;
-
-    double exponent = floor(log10(target_r));
-    double magnitude = pow(10, exponent);
-    double normalized_base = target_r / magnitude;
-    double closest_base = E24_BASE[0];
-    double min_diff = 1e9;
-
-    for (int i = 0; i < E24_COUNT; i++) {
-        double diff = fabs(normalized_base - E24_BASE[i]);
-        if (i == E24_COUNT - 1) {
-             double diff_next_decade = fabs(normalized_base - 10.0);
-             if (diff_next_decade < diff && diff_next_decade < min_diff) {
-                 closest_base = 1.0; magnitude *= 10; break;
-             }
-        }
-        if (diff < min_diff) { min_diff = diff; closest_base = E24_BASE[i]; }
-    }
-    return closest_base * magnitude;
-}
-
-static int resistor_to_bands(double r_ohms, int *d1, int *d2, int *mult_idx) {
-    if (r_ohms <= 0.0) return 0;
-
-    double v = r_ohms;
-    int exp = 0;
-
-    // 规范化到 [10, 100)
-    while (v >= 100.0) {
-        v /= 10.0;
-        exp++;
-    }
-    while (v < 10.0) {
-        v *= 10.0;
-        exp--;
-    }
-
-    int two_digits = (int)round(v);
-    if (two_digits >= 100) {
-        // 四舍五入变 100 的情况，修正一下
-        two_digits /= 10;
-        exp++;
-    }
-
-    int first = two_digits / 10;
-    int second = two_digits % 10;
-
-    // 你的菜单 multiplier 目前只支持 0~6 (x1 到 x1M)
-    if (exp < 0 || exp > 6) {
-        return 0; // 超出当前 4 环支持范围
-    }
-
-    if (d1) *d1 = first;
-    if (d2) *d2 = second;
-    if (mult_idx) *mult_idx = exp;
-    return 1;
-}
-
-// Refactored to use find_closest_e24_resistor helper
-static double get_standard_resistor_input(const char *component_name, double initial_guess) {
-    printf("\n[Select Standard E24 Resistor for %s]\n", component_name);
+// Snaps to the workbench series (E24 unless changed by get_series_input)
+static double get_standard_resistor_input(Session *session, const char *component_name, double initial_guess) {
+    const char *sname = eseries_name(session->wb.series);
+    printf("\n[Select Standard %s Resistor for %s]\n", sname, component_name);
     double target_r = get_eng_input_with_default("Enter Target Value", &initial_guess, 1);
     
-    double final_R = find_closest_e24_resistor(target_r);
+    double final_R = eseries_nearest(session->wb.series, target_r);
     
     char fmt_buf[32]; format_eng(final_R, fmt_buf);
-    printf("-> Nearest Standard E24 Value: %sOhms\n", fmt_buf);
-    g_wb_resistor = final_R;
+    printf("-> Nearest Standard %s Value: %sOhms\n", sname, fmt_buf);
+    session->wb.resistor = final_R;
     return final_R;
 }
 
 // [UPDATED] Updated to accept string result instead of double
-static void add_record_to_history(CalcRecord **history, int *count, const char *tool, const char *details, const char *result_str) {
-    int new_count = *count + 1;
-    CalcRecord *temp = realloc(*history, new_count * sizeof(CalcRecord));
-    if (temp == NULL) { printf("\n[Error] Memory allocation failed!\n"); return; }
-    *history = temp;
-    strncpy((*history)[*count].tool_name, tool, MAX_STR_LEN - 1);
-    strncpy((*history)[*count].details, details, MAX_STR_LEN - 1);
-    strncpy((*history)[*count].result_str, result_str, MAX_STR_LEN - 1); // Save string
-    
-    (*history)[*count].tool_name[MAX_STR_LEN - 1] = '\0';
-    (*history)[*count].details[MAX_STR_LEN - 1] = '\0';
-    (*history)[*count].result_str[MAX_STR_LEN - 1] = '\0';
-    
-    *count = new_count;
+static void add_record_to_history(Session *session, const char *tool, const char *details, const char *result_str) {
+    PROF_BEGIN(span);
+    int rc = history_append(&session->history, tool, details, result_str);
+    PROF_END(PROF_HISTORY, span);
+    if (rc == -1) {
+        printf("\n[Error] Memory allocation failed!\n"); return;
+    }
+    if (rc == -2) printf("[Warning] History journal write failed; further records stay in memory only.\n");
     printf("[Record added to history]\n");
 }
 
-// [NEW Helper] Vertical Strip Chart Plotter
-// Layout: [Time] | [Visual Graph bar] | [Exact Value]
-static void plot_vertical_strip_chart(double *data, int total_steps, double t_total, const char *title, const char *unit) {
-    int display_rows = 25; // Limit height to fit on screen
-    int step_stride = total_steps / display_rows; 
-    if (step_stride < 1) step_stride = 1;
-
-    // 1. Calculate Min/Max for Scaling
-    double min_val = data[0], max_val = data[0];
-    for (int i = 0; i < total_steps; i++) {
-        if (data[i] < min_val) min_val = data[i];
-        if (data[i] > max_val) max_val = data[i];
+// Asks for overlay vs separate charts and the chart size (kept in the workbench)
+static void get_chart_layout(Session *session, int *overlay) {
+    printf("Charts: 1. Overlay (one shared time axis)  2. Separate\n");
+    *overlay = get_menu_selection("Select Layout", 1, 2) == 1;
+    char buf[MAX_INPUT_LEN], prompt[64];
+    snprintf(prompt, sizeof(prompt), "Chart size rows x width [default: %dx%d]", session->wb.chart_rows, session->wb.chart_width);
+    for (;;) {
+        get_string_input(prompt, buf, sizeof(buf));
+        int rows, width;
+        if (buf[0] == '\0') return;
+        if (sscanf(buf, "%d x %d", &rows, &width) == 2 && rows >= 1 && rows <= CHART_MAX_ROWS &&
+            width >= CHART_MIN_WIDTH && width <= CHART_MAX_WIDTH) {
+            session->wb.chart_rows = rows; session->wb.chart_width = width;
+            return;
+        }
+        printf("Invalid size. Use e.g. 25x40 (rows 1-%d, width %d-%d).\n", CHART_MAX_ROWS, CHART_MIN_WIDTH, CHART_MAX_WIDTH);
     }
-    double range = max_val - min_val;
-    if (fabs(range) < 1e-9) range = 1.0; // Prevent divide by zero for flat lines
+}
 
-    int graph_width = 40; // Width of the visual bar area
+// Reads a string, stripping the newline. An empty line yields "".
+static void get_string_input(const char *prompt, char *buf, int len) {
+    printf("%s: ", prompt);
+    if (!read_input(buf, len)) exit(1);
+    buf[strcspn(buf, "\r\n")] = '\0';
+}
 
-    printf("\n=== %s ===\n", title);
-    printf(" %-9s | %-40s | %-15s\n", "Time", "Waveform (Min->Max)", "Exact Value");
-    printf("-----------|------------------------------------------|-----------------\n");
+// Lets the user pick E6..E192; an empty line keeps the workbench series.
+static void get_series_input(Session *session) {
+    char buf[MAX_INPUT_LEN], prompt[80];
+    snprintf(prompt, sizeof(prompt), "Resistor series (E6/E12/E24/E48/E96/E192) [default: %s]",
+             eseries_name(session->wb.series));
+    while (1) {
+        get_string_input(prompt, buf, sizeof(buf));
+        if (buf[0] == '\0') return;
+        int s = eseries_from_name(buf);
+        if (s >= 0) { session->wb.series = s; return; }
+        printf("Unknown series.\n");
+    }
+}
 
-    for (int i = 0; i < total_steps; i += step_stride) {
-        if (i >= total_steps) break;
-        
-        double current_val = data[i];
-        double t_current = (double)i / total_steps * t_total;
-
-        // Calculate position (0 to graph_width)
-        int pos = (int)((current_val - min_val) / range * graph_width);
-        if (pos < 0) pos = 0;
-        if (pos >= graph_width) pos = graph_width - 1;
-
-        // Print Time
-        printf(" %6.2f ms | ", t_current * 1000.0);
-
-        // Print Graph Bar
-        for (int k = 0; k < graph_width; k++) {
-            if (k == pos) printf("O");      // The data point
-            else if (k < pos) printf("-");  // Fill bar
-            else printf(" ");               // Empty space
-        }
+/**
+ * @brief Asks for an output filename and appends `ext` (e.g. ".csv") if missing.
+ * @return 1 if a usable name is in fname, 0 if the user left it empty or it is too long.
+ */
+static int get_save_filename(const char *ext, char *fname, int size) {
+    printf("Enter filename (e.g. result1): ");
+    if (!read_input(fname, size)) return 0;
+    fname[strcspn(fname, "\r\n")] = '\0'; // strip newline
+    
+    if (strlen(fname) == 0) return 0;
 
-        // Print Exact Value on the Right
-        // Determine precision based on magnitude
-        if (fabs(current_val) < 0.001 && current_val != 0)
-            printf(" | %.3e %s\n", current_val, unit);
-        else
-            printf(" | %8.4f %s\n", current_val, unit);
+    // Automatic extension logic
+    int len = strlen(fname);
+    int ext_len = strlen(ext);
+    
+    // Append if missing
+    if (len < ext_len || strcmp(fname + len - ext_len, ext) != 0) {
+        if (len + ext_len < size) {
+            strcat(fname, ext);
+        } else {
+            printf("Filename too long to append extension.\n"); return 0;
+        }
     }
-    printf("-----------|------------------------------------------|-----------------\n");
-    printf(" Range: [%.4e] to [%.4e] %s\n", min_val, max_val, unit);
+    return 1;
+}
+
+/**
+ * @brief Optional follow-up for the divider / LED / op-amp tools: perturbs the resistors
+ *        by their tolerance and reports the spread and production yield of the output.
+ * @param spec Design and nominal values filled in by the caller.
+ */
+static void run_tolerance_analysis(McSpec *spec, const char *quantity, const char *unit,
+                                   Session *session) {
+    char buf[10];
+    printf("\nRun Monte Carlo tolerance analysis? (y/n): ");
+    if (!read_input(buf, sizeof(buf)) || tolower(buf[0]) != 'y') return;
+
+    double tol = 5.0, trials = 1e6, window = 2.0;
+    spec->tol_pct = get_eng_input_with_default("Resistor Tolerance (%)", &tol, 0);
+    printf("Distribution: 1. Uniform  2. Gaussian (tolerance = 3 sigma)\n");
+    spec->dist = get_menu_selection("Select Distribution", 1, 2);
+    spec->trials = (long)get_eng_input_with_default("Trials", &trials, 1);
+    window = get_eng_input_with_default("Spec window around nominal (+/- %)", &window, 0);
+
+    double nominal = mc_nominal(spec);
+    spec->spec_lo = nominal - fabs(nominal) * window / 100.0;
+    spec->spec_hi = nominal + fabs(nominal) * window / 100.0;
+    spec->n_threads = 0;
+    spec->seed = (unsigned long long)time(NULL);
+
+    McResult res;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    PROF_BEGIN(sim);
+    int rc = mc_run(spec, &res);
+    PROF_END(PROF_SIM, sim);
+    if (rc != 0) { printf("Error: invalid Monte Carlo settings.\n"); return; }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    printf("\n>>> Monte Carlo: %ld trials in %.3f s\n", res.trials, secs);
+    printf("-----------------------------------------------------\n");
+    printf("%-16s: %s\n", "Output", quantity);
+    printf("%-16s: %.6g %s\n", "Nominal", res.nominal, unit);
+    printf("%-16s: %.6g / %.4g %s\n", "Mean / Sigma", res.mean, res.sigma, unit);
+    printf("%-16s: %.6g .. %.6g %s\n", "Min .. Max", res.min, res.max, unit);
+    for (int k = 0; k < MC_PCT_COUNT; k++)
+        printf("P%-15g: %.6g %s\n", MC_PCT_LEVELS[k], res.pct[k], unit);
+    printf("%-16s: %.3f%% (within +/-%.3g%%)\n", "Yield", res.yield_pct, window);
+    printf("-----------------------------------------------------\n");
+
+    char details[MAX_STR_LEN], result_str[MAX_STR_LEN];
+    snprintf(details, MAX_STR_LEN, "%s tol=%.3g%% %s, %ld runs", quantity, spec->tol_pct,
+             spec->dist == MC_DIST_GAUSSIAN ? "gauss" : "unif", res.trials);
+    snprintf(result_str, MAX_STR_LEN, "mean=%.4g sd=%.3g yield=%.2f%%", res.mean, res.sigma, res.yield_pct);
+    add_record_to_history(session, "Monte Carlo", details, result_str);
 }
 
 // ============================================
 // Public Function Implementations
 // ============================================
 
-void free_history_memory(CalcRecord *history) {
-    if (history != NULL) free(history);
+// --- Item 1: Resistor Colour Codes (3-6 bands, decode / encode / bulk) ---
+// Modes 3 and 4: a whole file through bom_normalise_file() / bom_decode_file()
+static void bulk_bom(Session *session, int decode) {
+    if (decode) {
+        printf("\n>> Bulk Band Strings -> Values\n");
+        printf("One code per line, e.g. \"Yel-Vio-Red-Gld\"; the output is a CSV file.\n");
+    } else {
+        printf("\n>> Bulk BOM -> Standard Values & Colour Codes\n");
+        printf("One resistor per line, e.g. \"R12,4k7,0603\"; the output is a CSV file.\n");
+    }
+    char in_path[MAX_STR_LEN], out_path[MAX_STR_LEN];
+    get_string_input(decode ? "Band file to read" : "BOM file to read", in_path, sizeof(in_path));
+    if (in_path[0] == '\0') return;
+    get_string_input("CSV file to write", out_path, sizeof(out_path));
+    if (out_path[0] == '\0') return;
+    if (!decode) get_series_input(session);
+    double threads = sweep_default_threads();
+    int n_threads = (int)get_eng_input_with_default("Worker Threads", &threads, 0);
+
+    BomStats st;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int rc = decode ? bom_decode_file(in_path, out_path, n_threads, &st)
+                    : bom_normalise_file(in_path, out_path, session->wb.series, n_threads, &st);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    if (rc == BOM_ERR_INPUT) { printf("Error: cannot read '%s'.\n", in_path); return; }
+    if (rc == BOM_ERR_OUTPUT) { printf("Error: cannot write '%s'.\n", out_path); return; }
+    if (rc == BOM_ERR_MEMORY) { printf("Memory Error.\n"); return; }
+
+    printf("\n>>> %ld lines in %.3f s (%.0f lines/s)\n", st.lines, secs, secs > 0 ? st.lines / secs : 0);
+    char details[HISTORY_TEXT_LEN], result_str[HISTORY_TEXT_LEN];
+    if (decode) {
+        printf("  Decoded              : %ld\n", st.ok);
+        printf("  Invalid codes        : %ld\n", st.invalid);
+        snprintf(details, sizeof(details), "In=%s, Out=%s", in_path, out_path);
+        snprintf(result_str, sizeof(result_str), "%ld lines, %ld decoded, %ld invalid", st.lines, st.ok, st.invalid);
+        add_record_to_history(session, "Bulk Decode", details, result_str);
+        return;
+    }
+    printf("  Snapped to %s (%.3g%%): %ld\n", eseries_name(session->wb.series), eseries_tolerance_pct(session->wb.series), st.ok);
+    printf("  No value found       : %ld\n", st.no_value);
+    printf("  Outside colour range : %ld\n", st.out_of_range);
+    printf("  Largest deviation    : %.2f%%\n", st.max_dev_pct);
+    snprintf(details, sizeof(details), "In=%s, Out=%s, %s", in_path, out_path, eseries_name(session->wb.series));
+    snprintf(result_str, sizeof(result_str), "%ld lines, %ld ok, %ld no value, %ld out of range",
+             st.lines, st.ok, st.no_value, st.out_of_range);
+    add_record_to_history(session, "Bulk BOM", details, result_str);
 }
 
-// --- Item 1: 4-Band Resistor Decoder & Encoder ---
-void menu_item_1(CalcRecord **history, int *count) {
-    printf("\n>> 4-Band Resistor Tool\n");
+// One line per band: "Band 3 (Multiplier): Red"
+static void print_band_table(const BandCode *code) {
+    int nd = code->n <= 4 ? 2 : 3;
+    for (int k = 0; k < code->n; k++) {
+        const char *role = k < nd ? "Digit" : k == nd ? "Multiplier" : k == nd + 1 ? "Tolerance" : "Tempco";
+        printf("  Band %d (%s):%*s %s\n", k + 1, role, (int)(10 - strlen(role)), "", band_name(code->c[k]));
+    }
+}
+
+void menu_item_1(Session *session) {
+    printf("\n>> Resistor Colour Code Tool (3-6 bands)\n");
     printf("1. Colour Bands  -> Resistance\n");
-    printf("2. Resistance    -> Colour Bands (nearest E24)\n");
+    printf("2. Resistance    -> Colour Bands (nearest standard value)\n");
+    printf("3. BOM file      -> Standard values + colour codes (bulk)\n");
+    printf("4. Band file     -> Values (bulk decode)\n");
     
-    int mode = get_menu_selection("Select mode (1-2)", 1, 2);
+    int mode = get_menu_selection("Select mode (1-4)", 1, 4);
+    if (mode >= 3) { bulk_bom(session, mode == 4); return; }
 
     if (mode == 1) {
         // ========= 色环 -> 电阻 =========
-        printf("\n>> Resistor Colour Code Decoder (4-Band)\n");
-        printf("Colour Codes: 0:Blk 1:Brn 2:Red 3:Org 4:Yel 5:Grn 6:Blu 7:Vio 8:Gry 9:Wht\n");
-        int b1 = get_menu_selection("Band 1 Digit (0-9)", 0, 9);
-        int b2 = get_menu_selection("Band 2 Digit (0-9)", 0, 9);
-        printf("Mults: 0:x1 1:x10 2:x100 3:x1k 4:x10k 5:x100k 6:x1M\n");
-        int mult_idx = get_menu_selection("Multiplier Index (0-6)", 0, 6);
-        
-        char tol_str[20] = "5%";
-        double final_R = ((b1 * 10) + b2) * pow(10, mult_idx);
-        printf("\n>>> Result: Resistance = %.2f Ohms (+/- %s)\n", final_R, tol_str);
-        
-        g_wb_resistor = final_R;
-        printf("(Workbench resistor updated to %.2fR)\n", g_wb_resistor);
-
-        // ====== 这里开始：生成完整色环字符串并写到 history ======
-        char colour_code_str[MAX_STR_LEN];
-        snprintf(colour_code_str, MAX_STR_LEN, "%s-%s-%s-Gold",
-                 COLOUR_DIGITS[b1],
-                 COLOUR_DIGITS[b2],
-                 COLOUR_MULTIPLIERS[mult_idx]);
-
-        char details[MAX_STR_LEN];
-        snprintf(details, MAX_STR_LEN,
-                 "Bands=%s (b1=%d, b2=%d, mult=10^%d)",
-                 colour_code_str, b1, b2, mult_idx);
-        
-        char result_str[MAX_STR_LEN];
-        char fmt_res[32]; 
-        format_eng(final_R, fmt_res);
-        // 在结果里也带上完整色环字符串
-        snprintf(result_str, MAX_STR_LEN,
-                 "%sOhms +/- %s [%s]", fmt_res, tol_str, colour_code_str);
-
-        add_record_to_history(history, count, "4-Band Decode", details, result_str);
+        printf("\n>> Resistor Colour Code Decoder\n");
+        printf("Colours: Blk Brn Red Org Yel Grn Blu Vio Gry Wht Gld Slv Pnk (full names work too)\n");
+        char buf[MAX_STR_LEN];
+        BandCode code;
+        BandValue val;
+        for (;;) {
+            get_string_input("Bands, e.g. Yel-Vio-Red-Gld", buf, sizeof(buf));
+            int rc = bands_parse(buf, strlen(buf), &code);
+            if (rc == BANDS_OK) rc = bands_decode(&code, &val);
+            if (rc == BANDS_OK) break;
+            printf("Invalid code: %s.\n", bands_strerror(rc));
+        }
+
+        char colour_code_str[BANDS_TEXT_LEN];
+        bands_format(&code, 0, colour_code_str, sizeof(colour_code_str));
+        char fmt_res[32];
+        format_eng(val.ohms, fmt_res);
+        char tol_str[32];
+        snprintf(tol_str, sizeof(tol_str), "%g%%", val.tol_pct);
+        printf("\n>>> Result: Resistance = %sOhms (+/- %s)", fmt_res, tol_str);
+        if (val.tempco_ppm) printf(", %d ppm/K", val.tempco_ppm);
+        printf("\n");
+        print_band_table(&code);
+
+        session->wb.resistor = val.ohms;
+        printf("(Workbench resistor updated to %sR)\n", fmt_res);
+
+        char details[HISTORY_TEXT_LEN];
+        snprintf(details, sizeof(details), "Bands=%s (%d bands)", colour_code_str, code.n);
+        char result_str[HISTORY_TEXT_LEN];
+        snprintf(result_str, sizeof(result_str), "%sOhms +/- %s [%s]", fmt_res, tol_str, colour_code_str);
+        add_record_to_history(session, "Colour Decode", details, result_str);
     } 
     else {
-        // ========= 电阻值 -> 最近 E24 -> 色环 =========
-        printf("\n>> Resistance -> 4-Band Colour (Nearest E24)\n");
+        // ========= 电阻值 -> 最近标准值 -> 色环 =========
+        printf("\n>> Resistance -> Colour Bands (Nearest Standard Value)\n");
         printf("Enter a resistor value (supports p/n/u/m/k/M/G suffixes, e.g. 4.7k, 220, 1M)\n");
 
-        double target_r = get_eng_input_with_default("Target Resistance", &g_wb_resistor, 1);
+        double target_r = get_eng_input_with_default("Target Resistance", &session->wb.resistor, 1);
         if (target_r <= 0.0) {
             printf("Error: resistance must be positive.\n");
             return;
         }
+        get_series_input(session);
+        const char *sname = eseries_name(session->wb.series);
 
-        // 先近似到 E24
-        double r_e24 = find_closest_e24_resistor(target_r);
-        g_wb_resistor = r_e24; // workbench 也更新一下
+        double r_std = eseries_nearest(session->wb.series, target_r);
+        session->wb.resistor = r_std; // workbench 也更新一下
 
-        char fmt_in[32], fmt_e24[32];
+        char fmt_in[32], fmt_std[32];
         format_eng(target_r, fmt_in);
-        format_eng(r_e24, fmt_e24);
-
-        printf("\n>>> Nearest E24 Standard Value: %sOhms\n", fmt_e24);
+        format_eng(r_std, fmt_std);
+        printf("\n>>> Nearest %s Standard Value: %sOhms\n", sname, fmt_std);
 
-        // 再把 E24 值转换为 4 环色环
-        int d1, d2, mult_idx;
-        if (!resistor_to_bands(r_e24, &d1, &d2, &mult_idx)) {
-            printf("Sorry, %.3g Ohms is outside the supported 4-band range (approx 10Ω to 9.9MΩ).\n", r_e24);
+        BandCode code;
+        if (resistor_code(r_std, session->wb.series, &code) != BANDS_OK) {
+            printf("Sorry, %sOhms is outside the colour-code range (10m to 99G).\n", fmt_std);
             return;
         }
-
-        printf("\n4-Band Code (assume 5%% tolerance / Gold):\n");
-        printf("  Band 1 (1st digit): %d (%s)\n", d1, COLOUR_DIGITS[d1]);
-        printf("  Band 2 (2nd digit): %d (%s)\n", d2, COLOUR_DIGITS[d2]);
-        printf("  Band 3 (Multiplier): x10^%d (%s)\n", mult_idx, COLOUR_MULTIPLIERS[mult_idx]);
-        printf("  Band 4 (Tolerance):  5%% (Gold)\n");
-
-        // ====== 这里开始：为 encode 模式写完整色环字符串到 history ======
-        char colour_code_str[MAX_STR_LEN];
-        snprintf(colour_code_str, MAX_STR_LEN, "%s-%s-%s-Gold",
-                 COLOUR_DIGITS[d1],
-                 COLOUR_DIGITS[d2],
-                 COLOUR_MULTIPLIERS[mult_idx]);
-
-        char details[MAX_STR_LEN];
-        snprintf(details, MAX_STR_LEN,
-                 "Req=%sOhms,E24=%sOhms,Bands=%s",
-                 fmt_in, fmt_e24, colour_code_str);
-
-        char result_str[MAX_STR_LEN];
-        snprintf(result_str, MAX_STR_LEN,
-                 "%sOhms -> %s (5%%, Gold)",
-                 fmt_e24, colour_code_str);
-
-        add_record_to_history(history, count, "4-Band Encode", details, result_str);
+        printf("\n%d-Band Code (%s, %g%% tolerance):\n", code.n, sname, eseries_tolerance_pct(session->wb.series));
+        print_band_table(&code);
+
+        char colour_code_str[BANDS_TEXT_LEN];
+        bands_format(&code, 0, colour_code_str, sizeof(colour_code_str));
+        char details[HISTORY_TEXT_LEN];
+        snprintf(details, sizeof(details), "Req=%sOhms,%s=%sOhms,Bands=%s", fmt_in, sname, fmt_std, colour_code_str);
+        char result_str[HISTORY_TEXT_LEN];
+        snprintf(result_str, sizeof(result_str), "%sOhms -> %s (%g%%)", fmt_std, colour_code_str,
+                 eseries_tolerance_pct(session->wb.series));
+        add_record_to_history(session, "Colour Encode", details, result_str);
     }
 }
 
 
 // --- Item 2: Ohm's Law ---
-void menu_item_2(CalcRecord **history, int *count) {
+void menu_item_2(Session *session) {
     printf("\n>> Ohm's Law & Power (Interconnected)\n");
     printf("1.V=IR  2.I=V/R  3.R=V/I  4.P=VI\n");
     int mode = get_menu_selection("Selection (1-4)", 1, 4);
@@ -398,33 +407,33 @@ void menu_item_2(CalcRecord **history, int *count) {
 
     switch (mode) {
         case 1: // V=IR
-            i = get_eng_input_with_default("Current I (Amps)", &g_wb_current, 1);
-            r = get_standard_resistor_input("R", g_wb_resistor); 
+            i = get_eng_input_with_default("Current I (Amps)", &session->wb.current, 1);
+            r = get_standard_resistor_input(session, "R", session->wb.resistor); 
             res_val = i * r;
             strcpy(tool,"Ohm's Law (V)"); snprintf(details,MAX_STR_LEN,"I=%.3eA, R=%.1eR",i,r);
             strcpy(unit, "V");
-            g_wb_voltage = res_val;
+            session->wb.voltage = res_val;
             break;
         case 2: // I=V/R
-            v = get_eng_input_with_default("Voltage V", &g_wb_voltage, 0);
-            r = get_standard_resistor_input("R", g_wb_resistor);
+            v = get_eng_input_with_default("Voltage V", &session->wb.voltage, 0);
+            r = get_standard_resistor_input(session, "R", session->wb.resistor);
             res_val = v/r;
             strcpy(tool,"Ohm's Law (I)"); snprintf(details,MAX_STR_LEN,"V=%.2fV, R=%.1eR",v,r);
             strcpy(unit, "A");
-            g_wb_current = res_val;
+            session->wb.current = res_val;
             break;
         case 3: // R=V/I
-            v = get_eng_input_with_default("Voltage V", &g_wb_voltage, 0);
-            i = get_eng_input_with_default("Current I (Amps)", &g_wb_current, 1);
+            v = get_eng_input_with_default("Voltage V", &session->wb.voltage, 0);
+            i = get_eng_input_with_default("Current I (Amps)", &session->wb.current, 1);
             if (i == 0) { printf("Error: Current cannot be zero.\n"); return; }
             res_val = v/i;
             strcpy(tool,"Ohm's Law (R)"); snprintf(details,MAX_STR_LEN,"V=%.2fV, I=%.3eA",v,i);
             strcpy(unit, "Ohms");
-            g_wb_resistor = res_val;
+            session->wb.resistor = res_val;
             break;
         case 4: // P=VI
-            v = get_eng_input_with_default("Voltage V", &g_wb_voltage, 0);
-            i = get_eng_input_with_default("Current I (Amps)", &g_wb_current, 1);
+            v = get_eng_input_with_default("Voltage V", &session->wb.voltage, 0);
+            i = get_eng_input_with_default("Current I (Amps)", &session->wb.current, 1);
             res_val = v * i;
             strcpy(tool,"Power Calc (P)"); snprintf(details,MAX_STR_LEN,"V=%.2fV, I=%.3eA",v,i);
             strcpy(unit, "W");
@@ -442,190 +451,471 @@ void menu_item_2(CalcRecord **history, int *count) {
     char result_str[MAX_STR_LEN];
     snprintf(result_str, MAX_STR_LEN, "%s %s", fmt_res, unit);
 
-    add_record_to_history(history, count, tool, details, result_str);
+    add_record_to_history(session, tool, details, result_str);
 }
 
 // --- Item 3: Voltage Divider ---
-void menu_item_3(CalcRecord **history, int *count) {
+void menu_item_3(Session *session) {
     printf("\n>> Voltage Divider\n");
-    double vin = get_eng_input_with_default("Input Voltage Vin", &g_wb_voltage, 0);
-    double r1 = get_standard_resistor_input("Top Resistor R1", g_wb_resistor);
-    double r2 = get_standard_resistor_input("Bottom Resistor R2", g_wb_resistor);
+    double vin = get_eng_input_with_default("Input Voltage Vin", &session->wb.voltage, 0);
+    get_series_input(session);
+    double r1 = get_standard_resistor_input(session, "Top Resistor R1", session->wb.resistor);
+    double r2 = get_standard_resistor_input(session, "Bottom Resistor R2", session->wb.resistor);
 
     if ((r1+r2) == 0) return;
-    double vout = vin * (r2 / (r1 + r2));
+    double vout = divider_vout(vin, r1, r2);
     printf("\n>>> Result: Vout = %.4f V\n", vout);
 
     char details[MAX_STR_LEN]; snprintf(details, MAX_STR_LEN, "Vin=%.2fV, R1=%.1eR, R2=%.1eR", vin, r1, r2);
     char result_str[MAX_STR_LEN]; snprintf(result_str, MAX_STR_LEN, "Vout=%.4f V", vout);
     
-    add_record_to_history(history, count, "Voltage Divider", details, result_str);
+    add_record_to_history(session, "Voltage Divider", details, result_str);
+
+    McSpec mc = { .design = MC_DIVIDER, .p = { vin, r1, r2 } };
+    run_tolerance_analysis(&mc, "Vout", "V", session);
+}
+
+// Strip charts for an RLC run: loop current always, Vc and Ec with a C, El with an L.
+// n samples span t_total; `rows` time buckets of `width` columns.
+static void plot_rlc_charts(int type, const double *vc, const double *il, const double *ec,
+                            const double *el, int n, double t_total, int rows, int width, int overlay) {
+    ChartTrace traces[4];
+    int n_traces = 0;
+    traces[n_traces++] = (ChartTrace){ il, "Loop Current I(t)", "A", 'I' };
+    if (type != RLC_TYPE_RL) traces[n_traces++] = (ChartTrace){ vc, "Capacitor Voltage Vc(t)", "V", 'V' };
+    if (type != RLC_TYPE_RL) traces[n_traces++] = (ChartTrace){ ec, "Stored Energy: Capacitor", "J", 'C' };
+    if (type != RLC_TYPE_RC) traces[n_traces++] = (ChartTrace){ el, "Stored Energy: Inductor", "J", 'L' };
+
+    ChartSpec chart = { .title = "RLC Transient (shared time axis)", .t_total = t_total, .rows = rows, .width = width };
+    if (overlay) {
+        chart_print(&chart, traces, n_traces, n);
+    } else {
+        for (int k = 0; k < n_traces; k++) {
+            chart.title = traces[k].label;
+            traces[k].mark = 'O';
+            chart_print(&chart, &traces[k], 1, n);
+        }
+    }
+}
+
+// History result for an RLC run, showing the quantities that matter for the circuit type
+static void rlc_result_string(int type, const RlcStats *stats, char *result_str) {
+    if (type == RLC_TYPE_RC) { 
+        // RC: Only Capacitor energy matters
+        snprintf(result_str, MAX_STR_LEN, "PkV:%.1fV Ec:%.2eJ", stats->max_vc, stats->max_ec);
+    } else if (type == RLC_TYPE_RL) { 
+        // RL: Only Inductor energy matters
+        snprintf(result_str, MAX_STR_LEN, "PkI:%.2eA El:%.2eJ", stats->max_il, stats->max_el);
+    } else { 
+        // LC/RLC: Show BOTH Capacitor and Inductor Energy clearly
+        snprintf(result_str, MAX_STR_LEN, "Ec:%.2eJ El:%.2eJ", stats->max_ec, stats->max_el);
+    }
+}
+
+// Prints a time with an engineering suffix, or "-" when the metric is unavailable (< 0)
+static void print_eng_time(const char *label, double t) {
+    char buf[32];
+    if (t < 0) { printf(" %-18s: -\n", label); return; }
+    format_eng(t, buf);
+    printf(" %-18s: %ss\n", label, buf);
+}
+
+// Streaming run: memory stays O(chart rows) for any step count, metrics come from the loop
+static void run_rlc_stream(const RlcCircuit *ckt, double t_total, Session *session) {
+    double steps_in = (double)RLC_STREAM_DEFAULT_STEPS;
+    steps_in = get_eng_input_with_default("Time Steps", &steps_in, 1);
+    long long steps = steps_in < 1 ? 1 : steps_in > RLC_STREAM_MAX_STEPS ? RLC_STREAM_MAX_STEPS : (long long)steps_in;
+    int overlay;
+    get_chart_layout(session, &overlay);
+
+    double env_buf[4][2 * RLC_STREAM_MAX_ROWS];
+    RlcEnvelope env = { session->wb.chart_rows, env_buf[0], env_buf[1], env_buf[2], env_buf[3] };
+    RlcMetrics m;
+    printf("\nStreaming %lld steps...\n", steps);
+    clock_t t0 = clock();
+    PROF_BEGIN(sim);
+    int rc = rlc_stream(ckt, t_total, steps, &env, &m);
+    PROF_END(PROF_SIM, sim);
+    if (rc != 0) { printf("Error: invalid simulation parameters.\n"); return; }
+    double secs = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    printf("[Stream] %.2f s (%.1f M steps/s), display memory %d rows\n",
+           secs, secs > 0 ? steps / secs / 1e6 : 0.0, env.rows);
+
+    // Each bucket is a { min, max } pair, so 2 samples per chart row keep the envelope exact
+    plot_rlc_charts(ckt->type, env.vc, env.il, env.ec, env.el, 2 * env.rows, t_total, env.rows,
+                    session->wb.chart_width, overlay);
+
+    const char *name = (ckt->type == RLC_TYPE_RL) ? "I" : "Vc", *unit = (ckt->type == RLC_TYPE_RL) ? "A" : "V";
+    char buf[32];
+    printf("\n--- Waveform Metrics (%s) ---\n", name);
+    printf(" %-18s: %.4f %s\n", "Final value", m.final_value, unit);
+    format_eng(m.t_peak, buf);
+    printf(" %-18s: %.4f %s at %ss (overshoot %.2f %%)\n", "Peak", m.peak, unit, buf, m.overshoot_pct);
+    print_eng_time("Rise time 10-90 %", m.t_rise);
+    print_eng_time("Settling (2 %)", m.t_settle);
+    printf(" %-18s: %lld\n", "I zero crossings", m.current_crossings);
+    if (ckt->type == RLC_TYPE_LC || ckt->type == RLC_TYPE_RLC) {
+        // Second order: compare against zeta = (R/2) sqrt(C/L) and fd = f0 sqrt(1 - zeta^2)
+        double zeta = ckt->r / 2.0 * sqrt(ckt->c / ckt->l), f0 = 1.0 / (2 * M_PI * sqrt(ckt->l * ckt->c));
+        char th[32];
+        if (m.freq_est > 0) { format_eng(m.freq_est, buf); strcat(buf, "Hz"); } else snprintf(buf, sizeof(buf), "-");
+        if (zeta < 1) { format_eng(f0 * sqrt(1 - zeta * zeta), th); strcat(th, "Hz"); } else snprintf(th, sizeof(th), "none, overdamped");
+        printf(" %-18s: %s (theory %s)\n", "Damped frequency", buf, th);
+        if (m.zeta_est >= 0) printf(" %-18s: %.4f (theory %.4f)\n", "Damping ratio", m.zeta_est, zeta);
+        else printf(" %-18s: - (theory %.4f)\n", "Damping ratio", zeta);
+    }
+    printf("\n[Result] Final Total Energy: %.4e J\n", m.stats.final_energy);
+
+    char details[MAX_STR_LEN], result_str[MAX_STR_LEN];
+    snprintf(details, MAX_STR_LEN, "RLC Type %d, Vs=%.1fV, %lld steps", ckt->type, ckt->vs, steps);
+    rlc_result_string(ckt->type, &m.stats, result_str);
+    add_record_to_history(session, "RLC Analyser", details, result_str);
+}
+
+// AC sweep: Bode magnitude / phase of one component voltage relative to the source
+static void run_rlc_ac(const RlcCircuit *ckt, Session *session) {
+    int type = ckt->type;
+    printf("Output: 1. Vc (capacitor)  2. Vr (resistor)  3. Vl (inductor)\n");
+    AcProbe probe;
+    for (;;) {
+        probe = (AcProbe)get_menu_selection("Select Output Voltage", 1, 3);
+        if (ac_probe_valid(type, probe)) break;
+        printf("This circuit has no such component.\n");
+    }
+    double f_lo, f_hi;
+    ac_auto_range(ckt, &f_lo, &f_hi);
+    f_lo = get_eng_input_with_default("Start Frequency (Hz)", &f_lo, 1);
+    f_hi = get_eng_input_with_default("Stop Frequency (Hz)", &f_hi, 1);
+    if (!(f_lo > 0) || !(f_hi > f_lo)) { printf("Error: need 0 < start < stop.\n"); return; }
+    double points = AC_DEFAULT_POINTS;
+    points = get_eng_input_with_default("Sweep Points", &points, 1);
+    int n = points < 100 ? 100 : points > AC_MAX_POINTS ? AC_MAX_POINTS : (int)points;
+    int overlay;
+    get_chart_layout(session, &overlay);
+
+    AcSweep sw;
+    if (ac_sweep_alloc(&sw, n) != 0) { printf("Memory Error.\n"); return; }
+    clock_t t0 = clock();
+    PROF_BEGIN(sim);
+    ac_run(ckt, probe, f_lo, f_hi, &sw);
+    PROF_END(PROF_SIM, sim);
+    printf("\n[AC] %d log-spaced points in %.1f ms\n", n, (double)(clock() - t0) * 1000.0 / CLOCKS_PER_SEC);
+
+    char title[64];
+    snprintf(title, sizeof(title), "Bode: H = %s / Vs", ac_probe_name(probe));
+    ChartTrace traces[2] = {
+        { sw.mag_db, "Magnitude |H|", "dB", 'M' },
+        { sw.phase_deg, "Phase", "deg", 'P' }
+    };
+    ChartSpec chart = { .title = title, .rows = session->wb.chart_rows, .width = session->wb.chart_width,
+                        .x_unit = "Hz", .x_min = f_lo, .x_max = f_hi, .x_log = 1 };
+    if (overlay) chart_print(&chart, traces, 2, n);
+    else {
+        for (int k = 0; k < 2; k++) {
+            chart.title = traces[k].label;
+            traces[k].mark = 'O';
+            chart_print(&chart, &traces[k], 1, n);
+        }
+    }
+
+    // --- Summary ---
+    AcSummary sum;
+    ac_summarize(&sw, &sum);
+    char fbuf[32], lo[32], hi[32];
+    format_eng(sum.f_peak, fbuf);
+    printf("\n--- AC Summary (%s / Vs) ---\n", ac_probe_name(probe));
+    printf(" %-18s: %.2f dB at %sHz%s\n", "Peak", sum.peak_db, fbuf, sum.resonant ? " (resonance)" : " (sweep end)");
+    if (sum.f_lo3 > 0) { format_eng(sum.f_lo3, lo); strcat(lo, "Hz"); } else snprintf(lo, sizeof(lo), "-");
+    if (sum.f_hi3 > 0) { format_eng(sum.f_hi3, hi); strcat(hi, "Hz"); } else snprintf(hi, sizeof(hi), "-");
+    printf(" %-18s: %s / %s\n", "-3 dB points", lo, hi);
+    if (sum.bandwidth > 0) { format_eng(sum.bandwidth, fbuf); printf(" %-18s: %sHz\n", "Bandwidth", fbuf); }
+    if (type == RLC_TYPE_LC || type == RLC_TYPE_RLC) {
+        double q_th = sqrt(ckt->l / ckt->c) / ckt->r;
+        format_eng(1.0 / (2 * M_PI * sqrt(ckt->l * ckt->c)), fbuf);
+        printf(" %-18s: %sHz\n", "f0 (theory)", fbuf);
+        if (sum.q > 0) printf(" %-18s: %.4g (theory %.4g)\n", "Q", sum.q, q_th);
+        else printf(" %-18s: - (theory %.4g)\n", "Q", q_th);
+    } else {
+        format_eng(type == RLC_TYPE_RC ? 1.0 / (2 * M_PI * ckt->r * ckt->c) : ckt->r / (2 * M_PI * ckt->l), fbuf);
+        printf(" %-18s: %sHz\n", "Corner (theory)", fbuf);
+    }
+
+    // --- Optional full-resolution export ---
+    printf("\nExport all %d points? (y/n): ", n); char buf[MAX_INPUT_LEN];
+    if (read_input(buf, sizeof(buf)) && tolower(buf[0]) == 'y') {
+        printf("Format: 1. CSV  2. Binary (float64 columns, numpy.memmap)\n");
+        int format = get_menu_selection("Select Format", 1, 2);
+        char fname[128];
+        if (get_save_filename(format == WAVE_FMT_BIN ? ".bin" : ".csv", fname, sizeof(fname))) {
+            WaveColumn cols[5] = { { "f", "Hz", sw.f }, { "mag", "dB", sw.mag_db }, { "phase", "deg", sw.phase_deg },
+                                   { "re", "1", sw.re }, { "im", "1", sw.im } };
+            static const char *TYPE_NAMES[] = { "", "rc", "rl", "lc", "rlc" };
+            char meta[256];
+            snprintf(meta, sizeof(meta), "kind=ac\ntype=%s\nprobe=%s\nr=%.17g\nl=%.17g\nc=%.17g\n",
+                     TYPE_NAMES[type], ac_probe_name(probe), ckt->r, ckt->l, ckt->c);
+            PROF_BEGIN(exp);
+            int rc = wave_write(fname, format, cols, 5, n, 0, meta);
+            PROF_END(PROF_EXPORT, exp);
+            if (rc < 0) printf("Error writing '%s'.\n", fname);
+            else printf("Saved %d points to '%s'.\n", n, fname);
+        }
+    }
+
+    char details[MAX_STR_LEN], result_str[MAX_STR_LEN];
+    snprintf(details, MAX_STR_LEN, "AC RLC Type %d, %s/Vs", type, ac_probe_name(probe));
+    format_eng(sum.f_peak, fbuf);
+    if (sum.q > 0) snprintf(result_str, MAX_STR_LEN, "Pk:%.1fdB@%sHz Q:%.3g", sum.peak_db, fbuf, sum.q);
+    else if (sum.f_hi3 > 0 || sum.f_lo3 > 0) {
+        format_eng(sum.f_hi3 > 0 ? sum.f_hi3 : sum.f_lo3, hi);
+        snprintf(result_str, MAX_STR_LEN, "Pk:%.1fdB -3dB@%sHz", sum.peak_db, hi);
+    } else snprintf(result_str, MAX_STR_LEN, "Pk:%.1fdB@%sHz", sum.peak_db, fbuf);
+    add_record_to_history(session, "RLC Analyser", details, result_str);
+    ac_sweep_free(&sw);
+}
+
+// Spectrum of a stored transient (sample i at t = i * t_total / n): dominant frequencies,
+// harmonics of the strongest one and THD, plus an amplitude chart in dB
+static void run_rlc_fft(const RlcCircuit *ckt, const double *vc, const double *il, int n, double t_total,
+                        Session *session) {
+    int type = ckt->type;
+    const double *x = il;
+    const char *name = "I", *unit = "A";
+    if (type != RLC_TYPE_RL) {
+        printf("Signal: 1. Loop current I  2. Capacitor voltage Vc\n");
+        if (get_menu_selection("Select Signal", 1, 2) == 2) { x = vc; name = "Vc"; unit = "V"; }
+    }
+    printf("Window: 1. Rectangular  2. Hann  3. Hamming  4. Blackman  5. Flat-top (accurate amplitude)\n");
+    FftWindow win = (FftWindow)get_menu_selection("Select Window", 1, 5);
+
+    int nb = n / 2 + 1;
+    double *amp = malloc((size_t)nb * sizeof(double));
+    if (!amp) { printf("Memory Error.\n"); return; }
+    clock_t t0 = clock();
+    PROF_BEGIN(sim);
+    int rc = fft_amplitude_spectrum(x, n, win, amp);
+    PROF_END(PROF_SIM, sim);
+    if (rc < 0) { printf("Error: FFT failed.\n"); free(amp); return; }
+    double fs = n / t_total, df = fs / n;
+    char fbuf[32], dbuf[32];
+    format_eng(fs, fbuf); format_eng(df, dbuf);
+    printf("\n[FFT] %d samples (%s window) in %.1f ms, fs = %sHz, resolution %sHz\n",
+           n, fft_window_name(win), (double)(clock() - t0) * 1000.0 / CLOCKS_PER_SEC, fbuf, dbuf);
+
+    FftPeak peaks[5];
+    int n_peaks = fft_peaks(amp, nb, df, fft_window_lobe_bins(win) + 1, peaks, 5);
+    printf("\n--- Dominant Frequencies (%s, mean removed) ---\n", name);
+    if (n_peaks == 0) printf(" (none: signal has no oscillating content)\n");
+    for (int i = 0; i < n_peaks; i++) {
+        format_eng(peaks[i].freq, fbuf);
+        printf(" %d. %10sHz  %.4e %s\n", i + 1, fbuf, peaks[i].amp, unit);
+    }
+    double zeta = (type == RLC_TYPE_LC || type == RLC_TYPE_RLC) ? ckt->r / 2.0 * sqrt(ckt->c / ckt->l) : 1;
+    if (zeta < 1) {
+        format_eng(sqrt(1 - zeta * zeta) / (2 * M_PI * sqrt(ckt->l * ckt->c)), fbuf);
+        printf(" Damped frequency (theory): %sHz\n", fbuf);
+    }
+
+    double thd = -1;
+    if (n_peaks > 0) {
+        FftPeak harm[10];
+        int n_harm = fft_harmonics(amp, nb, df, peaks[0].freq, 10, harm, &thd);
+        format_eng(peaks[0].freq, fbuf);
+        printf("\n--- Harmonics of %sHz ---\n", fbuf);
+        for (int h = 0; h < n_harm; h++) {
+            format_eng(harm[h].freq, fbuf);
+            printf(" H%-2d %10sHz  %.4e %s  (%6.1f dBc)\n", h + 1, fbuf, harm[h].amp, unit,
+                   harm[h].amp > 0 ? 20 * log10(harm[h].amp / harm[0].amp) : -999.0);
+        }
+        if (thd >= 0) printf(" THD: %.3f %%\n", thd);
+        else printf(" (too few cycles recorded to resolve harmonics: lengthen the simulation time)\n");
+
+        // Chart the band that holds the content: up to 10x the dominant frequency by default
+        double f_max = 10 * peaks[0].freq;
+        if (f_max > fs / 2) f_max = fs / 2;
+        f_max = get_eng_input_with_default("Chart up to Frequency (Hz)", &f_max, 1);
+        int n_chart = (int)(f_max / df) + 1;
+        if (n_chart > nb) n_chart = nb;
+        if (n_chart >= 2) {
+            double ref = peaks[0].amp;
+            for (int k = 0; k < n_chart; k++) amp[k] = amp[k] > ref * 1e-6 ? 20 * log10(amp[k] / ref) : -120.0;
+            char title[64];
+            snprintf(title, sizeof(title), "Spectrum of %s (dB rel. strongest peak)", name);
+            ChartTrace tr = { amp, "Amplitude", "dB", 'O' };
+            ChartSpec chart = { .title = title, .rows = session->wb.chart_rows, .width = session->wb.chart_width,
+                                .x_unit = "Hz", .x_min = 0, .x_max = (n_chart - 1) * df };
+            chart_print(&chart, &tr, 1, n_chart);
+        }
+    }
+
+    char details[MAX_STR_LEN], result_str[MAX_STR_LEN];
+    snprintf(details, MAX_STR_LEN, "FFT RLC Type %d, %s, %d pts", type, name, n);
+    if (n_peaks > 0) {
+        format_eng(peaks[0].freq, fbuf);
+        if (thd >= 0) snprintf(result_str, MAX_STR_LEN, "Pk:%sHz THD:%.2f%%", fbuf, thd);
+        else snprintf(result_str, MAX_STR_LEN, "Pk:%sHz", fbuf);
+    } else snprintf(result_str, MAX_STR_LEN, "No peaks");
+    add_record_to_history(session, "RLC Analyser", details, result_str);
+    free(amp);
 }
 
 // --- Item 4: Universal RLC Transient Analyser (Vertical Detail Mode) ---
-void menu_item_4(CalcRecord **history, int *count) {
-    printf("\n>> RLC Transient Analyser (Vertical Detail Mode)\n");
+void menu_item_4(Session *session) {
+    printf("\n>> RLC Analyser: Transient & AC (Vertical Detail Mode)\n");
     printf("1. RC (Resistor-Capacitor)\n");
     printf("2. RL (Resistor-Inductor)\n");
     printf("3. LC (Inductor-Capacitor)\n");
     printf("4. RLC (Series Resistor-Inductor-Capacitor)\n");
     int type = get_menu_selection("Select Circuit Type", 1, 4);
+    printf("Analysis: 1. Transient (step response)  2. AC sweep (Bode magnitude / phase)\n");
+    int ac = get_menu_selection("Select Analysis", 1, 2) == 2;
 
     // --- 1. Inputs ---
-    double vs = get_eng_input_with_default("Step Input Voltage Vs", &g_wb_voltage, 0);
-    double r = 0, l = 0, c = 0;
+    RlcCircuit ckt = { type, 1.0, 0, 0, 0 };   // AC: transfer function, Vs does not matter
+    if (!ac) ckt.vs = get_eng_input_with_default("Step Input Voltage Vs", &session->wb.voltage, 0);
 
-    if (type != 3) r = get_standard_resistor_input("Series Resistor R", g_wb_resistor);
-    else { r = 0.1; printf("[Info] LC: Using 0.1 Ohm internal resistance.\n"); }
+    if (type != RLC_TYPE_LC) ckt.r = get_standard_resistor_input(session, "Series Resistor R", session->wb.resistor);
+    else printf("[Info] LC: Using 0.1 Ohm internal resistance.\n");
 
-    if (type != 1) l = get_eng_input_with_default("Inductance L", &g_wb_inductor, 1);
-    if (type != 2) c = get_eng_input_with_default("Capacitance C", &g_wb_capacitor, 1);
+    if (type != RLC_TYPE_RC) ckt.l = get_eng_input_with_default("Inductance L", &session->wb.inductor, 1);
+    if (type != RLC_TYPE_RL) ckt.c = get_eng_input_with_default("Capacitance C", &session->wb.capacitor, 1);
 
     // Safety
-    if (type == 1 && c <= 0) c = 1e-6;
-    if ((type != 1) && l <= 0) l = 1e-3;
+    rlc_apply_safety(&ckt);
+    if (ac) { run_rlc_ac(&ckt, session); return; }
 
     // --- 2. Auto-Time Calculation ---
-    double t_total = 0;
-    if (type == 1) t_total = 5.0 * r * c; // RC
-    else if (type == 2) t_total = 5.0 * (l / r); // RL
-    else if (type == 3) t_total = 3.0 * (1.0 / (1.0/(2*M_PI*sqrt(l*c)))); // LC (3 periods)
-    else if (type == 4) {
-        // RLC Auto-detection
-        double alpha = r / (2.0 * l);
-        double omega0 = 1.0 / sqrt(l * c);
-        if (alpha < omega0) {
-            // Underdamped: ensure we see oscillations
-            t_total = 10.0 * (2*M_PI/omega0); 
-            // Cap at reasonable decay time
-            double t_decay = 5.0 / alpha;
-            if (t_total > t_decay) t_total = t_decay;
-        } else {
-            // Overdamped/Crit: settle time
-            t_total = 10.0 / alpha; 
-        }
-    }
+    double t_total = rlc_auto_time(&ckt);
     t_total = get_eng_input_with_default("Total Simulation Time", &t_total, 1);
 
+    printf("Integrator: 1. Euler (fixed steps, x%d sub-steps)  2. Adaptive RK45 (Dormand-Prince)  3. Exact (closed form)\n"
+           "            4. Streaming (exact discrete steps, constant memory, waveform metrics)\n", SIM_SUBSTEPS);
+    int method = get_menu_selection("Select Integrator", 1, 4);
+    if (method == 4) { run_rlc_stream(&ckt, t_total, session); return; }
+
+    // Sample count: the default suits the plots, larger runs are meant for export
+    double samples = SIM_STEPS;
+    samples = get_eng_input_with_default("Stored Samples", &samples, 1);
+    int steps = (samples < SIM_STEPS) ? SIM_STEPS : (samples > SIM_MAX_STEPS) ? SIM_MAX_STEPS : (int)samples;
+    if (steps != samples) printf("[Info] Samples clamped to %d.\n", steps);
+    double rtol = RK45_DEFAULT_RTOL, atol = RK45_DEFAULT_ATOL;
+    while (method == 2) {
+        rtol = get_eng_input_with_default("Relative Tolerance", &rtol, 1);
+        atol = get_eng_input_with_default("Absolute Tolerance", &atol, 1);
+        if (rlc_rk45_tolerance_ok(rtol, atol)) break;
+        printf("Absolute tolerance must be > 0 and relative tolerance >= %.3g.\n", RK45_MIN_RTOL);
+        rtol = RK45_DEFAULT_RTOL; atol = RK45_DEFAULT_ATOL;
+    }
+
     // --- 3. High-Res Simulation ---
-    // We simulate at high resolution, then the plotter downsamples for display
-    #define SIM_STEPS 1000 
-    double dt = t_total / SIM_STEPS;
-    
-    double *data_vc = malloc(SIM_STEPS * sizeof(double));
-    double *data_il = malloc(SIM_STEPS * sizeof(double));
-    double *data_ec = malloc(SIM_STEPS * sizeof(double));
-    double *data_el = malloc(SIM_STEPS * sizeof(double));
+    double *data_vc = malloc((size_t)steps * sizeof(double));
+    double *data_il = malloc((size_t)steps * sizeof(double));
+    double *data_ec = malloc((size_t)steps * sizeof(double));
+    double *data_el = malloc((size_t)steps * sizeof(double));
 
     if (!data_vc || !data_il || !data_ec || !data_el) {
-        printf("Memory Error.\n"); return;
+        printf("Memory Error.\n");
+        free(data_vc); free(data_il); free(data_ec); free(data_el);
+        return;
     }
 
-    double vc = 0, il = 0;
-    // Track stats for history
-    double max_vc = 0, max_il = 0;
-    double max_ec = 0, max_el = 0; // Track max energy stored in each component
-
-    printf("\nComputing %d steps...\n", SIM_STEPS);
-
-    for (int i = 0; i < SIM_STEPS; i++) {
-        // Store Snapshot
-        data_vc[i] = vc;
-        data_il[i] = il;
-        data_ec[i] = (type == 2) ? 0 : 0.5 * c * vc * vc;
-        data_el[i] = (type == 1) ? 0 : 0.5 * l * il * il;
-        
-        // Track Peaks
-        if (fabs(vc) > max_vc) max_vc = fabs(vc);
-        if (fabs(il) > max_il) max_il = fabs(il);
-        if (data_ec[i] > max_ec) max_ec = data_ec[i];
-        if (data_el[i] > max_el) max_el = data_el[i];
-
-        // Euler Integration (Physics)
-        for(int k=0; k<10; k++) {
-            double loop_dt = dt / 10.0;
-            double v_r = il * r;
-            double v_c = (type == 2) ? 0 : vc;
-            double v_l = vs - v_r - v_c;
-
-            if (type == 1) { // RC
-                il = (vs - vc) / r;
-                vc += (il / c) * loop_dt;
-            } else { // RL, LC, RLC
-                double d_il = v_l / l;
-                il += d_il * loop_dt;
-                if (type != 2) vc += (il / c) * loop_dt;
-            }
+    printf("\nComputing %d steps...\n", steps);
+
+    RlcTrace trace = { data_vc, data_il, data_ec, data_el };
+    RlcStats stats;
+    PROF_BEGIN(sim);
+    if (method == 1) {
+        rlc_simulate_euler(&ckt, t_total, steps, &trace, &stats);
+        PROF_END(PROF_SIM, sim);
+    } else if (method == 3) {
+        static const char *RESPONSE_NAMES[] = { "exponential", "overdamped", "critically damped", "underdamped" };
+        rlc_simulate_analytic(&ckt, t_total, steps, &trace, &stats);
+        PROF_END(PROF_SIM, sim);
+        printf("[Exact] Response class: %s\n", RESPONSE_NAMES[rlc_classify(&ckt)]);
+    } else {
+        RlcSolverInfo info;
+        int rc = rlc_simulate_rk45(&ckt, t_total, steps, rtol, atol, &trace, &stats, &info);
+        PROF_END(PROF_SIM, sim);
+        if (rc != 0) {
+            printf("Error: %s.\n", rlc_rk45_strerror(rc));
+            free(data_vc); free(data_il); free(data_ec); free(data_el);
+            return;
         }
+        printf("[RK45] %ld derivative evaluations (%ld accepted / %ld rejected steps), Euler uses %ld.\n",
+               info.n_evals, info.n_accepted, info.n_rejected, (long)steps * SIM_SUBSTEPS);
+    }
+    if (method != 3) {
+        // Validate the numerical result against the closed-form solution
+        double err_vc, err_il;
+        rlc_compare_exact(&ckt, t_total, steps, &trace, &err_vc, &err_il);
+        printf("[Check] Max deviation from exact: Vc %.3e V, I %.3e A\n", err_vc, err_il);
     }
 
     // --- 4. Vertical Plotting with Values ---
-    // Plot 1: Loop Current (All types have current)
-    plot_vertical_strip_chart(data_il, SIM_STEPS, t_total, "Loop Current I(t)", "A");
-
-    // Plot 2: Capacitor Voltage (if C exists)
-    if (type != 2) 
-        plot_vertical_strip_chart(data_vc, SIM_STEPS, t_total, "Capacitor Voltage Vc(t)", "V");
-
-    // Plot 3: Energy Analysis
-    if (type != 2)
-        plot_vertical_strip_chart(data_ec, SIM_STEPS, t_total, "Stored Energy: Capacitor", "J");
-    
-    if (type != 1)
-        plot_vertical_strip_chart(data_el, SIM_STEPS, t_total, "Stored Energy: Inductor", "J");
+    int overlay;
+    get_chart_layout(session, &overlay);
+    plot_rlc_charts(type, data_vc, data_il, data_ec, data_el, steps, t_total, session->wb.chart_rows,
+                    session->wb.chart_width, overlay);
 
     // Summary for Console
-    double final_energy = data_ec[SIM_STEPS-1] + data_el[SIM_STEPS-1];
-    printf("\n[Result] Final Total Energy: %.4e J\n", final_energy);
+    printf("\n[Result] Final Total Energy: %.4e J\n", stats.final_energy);
+
+    // --- Optional spectrum of the stored samples ---
+    printf("\nSpectrum analysis (FFT)? (y/n): "); char buf[MAX_INPUT_LEN];
+    if (read_input(buf, sizeof(buf)) && tolower(buf[0]) == 'y')
+        run_rlc_fft(&ckt, data_vc, data_il, steps, t_total, session);
+
+    // --- Optional full-resolution export ---
+    printf("\nExport all %d samples? (y/n): ", steps);
+    if (read_input(buf, sizeof(buf)) && tolower(buf[0]) == 'y') {
+        static const char *METHOD_NAMES[] = { "", "euler", "rk45", "exact" };
+        printf("Format: 1. CSV  2. Binary (float64 columns, numpy.memmap)\n");
+        int format = get_menu_selection("Select Format", 1, 2);
+        char fname[128];
+        if (get_save_filename(format == WAVE_FMT_BIN ? ".bin" : ".csv", fname, sizeof(fname))) {
+            RlcTrace out = { type != RLC_TYPE_RL ? data_vc : NULL, data_il,
+                             type != RLC_TYPE_RL ? data_ec : NULL, type != RLC_TYPE_RC ? data_el : NULL };
+            PROF_BEGIN(exp);
+            int rc = wave_export(fname, format, &ckt, METHOD_NAMES[method], t_total, steps, &out);
+            PROF_END(PROF_EXPORT, exp);
+            if (rc < 0)
+                printf("Error writing '%s'.\n", fname);
+            else printf("Saved %d samples to '%s'.\n", steps, fname);
+        }
+    }
 
     // --- 5. Save History (Intelligent Logic) ---
     char details[MAX_STR_LEN];
-    snprintf(details, MAX_STR_LEN, "RLC Type %d, Vs=%.1fV", type, vs);
+    snprintf(details, MAX_STR_LEN, "RLC Type %d, Vs=%.1fV", type, ckt.vs);
     
-    // Create intelligent result string that distinguishes components
     char result_str[MAX_STR_LEN];
-    
-    if (type == 1) { 
-        // RC: Only Capacitor energy matters
-        snprintf(result_str, MAX_STR_LEN, "PkV:%.1fV Ec:%.2eJ", max_vc, max_ec);
-    } else if (type == 2) { 
-        // RL: Only Inductor energy matters
-        snprintf(result_str, MAX_STR_LEN, "PkI:%.2eA El:%.2eJ", max_il, max_el);
-    } else { 
-        // LC/RLC: Show BOTH Capacitor and Inductor Energy clearly
-        snprintf(result_str, MAX_STR_LEN, "Ec:%.2eJ El:%.2eJ", max_ec, max_el);
-    }
+    rlc_result_string(type, &stats, result_str);
 
-    add_record_to_history(history, count, "RLC Analyser", details, result_str);
+    add_record_to_history(session, "RLC Analyser", details, result_str);
 
     // Cleanup
     free(data_vc); free(data_il); free(data_ec); free(data_el);
 }
 
 // --- Item 5: LED Calculator (Automated) ---
-void menu_item_5(CalcRecord **history, int *count) {
-    printf("\n>> LED Resistor Calc (Automatic E24 Selection)\n");
+void menu_item_5(Session *session) {
+    printf("\n>> LED Resistor Calc (Automatic E-Series Selection)\n");
     // 1. Get Inputs
-    double vs = get_eng_input_with_default("Supply Voltage Vs", &g_wb_voltage, 0);
-    double vf = get_eng_input_with_default("LED Forward Voltage Vf", &g_wb_vf, 0);
-    double target_i = get_eng_input_with_default("Target LED Current", &g_wb_current, 1);
-
-    // Basic Validation
-    if (vf >= vs) {
+    double vs = get_eng_input_with_default("Supply Voltage Vs", &session->wb.voltage, 0);
+    double vf = get_eng_input_with_default("LED Forward Voltage Vf", &session->wb.vf, 0);
+    double target_i = get_eng_input_with_default("Target LED Current", &session->wb.current, 1);
+    get_series_input(session);
+    const char *sname = eseries_name(session->wb.series);
+
+    // 2-4. Ideal resistance, nearest standard value, actual current (with validation)
+    LedDesign led;
+    int rc = led_design(vs, vf, target_i, session->wb.series, &led);
+    if (rc == -1) {
         printf("Error: Supply voltage must be greater than LED forward voltage.\n"); return;
     }
-    if (target_i <= 0) {
+    if (rc == -2) {
         printf("Error: Target current must be positive.\n"); return;
     }
-
-    // 2. Calculate Ideal Resistance
-    double r_ideal = (vs - vf) / target_i;
-
-    // 3. Find Nearest E24 Standard Resistor (Automatic)
-    double r_standard = find_closest_e24_resistor(r_ideal);
-
-    // 4. Re-calculate Actual Current with Standard Resistor
-    double i_actual = (vs - vf) / r_standard;
+    double r_ideal = led.r_ideal, r_standard = led.r_std, i_actual = led.i_actual;
 
     // 5. Output Results
     printf("\n>>> Results:\n");
@@ -636,169 +926,493 @@ void menu_item_5(CalcRecord **history, int *count) {
     printf("Theoretical Ideal Resistor: %sOhms\n", fmt_buf);
     
     format_eng(r_standard, fmt_buf);
-    printf("Nearest Standard E24 Value: %sOhms  <-- Recommended\n", fmt_buf);
+    printf("Nearest Standard %s Value: %sOhms  <-- Recommended\n", sname, fmt_buf);
     
     format_eng(i_actual, fmt_buf);
-    printf("Actual Current with E24 R : %sA\n", fmt_buf);
+    printf("Actual Current with %s R : %sA\n", sname, fmt_buf);
     printf("-----------------------------------------------------\n");
 
     // Update workbench variables with practical values
-    g_wb_resistor = r_standard;
-    g_wb_current = i_actual;
+    session->wb.resistor = r_standard;
+    session->wb.current = i_actual;
     printf("(Workbench set to R=%.2e, I=%.2e)\n", r_standard, i_actual);
 
     // 6. Save to History
-    char details[MAX_STR_LEN];
+    char details[HISTORY_TEXT_LEN];
     // Format history detail to show inputs and practical outputs
-    snprintf(details, MAX_STR_LEN, "Vs=%.1fV,Vf=%.1fV->Rstd=%.2eR", vs, vf, r_standard);
+    snprintf(details, sizeof(details), "Vs=%.1fV,Vf=%.1fV->Rstd=%.2eR", vs, vf, r_standard);
     
-    char result_str[MAX_STR_LEN];
+    char result_str[HISTORY_TEXT_LEN];
     char s_r[32], s_i[32]; format_eng(r_standard, s_r); format_eng(i_actual, s_i);
-    snprintf(result_str, MAX_STR_LEN, "R_std=%s, I_act=%sA", s_r, s_i);
+    snprintf(result_str, sizeof(result_str), "R_std=%s, I_act=%sA", s_r, s_i);
     
-    add_record_to_history(history, count, "LED Resistor Calc", details, result_str);
+    add_record_to_history(session, "LED Resistor Calc", details, result_str);
+
+    McSpec mc = { .design = MC_LED, .p = { vs, vf, r_standard } };
+    run_tolerance_analysis(&mc, "LED current", "A", session);
 }
 
 // --- Item 6: Op-Amp Gain Designer (Replaces Cap Energy) ---
-void menu_item_6(CalcRecord **history, int *count) {
+void menu_item_6(Session *session) {
     printf("\n>> Op-Amp Gain Designer (Non-Inv & Inverting)\n");
     printf("1. Non-Inverting Amplifier (Gain = 1 + R2/R1)\n");
     printf("2. Inverting Amplifier     (Gain = - R2/R1)\n");
     int mode = get_menu_selection("Mode", 1, 2);
 
     double target_gain = get_eng_input_with_default("Target Gain (magnitude)", NULL, 0);
-    if (target_gain < 1.0 && mode == 1) {
+    if (target_gain < 1.0 && mode == OPAMP_NON_INVERTING) {
         printf("Error: Non-inverting gain must be >= 1.\n"); return;
     }
+    get_series_input(session);
+
+    // Every pair of series values from 10 Ohm to 10 MOhm is considered; see opamp_search()
+    OpAmpSearch spec = { mode, target_gain, session->wb.series, 0, 0, 0, 0, 0, 0, 5 };
+    double top = spec.top_k;
+    top = get_eng_input_with_default("Pairs to list (1-50)", &top, 0);
+    spec.top_k = top < 1 ? 1 : top > OPAMP_MAX_TOP ? OPAMP_MAX_TOP : (int)top;
+
+    char buf[MAX_INPUT_LEN];
+    get_string_input("Limit total resistance / feedback current? (y/n)", buf, sizeof(buf));
+    if (buf[0] == 'y' || buf[0] == 'Y') {
+        double rtot_min = 0, rtot_max = 0, ifb_max = 0;
+        spec.rtot_min = get_eng_input_with_default("Min R1+R2 (0 = none)", &rtot_min, 1);
+        spec.rtot_max = get_eng_input_with_default("Max R1+R2 (0 = none)", &rtot_max, 1);
+        spec.vout = get_eng_input_with_default("Peak output |Vout| (0 = no current limit)", &session->wb.voltage, 0);
+        if (spec.vout != 0) spec.ifb_max = get_eng_input_with_default("Max feedback current", &ifb_max, 1);
+    }
 
-    // Ask for one resistor to fix, or iterate best match?
-    // Let's iterate E24 logic: Fix R1 (Standard), calculate ideal R2, find closest Standard R2.
-    // We try a few standard R1 bases to find the best pair.
-    
-    printf("\ncalculating best E24 resistor pairs...\n");
-    printf("--------------------------------------------------\n");
-    printf("| %-9s | %-9s | %-10s | %-8s |\n", "Fix R1", "Calc R2", "Std R2", "Error %");
-    printf("--------------------------------------------------\n");
-
-    double best_error = 100.0;
-    double best_r1 = 0, best_r2 = 0, best_act_gain = 0;
-
-    // We will test R1 values from 1k to 100k (common range) from the E24 array
-    // E24_BASE has values 1.0 to 9.1. We multiply by 1k, 10k, 100k.
-    double multipliers[] = {1000.0, 10000.0, 100000.0};
-    
-    for (int m = 0; m < 3; m++) {
-        for (int i = 0; i < E24_COUNT; i++) {
-            double r1 = E24_BASE[i] * multipliers[m];
-            
-            // Calculate ideal R2 based on gain formula
-            double r2_ideal = 0;
-            if (mode == 1) r2_ideal = r1 * (target_gain - 1.0); // G = 1 + R2/R1 -> R2 = R1(G-1)
-            else           r2_ideal = r1 * target_gain;         // G = R2/R1     -> R2 = R1*G
-            
-            if (r2_ideal <= 0) continue; // Gain=1 case for Non-Inv means R2=0 (Wire)
-
-            // Find closest E24 for R2
-            double r2_std = find_closest_e24_resistor(r2_ideal);
-            
-            // Calc actual gain
-            double act_gain = (mode == 1) ? (1.0 + r2_std/r1) : (r2_std/r1);
-            double error = fabs((act_gain - target_gain) / target_gain) * 100.0;
-
-            // Print top 5 reasonable matches or if error is very low
-            if (error < 2.0 && best_error > 0.01) { // Just show a few good ones
-                char s_r1[16], s_r2[16];
-                format_eng(r1, s_r1); format_eng(r2_std, s_r2);
-                printf("| %-9s | %-9.2f | %-10s | %5.2f%%   |\n", s_r1, r2_ideal, s_r2, error);
-            }
+    OpAmpDesign pairs[OPAMP_MAX_TOP];
+    PROF_BEGIN(sim);
+    int n_pairs = opamp_search(&spec, pairs);
+    PROF_END(PROF_SIM, sim);
+    if (n_pairs <= 0) {
+        if (mode == OPAMP_NON_INVERTING && target_gain == 1.0)
+            printf("Gain of exactly 1: use a voltage follower (R2 = 0, R1 open).\n");
+        else
+            printf("No resistor pair satisfies the limits.\n");
+        return;
+    }
 
-            if (error < best_error) {
-                best_error = error;
-                best_r1 = r1;
-                best_r2 = r2_std;
-                best_act_gain = act_gain;
-            }
-        }
+    printf("\nBest %s resistor pairs (10 Ohm - 10 MOhm):\n", eseries_name(session->wb.series));
+    printf("-----------------------------------------------------------------------\n");
+    printf("| %-3s | %-9s | %-9s | %-9s | %-9s | %-9s |\n", "#", "R1", "R2", "R1+R2", "Gain", "Error %");
+    printf("-----------------------------------------------------------------------\n");
+    for (int k = 0; k < n_pairs; k++) {
+        char s1[32], s2[32], st[32];
+        format_eng(pairs[k].r1, s1); format_eng(pairs[k].r2, s2); format_eng(pairs[k].r1 + pairs[k].r2, st);
+        printf("| %-3d | %-9s | %-9s | %-9s | %-9.4f | %-9.4f |\n",
+               k + 1, s1, s2, st, pairs[k].gain, pairs[k].error_pct);
     }
-    printf("--------------------------------------------------\n");
-    
+    printf("-----------------------------------------------------------------------\n");
+
+    OpAmpDesign best = pairs[0];
     char s_r1[32], s_r2[32];
-    format_eng(best_r1, s_r1); format_eng(best_r2, s_r2);
+    format_eng(best.r1, s_r1); format_eng(best.r2, s_r2);
 
     printf("\n>>> Best Recommendation:\n");
     printf("    R1 = %sOhms\n", s_r1);
     printf("    R2 = %sOhms\n", s_r2);
-    printf("    Actual Gain = %.4f (Error: %.3f%%)\n", best_act_gain, best_error);
+    printf("    Actual Gain = %.4f (Error: %.3f%%)\n", best.gain, best.error_pct);
+    if (spec.vout != 0) {
+        char s_i[32]; format_eng(opamp_feedback_current(mode, spec.vout, best.r1, best.r2), s_i);
+        printf("    Feedback current at |Vout| = %sA\n", s_i);
+    }
 
     // Update Workbench
-    g_wb_resistor = best_r1; // Set R1 as default for next operations
+    session->wb.resistor = best.r1; // Set R1 as default for next operations
     printf("(Workbench R set to R1: %s)\n", s_r1);
 
-    char details[MAX_STR_LEN];
-    snprintf(details, MAX_STR_LEN, "%s, Tgt G=%.2f", 
+    char details[HISTORY_TEXT_LEN];
+    snprintf(details, sizeof(details), "%s, Tgt G=%.2f", 
              (mode==1?"Non-Inv":"Inv"), target_gain);
     
-    char result_str[MAX_STR_LEN];
-    snprintf(result_str, MAX_STR_LEN, "R1=%s, R2=%s, G=%.2f", s_r1, s_r2, best_act_gain);
+    char result_str[HISTORY_TEXT_LEN];
+    snprintf(result_str, sizeof(result_str), "R1=%s, R2=%s, G=%.2f", s_r1, s_r2, best.gain);
+
+    add_record_to_history(session, "Op-Amp Designer", details, result_str);
 
-    add_record_to_history(history, count, "Op-Amp Designer", details, result_str);
+    McSpec mc = { .design = mode == OPAMP_NON_INVERTING ? MC_OPAMP_NONINV : MC_OPAMP_INV, .p = { best.r1, best.r2 } };
+    run_tolerance_analysis(&mc, "Gain", "", session);
 }
 
 // --- Item 7: History View/Save ---
-void menu_item_7(CalcRecord **history, int *count) {
+void menu_item_7(Session *session) {
     printf("\n>> View/Save Calculation History\n---------------------------------\n");
-    if (*count == 0) { printf("History is empty.\n"); return; }
+    if (session->history.count == 0) { printf("History is empty.\n"); return; }
     
     // [UPDATED] Table header for string results
     printf("%-3s | %-22s | %-25s | %-35s\n", "ID", "Tool Name", "Inputs", "Results");
     printf("--------------------------------------------------------------------------------------------\n");
-    for (int i = 0; i < *count; i++) {
+    for (int i = 0; i < session->history.count; i++) {
+        const CalcRecord *rec = history_get(&session->history, i);
         printf("#%-2d | %-22s | %-25s | %-35s\n", 
             i + 1, 
-            (*history)[i].tool_name, 
-            (*history)[i].details, 
-            (*history)[i].result_str); // Print string instead of double
+            rec->tool_name, 
+            rec->details, 
+            rec->result_str); // Print string instead of double
     }
     printf("--------------------------------------------------------------------------------------------\n");
     
-    printf("\nSave to CSV file? (y/n): "); char buf[10]; fgets(buf, sizeof(buf), stdin);
-    if (tolower(buf[0]) == 'y') {
-        char fname[128]; 
-        printf("Enter filename (e.g. result1): ");
-        fgets(fname, sizeof(fname), stdin); 
-        fname[strcspn(fname, "\r\n")] = '\0'; // strip newline
-        
-        if (strlen(fname) == 0) return;
+    printf("\nExport history? (y/n): "); char buf[MAX_INPUT_LEN];
+    if (!read_input(buf, sizeof(buf)) || tolower(buf[0]) != 'y') return;
+
+    static const char *EXTS[] = { "", ".csv", ".tsv", ".jsonl" };
+    printf("Format: 1. CSV  2. TSV  3. JSON Lines\n");
+    int format = get_menu_selection("Select Format", 1, 3);
+    char filter[MAX_INPUT_LEN];
+    get_string_input("Only this tool (exact name, empty = all)", filter, sizeof(filter));
+    get_string_input("Fields: i=ID t=Tool n=Inputs r=Results [default: tnr]", buf, sizeof(buf));
+    unsigned fields = 0;
+    for (const char *c = buf; *c; c++) {
+        switch (tolower((unsigned char)*c)) {
+            case 'i': fields |= HISTORY_F_ID; break;
+            case 't': fields |= HISTORY_F_TOOL; break;
+            case 'n': fields |= HISTORY_F_INPUTS; break;
+            case 'r': fields |= HISTORY_F_RESULTS; break;
+            default: break;
+        }
+    }
+    if (!fields) fields = HISTORY_F_TOOL | HISTORY_F_INPUTS | HISTORY_F_RESULTS;
+
+    char fname[128];
+    if (!get_save_filename(EXTS[format], fname, sizeof(fname))) return;
+    PROF_BEGIN(exp);
+    long rows = history_export(&session->history, fname, format, fields, filter);
+    PROF_END(PROF_EXPORT, exp);
+    if (rows < 0) printf("Error writing '%s'.\n", fname);
+    else printf("Saved %ld records to '%s'.\n", rows, fname);
+}
 
-        // [NEW] Automatic .csv extension logic
-        int len = strlen(fname);
-        const char *ext = ".csv";
-        int ext_len = 4;
-        
-        // Check if string already ends with .csv
-        int needs_ext = 1;
-        if (len >= ext_len) {
-            if (strcmp(fname + len - ext_len, ext) == 0) {
-                needs_ext = 0;
+// Prompts for one sweep axis; an empty answer means the single workbench value
+static int get_sweep_axis(const char *name, double wb_value, SweepAxis *ax) {
+    char buf[MAX_INPUT_LEN], prompt[96], def[32];
+    format_eng(wb_value, def);
+    snprintf(prompt, sizeof(prompt), "%s values [default: %s]", name, def);
+    for (;;) {
+        get_string_input(prompt, buf, sizeof(buf));
+        if (buf[0] == '\0') snprintf(buf, sizeof(buf), "%.17g", wb_value);
+        if (sweep_parse_axis(buf, ax) == 0) return 0;
+        printf("Invalid axis. Use e.g. 4.7k | 1k,2.2k | 10:1k:20 | 10:1k:20log | e24:100:10k\n");
+    }
+}
+
+// --- Item 8: RLC Parameter Sweep (Multithreaded) ---
+void menu_item_8(Session *session) {
+    printf("\n>> RLC Parameter Sweep (Multithreaded)\n");
+    printf("1. RC  2. RL  3. LC  4. RLC\n");
+    SweepSpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.type = get_menu_selection("Select Circuit Type", 1, 4);
+
+    printf("Axis formats: 4.7k | 1k,2.2k,4.7k | 10:1k:20 (linear) | 10:1k:20log | e24:100:10k\n");
+    get_sweep_axis("Step Voltage Vs", session->wb.voltage, &spec.vs);
+    if (spec.type != RLC_TYPE_LC) get_sweep_axis("Series Resistor R", session->wb.resistor, &spec.r);
+    if (spec.type != RLC_TYPE_RC) get_sweep_axis("Inductance L", session->wb.inductor, &spec.l);
+    if (spec.type != RLC_TYPE_RL) get_sweep_axis("Capacitance C", session->wb.capacitor, &spec.c);
+
+    long n_points = sweep_point_count(&spec);
+    if (n_points <= 0) {
+        printf("Error: grid exceeds %ld points.\n", SWEEP_MAX_POINTS);
+        goto cleanup;
+    }
+    printf("Grid: %ld points\n", n_points);
+
+    spec.t_total = get_eng_input_with_default("Total Time per point (0 = auto)", &spec.t_total, 1);
+    printf("Integrator: 1. Euler  2. Adaptive RK45  3. Exact (closed form)\n");
+    spec.method = get_menu_selection("Select Integrator", 1, 3);
+    double threads = sweep_default_threads();
+    int n_threads = (int)get_eng_input_with_default("Worker Threads", &threads, 0);
+
+    SweepPoint *pts = malloc(n_points * sizeof(SweepPoint));
+    if (!pts) { printf("Memory Error.\n"); goto cleanup; }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    PROF_BEGIN(sim);
+    int rc = sweep_run(&spec, n_threads, pts);
+    PROF_END(PROF_SIM, sim);
+    if (rc != 0) {
+        printf("Error: sweep failed.\n");
+        free(pts); goto cleanup;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    printf("\nSimulated %ld points on %d threads in %.3f s\n", n_points, n_threads < 1 ? 1 : n_threads, secs);
+
+    // Summary table (first rows only for big grids)
+    int shown = n_points < 20 ? (int)n_points : 20;
+    printf("---------------------------------------------------------------------------------------\n");
+    printf("| %-8s | %-8s | %-8s | %-8s | %-9s | %-9s | %-9s | %-9s |\n",
+           "Vs", "R", "L", "C", "max Vc", "max I", "max Ec", "max El");
+    printf("---------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < shown; i++) {
+        char s_v[32], s_r[32], s_l[32], s_c[32];
+        format_eng(pts[i].vs, s_v); format_eng(pts[i].r, s_r);
+        format_eng(pts[i].l, s_l);  format_eng(pts[i].c, s_c);
+        printf("| %-8s | %-8s | %-8s | %-8s | %9.3e | %9.3e | %9.3e | %9.3e |\n", s_v, s_r, s_l, s_c,
+               pts[i].stats.max_vc, pts[i].stats.max_il, pts[i].stats.max_ec, pts[i].stats.max_el);
+    }
+    if (shown < n_points) printf("| ... %ld more rows (save CSV for all)\n", n_points - shown);
+    printf("---------------------------------------------------------------------------------------\n");
+
+    // Extremes across the grid
+    long i_min = 0, i_max = 0;
+    double os_max = 0;
+    for (long i = 1; i < n_points; i++) {
+        if (pts[i].stats.max_il < pts[i_min].stats.max_il) i_min = i;
+        if (pts[i].stats.max_il > pts[i_max].stats.max_il) i_max = i;
+    }
+    for (long i = 0; i < n_points; i++) {
+        double os = sweep_overshoot_pct(spec.type, &pts[i]);
+        if (os > os_max) os_max = os;
+    }
+    char s_lo[32], s_hi[32];
+    format_eng(pts[i_min].stats.max_il, s_lo); format_eng(pts[i_max].stats.max_il, s_hi);
+    printf("Peak current range: %sA .. %sA\n", s_lo, s_hi);
+    if (spec.type != RLC_TYPE_RL) printf("Worst Vc overshoot: %.2f%%\n", os_max);
+
+    printf("\nSave full grid to CSV file? (y/n): "); char buf[10];
+    if (read_input(buf, sizeof(buf)) && tolower(buf[0]) == 'y') {
+        char fname[128];
+        if (get_save_filename(".csv", fname, sizeof(fname))) {
+            if (sweep_write_csv(fname, spec.type, pts, n_points) == 0) printf("Saved to '%s'.\n", fname);
+            else printf("Error writing '%s'.\n", fname);
+        }
+    }
+
+    char details[HISTORY_TEXT_LEN];
+    snprintf(details, sizeof(details), "Sweep Type %d, %ld pts", spec.type, n_points);
+    char result_str[HISTORY_TEXT_LEN];
+    snprintf(result_str, sizeof(result_str), "PkI %sA..%sA", s_lo, s_hi);
+    add_record_to_history(session, "RLC Sweep", details, result_str);
+    free(pts);
+
+cleanup:
+    sweep_free_axis(&spec.vs); sweep_free_axis(&spec.r);
+    sweep_free_axis(&spec.l);  sweep_free_axis(&spec.c);
+}
+
+// --- Item 9: Resistor Network Synthesizer ---
+void menu_item_9(Session *session) {
+    printf("\n>> Resistor Network Synthesizer (Series / Parallel)\n");
+    RnetSpec spec = { 0, ESERIES_E24, 3, 0.1, 0 };
+    spec.target = get_eng_input_with_default("Target Resistance", &session->wb.resistor, 1);
+    if (!(spec.target >= RNET_MIN_TARGET && spec.target <= RNET_MAX_TARGET)) {
+        printf("Error: Target must be %g .. %g Ohms.\n", RNET_MIN_TARGET, RNET_MAX_TARGET);
+        return;
+    }
+    get_series_input(session);
+    spec.series = session->wb.series;
+    spec.max_parts = get_menu_selection("Max parts (1-4)", 1, RNET_MAX_PARTS);
+    spec.tol_pct = get_eng_input_with_default("Tolerance % (stop at fewest parts within it, 0 = search all)", &spec.tol_pct, 0);
+    double threads = sweep_default_threads();
+    spec.n_threads = (int)get_eng_input_with_default("Worker Threads", &threads, 0);
+
+    RnetResult nets[RNET_MAX_PARTS];
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    PROF_BEGIN(sim);
+    int n_nets = rnet_synthesize(&spec, nets);
+    PROF_END(PROF_SIM, sim);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (n_nets <= 0) { printf("Error: synthesis failed.\n"); return; }
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    char s_t[32]; format_eng(spec.target, s_t);
+    printf("\nBest %s networks for %sOhms (searched in %.3f s):\n", eseries_name(spec.series), s_t, secs);
+    printf("---------------------------------------------------------------------------------\n");
+    printf("| %-5s | %-44s | %-10s | %-9s |\n", "Parts", "Network", "Value", "Error %");
+    printf("---------------------------------------------------------------------------------\n");
+    for (int k = 0; k < n_nets; k++) {
+        if (!nets[k].n_parts) continue;
+        char expr[RNET_EXPR_LEN];
+        rnet_format(&nets[k], expr, sizeof(expr));
+        printf("| %-5d | %-44s | %-10.6g | %-9.2e |\n", k + 1, expr, nets[k].value, nets[k].error_pct);
+    }
+    printf("---------------------------------------------------------------------------------\n");
+
+    // Fewest parts within tolerance, otherwise the most accurate
+    int pick = rnet_pick(nets, n_nets, spec.tol_pct);
+    char expr[RNET_EXPR_LEN], s_v[32];
+    rnet_format(&nets[pick], expr, sizeof(expr)); format_eng(nets[pick].value, s_v);
+    printf("\n>>> Recommended: %s = %.6g Ohms (Error: %.3e%%)\n", expr, nets[pick].value, nets[pick].error_pct);
+    if (spec.tol_pct > 0 && nets[pick].error_pct > spec.tol_pct)
+        printf("    (No network of up to %d parts is within %.3g%%)\n", spec.max_parts, spec.tol_pct);
+
+    session->wb.resistor = nets[pick].value;
+    printf("(Workbench R set to %s)\n", s_v);
+
+    char details[MAX_STR_LEN];
+    snprintf(details, MAX_STR_LEN, "Tgt=%s, %s, N<=%d", s_t, eseries_name(spec.series), spec.max_parts);
+    char result_str[MAX_STR_LEN];
+    snprintf(result_str, MAX_STR_LEN, "%d parts, R=%s, err=%.2e%%", nets[pick].n_parts, s_v, nets[pick].error_pct);
+    add_record_to_history(session, "R Network Synth", details, result_str);
+}
+
+// --- Item 10: Netlist Solver (Modified Nodal Analysis) ---
+// Reads a SPICE-like netlist from a file or typed in, prints the operating point, runs the
+// .dc / .tran analyses it requests, and copies a chosen node voltage or element current into
+// the workbench.
+void menu_item_10(Session *session) {
+    printf("\n>> Netlist Solver (Modified Nodal Analysis, sparse LU)\n");
+    printf("Elements: R/C/L/V/I <name> <node> <node> <value>, node 0 = ground;\n"
+           "directives: .tran <step> <stop>, .dc <element> <start> <stop> <step>, .end\n");
+    char path[128];
+    get_string_input("Netlist file (blank = type it in)", path, sizeof(path));
+
+    Netlist nl;
+    netlist_init(&nl);
+    int rc;
+    if (path[0]) {
+        rc = netlist_load(&nl, path);
+    } else {
+        printf("Enter the netlist, finish with .end:\n");
+        char line[NL_LINE_LEN];
+        rc = NL_OK;
+        while (rc == NL_OK && read_input(line, sizeof(line))) rc = netlist_parse_line(&nl, line);
+        if (rc > 0) rc = NL_OK;
+        if (rc == NL_OK && nl.n_el == 0) { snprintf(nl.err, sizeof(nl.err), "netlist has no elements"); rc = NL_ERR_SYNTAX; }
+        snprintf(path, sizeof(path), "typed");
+    }
+    if (rc != NL_OK) { printf("Error: %s\n", rc == NL_ERR_MEMORY ? "out of memory" : nl.err); netlist_free(&nl); return; }
+
+    // --- 1. Build and operating point ---
+    MnaSystem sys;
+    struct timespec t0, t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    PROF_BEGIN(sim);
+    if (mna_build(&sys, &nl) != NL_OK) { printf("Memory Error.\n"); netlist_free(&nl); return; }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double *x = malloc((size_t)sys.n * sizeof(double));
+    rc = x ? mna_op(&sys, x) : NL_ERR_MEMORY;
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    PROF_END(PROF_SIM, sim);
+    if (rc != NL_OK) {
+        printf("Error: %s\n", rc == NL_ERR_SINGULAR ? "singular matrix (loop of voltage sources / inductors?)" : "out of memory");
+        free(x); mna_free(&sys); netlist_free(&nl);
+        return;
+    }
+    printf("\n[MNA] %d nodes, %d elements -> %d unknowns, %d matrix entries, L+U %d entries\n",
+           nl.n_nodes, nl.n_el, sys.n, sys.a.nnz, sys.lu.lnz + sys.lu.unz);
+    printf("[MNA] ordering %.2f ms, factor + solve %.2f ms\n",
+           ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9) * 1e3,
+           ((t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) * 1e-9) * 1e3);
+
+    enum { SHOW_MAX = 40 };
+    char buf[32];
+    printf("\n--- Operating Point ---\n");
+    for (int k = 1; k < nl.n_nodes && k <= SHOW_MAX; k++) {
+        format_eng(mna_node_voltage(&sys, x, k), buf);
+        printf(" V(%s)%*s %sV\n", nl.node_names[k], (int)(16 - strlen(nl.node_names[k])), "", buf);
+    }
+    if (nl.n_nodes - 1 > SHOW_MAX) printf(" ... %d more nodes\n", nl.n_nodes - 1 - SHOW_MAX);
+    for (int i = 0; i < nl.n_el && i < SHOW_MAX; i++) {
+        if (nl.el[i].kind == NL_C) continue;
+        format_eng(mna_element_current(&sys, x, i), buf);
+        printf(" I(%s)%*s %sA\n", nl.el[i].name, (int)(16 - strlen(nl.el[i].name)), "", buf);
+    }
+    if (nl.n_el > SHOW_MAX) printf(" ... %d more elements\n", nl.n_el - SHOW_MAX);
+
+    // --- 2. Analyses requested by the netlist ---
+    int probe = -1;
+    if (nl.dir.has_dc || nl.dir.has_tran) {
+        char name[NL_NAME_LEN + 8];
+        while (probe < 0) {
+            get_string_input("Probe node for .dc / .tran", name, sizeof(name));
+            probe = netlist_find_node(&nl, name);
+            if (probe < 0) printf("No node '%s'.\n", name);
+        }
+    }
+    if (nl.dir.has_dc) {
+        int elem = netlist_find_element(&nl, nl.dir.dc_elem), n = nl.dir.dc_points;
+        double *v = (elem >= 0) ? malloc((size_t)n * sizeof(double)) : NULL;
+        if (elem < 0) printf("Error: .dc element '%s' not found.\n", nl.dir.dc_elem);
+        else if (!v) printf("Memory Error.\n");
+        else {
+            PROF_BEGIN(dc);
+            rc = mna_dc_sweep(&sys, &nl, elem, nl.dir.dc_start, nl.dir.dc_stop, n, probe, v);
+            PROF_END(PROF_SIM, dc);
+            if (rc != NL_OK) printf("Error: singular matrix during the sweep.\n");
+            else if (n >= 2) {
+                static const char *UNITS[] = { "", "Ohm", "F", "H", "V", "A" };
+                char title[64];
+                snprintf(title, sizeof(title), "DC sweep of %s: V(%s)", nl.el[elem].name, nl.node_names[probe]);
+                ChartTrace tr = { v, "V", "V", 'O' };
+                ChartSpec chart = { title, 0, session->wb.chart_rows, session->wb.chart_width, UNITS[nl.el[elem].kind],
+                                    nl.dir.dc_start, nl.dir.dc_stop, 0, nl.el[elem].name };
+                chart_print(&chart, &tr, 1, n);
+                printf("[DC] %d points, %d factorisation(s), %d refactorisation(s)\n", n, sys.n_factor, sys.n_refactor);
             }
         }
-        
-        // Append if missing
-        if (needs_ext) {
-            if (len + ext_len < sizeof(fname)) {
-                strcat(fname, ext);
-            } else {
-                printf("Filename too long to append extension.\n"); return;
+        free(v);
+    }
+    if (nl.dir.has_tran) {
+        double stop = nl.dir.tran_stop, step = nl.dir.tran_step;
+        long steps = lround(stop / step);
+        double *v = (steps <= SIM_MAX_STEPS) ? malloc(((size_t)steps + 1) * sizeof(double)) : NULL;
+        NlTranStats st;
+        int factors = sys.n_factor + sys.n_refactor;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        PROF_BEGIN(tran);
+        long done = mna_tran(&sys, step, stop, probe, -1, v, &st);
+        PROF_END(PROF_SIM, tran);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (done < 0) printf("Error: transient failed (singular matrix).\n");
+        else {
+            printf("\n[TRAN] %ld steps in %.1f ms, %d (re)factorisations for the whole run\n", done,
+                   ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9) * 1e3,
+                   sys.n_factor + sys.n_refactor - factors);
+            if (v) {
+                char title[64];
+                snprintf(title, sizeof(title), "Transient: V(%s)", nl.node_names[probe]);
+                ChartTrace tr = { v, "V", "V", 'O' };
+                ChartSpec chart = { title, stop, session->wb.chart_rows, session->wb.chart_width, NULL, 0, 0, 0, NULL };
+                chart_print(&chart, &tr, 1, (int)done + 1);
             }
+            printf(" V(%s): final %.6g V, min %.6g V, max %.6g V\n", nl.node_names[probe],
+                   st.final_value, st.min_value, st.max_value);
         }
+        free(v);
+    }
 
-        FILE *fp = fopen(fname, "w"); 
-        if (!fp) { printf("Error opening file '%s'.\n", fname); return; }
-        
-        fprintf(fp, "Tool Name,Inputs,Results\n");
-        for (int i = 0; i < *count; i++) 
-            fprintf(fp, "%s,%s,%s\n", (*history)[i].tool_name, (*history)[i].details, (*history)[i].result_str);
-        
-        fclose(fp); printf("Saved to '%s'.\n", fname);
+    // --- 3. Workbench and history ---
+    char name[NL_NAME_LEN + 8], result_str[MAX_STR_LEN], details[MAX_STR_LEN];
+    snprintf(result_str, MAX_STR_LEN, "Solved %d unknowns", sys.n);
+    get_string_input("Copy to workbench: node (-> V) or element (-> I), blank = skip", name, sizeof(name));
+    if (name[0]) {
+        int node = netlist_find_node(&nl, name), elem = netlist_find_element(&nl, name);
+        if (node >= 0) {
+            session->wb.voltage = mna_node_voltage(&sys, x, node);
+            format_eng(session->wb.voltage, buf);
+            printf("(Workbench V set to %sV)\n", buf);
+            snprintf(result_str, MAX_STR_LEN, "V(%s)=%sV", nl.node_names[node], buf);
+        } else if (elem >= 0) {
+            session->wb.current = mna_element_current(&sys, x, elem);
+            format_eng(session->wb.current, buf);
+            printf("(Workbench I set to %sA)\n", buf);
+            snprintf(result_str, MAX_STR_LEN, "I(%s)=%sA", nl.el[elem].name, buf);
+        } else {
+            printf("No node or element '%s'.\n", name);
+        }
+    }
+    snprintf(details, MAX_STR_LEN, "%.24s: %d nodes, %d elements", path, nl.n_nodes, nl.n_el);
+    add_record_to_history(session, "Netlist Solver", details, result_str);
+
+    free(x);
+    mna_free(&sys);
+    netlist_free(&nl);
+}
+
+// ============================================
+// Item 11: Session Profile
+// ============================================
+
+void menu_item_11(Session *session) {
+    (void)session;
+    prof_report(stdout);
+    printf("\n1. Keep counters  2. Reset span counters\n");
+    if (get_menu_selection("Select Option", 1, 2) == 2) {
+        prof_reset();
+        printf("Span counters reset.\n");
     }
 }
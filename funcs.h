@@ -2,22 +2,23 @@
 #define FUNCS_H
 
 #define MAX_STR_LEN 64
+// History text built from paths and formatted values: two MAX_STR_LEN paths, or several
+// ENG_FMT_LEN values plus a full-name colour code, always fit
+#define HISTORY_TEXT_LEN 256
 
-// 定义历史记录结构体
-typedef struct {
-    char tool_name[MAX_STR_LEN];
-    char details[MAX_STR_LEN];    // 用于记录输入参数 (Inputs)
-    char result_str[MAX_STR_LEN]; // [修改] 用于记录输出结果 (Outputs)，支持文本
-} CalcRecord;
+#include "session.h"
 
 // 函数原型
-void free_history_memory(CalcRecord *history);
-void menu_item_1(CalcRecord **history, int *count);
-void menu_item_2(CalcRecord **history, int *count);
-void menu_item_3(CalcRecord **history, int *count);
-void menu_item_4(CalcRecord **history, int *count);
-void menu_item_5(CalcRecord **history, int *count);
-void menu_item_6(CalcRecord **history, int *count);
-void menu_item_7(CalcRecord **history, int *count);
+void menu_item_1(Session *session);
+void menu_item_2(Session *session);
+void menu_item_3(Session *session);
+void menu_item_4(Session *session);
+void menu_item_5(Session *session);
+void menu_item_6(Session *session);
+void menu_item_7(Session *session);
+void menu_item_8(Session *session);
+void menu_item_9(Session *session);
+void menu_item_10(Session *session);
+void menu_item_11(Session *session);
 
 #endif
@@ -0,0 +1,426 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdalign.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "history.h"
+
+// Journal layout: 16-byte header, then frames of
+//   u32 payload length | u32 CRC-32 of payload | "tool\0details\0result\0"
+// A frame is only trusted if it is complete and its checksum matches.
+static const char JOURNAL_MAGIC[8] = { 'E', 'L', 'E', 'C', 'H', 'I', 'S', 'T' };
+#define JOURNAL_VERSION 1
+#define JOURNAL_HEADER_LEN 16
+#define JOURNAL_FRAME_HDR 8
+#define JOURNAL_MAX_PAYLOAD (1 << 20)
+
+struct HistoryBlock {
+    HistoryBlock *next;
+    alignas(max_align_t) char data[];
+};
+
+// ============================================
+// Bump arena
+// ============================================
+
+// Returns size bytes (aligned to align) from the arena, starting a new block when needed
+static void *arena_alloc(History *h, size_t size, size_t align) {
+    size_t pad = (size_t)(-(uintptr_t)h->bump) & (align - 1);
+    if (!h->bump || pad + size > h->left) {
+        // Oversized requests get a block of their own
+        size_t cap = size > HISTORY_ARENA_BLOCK / 4 ? size : HISTORY_ARENA_BLOCK;
+        HistoryBlock *b = malloc(sizeof(HistoryBlock) + cap);
+        if (!b) return NULL;
+        b->next = h->blocks;
+        h->blocks = b;
+        h->bump = b->data;
+        h->left = cap;
+        pad = 0;
+    }
+    void *p = h->bump + pad;
+    h->bump += pad + size;
+    h->left -= pad + size;
+    return p;
+}
+
+static const char *arena_strdup(History *h, const char *s) {
+    size_t len = strlen(s) + 1;
+    char *p = arena_alloc(h, len, 1);
+    if (p) memcpy(p, s, len);
+    return p;
+}
+
+// ============================================
+// CRC-32 (IEEE, reflected) for journal frames
+// ============================================
+
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+// Built once per process; sessions on other threads may journal at the same time
+static void crc_build(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t crc32_buf(const void *data, size_t len) {
+    pthread_once(&crc_once, crc_build);
+    const unsigned char *p = data;
+    uint32_t c = 0xFFFFFFFFu;
+    while (len--) c = crc_table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+// ============================================
+// Records
+// ============================================
+
+// Adds a record slot. With copy == 0 the strings are used in place (journal mapping).
+static int push_record(History *h, const char *tool, const char *details, const char *result_str, int copy) {
+    int slot = h->count % HISTORY_CHUNK;
+
+    if (slot == 0 && h->count / HISTORY_CHUNK == h->n_chunks) {
+        if (h->n_chunks == h->cap_chunks) {
+            int cap = h->cap_chunks ? 2 * h->cap_chunks : 8;
+            CalcRecord **dir = realloc(h->chunks, cap * sizeof(CalcRecord *));
+            if (!dir) return -1;
+            h->chunks = dir;
+            h->cap_chunks = cap;
+        }
+        CalcRecord *chunk = arena_alloc(h, HISTORY_CHUNK * sizeof(CalcRecord), alignof(CalcRecord));
+        if (!chunk) return -1;
+        h->chunks[h->n_chunks++] = chunk;
+    }
+
+    CalcRecord *r = &h->chunks[h->count / HISTORY_CHUNK][slot];
+    const CalcRecord *prev = h->count ? history_get(h, h->count - 1) : NULL;
+    if (copy) {
+        r->tool_name = (prev && strcmp(prev->tool_name, tool) == 0) ? prev->tool_name : arena_strdup(h, tool);
+        r->details = arena_strdup(h, details);
+        r->result_str = arena_strdup(h, result_str);
+        if (!r->tool_name || !r->details || !r->result_str) return -1;
+    } else {
+        r->tool_name = tool; r->details = details; r->result_str = result_str;
+    }
+
+    h->count++;
+    return 0;
+}
+
+// Writes all of buf, retrying on EINTR and short writes
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, buf, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        buf += w; len -= (size_t)w;
+    }
+    return 0;
+}
+
+// One write() per record so a crash leaves at most one torn frame at the tail
+static int journal_write(int fd, const char *tool, const char *details, const char *result_str) {
+    size_t lt = strlen(tool) + 1, ld = strlen(details) + 1, lr = strlen(result_str) + 1;
+    size_t payload = lt + ld + lr;
+    if (payload > JOURNAL_MAX_PAYLOAD) return -1;
+
+    char stack_buf[512];
+    char *frame = (JOURNAL_FRAME_HDR + payload <= sizeof(stack_buf)) ? stack_buf : malloc(JOURNAL_FRAME_HDR + payload);
+    if (!frame) return -1;
+    char *p = frame + JOURNAL_FRAME_HDR;
+    memcpy(p, tool, lt); memcpy(p + lt, details, ld); memcpy(p + lt + ld, result_str, lr);
+    uint32_t len32 = (uint32_t)payload, crc = crc32_buf(p, payload);
+    memcpy(frame, &len32, 4);
+    memcpy(frame + 4, &crc, 4);
+
+    int rc = write_all(fd, frame, JOURNAL_FRAME_HDR + payload);
+    if (frame != stack_buf) free(frame);
+    return rc;
+}
+
+/**
+ * @brief Appends a record in O(1) amortised: no record is ever copied or moved.
+ *        Tool names repeated from the previous record share its string.
+ *        With a journal attached the record is also written to disk.
+ * @return 0 on success, -1 on allocation failure (history unchanged),
+ *         -2 if the journal write failed (record kept in memory, journal detached).
+ */
+int history_append(History *h, const char *tool, const char *details, const char *result_str) {
+    if (push_record(h, tool, details, result_str, 1) != 0) return -1;
+    if (h->journal_fd >= 0 && journal_write(h->journal_fd, tool, details, result_str) != 0) {
+        close(h->journal_fd);
+        h->journal_fd = -1;
+        return -2;
+    }
+    return 0;
+}
+
+// Releases every record and string at once, and detaches the journal
+void history_free(History *h) {
+    if (h->journal_fd >= 0) close(h->journal_fd);
+    if (h->map) munmap((void *)h->map, h->map_len);
+    HistoryBlock *b = h->blocks;
+    while (b) {
+        HistoryBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    free(h->chunks);
+    History empty = HISTORY_INIT;
+    *h = empty;
+}
+
+// ============================================
+// Journal reload
+// ============================================
+
+// Length of the valid frame at p (0 if torn, corrupt or incomplete)
+static size_t check_frame(const char *p, size_t avail) {
+    if (avail < JOURNAL_FRAME_HDR) return 0;
+    uint32_t len, crc;
+    memcpy(&len, p, 4);
+    memcpy(&crc, p + 4, 4);
+    if (len < 3 || len > JOURNAL_MAX_PAYLOAD || len > avail - JOURNAL_FRAME_HDR) return 0;
+
+    const char *s = p + JOURNAL_FRAME_HDR, *end = s + len;
+    if (end[-1] != '\0') return 0;
+    // Exactly three NUL-terminated strings
+    const char *z1 = memchr(s, '\0', len);
+    const char *z2 = z1 + 1 < end ? memchr(z1 + 1, '\0', end - z1 - 1) : NULL;
+    if (!z2 || z2 + 1 >= end || memchr(z2 + 1, '\0', end - z2 - 1) != end - 1) return 0;
+    if (crc32_buf(s, len) != crc) return 0;
+    return JOURNAL_FRAME_HDR + len;
+}
+
+/**
+ * @brief Attaches an append-only journal to an empty history, loading any records it holds.
+ *
+ * The existing file is memory-mapped read-only and its records point straight into the
+ * mapping; only the frame checks run, nothing is parsed or copied. A torn or corrupt tail
+ * (e.g. from a crash mid-write) is cut off so new records follow the last good frame.
+ * @param truncated Set to the number of bytes dropped from the tail (may be NULL).
+ * @return Number of records loaded, or -1 if the file cannot be used (history unchanged).
+ */
+int history_open_journal(History *h, const char *path, long *truncated) {
+    if (truncated) *truncated = 0;
+    if (h->count != 0 || h->journal_fd >= 0) return -1;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return -1; }
+    size_t size = (size_t)st.st_size;
+
+    if (size == 0) {
+        char header[JOURNAL_HEADER_LEN] = { 0 };
+        uint32_t version = JOURNAL_VERSION;
+        memcpy(header, JOURNAL_MAGIC, 8);
+        memcpy(header + 8, &version, 4);
+        if (write_all(fd, header, sizeof(header)) != 0) { close(fd); return -1; }
+        h->journal_fd = fd;
+        return 0;
+    }
+
+    if (size < JOURNAL_HEADER_LEN) { close(fd); return -1; }
+    char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) { close(fd); return -1; }
+    uint32_t version;
+    memcpy(&version, map + 8, 4);
+    if (memcmp(map, JOURNAL_MAGIC, 8) != 0 || version != JOURNAL_VERSION) {
+        // Not one of our journals: leave the file alone
+        munmap(map, size); close(fd);
+        return -1;
+    }
+
+    size_t off = JOURNAL_HEADER_LEN, n;
+    while ((n = check_frame(map + off, size - off)) > 0) {
+        const char *tool = map + off + JOURNAL_FRAME_HDR;
+        const char *details = tool + strlen(tool) + 1;
+        const char *result_str = details + strlen(details) + 1;
+        if (push_record(h, tool, details, result_str, 0) != 0) {
+            // Out of memory, not a bad frame: leave the file as it is
+            history_free(h);
+            munmap(map, size); close(fd);
+            return -1;
+        }
+        off += n;
+    }
+
+    if (off < size) {
+        // Torn tail: drop it so appends continue from the last good frame
+        if (ftruncate(fd, (off_t)off) != 0) { munmap(map, size); close(fd); history_free(h); return -1; }
+        if (truncated) *truncated = (long)(size - off);
+    }
+    h->map = map;
+    h->map_len = size;
+    h->journal_fd = fd;
+    return h->count;
+}
+
+// ============================================
+// Export (CSV / TSV / JSON Lines)
+// ============================================
+
+typedef struct {
+    int fd;
+    char *buf;
+    size_t len;
+    int failed;
+} ExportBuf;
+
+static void out_flush(ExportBuf *o) {
+    if (o->len && !o->failed && write_all(o->fd, o->buf, o->len) != 0) o->failed = 1;
+    o->len = 0;
+}
+
+// Makes room for n more bytes (n is always small next to the buffer)
+static inline char *out_reserve(ExportBuf *o, size_t n) {
+    if (o->len + n > HISTORY_EXPORT_BUF) out_flush(o);
+    return o->buf + o->len;
+}
+
+static void out_bytes(ExportBuf *o, const char *s, size_t n) {
+    while (n > 0) {
+        size_t room = HISTORY_EXPORT_BUF - o->len;
+        if (room == 0) { out_flush(o); room = HISTORY_EXPORT_BUF; }
+        size_t k = n < room ? n : room;
+        memcpy(o->buf + o->len, s, k);
+        o->len += k; s += k; n -= k;
+    }
+}
+
+// RFC 4180: quote when the field holds a comma, quote, CR or LF; double embedded quotes
+static void out_csv(ExportBuf *o, const char *s) {
+    size_t n = strcspn(s, ",\"\r\n");
+    if (s[n] == '\0') { out_bytes(o, s, n); return; }
+    out_bytes(o, "\"", 1);
+    for (;;) {
+        n = strcspn(s, "\"");
+        out_bytes(o, s, n);
+        if (s[n] == '\0') break;
+        out_bytes(o, "\"\"", 2);
+        s += n + 1;
+    }
+    out_bytes(o, "\"", 1);
+}
+
+// TSV cannot quote, so tab, newline, CR and backslash are escaped as \t \n \r \\ .
+static void out_tsv(ExportBuf *o, const char *s) {
+    for (;;) {
+        size_t n = strcspn(s, "\t\n\r\\");
+        out_bytes(o, s, n);
+        if (s[n] == '\0') return;
+        char esc[2] = { '\\', s[n] == '\t' ? 't' : s[n] == '\n' ? 'n' : s[n] == '\r' ? 'r' : '\\' };
+        out_bytes(o, esc, 2);
+        s += n + 1;
+    }
+}
+
+static void out_json_str(ExportBuf *o, const char *s) {
+    static const char HEX[] = "0123456789abcdef";
+    out_bytes(o, "\"", 1);
+    for (;;) {
+        const char *p = s;
+        while (*p && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20) p++;
+        out_bytes(o, s, p - s);
+        if (*p == '\0') break;
+        char *e = out_reserve(o, 6);
+        unsigned char c = (unsigned char)*p;
+        int k;
+        if (c == '"' || c == '\\') { e[0] = '\\'; e[1] = c; k = 2; }
+        else if (c == '\n') { e[0] = '\\'; e[1] = 'n'; k = 2; }
+        else if (c == '\t') { e[0] = '\\'; e[1] = 't'; k = 2; }
+        else if (c == '\r') { e[0] = '\\'; e[1] = 'r'; k = 2; }
+        else { memcpy(e, "\\u00", 4); e[4] = HEX[c >> 4]; e[5] = HEX[c & 15]; k = 6; }
+        o->len += k;
+        s = p + 1;
+    }
+    out_bytes(o, "\"", 1);
+}
+
+static void out_field(ExportBuf *o, int format, int *first, const char *key, const char *val) {
+    if (format == HISTORY_FMT_JSONL) {
+        out_bytes(o, *first ? "{\"" : ",\"", 2);
+        out_bytes(o, key, strlen(key));
+        out_bytes(o, "\":", 2);
+        out_json_str(o, val);
+    } else {
+        if (!*first) out_bytes(o, format == HISTORY_FMT_CSV ? "," : "\t", 1);
+        if (format == HISTORY_FMT_CSV) out_csv(o, val); else out_tsv(o, val);
+    }
+    *first = 0;
+}
+
+/**
+ * @brief Streams the history (straight from the chunks / journal mapping) to path.
+ *
+ * Rows are formatted into one large buffer that is written out in HISTORY_EXPORT_BUF
+ * blocks, so a million records cost a few dozen write() calls. CSV follows RFC 4180
+ * (quoted fields, CRLF rows); TSV escapes tabs and newlines; JSONL writes one object per line.
+ * @param path        Output file, or "-" for stdout.
+ * @param fields      HISTORY_F_* mask (0 = all fields).
+ * @param tool_filter Only records whose tool name matches exactly (NULL or "" = all).
+ * @return Number of records written, or -1 on bad arguments or an I/O error.
+ */
+long history_export(const History *h, const char *path, int format, unsigned fields, const char *tool_filter) {
+    static const char *NAMES[4] = { "ID", "Tool Name", "Inputs", "Results" };
+    static const char *KEYS[4] = { "id", "tool", "inputs", "results" };
+    if (format < HISTORY_FMT_CSV || format > HISTORY_FMT_JSONL) return -1;
+    if (fields == 0) fields = HISTORY_F_ALL;
+    if (tool_filter && !*tool_filter) tool_filter = NULL;
+
+    int to_stdout = strcmp(path, "-") == 0;
+    ExportBuf o = { to_stdout ? STDOUT_FILENO : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644), NULL, 0, 0 };
+    if (o.fd < 0) return -1;
+    o.buf = malloc(HISTORY_EXPORT_BUF);
+    if (!o.buf) { if (!to_stdout) close(o.fd); return -1; }
+    if (to_stdout) fflush(stdout);   // keep earlier stdio output in order
+
+    const char *eol = format == HISTORY_FMT_CSV ? "\r\n" : "\n";
+    int first;
+    if (format != HISTORY_FMT_JSONL) {
+        first = 1;
+        for (int f = 0; f < 4; f++) if (fields & (1u << f)) out_field(&o, format, &first, KEYS[f], NAMES[f]);
+        out_bytes(&o, eol, strlen(eol));
+    }
+
+    long written = 0;
+    const char *last_tool = NULL;
+    int last_match = 0;
+    for (int i = 0; i < h->count && !o.failed; i++) {
+        const CalcRecord *r = history_get(h, i);
+        if (tool_filter) {
+            // Consecutive records usually share one tool string, so compare pointers first
+            if (r->tool_name != last_tool) { last_tool = r->tool_name; last_match = strcmp(last_tool, tool_filter) == 0; }
+            if (!last_match) continue;
+        }
+        const char *vals[4] = { NULL, r->tool_name, r->details, r->result_str };
+        first = 1;
+        if (fields & HISTORY_F_ID) {
+            char id[16];
+            int n = snprintf(id, sizeof(id), "%d", i + 1);
+            if (format == HISTORY_FMT_JSONL) out_bytes(&o, "{\"id\":", 6);   // numeric, unquoted
+            out_bytes(&o, id, n);
+            first = 0;
+        }
+        for (int f = 1; f < 4; f++) if (fields & (1u << f)) out_field(&o, format, &first, KEYS[f], vals[f]);
+        if (format == HISTORY_FMT_JSONL) out_bytes(&o, "}\n", 2);
+        else out_bytes(&o, eol, strlen(eol));
+        written++;
+    }
+    out_flush(&o);
+
+    int failed = o.failed;
+    free(o.buf);
+    if (!to_stdout && close(o.fd) != 0) failed = 1;
+    return failed ? -1 : written;
+}
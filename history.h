@@ -0,0 +1,60 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+// ============================================
+// Calculation history: records in fixed-size chunks that never move,
+// strings packed into a bump arena. One history_free() releases it all.
+// Optionally mirrored to an append-only binary journal on disk.
+// ============================================
+
+#include <stddef.h>
+
+#define HISTORY_CHUNK 256                 // records per chunk
+#define HISTORY_ARENA_BLOCK (64 * 1024)   // default arena block size
+#define HISTORY_DEFAULT_JOURNAL "history.bin"
+#define HISTORY_EXPORT_BUF (256 * 1024)  // export output is flushed in writes of this size
+
+// Export formats
+enum { HISTORY_FMT_CSV = 1, HISTORY_FMT_TSV, HISTORY_FMT_JSONL };
+
+// Export field selection (bit mask)
+enum {
+    HISTORY_F_ID      = 1,
+    HISTORY_F_TOOL    = 2,
+    HISTORY_F_INPUTS  = 4,
+    HISTORY_F_RESULTS = 8,
+    HISTORY_F_ALL     = 15
+};
+
+typedef struct {
+    const char *tool_name;
+    const char *details;    // inputs
+    const char *result_str; // outputs, as text
+} CalcRecord;
+
+typedef struct HistoryBlock HistoryBlock;
+
+typedef struct {
+    CalcRecord **chunks;    // chunk directory, grown geometrically
+    int n_chunks, cap_chunks;
+    int count;
+    HistoryBlock *blocks;   // arena blocks, newest first
+    char *bump;             // free space in the newest block
+    size_t left;
+    int journal_fd;         // -1 when no journal is attached
+    const char *map;        // read-only mapping of the journal as loaded
+    size_t map_len;
+} History;
+
+#define HISTORY_INIT { NULL, 0, 0, 0, NULL, NULL, 0, -1, NULL, 0 }
+
+int history_append(History *h, const char *tool, const char *details, const char *result_str);
+void history_free(History *h);
+int history_open_journal(History *h, const char *path, long *truncated);
+long history_export(const History *h, const char *path, int format, unsigned fields, const char *tool_filter);
+
+static inline const CalcRecord *history_get(const History *h, int i) {
+    return &h->chunks[i / HISTORY_CHUNK][i % HISTORY_CHUNK];
+}
+
+#endif
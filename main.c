@@ -4,52 +4,96 @@
 #include <ctype.h>
 #include <math.h>
 #include "funcs.h"
+#include "batch.h"
+#include "server.h"
+#include "prof.h"
 
 /* Prototypes with updated signatures */
-static void main_menu(CalcRecord **history, int *count);
+static void main_menu(Session *session);
 static void print_main_menu(void);
 static int  get_user_input(void);
-static void select_menu_item(int input, CalcRecord **history, int *count);
+static void select_menu_item(int input, Session *session);
 static void go_back_to_main(void);
 static int  is_integer(const char *s);
 
-int main(void)
+int main(int argc, char **argv)
 {
     // === PROGRAM STATE INITIALIZATION ===
-    // Initialize pointer to NULL, indicating no memory allocated yet.
-    CalcRecord *history_array = NULL; 
-    // Initialize counter to 0 records.
-    int history_count = 0;
+    // Workbench defaults and an empty history: no memory is allocated until the first record.
+    Session session = SESSION_INIT;
+    prof_init();
+
+    // Options: --batch <file|->   run commands without prompting ("-" = stdin)
+    //          --serve <socket>   answer batch commands on a Unix domain socket (server.h)
+    //          --workers <n>      server threads for heavy jobs (default: one per CPU)
+    //          --history <file>   journal to use (interactive default: history.bin)
+    //          --no-history       keep history in memory only
+    const char *batch_path = NULL;
+    const char *serve_path = NULL;
+    int n_workers = 0;
+    const char *journal_path = NULL;
+    int no_journal = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batch_path = argv[++i];
+        else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) serve_path = argv[++i];
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) n_workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--history") == 0 && i + 1 < argc) journal_path = argv[++i];
+        else if (strcmp(argv[i], "--no-history") == 0) no_journal = 1;
+        else {
+            fprintf(stderr, "Usage: %s [--batch <file|-> | --serve <socket> [--workers <n>]]"
+                            " [--history <file> | --no-history]\n", argv[0]);
+            return 2;
+        }
+    }
+    // Every server connection has a session of its own; the journal is not used
+    if (serve_path) return server_run(serve_path, n_workers) == 0 ? 0 : 1;
+    // Batch runs only journal when asked to
+    if (!journal_path && !batch_path) journal_path = HISTORY_DEFAULT_JOURNAL;
+
+    if (journal_path && !no_journal) {
+        long truncated = 0;
+        int loaded = history_open_journal(&session.history, journal_path, &truncated);
+        FILE *msg = batch_path ? stderr : stdout;
+        if (loaded < 0) fprintf(msg, "[Warning] Cannot use history journal '%s'; history is not saved.\n", journal_path);
+        else if (loaded > 0) fprintf(msg, "[History] %d records loaded from '%s'.\n", loaded, journal_path);
+        if (truncated > 0) fprintf(msg, "[History] Dropped %ld bytes of incomplete data after a crash.\n", truncated);
+    }
+
+    if (batch_path) {
+        int errors = run_batch(batch_path, &session);
+        session_free(&session);
+        return errors ? 1 : 0;
+    }
 
     /* this will run forever until exit(0) is called */
     for(;;) {
-        // Pass addresses of our state variables so functions can modify them
-        main_menu(&history_array, &history_count);
+        // Pass the session so the tools can read and update it
+        main_menu(&session);
     }
 
     /* NOT REACHED in this design, but good practice for robustness */
-    free_history_memory(history_array);
+    session_free(&session);
     return 0;
 }
 
-static void main_menu(CalcRecord **history, int *count)
+static void main_menu(Session *session)
 {
     print_main_menu();
     {
         int input = get_user_input();
-        select_menu_item(input, history, count);
+        select_menu_item(input, session);
     }
 }
 
 static int get_user_input(void)
 {
-    enum { MENU_ITEMS = 8 };    
+    enum { MENU_ITEMS = 12 };    
     char buf[128];
     int valid_input = 0;
     int value = 0;
 
     do {
-        printf("\nSelect item (1-8): ");
+        printf("\nSelect item (1-%d): ", MENU_ITEMS);
         if (!fgets(buf, sizeof(buf), stdin)) {
             puts("\nInput error. Exiting.");
             exit(1);
@@ -73,24 +117,31 @@ static int get_user_input(void)
     return value;
 }
 
-static void select_menu_item(int input, CalcRecord **history, int *count)
+static void select_menu_item(int input, Session *session)
 {
-    // Pass state variables to appropriate functions
+    // Pass the session to the selected tool; each tool run is one profile span
+    PROF_BEGIN(span);
     switch (input) {
-        case 1: menu_item_1(history, count); go_back_to_main(); break;
-        case 2: menu_item_2(history, count); go_back_to_main(); break;
-        case 3: menu_item_3(history, count); go_back_to_main(); break;
-        case 4: menu_item_4(history, count); go_back_to_main(); break;
-        case 5: menu_item_5(history, count); go_back_to_main(); break;
-        case 6: menu_item_6(history, count); go_back_to_main(); break;
-        case 7: menu_item_7(history, count); go_back_to_main(); break;
-        default: // Case 8: Exit
+        case 1: menu_item_1(session); break;
+        case 2: menu_item_2(session); break;
+        case 3: menu_item_3(session); break;
+        case 4: menu_item_4(session); break;
+        case 5: menu_item_5(session); break;
+        case 6: menu_item_6(session); break;
+        case 7: menu_item_7(session); break;
+        case 8: menu_item_8(session); break;
+        case 9: menu_item_9(session); break;
+        case 10: menu_item_10(session); break;
+        case 11: menu_item_11(session); go_back_to_main(); return;
+        default: // Case 12: Exit
             printf("\nCleaning up memory...\n");
             // IMPOTANT: Free memory before exiting to prevent leaks
-            free_history_memory(*history); // Dereference to get the actual array pointer
+            session_free(session);
             printf("Exiting Embedded Electronics Assistant. Goodbye!\n");
             exit(0);
     }
+    PROF_END((ProfSlot)(PROF_TOOL_1 + input - 1), span);
+    go_back_to_main();
 }
 
 static void print_main_menu(void)
@@ -99,14 +150,18 @@ static void print_main_menu(void)
     printf("   EMBEDDED ELECTRONICS ASSISTANT\n");
     printf("=================================================\n");
     printf("Please select a tool:\n\n"
-           "\t1. Resistor Colour Code Decoder\n"
+           "\t1. Resistor Colour Codes (3-6 bands, bulk)\n"
            "\t2. Ohm's Law & Power Calculator\n"
            "\t3. Voltage Divider Designer\n"
-           "\t4. Universal RLC Transient Analyser\n" // Updated
+           "\t4. Universal RLC Analyser (Transient & AC)\n" // Updated
            "\t5. LED Current-Limiting Resistor Calculator\n"
-           "\t6. Op-Amp Gain Designer (E24 Matcher)\n" // Updated
+           "\t6. Op-Amp Gain Designer (E-Series Matcher)\n" // Updated
            "\t7. View/Save Calculation History\n"
-           "\n\t8. Exit Application\n");
+           "\t8. RLC Parameter Sweep (Multithreaded)\n"
+           "\t9. Resistor Network Synthesizer\n"
+           "\t10. Netlist Solver (MNA, sparse LU)\n"
+           "\t11. Session Profile (timings & allocations)\n"
+           "\n\t12. Exit Application\n");
     printf("=================================================\n");
 }
 
@@ -0,0 +1,272 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "montecarlo.h"
+
+// Trials generated and evaluated per inner batch (fits comfortably in L1)
+#define MC_BLOCK 1024
+// Trials per random stream. Chunks are seeded by index and their sums reduced in index order,
+// so a seed gives the same result on any number of threads.
+#define MC_CHUNK (64 * MC_BLOCK)
+// Smallest part-value factor: a Gaussian draw beyond -1/tol would make a resistor <= 0
+#define MC_MIN_FACTOR 1e-3
+// Histogram resolution used for the percentiles
+#define MC_BINS 4096
+
+const double MC_PCT_LEVELS[MC_PCT_COUNT] = { 1.0, 5.0, 50.0, 95.0, 99.0 };
+
+// ============================================
+// Per-chunk PRNG: xoshiro256+ seeded with splitmix64
+// ============================================
+
+typedef struct { uint64_t s[4]; } McRng;
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void rng_seed(McRng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&seed);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+// Uniform double in [0, 1)
+static inline double rng_unit(McRng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = s[0] + s[3];
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return (result >> 11) * 0x1.0p-53;
+}
+
+// Fills f[] with multiplicative part-value factors around 1.0
+static void fill_factors(McRng *rng, int dist, double tol, double *f, int n) {
+    if (dist == MC_DIST_GAUSSIAN) {
+        double sigma = tol / 3.0;
+        for (int i = 0; i < n; i += 2) {
+            // Box-Muller: two normals per pair of uniforms
+            double u1 = 1.0 - rng_unit(rng), u2 = rng_unit(rng);
+            double r = sigma * sqrt(-2.0 * log(u1));
+            f[i] = fmax(1.0 + r * cos(2.0 * M_PI * u2), MC_MIN_FACTOR);
+            if (i + 1 < n) f[i + 1] = fmax(1.0 + r * sin(2.0 * M_PI * u2), MC_MIN_FACTOR);
+        }
+    } else {
+        for (int i = 0; i < n; i++) f[i] = 1.0 + tol * (2.0 * rng_unit(rng) - 1.0);
+    }
+}
+
+// ============================================
+// Design evaluation
+// ============================================
+
+// Output with resistor factors f1 (first resistor) and f2 (second resistor)
+static double mc_eval(const McSpec *spec, double f1, double f2) {
+    const double *p = spec->p;
+    switch (spec->design) {
+        case MC_DIVIDER:      return p[0] * (p[2] * f2) / (p[1] * f1 + p[2] * f2);
+        case MC_LED:          return (p[0] - p[1]) / (p[2] * f1);
+        case MC_OPAMP_NONINV: return 1.0 + (p[1] * f2) / (p[0] * f1);
+        default:              return (p[1] * f2) / (p[0] * f1);
+    }
+}
+
+double mc_nominal(const McSpec *spec) {
+    return mc_eval(spec, 1.0, 1.0);
+}
+
+// Same as mc_eval but over whole blocks, one tight loop per design
+static void mc_eval_block(const McSpec *spec, const double *restrict f1, const double *restrict f2,
+                          double *restrict out, int n) {
+    const double p0 = spec->p[0], p1 = spec->p[1], p2 = spec->p[2];
+    switch (spec->design) {
+        case MC_DIVIDER:
+            for (int i = 0; i < n; i++) out[i] = p0 * (p2 * f2[i]) / (p1 * f1[i] + p2 * f2[i]);
+            break;
+        case MC_LED: {
+            const double v = p0 - p1;
+            for (int i = 0; i < n; i++) out[i] = v / (p2 * f1[i]);
+            break;
+        }
+        case MC_OPAMP_NONINV: {
+            const double ratio = p1 / p0;
+            for (int i = 0; i < n; i++) out[i] = 1.0 + ratio * f2[i] / f1[i];
+            break;
+        }
+        default: {
+            const double ratio = p1 / p0;
+            for (int i = 0; i < n; i++) out[i] = ratio * f2[i] / f1[i];
+            break;
+        }
+    }
+}
+
+// ============================================
+// Parallel run + reduction
+// ============================================
+
+// Sums of (x - nominal), kept per chunk for an order-fixed reduction
+typedef struct {
+    double sum, sumsq;
+} McPartial;
+
+typedef struct {
+    const McSpec *spec;
+    long first, stride;          // chunks first, first + stride, ... below n_chunks
+    long n_chunks;
+    double hist_lo, bin_scale;   // histogram mapping
+    McPartial *part;             // shared, one entry per chunk
+    // Per-thread partial results (exact, so merge order does not matter), merged by mc_run
+    long hist[MC_BINS];
+    double min, max;
+    long in_spec;
+} McWorker;
+
+static uint64_t chunk_seed(uint64_t seed, long chunk) {
+    return seed + 0x632be59bd9b4e019ULL * (uint64_t)(chunk + 1);
+}
+
+static void *mc_worker(void *arg) {
+    McWorker *w = arg;
+    const McSpec *spec = w->spec;
+    double f1[MC_BLOCK], f2[MC_BLOCK], out[MC_BLOCK];
+    double tol = spec->tol_pct / 100.0;
+    double nominal = mc_nominal(spec);
+
+    w->in_spec = 0;
+    w->min = INFINITY; w->max = -INFINITY;
+    memset(w->hist, 0, sizeof(w->hist));
+
+    for (long c = w->first; c < w->n_chunks; c += w->stride) {
+        McRng rng;
+        rng_seed(&rng, chunk_seed(spec->seed, c));
+        long trials = spec->trials - c * MC_CHUNK;
+        if (trials > MC_CHUNK) trials = MC_CHUNK;
+        double sum = 0, sumsq = 0;
+
+        for (long done = 0; done < trials; done += MC_BLOCK) {
+            int n = (trials - done < MC_BLOCK) ? (int)(trials - done) : MC_BLOCK;
+            fill_factors(&rng, spec->dist, tol, f1, n);
+            fill_factors(&rng, spec->dist, tol, f2, n);
+            mc_eval_block(spec, f1, f2, out, n);
+
+            for (int i = 0; i < n; i++) {
+                double x = out[i], d = x - nominal;
+                sum += d; sumsq += d * d;
+                if (x < w->min) w->min = x;
+                if (x > w->max) w->max = x;
+                w->in_spec += (x >= spec->spec_lo && x <= spec->spec_hi);
+                // Clamped before the cast: NaN goes to bin 0, +/-inf to the end bins
+                double pos = (x - w->hist_lo) * w->bin_scale;
+                long b = pos > 0 ? (pos < MC_BINS ? (long)pos : MC_BINS - 1) : 0;
+                w->hist[b]++;
+            }
+        }
+        w->part[c].sum = sum;
+        w->part[c].sumsq = sumsq;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs spec->trials random builds across threads and reduces the statistics. The
+ *        result depends on spec->seed only, not on the thread count.
+ * @return 0 on success, -1 on bad parameters (trials < 1, tolerance outside 0 .. < 100 %) or
+ *         allocation failure.
+ */
+int mc_run(const McSpec *spec, McResult *res) {
+    if (spec->trials < 1 || !(spec->tol_pct >= 0 && spec->tol_pct < 100)) return -1;
+
+    long n_chunks = (spec->trials + MC_CHUNK - 1) / MC_CHUNK;
+    int n_threads = spec->n_threads;
+    if (n_threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = cores > 0 ? (int)cores : 1;
+    }
+    if (n_threads > n_chunks) n_threads = (int)n_chunks;
+
+    // Histogram span: worst-case corners (+/- 2x tolerance covers the 6-sigma Gaussian tails)
+    double t = spec->tol_pct / 100.0 * (spec->dist == MC_DIST_GAUSSIAN ? 2.0 : 1.0);
+    double lo = INFINITY, hi = -INFINITY;
+    for (int a = -1; a <= 1; a += 2) {
+        for (int b = -1; b <= 1; b += 2) {
+            double v = mc_eval(spec, fmax(1.0 + a * t, MC_MIN_FACTOR), fmax(1.0 + b * t, MC_MIN_FACTOR));
+            if (v < lo) lo = v;
+            if (v > hi) hi = v;
+        }
+    }
+    if (hi - lo < 1e-300) hi = lo + 1e-300 + fabs(lo) * 1e-12;
+
+    McWorker *workers = malloc(n_threads * sizeof(McWorker));
+    pthread_t *threads = malloc(n_threads * sizeof(pthread_t));
+    McPartial *part = malloc(n_chunks * sizeof(McPartial));
+    if (!workers || !threads || !part) { free(workers); free(threads); free(part); return -1; }
+
+    int started = 1;
+    for (int i = 0; i < n_threads; i++) {
+        McWorker *w = &workers[i];
+        w->spec = spec;
+        w->first = i;
+        w->stride = n_threads;
+        w->n_chunks = n_chunks;
+        w->part = part;
+        w->hist_lo = lo;
+        w->bin_scale = MC_BINS / (hi - lo);
+    }
+    // Worker 0 runs on the calling thread
+    for (int i = 1; i < n_threads; i++, started++) {
+        if (pthread_create(&threads[i], NULL, mc_worker, &workers[i]) != 0) break;
+    }
+    for (int i = started; i < n_threads; i++) mc_worker(&workers[i]); // could not spawn: run inline
+    mc_worker(&workers[0]);
+    for (int i = 1; i < started; i++) pthread_join(threads[i], NULL);
+
+    // Reduction
+    long hist[MC_BINS];
+    double sum = 0, sumsq = 0;
+    long in_spec = 0;
+    memset(hist, 0, sizeof(hist));
+    res->min = INFINITY; res->max = -INFINITY;
+    for (long c = 0; c < n_chunks; c++) { sum += part[c].sum; sumsq += part[c].sumsq; }
+    for (int i = 0; i < n_threads; i++) {
+        McWorker *w = &workers[i];
+        in_spec += w->in_spec;
+        if (w->min < res->min) res->min = w->min;
+        if (w->max > res->max) res->max = w->max;
+        for (int b = 0; b < MC_BINS; b++) hist[b] += w->hist[b];
+    }
+
+    long n = spec->trials;
+    double nominal = mc_nominal(spec);
+    double mean_d = sum / n;
+    res->nominal = nominal;
+    res->mean = nominal + mean_d;
+    res->sigma = (n > 1) ? sqrt(fmax(0.0, (sumsq - n * mean_d * mean_d) / (n - 1))) : 0;
+    res->yield_pct = 100.0 * in_spec / n;
+    res->trials = n;
+
+    // Percentiles: walk the cumulative histogram, interpolating inside the bin
+    double bin_w = (hi - lo) / MC_BINS;
+    long cum = 0;
+    int b = 0;
+    for (int k = 0; k < MC_PCT_COUNT; k++) {
+        double target = MC_PCT_LEVELS[k] / 100.0 * n;
+        while (b < MC_BINS - 1 && cum + hist[b] < target) cum += hist[b++];
+        double frac = hist[b] ? (target - cum) / hist[b] : 0.5;
+        double v = lo + (b + frac) * bin_w;
+        if (v < res->min) v = res->min;
+        if (v > res->max) v = res->max;
+        res->pct[k] = v;
+    }
+
+    free(workers); free(threads); free(part);
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+// ============================================
+// Monte Carlo tolerance / yield analysis
+// ============================================
+
+// Designs that can be analysed, and what p[] holds for each
+enum {
+    MC_DIVIDER = 1,     // p = { Vin, R1, R2 }  -> Vout
+    MC_LED,             // p = { Vs, Vf, R }    -> LED current
+    MC_OPAMP_NONINV,    // p = { R1, R2 }       -> gain 1 + R2/R1
+    MC_OPAMP_INV        // p = { R1, R2 }       -> gain R2/R1
+};
+
+// Resistor value distributions
+enum {
+    MC_DIST_UNIFORM = 1,  // flat over +/- tolerance
+    MC_DIST_GAUSSIAN      // tolerance = 3 sigma
+};
+
+#define MC_PCT_COUNT 5
+extern const double MC_PCT_LEVELS[MC_PCT_COUNT]; // 1, 5, 50, 95, 99 %
+
+typedef struct {
+    int design;
+    double p[3];
+    double tol_pct;          // resistor tolerance, e.g. 5 for Gold (0 .. < 100)
+    int dist;
+    double spec_lo, spec_hi; // output window that counts as a good build
+    long trials;
+    int n_threads;           // <= 0 means one per core
+    unsigned long long seed;
+} McSpec;
+
+typedef struct {
+    double nominal;          // output with every part at nominal
+    double mean, sigma;
+    double min, max;
+    double pct[MC_PCT_COUNT];
+    double yield_pct;        // % of trials inside [spec_lo, spec_hi]
+    long trials;
+} McResult;
+
+double mc_nominal(const McSpec *spec);
+int mc_run(const McSpec *spec, McResult *res);
+
+#endif
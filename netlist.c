@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include "netlist.h"
+#include "circuits.h"
+
+// ============================================
+// Netlist parsing
+// ============================================
+// One element or directive per line, e.g.
+//     * comment line
+//     V1 in 0 DC 5       ; trailing comment
+//     R1 in out 4.7k
+//     C1 out 0 100n
+//     .tran 1u 2m
+//     .dc V1 0 10 0.5
+//     .end
+// Node "0" (or "gnd") is ground; other node names are free text. Element names start with
+// R, C, L, V or I. Values take the workbench suffixes (p n u m k M G) and "meg".
+
+void netlist_init(Netlist *nl) {
+    memset(nl, 0, sizeof(*nl));
+}
+
+void netlist_free(Netlist *nl) {
+    free(nl->node_names); free(nl->hash); free(nl->el);
+    netlist_init(nl);
+}
+
+const char *netlist_kind_name(NlKind kind) {
+    static const char *NAMES[] = { "", "Resistor", "Capacitor", "Inductor", "Voltage source", "Current source" };
+    return (kind >= NL_R && kind <= NL_I) ? NAMES[kind] : "?";
+}
+
+// Node and element names share one open-addressing index. A slot holds a node index (>= 0)
+// or -(element + 2) for an element, so a node and an element may have the same name.
+// Names are case-insensitive, as in SPICE.
+static unsigned name_hash(const char *s) {
+    unsigned h = 2166136261u;   // FNV-1a
+    while (*s) { h ^= (unsigned char)tolower((unsigned char)*s++); h *= 16777619u; }
+    return h;
+}
+
+static int is_ground(const char *name) {
+    return strcmp(name, "0") == 0 || strcasecmp(name, "gnd") == 0;
+}
+
+static const char *slot_name(const Netlist *nl, int v) {
+    return v >= 0 ? nl->node_names[v] : nl->el[-v - 2].name;
+}
+
+static int name_lookup(const Netlist *nl, const char *name, int want_elem) {
+    if (!nl->hash_cap) return -1;
+    for (unsigned h = name_hash(name) & (nl->hash_cap - 1); nl->hash[h] != -1; h = (h + 1) & (nl->hash_cap - 1)) {
+        int v = nl->hash[h];
+        if ((v < -1) == want_elem && strcasecmp(slot_name(nl, v), name) == 0) return want_elem ? -v - 2 : v;
+    }
+    return -1;
+}
+
+static void hash_insert(Netlist *nl, int v) {
+    unsigned h = name_hash(slot_name(nl, v)) & (nl->hash_cap - 1);
+    while (nl->hash[h] != -1) h = (h + 1) & (nl->hash_cap - 1);
+    nl->hash[h] = v;
+}
+
+// Keeps the index at most half full. Returns -1 when out of memory.
+static int hash_reserve(Netlist *nl) {
+    if (2 * (nl->n_nodes + nl->n_el + 2) <= nl->hash_cap) return 0;
+    int cap = nl->hash_cap ? 2 * nl->hash_cap : 256;
+    int *p = malloc((size_t)cap * sizeof(int));
+    if (!p) return -1;
+    free(nl->hash);
+    nl->hash = p;
+    nl->hash_cap = cap;
+    for (int i = 0; i < cap; i++) p[i] = -1;
+    for (int i = 1; i < nl->n_nodes; i++) hash_insert(nl, i);
+    for (int i = 0; i < nl->n_el; i++) hash_insert(nl, -i - 2);
+    return 0;
+}
+
+// Index of a node, or -1 if it does not exist
+int netlist_find_node(const Netlist *nl, const char *name) {
+    return is_ground(name) ? 0 : name_lookup(nl, name, 0);
+}
+
+// Index of an element by name, or -1
+int netlist_find_element(const Netlist *nl, const char *name) {
+    return name_lookup(nl, name, 1);
+}
+
+// Index of a node, added on first use. Returns -1 when out of memory.
+static int node_index(Netlist *nl, const char *name) {
+    int k = netlist_find_node(nl, name);
+    if (k >= 0) return k;
+    if (nl->n_nodes == 0) nl->n_nodes = 1;   // ground always exists
+    if (nl->n_nodes + 1 > nl->node_cap) {
+        int cap = nl->node_cap ? 2 * nl->node_cap : 64;
+        char (*p)[NL_NAME_LEN] = realloc(nl->node_names, (size_t)cap * NL_NAME_LEN);
+        if (!p) return -1;
+        if (nl->node_cap == 0) snprintf(p[0], NL_NAME_LEN, "0");
+        nl->node_names = p;
+        nl->node_cap = cap;
+    }
+    if (hash_reserve(nl) != 0) return -1;
+    k = nl->n_nodes++;
+    snprintf(nl->node_names[k], NL_NAME_LEN, "%s", name);
+    hash_insert(nl, k);
+    return k;
+}
+
+// Values use the workbench parser, which also knows the SPICE "meg" suffix
+static int netlist_value(const char *s, double *out) {
+    return parse_eng_value(s, out) == ENG_OK ? 0 : -1;
+}
+
+static int syntax(Netlist *nl, const char *msg, const char *tok) {
+    snprintf(nl->err, sizeof(nl->err), "line %d: %s%s%.32s%s", nl->line_no, msg,
+             tok ? " '" : "", tok ? tok : "", tok ? "'" : "");
+    return NL_ERR_SYNTAX;
+}
+
+static int parse_directive(Netlist *nl, char **tok, int n_tok) {
+    NlDirectives *d = &nl->dir;
+    if (strcasecmp(tok[0], ".op") == 0) return NL_OK;
+    if (strcasecmp(tok[0], ".end") == 0) return 1;
+    if (strcasecmp(tok[0], ".tran") == 0) {
+        if (n_tok != 3 || netlist_value(tok[1], &d->tran_step) || netlist_value(tok[2], &d->tran_stop))
+            return syntax(nl, "expected .tran <step> <stop>", NULL);
+        if (!(d->tran_step > 0) || !(d->tran_stop >= d->tran_step)) return syntax(nl, "need 0 < step <= stop", NULL);
+        d->has_tran = 1;
+        return NL_OK;
+    }
+    if (strcasecmp(tok[0], ".dc") == 0) {
+        double step;
+        if (n_tok != 5 || netlist_value(tok[2], &d->dc_start) || netlist_value(tok[3], &d->dc_stop) ||
+            netlist_value(tok[4], &step))
+            return syntax(nl, "expected .dc <element> <start> <stop> <step>", NULL);
+        double points = (step != 0) ? floor((d->dc_stop - d->dc_start) / step + 1e-9) + 1 : 0;
+        if (points < 1 || points > NL_MAX_SWEEP) return syntax(nl, "bad .dc step", tok[4]);
+        snprintf(d->dc_elem, NL_NAME_LEN, "%s", tok[1]);
+        d->dc_points = (int)points;
+        d->dc_stop = d->dc_start + (points - 1) * step;
+        d->has_dc = 1;
+        return NL_OK;
+    }
+    return syntax(nl, "unknown directive", tok[0]);
+}
+
+/**
+ * @brief Parses one netlist line (element, directive, comment or blank).
+ * @return NL_OK, 1 for ".end", or a negative NL_ERR_* code with nl->err set.
+ */
+int netlist_parse_line(Netlist *nl, const char *line) {
+    char buf[NL_LINE_LEN], *tok[8], *save;
+    int n_tok = 0;
+    nl->line_no++;
+    snprintf(buf, sizeof(buf), "%s", line);
+    buf[strcspn(buf, ";")] = '\0';   // trailing comment
+    for (char *p = strtok_r(buf, " \t\r\n", &save); p && n_tok < 8; p = strtok_r(NULL, " \t\r\n", &save)) tok[n_tok++] = p;
+    if (n_tok == 0 || tok[0][0] == '*') return NL_OK;
+    if (tok[0][0] == '.') return parse_directive(nl, tok, n_tok);
+
+    static const char KINDS[] = "?RCLVI";
+    const char *k = strchr(KINDS + 1, toupper((unsigned char)tok[0][0]));
+    if (!k) return syntax(nl, "unknown element type", tok[0]);
+    NlElement e = { (NlKind)(k - KINDS), "", 0, 0, 0, -1 };
+
+    // Sources may write "DC 5" for the value
+    int vi = 3;
+    if ((e.kind == NL_V || e.kind == NL_I) && n_tok == 5 && strcasecmp(tok[3], "dc") == 0) vi = 4;
+    if (n_tok != vi + 1) return syntax(nl, "expected <name> <node> <node> <value>", NULL);
+    if (strlen(tok[0]) >= NL_NAME_LEN || strlen(tok[1]) >= NL_NAME_LEN || strlen(tok[2]) >= NL_NAME_LEN)
+        return syntax(nl, "name too long", NULL);
+    if (netlist_find_element(nl, tok[0]) >= 0) return syntax(nl, "duplicate element", tok[0]);
+    if (netlist_value(tok[vi], &e.value)) return syntax(nl, "bad value", tok[vi]);
+    if (e.kind <= NL_L && !(e.value > 0)) return syntax(nl, "value must be positive", tok[vi]);
+    snprintf(e.name, NL_NAME_LEN, "%s", tok[0]);
+    e.n1 = node_index(nl, tok[1]);
+    e.n2 = node_index(nl, tok[2]);
+    if (e.n1 < 0 || e.n2 < 0) return NL_ERR_MEMORY;
+    if (e.n1 == e.n2 && (e.kind == NL_V || e.kind == NL_L)) return syntax(nl, "element shorts its own terminals", tok[0]);
+    if (e.kind == NL_V || e.kind == NL_L) e.branch = nl->n_branch++;
+
+    if (nl->n_el == nl->el_cap) {
+        int cap = nl->el_cap ? 2 * nl->el_cap : 64;
+        NlElement *p = realloc(nl->el, (size_t)cap * sizeof(NlElement));
+        if (!p) return NL_ERR_MEMORY;
+        nl->el = p;
+        nl->el_cap = cap;
+    }
+    if (hash_reserve(nl) != 0) return NL_ERR_MEMORY;
+    nl->el[nl->n_el] = e;
+    hash_insert(nl, -nl->n_el - 2);
+    nl->n_el++;
+    return NL_OK;
+}
+
+/**
+ * @brief Reads a netlist file up to ".end" or end of file.
+ * @return NL_OK or a negative NL_ERR_* code with nl->err set.
+ */
+int netlist_load(Netlist *nl, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) { snprintf(nl->err, sizeof(nl->err), "cannot open '%.60s'", path); return NL_ERR_IO; }
+    char line[NL_LINE_LEN];
+    int rc = NL_OK;
+    while (rc == NL_OK && fgets(line, sizeof(line), fp)) rc = netlist_parse_line(nl, line);
+    fclose(fp);
+    if (rc < 0) return rc;
+    if (nl->n_el == 0) { snprintf(nl->err, sizeof(nl->err), "netlist has no elements"); return NL_ERR_SYNTAX; }
+    return NL_OK;
+}
+
+// ============================================
+// MNA assembly
+// ============================================
+// Every analysis calls the same stamping walk; the first walk records positions (triplets),
+// later walks add values through the recorded slots. So the pattern, and with it the
+// fill-reducing order, is fixed at build time whatever the element values or analysis.
+
+enum { MNA_DC, MNA_BE, MNA_TRAP };   // capacitor open / inductor short, backward Euler, trapezoidal
+
+typedef struct {
+    MnaSystem *sys;
+    SpTriplets *trip;   // set while recording the pattern
+    int cursor, failed;
+} Stamper;
+
+static void stamp(Stamper *s, int r, int c, double v) {
+    if (r < 0 || c < 0) return;   // ground row / column
+    if (s->trip) {
+        if (sp_triplets_add(s->trip, r, c) < 0) s->failed = 1;
+    } else {
+        s->sys->a.val[s->sys->slot[s->cursor]] += v;
+    }
+    s->cursor++;
+}
+
+static void stamp_conductance(Stamper *s, int a, int b, double g) {
+    stamp(s, a, a, g); stamp(s, b, b, g);
+    stamp(s, a, b, -g); stamp(s, b, a, -g);
+}
+
+// Branch current i from a to b with v_a - v_b - z i = rhs
+static void stamp_branch(Stamper *s, int a, int b, int br, double z) {
+    stamp(s, a, br, 1); stamp(s, b, br, -1);
+    stamp(s, br, a, 1); stamp(s, br, b, -1);
+    stamp(s, br, br, -z);
+}
+
+// Companion-model coefficient of C (conductance) or L (impedance) for a step h
+static double companion(int mode, double x, double h) {
+    return mode == MNA_DC ? 0 : mode == MNA_BE ? x / h : 2 * x / h;
+}
+
+static void stamp_all(Stamper *s, int mode, double h) {
+    const Netlist *nl = s->sys->nl;
+    int nb = nl->n_nodes - 1;
+    for (int i = 0; i < nl->n_el; i++) {
+        const NlElement *e = &nl->el[i];
+        int a = e->n1 - 1, b = e->n2 - 1, br = nb + e->branch;
+        switch (e->kind) {
+            case NL_R: stamp_conductance(s, a, b, 1.0 / e->value); break;
+            case NL_C: stamp_conductance(s, a, b, companion(mode, e->value, h)); break;
+            case NL_L: stamp_branch(s, a, b, br, companion(mode, e->value, h)); break;
+            case NL_V: stamp_branch(s, a, b, br, 0); break;
+            case NL_I: break;
+        }
+    }
+    for (int k = 0; k < nb; k++) stamp(s, k, k, NL_GMIN);
+}
+
+// Right-hand side: sources plus the companion history terms of C and L
+static void load_rhs(MnaSystem *sys, int mode, double h) {
+    const Netlist *nl = sys->nl;
+    int nb = nl->n_nodes - 1;
+    memset(sys->rhs, 0, (size_t)sys->n * sizeof(double));
+    for (int i = 0; i < nl->n_el; i++) {
+        const NlElement *e = &nl->el[i];
+        int a = e->n1 - 1, b = e->n2 - 1;
+        double inj = 0;   // current pushed into node a (and out of b)
+        switch (e->kind) {
+            case NL_V: sys->rhs[nb + e->branch] = e->value; break;
+            case NL_I: inj = -e->value; break;
+            case NL_C:
+                if (mode != MNA_DC) inj = companion(mode, e->value, h) * sys->v_prev[i] + (mode == MNA_TRAP ? sys->i_prev[i] : 0);
+                break;
+            case NL_L:
+                if (mode != MNA_DC) {
+                    double z = companion(mode, e->value, h);
+                    sys->rhs[nb + e->branch] = -z * sys->i_prev[i] - (mode == MNA_TRAP ? sys->v_prev[i] : 0);
+                }
+                break;
+            case NL_R: break;
+        }
+        if (a >= 0) sys->rhs[a] += inj;
+        if (b >= 0) sys->rhs[b] -= inj;
+    }
+}
+
+// Writes matrix values for the given analysis and factors them, reusing the previous pivots
+// and L/U pattern when they still hold
+static int mna_factor(MnaSystem *sys, int mode, double h) {
+    memset(sys->a.val, 0, (size_t)sys->a.nnz * sizeof(double));
+    Stamper s = { sys, NULL, 0, 0 };
+    stamp_all(&s, mode, h);
+    if (sys->lu.factored && splu_refactor(&sys->a, &sys->lu) == 0) { sys->n_refactor++; return NL_OK; }
+    if (splu_factor(&sys->a, &sys->lu) != 0) return NL_ERR_SINGULAR;
+    sys->n_factor++;
+    return NL_OK;
+}
+
+/**
+ * @brief Builds the MNA pattern (compressed sparse column) and its fill-reducing order.
+ * @return NL_OK or NL_ERR_MEMORY.
+ */
+int mna_build(MnaSystem *sys, const Netlist *nl) {
+    memset(sys, 0, sizeof(*sys));
+    sys->nl = nl;
+    sys->n = nl->n_nodes - 1 + nl->n_branch;
+    if (sys->n < 1) return NL_ERR_SYNTAX;
+
+    SpTriplets trip;
+    sp_triplets_init(&trip, sys->n);
+    Stamper s = { sys, &trip, 0, 0 };
+    stamp_all(&s, MNA_DC, 1.0);
+    sys->n_stamps = s.cursor;
+    sys->slot = malloc((size_t)(s.cursor ? s.cursor : 1) * sizeof(int));
+    int rc = (s.failed || !sys->slot || sp_compress(&trip, &sys->a, sys->slot) != 0) ? NL_ERR_MEMORY : NL_OK;
+    sp_triplets_free(&trip);
+    if (rc == NL_OK && splu_analyze(&sys->a, &sys->lu) != 0) rc = NL_ERR_MEMORY;
+
+    sys->rhs = malloc((size_t)sys->n * sizeof(double));
+    sys->v_prev = calloc((size_t)nl->n_el, sizeof(double));
+    sys->i_prev = calloc((size_t)nl->n_el, sizeof(double));
+    if (rc == NL_OK && (!sys->rhs || !sys->v_prev || !sys->i_prev)) rc = NL_ERR_MEMORY;
+    if (rc != NL_OK) mna_free(sys);
+    return rc;
+}
+
+void mna_free(MnaSystem *sys) {
+    sp_free(&sys->a);
+    splu_free(&sys->lu);
+    free(sys->slot); free(sys->rhs); free(sys->v_prev); free(sys->i_prev);
+    memset(sys, 0, sizeof(*sys));
+}
+
+double mna_node_voltage(const MnaSystem *sys, const double *x, int node) {
+    (void)sys;
+    return node > 0 ? x[node - 1] : 0.0;
+}
+
+// Current from n1 to n2 through the element; capacitors use the last transient state
+double mna_element_current(const MnaSystem *sys, const double *x, int elem) {
+    const NlElement *e = &sys->nl->el[elem];
+    switch (e->kind) {
+        case NL_R: return (mna_node_voltage(sys, x, e->n1) - mna_node_voltage(sys, x, e->n2)) / e->value;
+        case NL_I: return e->value;
+        case NL_C: return sys->i_prev[elem];
+        default:   return x[sys->nl->n_nodes - 1 + e->branch];
+    }
+}
+
+// ============================================
+// Analyses
+// ============================================
+
+/**
+ * @brief DC operating point (capacitors open, inductors shorted). x receives sys->n unknowns.
+ * @return NL_OK or NL_ERR_SINGULAR.
+ */
+int mna_op(MnaSystem *sys, double *x) {
+    int rc = mna_factor(sys, MNA_DC, 1.0);
+    if (rc != NL_OK) return rc;
+    load_rhs(sys, MNA_DC, 1.0);
+    splu_solve(&sys->lu, sys->rhs);
+    sys->n_solve++;
+    memcpy(x, sys->rhs, (size_t)sys->n * sizeof(double));
+    memset(sys->i_prev, 0, (size_t)sys->nl->n_el * sizeof(double));
+    return NL_OK;
+}
+
+/**
+ * @brief Sweeps one element's value and records the probe node voltage at each point.
+ *        Sources only change the right-hand side, so one factorisation serves the whole sweep;
+ *        R, L or C change the matrix values and are refactored on the same pattern.
+ * @return NL_OK or NL_ERR_SINGULAR. The element keeps its original value afterwards.
+ */
+int mna_dc_sweep(MnaSystem *sys, Netlist *nl, int elem, double start, double stop, int points,
+                 int probe_node, double *values) {
+    NlElement *e = &nl->el[elem];
+    double saved = e->value;
+    int source = (e->kind == NL_V || e->kind == NL_I), rc = NL_OK;
+    for (int k = 0; k < points && rc == NL_OK; k++) {
+        e->value = (points > 1) ? start + (stop - start) * k / (points - 1) : start;
+        if (e->kind <= NL_L && !(e->value > 0)) { values[k] = NAN; continue; }
+        if (!source || k == 0) rc = mna_factor(sys, MNA_DC, 1.0);
+        if (rc != NL_OK) break;
+        load_rhs(sys, MNA_DC, 1.0);
+        splu_solve(&sys->lu, sys->rhs);
+        sys->n_solve++;
+        values[k] = mna_node_voltage(sys, sys->rhs, probe_node);
+    }
+    e->value = saved;
+    return rc;
+}
+
+// Element voltages and currents after a solved step, for the next step's history terms
+static void update_state(MnaSystem *sys, int mode, double h) {
+    const Netlist *nl = sys->nl;
+    const double *x = sys->rhs;
+    for (int i = 0; i < nl->n_el; i++) {
+        const NlElement *e = &nl->el[i];
+        double v = mna_node_voltage(sys, x, e->n1) - mna_node_voltage(sys, x, e->n2);
+        if (e->kind == NL_C) {
+            double g = companion(mode, e->value, h);
+            sys->i_prev[i] = g * (v - sys->v_prev[i]) - (mode == MNA_TRAP ? sys->i_prev[i] : 0);
+        } else if (e->kind == NL_L) {
+            sys->i_prev[i] = x[nl->n_nodes - 1 + e->branch];
+        }
+        sys->v_prev[i] = v;
+    }
+}
+
+/**
+ * @brief Step response from rest: every source switches on at t = 0 with all capacitors
+ *        discharged and inductor currents zero. The first step is backward Euler (it damps the
+ *        jump at t = 0), the rest trapezoidal; with a fixed step that is two factorisations for
+ *        the whole run, then one forward/back substitution per step.
+ * @param probe_node Node whose voltage is recorded, or -1 to record probe_elem's current.
+ * @param values Optional, receives steps + 1 samples (t = k * step).
+ * @return Number of steps, or a negative NL_ERR_* code.
+ */
+long mna_tran(MnaSystem *sys, double step, double stop, int probe_node, int probe_elem,
+              double *values, NlTranStats *st) {
+    long steps = lround(stop / step);
+    if (steps < 1) return NL_ERR_SYNTAX;
+    const Netlist *nl = sys->nl;
+    memset(sys->v_prev, 0, (size_t)nl->n_el * sizeof(double));
+    memset(sys->i_prev, 0, (size_t)nl->n_el * sizeof(double));
+    memset(sys->rhs, 0, (size_t)sys->n * sizeof(double));
+
+    double y = 0;
+    st->min_value = st->max_value = st->final_value = 0;
+    if (values) values[0] = 0;
+    int mode = -1;
+    for (long k = 1; k <= steps; k++) {
+        int m = (k == 1) ? MNA_BE : MNA_TRAP;
+        if (m != mode) {
+            int rc = mna_factor(sys, m, step);
+            if (rc != NL_OK) return rc;
+            mode = m;
+        }
+        load_rhs(sys, mode, step);
+        splu_solve(&sys->lu, sys->rhs);
+        sys->n_solve++;
+        update_state(sys, mode, step);
+        y = (probe_node >= 0) ? mna_node_voltage(sys, sys->rhs, probe_node)
+                              : mna_element_current(sys, sys->rhs, probe_elem);
+        if (values) values[k] = y;
+        if (y < st->min_value) st->min_value = y;
+        if (y > st->max_value) st->max_value = y;
+    }
+    st->final_value = y;
+    return steps;
+}
@@ -0,0 +1,98 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+// ============================================
+// SPICE-like netlists solved by modified nodal analysis (MNA) on the sparse LU in sparse.c.
+// Nothing in here prompts; errors come back as negative codes with a message in nl->err.
+// ============================================
+
+#include "sparse.h"
+
+#define NL_NAME_LEN 24
+#define NL_LINE_LEN 256
+#define NL_ERR_LEN 96
+#define NL_GMIN 1e-12           // conductance from every node to ground (floating nodes)
+#define NL_MAX_SWEEP 1000000
+
+// Return codes
+enum {
+    NL_OK = 0,
+    NL_ERR_SYNTAX = -1,     // bad line (nl->err says which)
+    NL_ERR_MEMORY = -2,
+    NL_ERR_SINGULAR = -3,   // e.g. a loop of voltage sources / inductors
+    NL_ERR_IO = -4
+};
+
+typedef enum { NL_R = 1, NL_C, NL_L, NL_V, NL_I } NlKind;
+
+typedef struct {
+    NlKind kind;
+    char name[NL_NAME_LEN];
+    int n1, n2;             // node indices, 0 = ground; current flows n1 -> n2 through the part
+    double value;           // ohms, farads, henries, volts, amps
+    int branch;             // V and L: index of the branch-current unknown, else -1
+} NlElement;
+
+// Analyses requested in the netlist (".op" is always available)
+typedef struct {
+    int has_tran;
+    double tran_step, tran_stop;
+    int has_dc;
+    char dc_elem[NL_NAME_LEN];
+    double dc_start, dc_stop;
+    int dc_points;
+} NlDirectives;
+
+typedef struct {
+    int n_nodes;                        // including ground (node 0)
+    char (*node_names)[NL_NAME_LEN];
+    int node_cap;
+    int *hash;                          // open-addressing name index (nodes and elements)
+    int hash_cap;
+    NlElement *el;
+    int n_el, el_cap;
+    int n_branch;
+    NlDirectives dir;
+    int line_no;                        // last line read (for messages)
+    char err[NL_ERR_LEN];
+} Netlist;
+
+// MNA system: unknowns are node voltages 1 .. n_nodes-1 then branch currents. The matrix pattern
+// is built once; every analysis only rewrites values and reuses the symbolic factorisation.
+typedef struct {
+    const Netlist *nl;
+    int n;                  // unknowns
+    SpMatrix a;
+    int *slot;              // stamp index -> position in a.val
+    int n_stamps;
+    SpLu lu;
+    double *rhs;            // right-hand side / solution (n)
+    double *v_prev;         // transient state: element voltages (n_el)
+    double *i_prev;         // transient state: element currents (n_el)
+    int n_factor, n_refactor, n_solve;   // work counters
+} MnaSystem;
+
+// Probe summary of a transient run
+typedef struct {
+    double final_value, min_value, max_value;
+} NlTranStats;
+
+void netlist_init(Netlist *nl);
+void netlist_free(Netlist *nl);
+int netlist_parse_line(Netlist *nl, const char *line);
+int netlist_load(Netlist *nl, const char *path);
+int netlist_find_node(const Netlist *nl, const char *name);
+int netlist_find_element(const Netlist *nl, const char *name);
+const char *netlist_kind_name(NlKind kind);
+
+int mna_build(MnaSystem *sys, const Netlist *nl);
+void mna_free(MnaSystem *sys);
+int mna_op(MnaSystem *sys, double *x);
+double mna_node_voltage(const MnaSystem *sys, const double *x, int node);
+double mna_element_current(const MnaSystem *sys, const double *x, int elem);
+int mna_dc_sweep(MnaSystem *sys, Netlist *nl, int elem, double start, double stop, int points,
+                 int probe_node, double *values);
+long mna_tran(MnaSystem *sys, double step, double stop, int probe_node, int probe_elem,
+              double *values, NlTranStats *st);
+
+#endif
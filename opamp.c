@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <math.h>
+#include "opamp.h"
+
+#define OPAMP_GRID_MAX (ESERIES_MAX_SIZE * OPAMP_MAX_DECADES + 1)
+// Errors closer than this (in %) count as the same ratio
+#define OPAMP_TIE_PCT 1e-9
+
+// ============================================
+// Helpers
+// ============================================
+
+// Current through the feedback network when the output sits at vout
+double opamp_feedback_current(int mode, double vout, double r1, double r2) {
+    // Non-inverting: Vout drives R2 + R1 to ground. Inverting: R2 sits between Vout and virtual ground.
+    return fabs(vout) / (mode == OPAMP_NON_INVERTING ? r1 + r2 : r2);
+}
+
+// Every series value in [r_min, r_max], ascending. Returns the count.
+static int build_grid(ESeries series, double r_min, double r_max, double *grid) {
+    const double *base;
+    int n_base = eseries_values(series, &base), n = 0;
+    int d0 = (int)floor(log10(r_min) + 1e-9), d1 = (int)floor(log10(r_max) + 1e-9);
+
+    for (int d = d0; d <= d1; d++) {
+        double p10 = pow(10, abs(d));
+        for (int i = 0; i < n_base; i++) {
+            // Divide for negative decades so e.g. 4.7 / 10 rounds to the nearest double of 0.47
+            double v = d >= 0 ? base[i] * p10 : base[i] / p10;
+            if (v >= r_min * (1 - 1e-12) && v <= r_max * (1 + 1e-12)) grid[n++] = v;
+        }
+    }
+    return n;
+}
+
+// First index with grid[i] >= x (n if none)
+static int lower_bound(const double *grid, int n, double x) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (grid[mid] < x) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// First index with grid[i] > x (n if none)
+static int upper_bound(const double *grid, int n, double x) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (grid[mid] <= x) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Ranking: lower error first. The same ratio repeats in every decade, so ties go to
+// the pair centred nearest 10k (sqrt(R1*R2) = 1e4), away from loading and noise extremes.
+static int pair_better(const OpAmpDesign *a, const OpAmpDesign *b) {
+    if (fabs(a->error_pct - b->error_pct) > OPAMP_TIE_PCT) return a->error_pct < b->error_pct;
+    return fabs(log10(a->r1 * a->r2) - 8.0) < fabs(log10(b->r1 * b->r2) - 8.0);
+}
+
+// Inserts d into the ranked top-k list if it beats the current k-th entry
+static void top_insert(OpAmpDesign *top, int *n, int k, const OpAmpDesign *d) {
+    int pos = *n < k ? *n : k - 1;
+    if (*n == k && !pair_better(d, &top[k - 1])) return;
+    while (pos > 0 && pair_better(d, &top[pos - 1])) {
+        top[pos] = top[pos - 1];
+        pos--;
+    }
+    top[pos] = *d;
+    if (*n < k) (*n)++;
+}
+
+// ============================================
+// Search
+// ============================================
+
+/**
+ * @brief Exhaustive top-K search over every (R1, R2) pair of the series in [r_min, r_max].
+ *
+ * For each R1 (ascending) the ideal R2 = ratio * R1 also ascends, so one pointer merged
+ * through the sorted grid finds the bracketing R2 in amortised O(1). The gain error grows
+ * monotonically away from that bracket, so candidates are taken outward from it until they
+ * can no longer enter the top-K list. The constraints reduce to an R2 window per R1.
+ * @return Number of pairs written to out (best first, see pair_better), or -1 on bad parameters.
+ */
+int opamp_search(const OpAmpSearch *spec, OpAmpDesign *out) {
+    int mode = spec->mode, k = spec->top_k;
+    double gain = spec->gain;
+    double r_min = spec->r_min > 0 ? spec->r_min : 10.0;
+    double r_max = spec->r_max > 0 ? spec->r_max : 10e6;
+
+    if (mode != OPAMP_NON_INVERTING && mode != OPAMP_INVERTING) return -1;
+    if (k < 1 || k > OPAMP_MAX_TOP || !(gain > 0)) return -1;
+    if (spec->series < 0 || spec->series >= ESERIES_COUNT) return -1;
+    if (r_min > r_max || log10(r_max) - log10(r_min) > OPAMP_MAX_DECADES - 1) return -1;
+
+    // Target R2/R1 ratio. A non-inverting gain of exactly 1 needs R2 = 0 (a wire).
+    double ratio = (mode == OPAMP_NON_INVERTING) ? gain - 1.0 : gain;
+    if (!(ratio > 0)) return -1;
+
+    double grid[OPAMP_GRID_MAX];
+    int n = build_grid(spec->series, r_min, r_max, grid);
+    int found = 0, j = 0;
+
+    for (int i = 0; i < n; i++) {
+        double r1 = grid[i], target = ratio * r1;
+
+        // R2 window from the constraints
+        double lo2 = 0, hi2 = INFINITY;
+        if (spec->rtot_min > 0) lo2 = fmax(lo2, spec->rtot_min - r1);
+        if (spec->rtot_max > 0) hi2 = spec->rtot_max - r1;
+        if (spec->ifb_max > 0 && spec->vout != 0) {
+            double r_need = fabs(spec->vout) / spec->ifb_max;  // minimum feedback resistance
+            lo2 = fmax(lo2, mode == OPAMP_NON_INVERTING ? r_need - r1 : r_need);
+        }
+        int a = lower_bound(grid, n, lo2), b = upper_bound(grid, n, hi2);
+        if (a >= b) continue;
+
+        // Merge step: the ideal R2 only moves forward as R1 grows
+        while (j < n && grid[j] < target) j++;
+
+        int left = (j < b ? j : b) - 1, right = j > a ? j : a;
+        while (left >= a || right < b) {
+            int pick;
+            if (left < a) pick = right++;
+            else if (right >= b) pick = left--;
+            else if (target - grid[left] <= grid[right] - target) pick = left--;
+            else pick = right++;
+
+            double r2 = grid[pick];
+            OpAmpDesign d = { r1, r2, (mode == OPAMP_NON_INVERTING) ? 1.0 + r2 / r1 : r2 / r1, 0 };
+            d.error_pct = fabs(d.gain - gain) / gain * 100.0;
+            // Everything further out is strictly worse
+            if (found == k && d.error_pct > out[k - 1].error_pct + OPAMP_TIE_PCT) break;
+            top_insert(out, &found, k, &d);
+        }
+    }
+    return found;
+}
@@ -0,0 +1,37 @@
+#ifndef OPAMP_H
+#define OPAMP_H
+
+// ============================================
+// Op-amp gain resistor pair search over a full E-series grid
+// ============================================
+
+#include "eseries.h"
+
+// Op-amp configurations (matches the menu numbering)
+enum { OPAMP_NON_INVERTING = 1, OPAMP_INVERTING = 2 };
+
+// Largest top-K list opamp_search() will keep
+#define OPAMP_MAX_TOP 50
+// Widest part range accepted (decades between r_min and r_max)
+#define OPAMP_MAX_DECADES 12
+
+typedef struct {
+    double r1, r2;
+    double gain;      // actual gain magnitude
+    double error_pct; // |gain - target| / target * 100
+} OpAmpDesign;
+
+typedef struct {
+    int mode;                  // OPAMP_NON_INVERTING or OPAMP_INVERTING
+    double gain;               // target gain magnitude
+    ESeries series;
+    double r_min, r_max;       // range for each part; 0 selects 10 Ohm .. 10 MOhm
+    double rtot_min, rtot_max; // limits on R1 + R2 (0 = no limit)
+    double vout, ifb_max;      // feedback current at |Vout| must stay <= ifb_max (0 = no limit)
+    int top_k;                 // number of pairs to return (1 .. OPAMP_MAX_TOP)
+} OpAmpSearch;
+
+int opamp_search(const OpAmpSearch *spec, OpAmpDesign *out);
+double opamp_feedback_current(int mode, double vout, double r1, double r2);
+
+#endif
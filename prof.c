@@ -0,0 +1,258 @@
+#include "prof.h"
+
+#ifndef NO_PROF
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <malloc.h>
+#include <stdatomic.h>
+
+typedef struct {
+    unsigned long long count, total_ns, min_ns, max_ns;
+    unsigned long long allocs, bytes;   // allocations made while the span was open
+    unsigned long long hist[PROF_BUCKETS];
+} ProfStat;
+
+static const char *SLOT_NAMES[PROF_SLOTS] = {
+    "1 Colour Code", "2 Ohm's Law", "3 Divider", "4 RLC Analyser", "5 LED Resistor",
+    "6 Op-Amp", "7 History", "8 RLC Sweep", "9 Network Synth", "10 Netlist",
+    "batch command", "input parse", "simulation", "plotting", "history append", "export"
+};
+
+static ProfStat g_stats[PROF_SLOTS];
+static unsigned long long g_start_ns;
+static unsigned long long g_wait_ns;   // time spent blocked on user input so far
+
+// ============================================
+// Allocation counters
+// ============================================
+// The malloc family (malloc/calloc/realloc/free and the aligned variants) is defined here and
+// forwards to glibc's own entry points, so every allocation in the process (including the C
+// library's) is counted without touching call sites, and every block that free() sees was counted.
+// Live bytes use malloc_usable_size(), i.e. the allocator's rounded-up block sizes.
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void __libc_free(void *p);
+extern void *__libc_memalign(size_t align, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+
+static _Atomic unsigned long long g_allocs, g_frees, g_bytes, g_live, g_peak;
+
+static void note_alloc(void *p, size_t requested) {
+    if (!p) return;
+    atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_bytes, requested, memory_order_relaxed);
+    size_t usable = malloc_usable_size(p);
+    unsigned long long live = atomic_fetch_add_explicit(&g_live, usable, memory_order_relaxed) + usable;
+    unsigned long long peak = atomic_load_explicit(&g_peak, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&g_peak, &peak, live,
+                                                                 memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+static void note_free(void *p) {
+    if (!p) return;
+    atomic_fetch_add_explicit(&g_frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&g_live, malloc_usable_size(p), memory_order_relaxed);
+}
+
+void *malloc(size_t size) {
+    void *p = __libc_malloc(size);
+    note_alloc(p, size);
+    return p;
+}
+
+void *calloc(size_t n, size_t size) {
+    void *p = __libc_calloc(n, size);
+    note_alloc(p, n * size);
+    return p;
+}
+
+// Counted as a free of the old block plus a new allocation, as that is what it may cost
+void *realloc(void *old, size_t size) {
+    size_t old_size = old ? malloc_usable_size(old) : 0;
+    void *p = __libc_realloc(old, size);
+    if (!p) return NULL;
+    if (old) {
+        atomic_fetch_add_explicit(&g_frees, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&g_live, old_size, memory_order_relaxed);
+    }
+    note_alloc(p, size);
+    return p;
+}
+
+void free(void *p) {
+    note_free(p);
+    __libc_free(p);
+}
+
+void *memalign(size_t align, size_t size) {
+    void *p = __libc_memalign(align, size);
+    note_alloc(p, size);
+    return p;
+}
+
+void *aligned_alloc(size_t align, size_t size) {
+    void *p = __libc_memalign(align, size);
+    note_alloc(p, size);
+    return p;
+}
+
+int posix_memalign(void **out, size_t align, size_t size) {
+    if (align % sizeof(void *) != 0 || (align & (align - 1)) != 0 || align == 0) return EINVAL;
+    void *p = __libc_memalign(align, size);
+    if (!p) return ENOMEM;
+    note_alloc(p, size);
+    *out = p;
+    return 0;
+}
+
+void *valloc(size_t size) {
+    void *p = __libc_valloc(size);
+    note_alloc(p, size);
+    return p;
+}
+
+void *pvalloc(size_t size) {
+    void *p = __libc_pvalloc(size);
+    note_alloc(p, size);
+    return p;
+}
+
+// ============================================
+// Spans
+// ============================================
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+void prof_begin(ProfSpan *s) {
+    s->wait0 = g_wait_ns;
+    s->allocs0 = atomic_load_explicit(&g_allocs, memory_order_relaxed);
+    s->bytes0 = atomic_load_explicit(&g_bytes, memory_order_relaxed);
+    s->t0 = now_ns();
+}
+
+void prof_end(ProfSlot slot, const ProfSpan *s) {
+    unsigned long long ns = now_ns() - s->t0 - (g_wait_ns - s->wait0);
+    ProfStat *st = &g_stats[slot];
+    int b = ns ? 64 - __builtin_clzll(ns) : 0;
+    if (b >= PROF_BUCKETS) b = PROF_BUCKETS - 1;
+    st->hist[b]++;
+    if (st->count == 0 || ns < st->min_ns) st->min_ns = ns;
+    if (ns > st->max_ns) st->max_ns = ns;
+    st->count++;
+    st->total_ns += ns;
+    st->allocs += atomic_load_explicit(&g_allocs, memory_order_relaxed) - s->allocs0;
+    st->bytes += atomic_load_explicit(&g_bytes, memory_order_relaxed) - s->bytes0;
+}
+
+unsigned long long prof_wait_begin(void) {
+    return now_ns();
+}
+
+void prof_wait_end(unsigned long long t0) {
+    g_wait_ns += now_ns() - t0;
+}
+
+void prof_reset(void) {
+    memset(g_stats, 0, sizeof(g_stats));
+    g_start_ns = now_ns();
+}
+
+// ============================================
+// Report
+// ============================================
+
+static void format_ns(unsigned long long ns, char *buf, int len) {
+    if (ns < 1000ULL) snprintf(buf, len, "%lluns", ns);
+    else if (ns < 1000000ULL) snprintf(buf, len, "%.1fus", ns / 1e3);
+    else if (ns < 1000000000ULL) snprintf(buf, len, "%.1fms", ns / 1e6);
+    else snprintf(buf, len, "%.2fs", ns / 1e9);
+}
+
+static void format_bytes(unsigned long long n, char *buf, int len) {
+    if (n < 1024ULL) snprintf(buf, len, "%lluB", n);
+    else if (n < 1048576ULL) snprintf(buf, len, "%.1fKiB", n / 1024.0);
+    else if (n < 1073741824ULL) snprintf(buf, len, "%.1fMiB", n / 1048576.0);
+    else snprintf(buf, len, "%.2fGiB", n / 1073741824.0);
+}
+
+// Upper edge of the bucket holding the p-quantile, clamped to the observed range
+static unsigned long long hist_quantile(const ProfStat *st, double p) {
+    unsigned long long rank = (unsigned long long)(p * (st->count - 1)) + 1, seen = 0;
+    for (int b = 0; b < PROF_BUCKETS - 1; b++) {
+        seen += st->hist[b];
+        if (seen >= rank) {
+            unsigned long long edge = b ? (1ULL << b) - 1 : 0;
+            if (edge > st->max_ns) edge = st->max_ns;
+            return edge < st->min_ns ? st->min_ns : edge;
+        }
+    }
+    return st->max_ns;
+}
+
+void prof_report(FILE *out) {
+    char a[24], b[24], c[24], d[24], e[24], f[24];
+    format_ns(now_ns() - g_start_ns, a, sizeof(a));
+    fprintf(out, "\n--- Session Profile (%s wall clock) ---\n", a);
+    fprintf(out, "%-16s %7s %9s %9s %9s %9s %9s %8s %9s\n",
+            "span", "count", "total", "mean", "p50", "p90", "max", "allocs", "bytes");
+    int any = 0;
+    for (int s = 0; s < PROF_SLOTS; s++) {
+        const ProfStat *st = &g_stats[s];
+        if (!st->count) continue;
+        any = 1;
+        format_ns(st->total_ns, a, sizeof(a));
+        format_ns(st->total_ns / st->count, b, sizeof(b));
+        format_ns(hist_quantile(st, 0.5), c, sizeof(c));
+        format_ns(hist_quantile(st, 0.9), d, sizeof(d));
+        format_ns(st->max_ns, e, sizeof(e));
+        format_bytes(st->bytes, f, sizeof(f));
+        fprintf(out, "%-16s %7llu %9s %9s %9s %9s %9s %8llu %9s\n",
+                SLOT_NAMES[s], st->count, a, b, c, d, e, st->allocs, f);
+    }
+    if (!any) fprintf(out, "(no spans recorded yet)\n");
+    fprintf(out, "Time waiting for input is excluded; p50/p90 are log2 bucket edges.\n");
+
+    format_bytes(atomic_load(&g_bytes), a, sizeof(a));
+    format_bytes(atomic_load(&g_live), b, sizeof(b));
+    format_bytes(atomic_load(&g_peak), c, sizeof(c));
+    fprintf(out, "Heap (process lifetime): %llu allocations, %llu frees, %s requested, %s live, %s peak\n",
+            (unsigned long long)atomic_load(&g_allocs), (unsigned long long)atomic_load(&g_frees), a, b, c);
+}
+
+static const char *g_dump_path;
+
+static void dump_at_exit(void) {
+    if (strcmp(g_dump_path, "1") == 0 || strcmp(g_dump_path, "stderr") == 0) {
+        prof_report(stderr);
+        return;
+    }
+    FILE *f = fopen(g_dump_path, "a");
+    if (!f) { fprintf(stderr, "[Profile] Cannot write '%s'.\n", g_dump_path); return; }
+    prof_report(f);
+    fclose(f);
+}
+
+/**
+ * @brief Starts the session clock and, if PROF_ENV is set (and not "0"), registers a report
+ *        dump at exit: to stderr for "1" or "stderr", otherwise appended to that file.
+ */
+void prof_init(void) {
+    g_start_ns = now_ns();
+    const char *env = getenv(PROF_ENV);
+    if (env && *env && strcmp(env, "0") != 0) {
+        g_dump_path = env;
+        atexit(dump_at_exit);
+    }
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef PROF_H
+#define PROF_H
+
+// ============================================
+// Session instrumentation: wall-clock spans for every menu tool and for the inner stages
+// (input parsing, simulation, plotting, history append, export), kept in fixed-size log2
+// histograms, plus process-wide allocation counters (the malloc family is wrapped in prof.c).
+// Spans are recorded from the main thread only; allocation counters are atomic.
+//
+// Build with -DNO_PROF and all of it compiles out: the span macros become empty statements
+// and the allocator is left alone.
+// ============================================
+
+#include <stdio.h>
+
+#define PROF_ENV "WORKBENCH_PROF"   // set to 1 (stderr) or a file name to dump the report at exit
+#define PROF_BUCKETS 40             // bucket b holds spans of [2^(b-1), 2^b) ns; the last is open
+
+typedef enum {
+    PROF_TOOL_1 = 0,        // menu items 1 .. 10 (PROF_TOOL_1 + n - 1), input waits excluded
+    PROF_TOOL_LAST = PROF_TOOL_1 + 9,
+    PROF_BATCH,             // one batch-mode command
+    PROF_INPUT,             // engineering-value parse (the wait for the keyboard is excluded)
+    PROF_SIM,               // solvers and searches
+    PROF_PLOT,              // chart rendering
+    PROF_HISTORY,           // history append (journal write included)
+    PROF_EXPORT,            // history / waveform files
+    PROF_SLOTS
+} ProfSlot;
+
+#ifndef NO_PROF
+
+typedef struct {
+    unsigned long long t0, wait0, allocs0, bytes0;
+} ProfSpan;
+
+void prof_init(void);
+void prof_begin(ProfSpan *s);
+void prof_end(ProfSlot slot, const ProfSpan *s);
+void prof_report(FILE *out);
+void prof_reset(void);
+unsigned long long prof_wait_begin(void);
+void prof_wait_end(unsigned long long t0);
+
+#define PROF_BEGIN(span) ProfSpan span; prof_begin(&span)
+#define PROF_END(slot, span) prof_end((slot), &span)
+// Around a blocking read of user input: the wait is subtracted from every span open across it
+#define PROF_WAIT_BEGIN(w) unsigned long long w = prof_wait_begin()
+#define PROF_WAIT_END(w) prof_wait_end(w)
+
+#else
+
+#define PROF_BEGIN(span) ((void)0)
+#define PROF_END(slot, span) ((void)0)
+#define PROF_WAIT_BEGIN(w) ((void)0)
+#define PROF_WAIT_END(w) ((void)0)
+
+static inline void prof_init(void) {}
+static inline void prof_reset(void) {}
+static inline void prof_report(FILE *out) {
+    fprintf(out, "Instrumentation is compiled out (built with -DNO_PROF).\n");
+}
+
+#endif
+
+#endif
@@ -0,0 +1,379 @@
+#include <math.h>
+#include "rlc.h"
+
+// Fills in the internal resistance for LC and guards against zero L/C
+void rlc_apply_safety(RlcCircuit *ckt) {
+    if (ckt->type == RLC_TYPE_LC) ckt->r = 0.1;
+    if (ckt->type == RLC_TYPE_RC && ckt->c <= 0) ckt->c = 1e-6;
+    if (ckt->type != RLC_TYPE_RC && ckt->l <= 0) ckt->l = 1e-3;
+}
+
+// Suggests a total simulation time long enough to see the interesting part
+double rlc_auto_time(const RlcCircuit *ckt) {
+    double r = ckt->r, l = ckt->l, c = ckt->c;
+    double t_total = 0;
+    if (ckt->type == RLC_TYPE_RC) t_total = 5.0 * r * c;
+    else if (ckt->type == RLC_TYPE_RL) t_total = 5.0 * (l / r);
+    else if (ckt->type == RLC_TYPE_LC) t_total = 3.0 * (1.0 / (1.0/(2*M_PI*sqrt(l*c)))); // 3 periods
+    else if (ckt->type == RLC_TYPE_RLC) {
+        // RLC Auto-detection
+        double alpha = r / (2.0 * l);
+        double omega0 = 1.0 / sqrt(l * c);
+        if (alpha < omega0) {
+            // Underdamped: ensure we see oscillations
+            t_total = 10.0 * (2*M_PI/omega0);
+            // Cap at reasonable decay time
+            double t_decay = 5.0 / alpha;
+            if (t_total > t_decay) t_total = t_decay;
+        } else {
+            // Overdamped/Crit: settle time
+            t_total = 10.0 / alpha;
+        }
+    }
+    return t_total;
+}
+
+// Stores one sample (if tracing) and folds it into the running stats
+static void record_sample(const RlcCircuit *ckt, int i, double vc, double il,
+                          RlcTrace *trace, RlcStats *acc) {
+    double ec = (ckt->type == RLC_TYPE_RL) ? 0 : 0.5 * ckt->c * vc * vc;
+    double el = (ckt->type == RLC_TYPE_RC) ? 0 : 0.5 * ckt->l * il * il;
+
+    // Store Snapshot
+    if (trace) {
+        if (trace->vc) trace->vc[i] = vc;
+        if (trace->il) trace->il[i] = il;
+        if (trace->ec) trace->ec[i] = ec;
+        if (trace->el) trace->el[i] = el;
+    }
+
+    // Track Peaks
+    if (fabs(vc) > acc->max_vc) acc->max_vc = fabs(vc);
+    if (fabs(il) > acc->max_il) acc->max_il = fabs(il);
+    if (ec > acc->max_ec) acc->max_ec = ec;
+    if (el > acc->max_el) acc->max_el = el;
+    acc->final_energy = ec + el;
+}
+
+/**
+ * @brief Forward Euler integration of the loop, SIM_SUBSTEPS per stored sample.
+ * @param trace Optional sample buffers of length `steps` (NULL to keep only stats).
+ */
+void rlc_simulate_euler(const RlcCircuit *ckt, double t_total, int steps,
+                        RlcTrace *trace, RlcStats *stats) {
+    int type = ckt->type;
+    double vs = ckt->vs, r = ckt->r, l = ckt->l, c = ckt->c;
+    double dt = t_total / steps;
+    double loop_dt = dt / SIM_SUBSTEPS;
+
+    double vc = 0, il = 0;
+    RlcStats acc = { 0, 0, 0, 0, 0 };
+
+    for (int i = 0; i < steps; i++) {
+        record_sample(ckt, i, vc, il, trace, &acc);
+
+        // Euler Integration (Physics)
+        for (int k = 0; k < SIM_SUBSTEPS; k++) {
+            double v_r = il * r;
+            double v_c = (type == RLC_TYPE_RL) ? 0 : vc;
+            double v_l = vs - v_r - v_c;
+
+            if (type == RLC_TYPE_RC) {
+                il = (vs - vc) / r;
+                vc += (il / c) * loop_dt;
+            } else { // RL, LC, RLC
+                double d_il = v_l / l;
+                il += d_il * loop_dt;
+                if (type != RLC_TYPE_RL) vc += (il / c) * loop_dt;
+            }
+        }
+    }
+
+    if (stats) *stats = acc;
+}
+
+// ============================================
+// Adaptive Dormand-Prince RK45
+// ============================================
+// State y = { Vc, I }. For RC the current is algebraic (I = (Vs - Vc) / R),
+// so only Vc is integrated; for RL there is no capacitor so Vc stays 0.
+
+static void rlc_deriv(const RlcCircuit *ckt, const double y[2], double dy[2]) {
+    double vc = y[0], il = y[1];
+    switch (ckt->type) {
+        case RLC_TYPE_RC:
+            dy[0] = (ckt->vs - vc) / (ckt->r * ckt->c);
+            dy[1] = 0;
+            break;
+        case RLC_TYPE_RL:
+            dy[0] = 0;
+            dy[1] = (ckt->vs - il * ckt->r) / ckt->l;
+            break;
+        default: // LC, RLC
+            dy[0] = il / ckt->c;
+            dy[1] = (ckt->vs - il * ckt->r - vc) / ckt->l;
+            break;
+    }
+}
+
+static double rlc_current(const RlcCircuit *ckt, const double y[2]) {
+    return (ckt->type == RLC_TYPE_RC) ? (ckt->vs - y[0]) / ckt->r : y[1];
+}
+
+// Butcher tableau (Dormand & Prince 1980), 5th order solution with FSAL.
+// The circuit is time-invariant so the node weights c_i are not needed.
+static const double DP_A[7][6] = {
+    { 0 },
+    { 1.0/5 },
+    { 3.0/40, 9.0/40 },
+    { 44.0/45, -56.0/15, 32.0/9 },
+    { 19372.0/6561, -25360.0/2187, 64448.0/6561, -212.0/729 },
+    { 9017.0/3168, -355.0/33, 46732.0/5247, 49.0/176, -5103.0/18656 },
+    { 35.0/384, 0, 500.0/1113, 125.0/192, -2187.0/6784, 11.0/84 }
+};
+// Error weights: 5th order minus embedded 4th order
+static const double DP_E[7] = {
+    71.0/57600, 0, -71.0/16695, 71.0/1920, -17253.0/339200, 22.0/525, -1.0/40
+};
+// 4th order dense output: y(t + th*h) = y + h * sum_i k_i * (P[i][0]th + P[i][1]th^2 + P[i][2]th^3 + P[i][3]th^4)
+static const double DP_P[7][4] = {
+    { 1, -8048581381.0/2820520608, 8663915743.0/2820520608, -12715105075.0/11282082432 },
+    { 0, 0, 0, 0 },
+    { 0, 131558114200.0/32700410799, -68118460800.0/10900136933, 87487479700.0/32700410799 },
+    { 0, -1754552775.0/470086768, 14199869525.0/1410260304, -10690763975.0/1880347072 },
+    { 0, 127303824393.0/49829197408, -318862633887.0/49829197408, 701980252875.0/199316789632 },
+    { 0, -282668133.0/205662961, 2019193451.0/616988883, -1453857185.0/822651844 },
+    { 0, 40617522.0/29380423, -110615467.0/29380423, 69997945.0/29380423 }
+};
+
+/**
+ * @brief 1 if rtol/atol are usable by rlc_simulate_rk45(): finite, atol > 0 and
+ *        rtol >= RK45_MIN_RTOL. A zero atol would divide by a zero scale on any component that
+ *        stays at 0.
+ */
+int rlc_rk45_tolerance_ok(double rtol, double atol) {
+    return isfinite(rtol) && isfinite(atol) && atol > 0 && rtol >= RK45_MIN_RTOL;
+}
+
+const char *rlc_rk45_strerror(int rc) {
+    switch (rc) {
+        case RK45_OK: return "ok";
+        case RK45_ERR_ARGS: return "invalid tolerances or duration";
+        case RK45_ERR_COLLAPSED: return "step size collapsed, tolerance too tight";
+        case RK45_ERR_STEPS: return "step limit reached, tolerance too tight or t too long";
+        default: return "?";
+    }
+}
+
+/**
+ * @brief Error-controlled Dormand-Prince integration, resampled onto `steps` evenly spaced
+ *        display points with the method's own 4th order interpolant.
+ * @param rtol,atol Per-component tolerances (the error norm is RMS over Vc and I).
+ * @return RK45_OK, or RK45_ERR_ARGS / RK45_ERR_COLLAPSED / RK45_ERR_STEPS (rlc_rk45_strerror()).
+ *         Stops after RK45_MAX_STEPS steps, so a run is bounded whatever the tolerances.
+ */
+int rlc_simulate_rk45(const RlcCircuit *ckt, double t_total, int steps,
+                      double rtol, double atol,
+                      RlcTrace *trace, RlcStats *stats, RlcSolverInfo *info) {
+    if (!rlc_rk45_tolerance_ok(rtol, atol) || !(t_total > 0) || steps < 1) return RK45_ERR_ARGS;
+    RlcStats acc = { 0, 0, 0, 0, 0 };
+    RlcSolverInfo work = { 0, 0, 0 };
+    double dt = t_total / steps;
+
+    double t = 0, y[2] = { 0, 0 };
+    double k[7][2];
+    double h = dt;          // first guess: one display interval
+    double h_min = t_total * 1e-14;
+    int next = 0;           // next display sample to fill
+    int rc = RK45_OK;
+
+    rlc_deriv(ckt, y, k[0]); work.n_evals++;
+
+    while (next < steps) {
+        if (work.n_accepted + work.n_rejected >= RK45_MAX_STEPS) { rc = RK45_ERR_STEPS; break; }
+        if (t + h > t_total) h = t_total - t;
+
+        // Stages 2..7 (stage 7 is evaluated at the new point and reused as k1 next step)
+        double y_new[2] = { 0, 0 };     // set at stage 7
+        for (int s = 1; s < 7; s++) {
+            double ys[2];
+            for (int j = 0; j < 2; j++) {
+                double sum = 0;
+                for (int m = 0; m < s; m++) sum += DP_A[s][m] * k[m][j];
+                ys[j] = y[j] + h * sum;
+            }
+            if (s == 6) { y_new[0] = ys[0]; y_new[1] = ys[1]; }
+            rlc_deriv(ckt, ys, k[s]); work.n_evals++;
+        }
+
+        double err = 0;
+        for (int j = 0; j < 2; j++) {
+            double e = 0;
+            for (int s = 0; s < 7; s++) e += DP_E[s] * k[s][j];
+            double scale = atol + rtol * fmax(fabs(y[j]), fabs(y_new[j]));
+            e = h * e / scale;
+            err += e * e;
+        }
+        err = sqrt(err / 2);
+        if (!isfinite(err)) { rc = RK45_ERR_COLLAPSED; break; }
+
+        if (err <= 1.0) {
+            // Accepted: emit every display sample that falls inside [t, t + h]
+            double t_new = (h >= t_total - t) ? t_total : t + h;
+            while (next < steps && next * dt <= t_new) {
+                double th = (next * dt - t) / h;
+                double b[7], yi[2];
+                for (int s = 0; s < 7; s++)
+                    b[s] = th * (DP_P[s][0] + th * (DP_P[s][1] + th * (DP_P[s][2] + th * DP_P[s][3])));
+                for (int j = 0; j < 2; j++) {
+                    double sum = 0;
+                    for (int s = 0; s < 7; s++) sum += b[s] * k[s][j];
+                    yi[j] = y[j] + h * sum;
+                }
+                record_sample(ckt, next, yi[0], rlc_current(ckt, yi), trace, &acc);
+                next++;
+            }
+            t = t_new;
+            y[0] = y_new[0]; y[1] = y_new[1];
+            k[0][0] = k[6][0]; k[0][1] = k[6][1]; // FSAL
+            work.n_accepted++;
+        } else {
+            work.n_rejected++;
+        }
+
+        // Standard step-size controller with safety factor and growth limits
+        double factor = (err == 0) ? 5.0 : 0.9 * pow(err, -0.2);
+        if (factor > 5.0) factor = 5.0;
+        if (factor < 0.2) factor = 0.2;
+        h *= factor;
+        if (!isfinite(h) || h < h_min) { rc = RK45_ERR_COLLAPSED; break; }
+    }
+
+    if (stats) *stats = acc;
+    if (info) *info = work;
+    return rc;
+}
+
+// ============================================
+// Closed-form step response
+// ============================================
+// With Vc(0) = 0 and I(0) = 0 every topology has an exact solution, so the
+// class is decided once and each sample costs only a couple of exp/sin calls.
+
+#define RLC_EXACT_BLOCK 256
+
+RlcResponse rlc_classify(const RlcCircuit *ckt) {
+    if (ckt->type == RLC_TYPE_RC || ckt->type == RLC_TYPE_RL) return RLC_RESP_EXPONENTIAL;
+    double alpha = ckt->r / (2.0 * ckt->l);
+    double omega0 = 1.0 / sqrt(ckt->l * ckt->c);
+    if (fabs(alpha - omega0) <= 1e-9 * omega0) return RLC_RESP_CRITICAL;
+    return (alpha > omega0) ? RLC_RESP_OVERDAMPED : RLC_RESP_UNDERDAMPED;
+}
+
+/**
+ * @brief Evaluates Vc, I, Ec and El at the n times in t[]. All arrays must hold n values.
+ *        The response class is resolved up front so each loop is branch-free and vectorisable.
+ */
+void rlc_analytic_eval(const RlcCircuit *ckt, const double *restrict t, int n,
+                       double *restrict vc, double *restrict il,
+                       double *restrict ec, double *restrict el) {
+    const double vs = ckt->vs, r = ckt->r, l = ckt->l, c = ckt->c;
+    const double alpha = r / (2.0 * l);
+    const double omega0_sq = 1.0 / (l * c);
+
+    if (ckt->type == RLC_TYPE_RC) {
+        const double k = -1.0 / (r * c), i0 = vs / r;
+        for (int i = 0; i < n; i++) {
+            double e = exp(k * t[i]);
+            vc[i] = vs * (1.0 - e);
+            il[i] = i0 * e;
+        }
+    } else if (ckt->type == RLC_TYPE_RL) {
+        const double k = -r / l, i_inf = vs / r;
+        for (int i = 0; i < n; i++) {
+            vc[i] = 0;
+            il[i] = i_inf * (1.0 - exp(k * t[i]));
+        }
+    } else {
+        switch (rlc_classify(ckt)) {
+            case RLC_RESP_UNDERDAMPED: {
+                const double wd = sqrt(omega0_sq - alpha * alpha);
+                const double a_wd = alpha / wd, i_amp = vs / (l * wd);
+                for (int i = 0; i < n; i++) {
+                    double e = exp(-alpha * t[i]);
+                    double s = sin(wd * t[i]), co = cos(wd * t[i]);
+                    vc[i] = vs * (1.0 - e * (co + a_wd * s));
+                    il[i] = i_amp * e * s;
+                }
+                break;
+            }
+            case RLC_RESP_CRITICAL: {
+                const double i_amp = vs / l;
+                for (int i = 0; i < n; i++) {
+                    double e = exp(-alpha * t[i]);
+                    vc[i] = vs * (1.0 - e * (1.0 + alpha * t[i]));
+                    il[i] = i_amp * t[i] * e;
+                }
+                break;
+            }
+            default: { // overdamped: two real roots s1 > s2
+                const double root = sqrt(alpha * alpha - omega0_sq);
+                const double s1 = -alpha + root, s2 = -alpha - root;
+                const double inv_d = 1.0 / (s1 - s2), i_amp = vs / l;
+                for (int i = 0; i < n; i++) {
+                    double e1 = exp(s1 * t[i]), e2 = exp(s2 * t[i]);
+                    vc[i] = vs * (1.0 + (s2 * e1 - s1 * e2) * inv_d);
+                    il[i] = i_amp * (e1 - e2) * inv_d;
+                }
+                break;
+            }
+        }
+    }
+
+    // Stored energy (zero for the component a topology doesn't have)
+    const double half_c = (ckt->type == RLC_TYPE_RL) ? 0 : 0.5 * c;
+    const double half_l = (ckt->type == RLC_TYPE_RC) ? 0 : 0.5 * l;
+    for (int i = 0; i < n; i++) {
+        ec[i] = half_c * vc[i] * vc[i];
+        el[i] = half_l * il[i] * il[i];
+    }
+}
+
+// Exact waveform on the same grid the integrators use, evaluated in fixed-size blocks
+void rlc_simulate_analytic(const RlcCircuit *ckt, double t_total, int steps,
+                           RlcTrace *trace, RlcStats *stats) {
+    double t[RLC_EXACT_BLOCK], vc[RLC_EXACT_BLOCK], il[RLC_EXACT_BLOCK];
+    double ec[RLC_EXACT_BLOCK], el[RLC_EXACT_BLOCK];
+    RlcStats acc = { 0, 0, 0, 0, 0 };
+    double dt = t_total / steps;
+
+    for (int base = 0; base < steps; base += RLC_EXACT_BLOCK) {
+        int n = steps - base < RLC_EXACT_BLOCK ? steps - base : RLC_EXACT_BLOCK;
+        for (int j = 0; j < n; j++) t[j] = (base + j) * dt;
+        rlc_analytic_eval(ckt, t, n, vc, il, ec, el);
+        for (int j = 0; j < n; j++) record_sample(ckt, base + j, vc[j], il[j], trace, &acc);
+    }
+
+    if (stats) *stats = acc;
+}
+
+// Largest absolute deviation of a simulated trace (vc/il) from the exact solution
+void rlc_compare_exact(const RlcCircuit *ckt, double t_total, int steps,
+                       const RlcTrace *trace, double *err_vc, double *err_il) {
+    double t[RLC_EXACT_BLOCK], vc[RLC_EXACT_BLOCK], il[RLC_EXACT_BLOCK];
+    double ec[RLC_EXACT_BLOCK], el[RLC_EXACT_BLOCK];
+    double dt = t_total / steps;
+    double max_vc = 0, max_il = 0;
+
+    for (int base = 0; base < steps; base += RLC_EXACT_BLOCK) {
+        int n = steps - base < RLC_EXACT_BLOCK ? steps - base : RLC_EXACT_BLOCK;
+        for (int j = 0; j < n; j++) t[j] = (base + j) * dt;
+        rlc_analytic_eval(ckt, t, n, vc, il, ec, el);
+        for (int j = 0; j < n; j++) {
+            if (trace->vc && fabs(trace->vc[base + j] - vc[j]) > max_vc) max_vc = fabs(trace->vc[base + j] - vc[j]);
+            if (trace->il && fabs(trace->il[base + j] - il[j]) > max_il) max_il = fabs(trace->il[base + j] - il[j]);
+        }
+    }
+    if (err_vc) *err_vc = max_vc;
+    if (err_il) *err_il = max_il;
+}
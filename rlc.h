@@ -0,0 +1,84 @@
+#ifndef RLC_H
+#define RLC_H
+
+#include <float.h>
+
+// ============================================
+// Series RC / RL / LC / RLC step-response engine (no I/O)
+// ============================================
+
+// We simulate at high resolution, then the plotter downsamples for display
+#define SIM_STEPS 1000
+#define SIM_SUBSTEPS 10
+// Upper bound for a user-chosen sample count (4 traces of this many doubles)
+#define SIM_MAX_STEPS 10000000
+
+// Circuit types (matches the menu numbering)
+enum { RLC_TYPE_RC = 1, RLC_TYPE_RL, RLC_TYPE_LC, RLC_TYPE_RLC };
+
+typedef struct {
+    int type;
+    double vs;      // step input voltage
+    double r, l, c; // unused components are ignored
+} RlcCircuit;
+
+// Optional full-resolution output buffers (any pointer may be NULL)
+typedef struct {
+    double *vc, *il, *ec, *el;
+} RlcTrace;
+
+typedef struct {
+    double max_vc, max_il;  // peak |Vc| and |I|
+    double max_ec, max_el;  // peak stored energy in C and L
+    double final_energy;    // Ec + El at the last sample
+} RlcStats;
+
+// Default error tolerances for the adaptive integrator
+#define RK45_DEFAULT_RTOL 1e-6
+#define RK45_DEFAULT_ATOL 1e-9
+// Tightest usable rtol (close to double rounding the error estimate is noise) and the step
+// budget (accepted + rejected) of one run, so no tolerance can keep the integrator going for long
+#define RK45_MIN_RTOL (100 * DBL_EPSILON)
+#define RK45_MAX_STEPS 1000000L
+
+// rlc_simulate_rk45() results
+enum {
+    RK45_OK = 0,
+    RK45_ERR_ARGS = -1,       // tolerances outside rlc_rk45_tolerance_ok(), or t_total <= 0
+    RK45_ERR_COLLAPSED = -2,  // step size fell below t_total * 1e-14 or stopped being finite
+    RK45_ERR_STEPS = -3       // RK45_MAX_STEPS used up before t_total
+};
+
+// Work counters, so integrators can be compared on cost
+typedef struct {
+    long n_evals;     // derivative evaluations
+    long n_accepted;  // accepted steps
+    long n_rejected;  // rejected (retried) steps
+} RlcSolverInfo;
+
+// Closed-form response classes (see rlc_classify)
+typedef enum {
+    RLC_RESP_EXPONENTIAL,   // first order: RC or RL
+    RLC_RESP_OVERDAMPED,    // alpha > omega0
+    RLC_RESP_CRITICAL,      // alpha == omega0 (within 1e-9 relative)
+    RLC_RESP_UNDERDAMPED    // alpha < omega0 (LC is always here)
+} RlcResponse;
+
+void rlc_apply_safety(RlcCircuit *ckt);
+double rlc_auto_time(const RlcCircuit *ckt);
+void rlc_simulate_euler(const RlcCircuit *ckt, double t_total, int steps,
+                        RlcTrace *trace, RlcStats *stats);
+RlcResponse rlc_classify(const RlcCircuit *ckt);
+void rlc_analytic_eval(const RlcCircuit *ckt, const double *t, int n,
+                       double *vc, double *il, double *ec, double *el);
+void rlc_simulate_analytic(const RlcCircuit *ckt, double t_total, int steps,
+                           RlcTrace *trace, RlcStats *stats);
+void rlc_compare_exact(const RlcCircuit *ckt, double t_total, int steps,
+                       const RlcTrace *trace, double *err_vc, double *err_il);
+int rlc_rk45_tolerance_ok(double rtol, double atol);
+const char *rlc_rk45_strerror(int rc);
+int rlc_simulate_rk45(const RlcCircuit *ckt, double t_total, int steps,
+                      double rtol, double atol,
+                      RlcTrace *trace, RlcStats *stats, RlcSolverInfo *info);
+
+#endif
@@ -0,0 +1,229 @@
+#include <math.h>
+#include <string.h>
+#include "rlcstream.h"
+
+// ============================================
+// Exact discrete step
+// ============================================
+// With a constant input the state x = { Vc, I } obeys x' = M x + b, so one step of dt is
+// exactly x[k+1] = Ad x[k] + bd, with Ad = exp(M dt) and bd = integral_0^dt exp(M s) b ds.
+// Both come out of the exponential of the augmented matrix [[M dt, b dt], [0, 0]], so the
+// update is exact for any dt and costs four multiply-adds per step.
+
+static void mat3_mul(const double a[3][3], const double b[3][3], double out[3][3]) {
+    double t[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            t[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+    memcpy(out, t, sizeof(t));
+}
+
+// Scaling and squaring with a Taylor series: scale until ||a|| <= 0.5, sum, square back up
+static void expm3(double a[3][3], double out[3][3]) {
+    double norm = 0;
+    for (int i = 0; i < 3; i++) {
+        double row = fabs(a[i][0]) + fabs(a[i][1]) + fabs(a[i][2]);
+        if (row > norm) norm = row;
+    }
+    int squarings = 0;
+    while (norm > 0.5 && squarings < 1000) { norm *= 0.5; squarings++; }
+    double scale = ldexp(1.0, -squarings);
+    for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++) a[i][j] *= scale;
+
+    double term[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    memcpy(out, term, sizeof(term));
+    for (int k = 1; k <= 18; k++) {
+        mat3_mul(term, a, term);
+        for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++) {
+            term[i][j] /= k;
+            out[i][j] += term[i][j];
+        }
+    }
+    for (int s = 0; s < squarings; s++) mat3_mul(out, out, out);
+}
+
+// Fills Ad (2x2) and bd (2) for one step of dt
+static void discrete_step(const RlcCircuit *ckt, double dt, double ad[2][2], double bd[2]) {
+    double r = ckt->r, l = ckt->l, c = ckt->c, vs = ckt->vs;
+    double m[3][3] = { { 0 } };
+    switch (ckt->type) {
+        case RLC_TYPE_RC:   // only Vc is a state; I = (Vs - Vc) / R
+            m[0][0] = -dt / (r * c); m[0][2] = vs * dt / (r * c);
+            break;
+        case RLC_TYPE_RL:   // only I is a state; Vc stays 0
+            m[1][1] = -dt * r / l; m[1][2] = vs * dt / l;
+            break;
+        default:            // LC, RLC
+            m[0][1] = dt / c;
+            m[1][0] = -dt / l; m[1][1] = -dt * r / l; m[1][2] = vs * dt / l;
+            break;
+    }
+    double e[3][3];
+    expm3(m, e);
+    ad[0][0] = e[0][0]; ad[0][1] = e[0][1]; bd[0] = e[0][2];
+    ad[1][0] = e[1][0]; ad[1][1] = e[1][1]; bd[1] = e[1][2];
+}
+
+// ============================================
+// Online metrics
+// ============================================
+// The response y (Vc, or I for RL) is tracked as u = y / final, e = u - 1.
+
+typedef struct {
+    double prev_u, prev_t;
+    double t_lo, t_hi;           // rise threshold crossings (-1 until seen)
+    int in_band;
+    double t_enter;              // last entry into the settling band
+    int e_sign;                  // sign of e at the previous nonzero sample
+    long long e_cross;
+    double t_first, t_last;      // first and last crossing of the final value
+    double half_peak;            // largest |e| since the last crossing
+    long long n_ext;             // completed half cycles
+    double a_first, a_last;      // their first and last amplitudes
+    int i_sign;
+} Tracker;
+
+// Time at which the response passes level between the previous and current sample
+static double cross_time(const Tracker *tr, double u, double t, double level) {
+    return tr->prev_t + (level - tr->prev_u) / (u - tr->prev_u) * (t - tr->prev_t);
+}
+
+static inline void track(Tracker *tr, RlcMetrics *m, double u, double il, double t) {
+    double e = u - 1.0;
+
+    if (tr->t_lo < 0 && u >= RLC_RISE_LO) tr->t_lo = cross_time(tr, u, t, RLC_RISE_LO);
+    if (tr->t_hi < 0 && u >= RLC_RISE_HI) tr->t_hi = cross_time(tr, u, t, RLC_RISE_HI);
+
+    if (fabs(e) > RLC_SETTLE_BAND) tr->in_band = 0;
+    else if (!tr->in_band) { tr->in_band = 1; tr->t_enter = t; }
+
+    if (u > m->peak) { m->peak = u; m->t_peak = t; }
+
+    if (fabs(e) > tr->half_peak) tr->half_peak = fabs(e);
+    int es = (e > 0) - (e < 0);
+    if (es && es != tr->e_sign) {
+        if (tr->e_sign) {
+            double tc = cross_time(tr, u, t, 1.0);
+            if (tr->e_cross++ == 0) tr->t_first = tc;
+            else {
+                // The half cycle since the previous crossing is complete
+                if (tr->n_ext++ == 0) tr->a_first = tr->half_peak;
+                tr->a_last = tr->half_peak;
+            }
+            tr->t_last = tc;
+            tr->half_peak = fabs(e);
+        }
+        tr->e_sign = es;
+    }
+
+    int is = (il > 0) - (il < 0);
+    if (is && is != tr->i_sign) {
+        if (tr->i_sign) m->current_crossings++;
+        tr->i_sign = is;
+    }
+
+    tr->prev_u = u; tr->prev_t = t;
+}
+
+static void finish_metrics(const Tracker *tr, RlcMetrics *m) {
+    m->overshoot_pct = m->peak > 1.0 ? (m->peak - 1.0) * 100.0 : 0;
+    m->peak *= m->final_value;   // tracked as a fraction of the final value
+    m->t_rise = (tr->t_lo >= 0 && tr->t_hi >= 0) ? tr->t_hi - tr->t_lo : -1;
+    m->t_settle = tr->in_band ? tr->t_enter : -1;
+    m->freq_est = (tr->e_cross >= 2) ? (tr->e_cross - 1) / (2.0 * (tr->t_last - tr->t_first)) : 0;
+    m->zeta_est = -1;
+    if (tr->n_ext >= 2 && tr->a_last > 0 && tr->a_first >= tr->a_last) {
+        // Successive half-cycle extrema shrink by exp(-delta / 2)
+        double delta = 2.0 * log(tr->a_first / tr->a_last) / (double)(tr->n_ext - 1);
+        m->zeta_est = delta / sqrt(4.0 * M_PI * M_PI + delta * delta);
+    }
+}
+
+// ============================================
+// Envelope buckets
+// ============================================
+
+static inline void env_put(double *buf, int b, int first, double v) {
+    if (!buf) return;
+    double *mm = buf + 2 * b;
+    if (first) { mm[0] = mm[1] = v; return; }
+    if (v < mm[0]) mm[0] = v;
+    if (v > mm[1]) mm[1] = v;
+}
+
+// ============================================
+// Streaming engine
+// ============================================
+
+/**
+ * @brief Runs steps + 1 samples (t = 0 .. t_total) of the step response in O(1) memory.
+ *
+ * Peaks, rise time, settling time, overshoot, current zero crossings, damped frequency and a
+ * damping estimate are updated in the loop. If env is given, its rows are clamped to
+ * [1, min(RLC_STREAM_MAX_ROWS, steps + 1)] and each row receives the min/max of its equal
+ * slice of the run, laid out as { min, max } pairs that the strip chart can plot directly.
+ * @return 0 on success, -1 on bad parameters.
+ */
+int rlc_stream(const RlcCircuit *ckt, double t_total, long long steps,
+               RlcEnvelope *env, RlcMetrics *m) {
+    if (steps < 1 || steps > RLC_STREAM_MAX_STEPS || !(t_total > 0)) return -1;
+    if (ckt->type < RLC_TYPE_RC || ckt->type > RLC_TYPE_RLC) return -1;
+
+    int type = ckt->type;
+    double dt = t_total / steps;
+    double ad[2][2], bd[2];
+    discrete_step(ckt, dt, ad, bd);
+
+    long long n = steps + 1;
+    int rows = 0;
+    if (env) {
+        rows = env->rows < 1 ? 1 : env->rows > RLC_STREAM_MAX_ROWS ? RLC_STREAM_MAX_ROWS : env->rows;
+        if (rows > n) rows = (int)n;
+        env->rows = rows;
+    }
+    int b = 0, bucket_first = 1;
+    long long next = env ? n / rows : n + 1;   // first sample of bucket b + 1
+
+    memset(m, 0, sizeof(*m));
+    m->final_value = (type == RLC_TYPE_RL) ? ckt->vs / ckt->r : ckt->vs;
+    int normalised = m->final_value != 0;
+    double inv_final = normalised ? 1.0 / m->final_value : 0;
+    Tracker tr = { 0, 0, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    double half_c = 0.5 * ckt->c, half_l = 0.5 * ckt->l;
+    double x0 = 0, x1 = 0;   // Vc, I
+    RlcStats acc = { 0, 0, 0, 0, 0 };
+
+    for (long long k = 0; k < n; k++) {
+        double vc = x0, il = (type == RLC_TYPE_RC) ? (ckt->vs - x0) / ckt->r : x1;
+        double ec = (type == RLC_TYPE_RL) ? 0 : half_c * vc * vc;
+        double el = (type == RLC_TYPE_RC) ? 0 : half_l * il * il;
+
+        if (fabs(vc) > acc.max_vc) acc.max_vc = fabs(vc);
+        if (fabs(il) > acc.max_il) acc.max_il = fabs(il);
+        if (ec > acc.max_ec) acc.max_ec = ec;
+        if (el > acc.max_el) acc.max_el = el;
+
+        if (normalised) track(&tr, m, ((type == RLC_TYPE_RL) ? il : vc) * inv_final, il, k * dt);
+
+        if (env) {
+            if (k == next) {
+                b++; bucket_first = 1;
+                next = (long long)(b + 1) * n / rows;
+            }
+            env_put(env->vc, b, bucket_first, vc); env_put(env->il, b, bucket_first, il);
+            env_put(env->ec, b, bucket_first, ec); env_put(env->el, b, bucket_first, el);
+            bucket_first = 0;
+        }
+
+        if (k == n - 1) { acc.final_energy = ec + el; break; }
+        double n0 = ad[0][0] * x0 + ad[0][1] * x1 + bd[0];
+        double n1 = ad[1][0] * x0 + ad[1][1] * x1 + bd[1];
+        x0 = n0; x1 = n1;
+    }
+
+    if (normalised) finish_metrics(&tr, m);
+    else { m->t_rise = m->t_settle = m->zeta_est = -1; }
+    m->stats = acc;
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef RLCSTREAM_H
+#define RLCSTREAM_H
+
+// ============================================
+// Constant-memory streaming RLC transient: no per-sample storage, waveform
+// metrics computed online, display kept as a fixed number of min/max buckets
+// ============================================
+
+#include "rlc.h"
+
+#define RLC_STREAM_MAX_ROWS 500
+#define RLC_STREAM_MAX_STEPS 1000000000000LL
+#define RLC_STREAM_DEFAULT_STEPS 10000000LL
+
+// Settling band and rise-time thresholds, as fractions of the final value
+#define RLC_SETTLE_BAND 0.02
+#define RLC_RISE_LO 0.1
+#define RLC_RISE_HI 0.9
+
+typedef struct {
+    RlcStats stats;         // peak |Vc|, |I|, Ec, El and final energy, as in the buffered engines
+    double final_value;     // steady state of the response (Vc, or I for RL)
+    double peak, t_peak;    // largest response value and when it occurred
+    double overshoot_pct;   // (peak - final) / final, 0 if it never overshoots
+    double t_rise;          // 10 % -> 90 % of the final value, -1 if not reached
+    double t_settle;        // last entry into the 2 % band, -1 if not settled at the end
+    long long current_crossings;  // sign changes of the loop current
+    double freq_est;        // damped frequency (Hz) from crossings of the final value, 0 if none
+    double zeta_est;        // damping ratio from the logarithmic decrement, -1 if unmeasurable
+} RlcMetrics;
+
+// Display buckets: rows entries of { min, max } per trace (2 * rows doubles each, any may be NULL)
+typedef struct {
+    int rows;
+    double *vc, *il, *ec, *el;
+} RlcEnvelope;
+
+int rlc_stream(const RlcCircuit *ckt, double t_total, long long steps,
+               RlcEnvelope *env, RlcMetrics *m);
+
+#endif
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "rnet.h"
+#include "circuits.h"
+
+// Parts are drawn from target/100 .. target*100
+#define RNET_SPAN_DECADES 2
+// Slack on the symmetry cut of the 2+2 search; far above any best four-part error
+#define RNET_SYM_MARGIN 1.1
+
+// ============================================
+// Value tables
+// ============================================
+
+// One two-part network: grid[a] op grid[b] with a <= b
+typedef struct {
+    double v;
+    unsigned short a, b;
+    char op;
+} RnetPair;
+
+typedef struct {
+    double target;
+    const double *grid;   // single parts, ascending
+    int n;
+    const double *pv;     // two-part values, ascending
+    const RnetPair *pm;   // matching pair descriptions
+    long np;
+} RnetCtx;
+
+static int pair_cmp(const void *x, const void *y) {
+    double a = ((const RnetPair *)x)->v, b = ((const RnetPair *)y)->v;
+    return (a > b) - (a < b);
+}
+
+// Parts within RNET_SPAN_DECADES of target, ascending. Returns the count (0 if the span is not
+// made of finite normal doubles).
+static int build_grid(ESeries series, double target, double *grid) {
+    const double *base;
+    int n_base = eseries_values(series, &base), n = 0;
+    double lo = target * pow(10, -RNET_SPAN_DECADES), hi = target * pow(10, RNET_SPAN_DECADES);
+    if (!isnormal(lo) || !isnormal(hi)) return 0;
+    int d0 = (int)floor(log10(lo)), d1 = (int)floor(log10(hi));
+    for (int d = d0; d <= d1; d++) {
+        double p10 = pow(10, abs(d));
+        for (int i = 0; i < n_base; i++) {
+            double v = d >= 0 ? base[i] * p10 : base[i] / p10;
+            if (v >= lo && v <= hi) grid[n++] = v;
+        }
+    }
+    return n;
+}
+
+// First index with a[i] >= x
+static long lower_bound(const double *a, long n, double x) {
+    long lo = 0, hi = n;
+    while (lo < hi) {
+        long mid = (lo + hi) / 2;
+        if (a[mid] < x) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Distance used to pick the remainder: series parts add as resistance, parallel parts as conductance
+static inline double rem_score(double w, double rem, int cond) {
+    return cond ? fabs(1.0 / w - 1.0 / rem) : fabs(w - rem);
+}
+
+// Index of the entry of a[] closest to rem (exact: the score is monotone either side of rem)
+static long nearest(const double *a, long n, double rem, int cond) {
+    long j = lower_bound(a, n, rem);
+    if (j == n) return n - 1;
+    if (j > 0 && rem_score(a[j - 1], rem, cond) <= rem_score(a[j], rem, cond)) return j - 1;
+    return j;
+}
+
+static inline double combine_value(double x, double y, char op) {
+    return op == 'S' ? x + y : x * y / (x + y);
+}
+
+// ============================================
+// Network records
+// ============================================
+
+static void net_leaf(RnetResult *r, double v) {
+    r->value = v; r->n_parts = 1;
+    r->leaf[0] = v;
+    strcpy(r->code, "R");
+}
+
+static void net_pair(const RnetCtx *ctx, long j, RnetResult *r) {
+    const RnetPair *p = &ctx->pm[j];
+    r->value = p->v; r->n_parts = 2;
+    r->leaf[0] = ctx->grid[p->a]; r->leaf[1] = ctx->grid[p->b];
+    r->code[0] = 'R'; r->code[1] = 'R'; r->code[2] = p->op; r->code[3] = '\0';
+}
+
+static void net_join(const RnetResult *x, const RnetResult *y, char op, RnetResult *out) {
+    RnetResult r;
+    r.value = combine_value(x->value, y->value, op);
+    r.n_parts = x->n_parts + y->n_parts;
+    memcpy(r.leaf, x->leaf, x->n_parts * sizeof(double));
+    memcpy(r.leaf + x->n_parts, y->leaf, y->n_parts * sizeof(double));
+    size_t lx = strlen(x->code), ly = strlen(y->code);
+    memcpy(r.code, x->code, lx);
+    memcpy(r.code + lx, y->code, ly);
+    r.code[lx + ly] = op; r.code[lx + ly + 1] = '\0';
+    *out = r;
+}
+
+static void net_finish(RnetResult *r, double target) {
+    r->error_pct = fabs(r->value - target) / target * 100.0;
+}
+
+// ============================================
+// Best k-part network near a value
+// ============================================
+
+// Best three-part network x op (two-part) for rem, scored with rem_score(cond)
+static double best3(const RnetCtx *ctx, double rem, int cond, RnetResult *out) {
+    double best = INFINITY;
+    int bi = -1; long bj = 0; char bop = 'S';
+    for (int i = 0; i < ctx->n; i++) {
+        double x = ctx->grid[i];
+        if (x < rem) {        // series: x + Y = rem
+            long j = nearest(ctx->pv, ctx->np, rem - x, 0);
+            double s = rem_score(x + ctx->pv[j], rem, cond);
+            if (s < best) { best = s; bi = i; bj = j; bop = 'S'; }
+        } else if (x > rem) { // parallel: 1/x + 1/Y = 1/rem
+            long j = nearest(ctx->pv, ctx->np, rem * x / (x - rem), 1);
+            double s = rem_score(combine_value(x, ctx->pv[j], 'P'), rem, cond);
+            if (s < best) { best = s; bi = i; bj = j; bop = 'P'; }
+        }
+    }
+    if (bi < 0) return INFINITY;
+    if (out) {
+        RnetResult a, b;
+        net_leaf(&a, ctx->grid[bi]);
+        net_pair(ctx, bj, &b);
+        net_join(&a, &b, bop, out);
+    }
+    return best;
+}
+
+typedef struct {
+    const RnetCtx *ctx;
+    int parts;                 // 3 or 4
+    int lo1, hi1;              // slice of the single-part grid
+    long lo2, hi2;             // slice of the two-part table (4 parts only)
+    RnetResult best;
+    double err;                // |value - target|, INFINITY if nothing found
+} RnetWorker;
+
+static void worker_offer(RnetWorker *w, const RnetResult *x, const RnetResult *y, char op) {
+    double v = combine_value(x->value, y->value, op), e = fabs(v - w->ctx->target);
+    if (e < w->err) { w->err = e; net_join(x, y, op, &w->best); }
+}
+
+static void *rnet_worker(void *arg) {
+    RnetWorker *w = arg;
+    const RnetCtx *ctx = w->ctx;
+    const double t = ctx->target;
+    RnetResult a, b;
+    w->err = INFINITY;
+
+    // One part + (parts - 1) parts
+    for (int i = w->lo1; i < w->hi1 && w->err > 0; i++) {
+        double x = ctx->grid[i];
+        if (x == t) continue;
+        int cond = x > t;
+        double rem = cond ? t * x / (x - t) : t - x;
+        char op = cond ? 'P' : 'S';
+        net_leaf(&a, x);
+        if (w->parts == 3) {
+            long j = nearest(ctx->pv, ctx->np, rem, cond);
+            net_pair(ctx, j, &b);
+        } else if (best3(ctx, rem, cond, &b) == INFINITY) {
+            continue;
+        }
+        worker_offer(w, &a, &b, op);
+    }
+
+    // Two parts + two parts. By symmetry the smaller half of a series pair is about <= t/2
+    // and the smaller half of a parallel pair about <= 2t, so only those are scanned
+    // (with RNET_SYM_MARGIN for networks that miss the target).
+    for (long i = w->lo2; i < w->hi2 && w->err > 0; i++) {
+        double x = ctx->pv[i];
+        if (x <= t / 2 * RNET_SYM_MARGIN) {
+            long j = nearest(ctx->pv, ctx->np, t - x, 0);
+            net_pair(ctx, i, &a); net_pair(ctx, j, &b);
+            worker_offer(w, &a, &b, 'S');
+        } else if (x > t && x <= 2 * t * RNET_SYM_MARGIN) {
+            long j = nearest(ctx->pv, ctx->np, t * x / (x - t), 1);
+            net_pair(ctx, i, &a); net_pair(ctx, j, &b);
+            worker_offer(w, &a, &b, 'P');
+        }
+    }
+    return NULL;
+}
+
+// Splits the outer loops over n_threads and keeps the overall best
+static void run_parallel(const RnetCtx *ctx, int parts, int n_threads, RnetResult *out) {
+    long n2 = (parts == 4) ? ctx->np : 0;
+    RnetWorker *workers = calloc(n_threads, sizeof(RnetWorker));
+    pthread_t *threads = malloc(n_threads * sizeof(pthread_t));
+    if (!workers || !threads) { n_threads = 1; free(workers); free(threads); workers = NULL; threads = NULL; }
+    RnetWorker single;
+    RnetWorker *ws = workers ? workers : &single;
+
+    for (int i = 0; i < n_threads; i++) {
+        ws[i].ctx = ctx; ws[i].parts = parts;
+        ws[i].lo1 = (int)((long)ctx->n * i / n_threads);
+        ws[i].hi1 = (int)((long)ctx->n * (i + 1) / n_threads);
+        ws[i].lo2 = n2 * i / n_threads;
+        ws[i].hi2 = n2 * (i + 1) / n_threads;
+    }
+    // Worker 0 runs on the calling thread
+    int started = 1;
+    for (int i = 1; i < n_threads; i++, started++) {
+        if (pthread_create(&threads[i], NULL, rnet_worker, &ws[i]) != 0) break;
+    }
+    for (int i = started; i < n_threads; i++) rnet_worker(&ws[i]); // could not spawn: run inline
+    rnet_worker(&ws[0]);
+    for (int i = 1; i < started; i++) pthread_join(threads[i], NULL);
+
+    int best = 0;
+    for (int i = 1; i < n_threads; i++) if (ws[i].err < ws[best].err) best = i;
+    *out = ws[best].best;
+    if (ws[best].err == INFINITY) out->n_parts = 0;
+    free(workers); free(threads);
+}
+
+/**
+ * @brief Finds the closest network for each part count 1 .. spec->max_parts.
+ *
+ * Two-part values are precomputed into one sorted table, so three parts are a single part
+ * plus a binary search of that table and four parts are meet-in-the-middle: one part
+ * against the best three-part remainder, and two-part against two-part. Series remainders
+ * are matched in resistance and parallel remainders in conductance, where parts add linearly.
+ * @param best Array of spec->max_parts results; best[k-1] is the best k-part network
+ *             (n_parts == 0 if none exists).
+ * @return Number of part counts searched (stops early once one is within tol_pct),
+ *         or -1 on bad parameters (target outside RNET_MIN_TARGET .. RNET_MAX_TARGET) or
+ *         allocation failure.
+ */
+int rnet_synthesize(const RnetSpec *spec, RnetResult *best) {
+    double t = spec->target;
+    if (!(t >= RNET_MIN_TARGET && t <= RNET_MAX_TARGET)) return -1;
+    if (spec->max_parts < 1 || spec->max_parts > RNET_MAX_PARTS) return -1;
+    if (spec->series < 0 || spec->series >= ESERIES_COUNT) return -1;
+
+    int n_threads = spec->n_threads;
+    if (n_threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = cores > 0 ? (int)cores : 1;
+    }
+
+    double grid[ESERIES_MAX_SIZE * (2 * RNET_SPAN_DECADES + 2)];
+    RnetCtx ctx = { t, grid, build_grid(spec->series, t, grid), NULL, NULL, 0 };
+    if (ctx.n == 0) return -1;
+    RnetPair *pairs = NULL;
+    double *pv = NULL;
+
+    int k;
+    for (k = 1; k <= spec->max_parts; k++) {
+        RnetResult *r = &best[k - 1];
+        if (k == 1) {
+            net_leaf(r, grid[nearest(grid, ctx.n, t, 0)]);
+        } else {
+            if (!pairs) {
+                long np = (long)ctx.n * (ctx.n + 1);
+                pairs = malloc(np * sizeof(RnetPair));
+                pv = malloc(np * sizeof(double));
+                if (!pairs || !pv) { free(pairs); free(pv); return -1; }
+                long m = 0;
+                for (int a = 0; a < ctx.n; a++) {
+                    for (int b = a; b < ctx.n; b++) {
+                        RnetPair s = { grid[a] + grid[b], a, b, 'S' };
+                        RnetPair p = { combine_value(grid[a], grid[b], 'P'), a, b, 'P' };
+                        pairs[m++] = s; pairs[m++] = p;
+                    }
+                }
+                qsort(pairs, np, sizeof(RnetPair), pair_cmp);
+                for (long i = 0; i < np; i++) pv[i] = pairs[i].v;
+                ctx.pv = pv; ctx.pm = pairs; ctx.np = np;
+            }
+            if (k == 2) net_pair(&ctx, nearest(pv, ctx.np, t, 0), r);
+            else run_parallel(&ctx, k, n_threads, r);
+        }
+        if (r->n_parts) net_finish(r, t);
+        if (spec->tol_pct > 0 && r->n_parts && r->error_pct <= spec->tol_pct) { k++; break; }
+    }
+    free(pairs); free(pv);
+    return k - 1;
+}
+
+// Fewest parts within tol_pct, otherwise the most accurate. Returns -1 if best[] is empty.
+int rnet_pick(const RnetResult *best, int n, double tol_pct) {
+    int pick = -1;
+    for (int k = 0; k < n; k++) {
+        if (!best[k].n_parts) continue;
+        if (tol_pct > 0 && best[k].error_pct <= tol_pct) return k;
+        if (pick < 0 || best[k].error_pct < best[pick].error_pct) pick = k;
+    }
+    return pick;
+}
+
+// ============================================
+// Formatting
+// ============================================
+
+// Infix text, e.g. "4.70k + (10.00k || 22.00k)". Parentheses only where the operator changes.
+void rnet_format(const RnetResult *net, char *buf, int len) {
+    char text[RNET_MAX_PARTS][RNET_EXPR_LEN * 2];
+    char kind[RNET_MAX_PARTS];
+    int sp = 0, leaf = 0;
+
+    for (const char *c = net->code; *c && sp <= RNET_MAX_PARTS; c++) {
+        if (*c == 'R') {
+            if (sp == RNET_MAX_PARTS || leaf == net->n_parts) break;
+            format_eng(net->leaf[leaf++], text[sp]);
+            kind[sp++] = 'R';
+        } else if (sp >= 2) {
+            char joined[RNET_EXPR_LEN * 2];
+            const char *l = text[sp - 2], *r = text[sp - 1];
+            int lp = kind[sp - 2] != 'R' && kind[sp - 2] != *c;
+            int rp = kind[sp - 1] != 'R' && kind[sp - 1] != *c;
+            int n = snprintf(joined, sizeof(joined), "%s%s%s %s %s%s%s",
+                             lp ? "(" : "", l, lp ? ")" : "", *c == 'S' ? "+" : "||",
+                             rp ? "(" : "", r, rp ? ")" : "");
+            // Cannot happen for RNET_MAX_PARTS leaves, but a cut-off network must look cut off
+            if (n >= (int)sizeof(joined)) memcpy(joined + sizeof(joined) - 4, "...", 4);
+            sp--;
+            memcpy(text[sp - 1], joined, sizeof(joined));
+            kind[sp - 1] = *c;
+        }
+    }
+    snprintf(buf, len, "%s", sp ? text[0] : "");
+}
@@ -0,0 +1,40 @@
+#ifndef RNET_H
+#define RNET_H
+
+// ============================================
+// Series/parallel resistor network synthesis from standard parts
+// ============================================
+
+#include "eseries.h"
+
+// Networks of up to this many parts are searched
+#define RNET_MAX_PARTS 4
+// Longest formatted network, e.g. "(4.7k + 10k) || (22k + 1.5k)"
+#define RNET_EXPR_LEN 64
+// Accepted targets: every network value, and the product of two in a parallel pair, stays a
+// normal double
+#define RNET_MIN_TARGET 1e-150
+#define RNET_MAX_TARGET 1e150
+
+typedef struct {
+    double target;
+    ESeries series;
+    int max_parts;     // 1 .. RNET_MAX_PARTS
+    double tol_pct;    // stop at the fewest parts within this error (0 = always search max_parts)
+    int n_threads;     // 0 = one per core
+} RnetSpec;
+
+// A network in postfix form: 'R' pushes the next leaf, 'S'/'P' combine the top two
+typedef struct {
+    double value;
+    double error_pct;
+    int n_parts;
+    double leaf[RNET_MAX_PARTS];
+    char code[2 * RNET_MAX_PARTS];  // NUL-terminated postfix string, e.g. "RRSRP"
+} RnetResult;
+
+int rnet_synthesize(const RnetSpec *spec, RnetResult *best);
+int rnet_pick(const RnetResult *best, int n, double tol_pct);
+void rnet_format(const RnetResult *net, char *buf, int len);
+
+#endif
@@ -0,0 +1,488 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include "server.h"
+#include "batch.h"
+
+#define MAX_EVENTS 64
+
+// Clients must not reach the server's files through in=, out=, wave= ..., and a job keeps to
+// its worker thread (each worker starting a pool of its own would oversubscribe the CPUs)
+#define SERVER_BATCH_FLAGS (BATCH_NO_FILES | BATCH_ONE_THREAD)
+
+typedef struct Client {
+    struct Client *prev, *next;     // open list, or the closed list once fd is -1
+    int fd;                         // -1 once closed (the struct lives on while jobs run)
+    atomic_int gone;                // set on close: workers skip its queued jobs
+    int line_no;                    // lines received so far
+    int jobs;                       // heavy jobs in flight
+    int eof;                        // peer has finished sending
+    int skipping;                   // discarding the rest of an over-long line
+    unsigned events;                // current epoll interest
+    size_t in_len;
+    char in[SERVER_IN_BUF];
+    char *out;                      // queued responses: out[out_off .. out_len)
+    size_t out_off, out_len, out_cap;
+    Session session;
+} Client;
+
+typedef struct Job {
+    struct Job *next;
+    Client *c;
+    int line_no, rc;
+    char line[BATCH_LINE_LEN];
+    char reply[BATCH_REPLY_LEN];
+} Job;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    Job *head, *tail;       // waiting, oldest first
+    Job *done;              // finished, newest first
+    int done_fd;            // eventfd: bumped for every finished job
+    int stop;
+} Pool;
+
+typedef struct {
+    int ep, listen_fd, sig_fd;
+    int listen_paused;      // out of descriptors: accept again once a client closes
+    Client *clients;        // open
+    Client *closed;         // freed by reap_clients() once their jobs are back
+    Pool pool;
+    long long requests, n_clients;
+} Server;
+
+// epoll tags for the descriptors that are not clients
+static char TAG_LISTEN, TAG_DONE, TAG_SIGNAL;
+
+// ============================================
+// Worker pool
+// ============================================
+
+static void *worker(void *arg) {
+    Pool *p = arg;
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (!p->head && !p->stop) pthread_cond_wait(&p->ready, &p->lock);
+        if (p->stop) break;
+        Job *j = p->head;
+        p->head = j->next;
+        if (!p->head) p->tail = NULL;
+        pthread_mutex_unlock(&p->lock);
+
+        // Heavy tools never touch the session; the event loop records the reply
+        if (atomic_load_explicit(&j->c->gone, memory_order_relaxed)) j->rc = BATCH_SKIP;
+        else j->rc = batch_exec(NULL, j->line, j->reply, sizeof(j->reply), SERVER_BATCH_FLAGS);
+
+        pthread_mutex_lock(&p->lock);
+        j->next = p->done;
+        p->done = j;
+        uint64_t one = 1;
+        if (write(p->done_fd, &one, sizeof(one)) < 0) { /* counter saturated: a wakeup is pending anyway */ }
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+static void pool_submit(Pool *p, Job *j) {
+    j->next = NULL;
+    pthread_mutex_lock(&p->lock);
+    if (p->tail) p->tail->next = j;
+    else p->head = j;
+    p->tail = j;
+    pthread_cond_signal(&p->ready);
+    pthread_mutex_unlock(&p->lock);
+}
+
+// Takes every finished job, oldest first
+static Job *pool_take_done(Pool *p) {
+    uint64_t n;
+    if (read(p->done_fd, &n, sizeof(n)) < 0) { /* EAGAIN: already drained */ }
+    pthread_mutex_lock(&p->lock);
+    Job *j = p->done;
+    p->done = NULL;
+    pthread_mutex_unlock(&p->lock);
+    Job *rev = NULL;
+    while (j) { Job *next = j->next; j->next = rev; rev = j; j = next; }
+    return rev;
+}
+
+// ============================================
+// Clients
+// ============================================
+
+static size_t out_pending(const Client *c) {
+    return c->out_len - c->out_off;
+}
+
+static int can_read(const Client *c) {
+    return !c->eof && c->jobs < SERVER_MAX_JOBS && out_pending(c) < SERVER_OUT_HIGH &&
+           c->in_len < SERVER_IN_BUF - 1;
+}
+
+static void client_update(Server *s, Client *c) {
+    unsigned want = (can_read(c) ? EPOLLIN : 0) | (out_pending(c) ? EPOLLOUT : 0);
+    if (want == c->events) return;
+    struct epoll_event ev = { .events = want, .data.ptr = c };
+    epoll_ctl(s->ep, EPOLL_CTL_MOD, c->fd, &ev);
+    c->events = want;
+}
+
+static void client_free(Client *c) {
+    session_free(&c->session);
+    free(c->out);
+    free(c);
+}
+
+static void reap_clients(Server *s) {
+    Client **pp = &s->closed;
+    while (*pp) {
+        Client *c = *pp;
+        if (c->jobs == 0) { *pp = c->next; client_free(c); }
+        else pp = &c->next;
+    }
+}
+
+// Closes the socket now. The Client is only freed by reap_clients(): events already fetched
+// in this epoll_wait() round may still point at it, and so may jobs in the pool.
+static void client_close(Server *s, Client *c) {
+    epoll_ctl(s->ep, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    atomic_store_explicit(&c->gone, 1, memory_order_relaxed);
+    if (c->prev) c->prev->next = c->next;
+    else s->clients = c->next;
+    if (c->next) c->next->prev = c->prev;
+    c->prev = NULL;
+    c->next = s->closed;
+    s->closed = c;
+
+    if (s->listen_paused) {
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &TAG_LISTEN };
+        epoll_ctl(s->ep, EPOLL_CTL_MOD, s->listen_fd, &ev);
+        s->listen_paused = 0;
+    }
+}
+
+// Appends "line=<n> <reply>\n" to the client's output. Returns -1 if memory ran out.
+static int queue_reply(Client *c, int line_no, const char *reply) {
+    char buf[BATCH_REPLY_LEN + 24];
+    int n = snprintf(buf, sizeof(buf), "line=%d %s\n", line_no, reply);
+    if (n < 0) return -1;
+    if ((size_t)n >= sizeof(buf)) { n = (int)sizeof(buf) - 1; buf[n - 1] = '\n'; }
+
+    if (c->out_off > 0 && c->out_off == c->out_len) c->out_off = c->out_len = 0;
+    if (c->out_len + (size_t)n > c->out_cap) {
+        // Reuse the already-sent front before growing
+        if (c->out_off > 0) {
+            memmove(c->out, c->out + c->out_off, out_pending(c));
+            c->out_len -= c->out_off;
+            c->out_off = 0;
+        }
+        if (c->out_len + (size_t)n > c->out_cap) {
+            size_t cap = c->out_cap ? c->out_cap * 2 : 4096;
+            while (cap < c->out_len + (size_t)n) cap *= 2;
+            char *p = realloc(c->out, cap);
+            if (!p) return -1;
+            c->out = p;
+            c->out_cap = cap;
+        }
+    }
+    memcpy(c->out + c->out_len, buf, (size_t)n);
+    c->out_len += (size_t)n;
+    return 0;
+}
+
+// Records a successful reply in the client's session. The reply still goes out if that fails;
+// the operator is told, since a later "history" or "export" from the client will lack it.
+static void record_reply(Client *c, int line_no, const char *line, const char *reply) {
+    if (batch_record(&c->session, line, reply) != 0)
+        fprintf(stderr, "[Server] Client line %d could not be recorded in its history (out of memory).\n",
+                line_no);
+}
+
+// Sends what the socket takes without blocking. Returns -1 if the peer has gone.
+static int client_flush(Client *c) {
+    while (out_pending(c)) {
+        ssize_t n = send(c->fd, c->out + c->out_off, out_pending(c), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) { c->out_off += (size_t)n; continue; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        return -1;
+    }
+    c->out_off = c->out_len = 0;
+    return 0;
+}
+
+// One complete request line (newline removed)
+static int handle_line(Server *s, Client *c, const char *line) {
+    int line_no = ++c->line_no;
+    if (batch_heavy(line)) {
+        Job *j = malloc(sizeof(Job));
+        if (!j) return queue_reply(c, line_no, "error=\"out of memory\"");
+        j->c = c;
+        j->line_no = line_no;
+        snprintf(j->line, sizeof(j->line), "%s", line);
+        c->jobs++;
+        pool_submit(&s->pool, j);
+        return 0;
+    }
+    char reply[BATCH_REPLY_LEN];
+    int rc = batch_exec(&c->session, line, reply, sizeof(reply), SERVER_BATCH_FLAGS);
+    if (rc == BATCH_SKIP) return 0;
+    s->requests++;
+    if (rc == BATCH_OK) record_reply(c, line_no, line, reply);
+    return queue_reply(c, line_no, reply);
+}
+
+// Runs the complete lines in the input buffer while the client is under its limits
+static int process_input(Server *s, Client *c) {
+    size_t pos = 0;
+    while (pos < c->in_len && c->jobs < SERVER_MAX_JOBS && out_pending(c) < SERVER_OUT_HIGH) {
+        char *start = c->in + pos;
+        char *nl = memchr(start, '\n', c->in_len - pos);
+        if (c->skipping) {
+            if (!nl) { pos = c->in_len; break; }
+            c->skipping = 0;
+            pos = (size_t)(nl - c->in) + 1;
+            continue;
+        }
+        size_t len = nl ? (size_t)(nl - start) : c->in_len - pos;
+        if (len >= BATCH_LINE_LEN) {
+            c->line_no++;
+            if (queue_reply(c, c->line_no, "error=\"line too long\"") != 0) return -1;
+            if (nl) pos += len + 1;
+            else { c->skipping = 1; pos = c->in_len; }
+            continue;
+        }
+        if (!nl && !c->eof) break;      // wait for the rest of the line
+        start[len] = '\0';              // the '\n' (or one past the data: in[] has room)
+        if (handle_line(s, c, start) != 0) return -1;
+        pos += len + (nl != NULL);
+    }
+    memmove(c->in, c->in + pos, c->in_len - pos);
+    c->in_len -= pos;
+    return 0;
+}
+
+// After any event: parse, send, and close once a finished client has nothing left
+static void client_service(Server *s, Client *c) {
+    if (process_input(s, c) != 0 || client_flush(c) != 0) { client_close(s, c); return; }
+    if (c->eof && c->jobs == 0 && c->in_len == 0 && !out_pending(c)) { client_close(s, c); return; }
+    client_update(s, c);
+}
+
+static void client_read(Server *s, Client *c) {
+    // Keep one byte spare so a final unterminated line can be NUL-terminated in place
+    ssize_t n = read(c->fd, c->in + c->in_len, SERVER_IN_BUF - 1 - c->in_len);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EINTR) return;
+        client_close(s, c);
+        return;
+    }
+    if (n == 0) c->eof = 1;
+    c->in_len += (size_t)n;
+    client_service(s, c);
+}
+
+static void accept_clients(Server *s) {
+    for (;;) {
+        int fd = accept(s->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EMFILE || errno == ENFILE) {
+                // Stop polling the listener (level-triggered, it would spin) until one closes
+                fprintf(stderr, "[Server] Out of file descriptors; new connections wait.\n");
+                struct epoll_event ev = { .events = 0, .data.ptr = &TAG_LISTEN };
+                epoll_ctl(s->ep, EPOLL_CTL_MOD, s->listen_fd, &ev);
+                s->listen_paused = 1;
+            }
+            return;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        Client *c = calloc(1, sizeof(Client));
+        if (!c) { close(fd); continue; }
+        c->fd = fd;
+        c->session = (Session)SESSION_INIT;
+        c->events = EPOLLIN;
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        if (epoll_ctl(s->ep, EPOLL_CTL_ADD, fd, &ev) != 0) { close(fd); client_free(c); continue; }
+        c->next = s->clients;
+        if (s->clients) s->clients->prev = c;
+        s->clients = c;
+        s->n_clients++;
+    }
+}
+
+static void jobs_done(Server *s) {
+    Job *j = pool_take_done(&s->pool);
+    while (j) {
+        Job *next = j->next;
+        Client *c = j->c;
+        c->jobs--;
+        if (c->fd >= 0) {                       // else disconnected while the job ran
+            if (j->rc != BATCH_SKIP) {
+                s->requests++;
+                if (j->rc == BATCH_OK) record_reply(c, j->line_no, j->line, j->reply);
+            }
+            if (j->rc != BATCH_SKIP && queue_reply(c, j->line_no, j->reply) != 0) client_close(s, c);
+            else client_service(s, c);
+        }
+        free(j);
+        j = next;
+    }
+}
+
+// ============================================
+// Setup and main loop
+// ============================================
+
+static int listen_on(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: socket path '%s' is too long.\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // A socket file left behind by a killed server is replaced; anything else is not
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "Error: '%s' exists and is not a socket.\n", path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { perror("socket"); return -1; }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error: cannot listen on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    // Owner only, whatever the umask: connect() is refused until listen(), so nobody gets in first
+    if (chmod(path, 0600) != 0 || listen(fd, SERVER_BACKLOG) != 0) {
+        fprintf(stderr, "Error: cannot listen on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    return fd;
+}
+
+int server_run(const char *sock_path, int n_workers) {
+    if (n_workers < 1) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        n_workers = n > 0 ? (int)n : 1;
+    }
+
+    // SIGINT/SIGTERM arrive through signalfd; blocked before the workers start so they inherit it
+    sigset_t mask, old_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+
+    Server s = { 0 };
+    s.listen_fd = listen_on(sock_path);
+    s.ep = epoll_create1(EPOLL_CLOEXEC);
+    s.sig_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    s.pool.done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    pthread_t *threads = calloc((size_t)n_workers, sizeof(pthread_t));
+    if (s.listen_fd < 0 || s.ep < 0 || s.sig_fd < 0 || s.pool.done_fd < 0 || !threads) {
+        if (s.listen_fd >= 0) { close(s.listen_fd); unlink(sock_path); }
+        if (s.ep >= 0) close(s.ep);
+        if (s.sig_fd >= 0) close(s.sig_fd);
+        if (s.pool.done_fd >= 0) close(s.pool.done_fd);
+        free(threads);
+        pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+        return -1;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &TAG_LISTEN };
+    epoll_ctl(s.ep, EPOLL_CTL_ADD, s.listen_fd, &ev);
+    ev.data.ptr = &TAG_DONE;
+    epoll_ctl(s.ep, EPOLL_CTL_ADD, s.pool.done_fd, &ev);
+    ev.data.ptr = &TAG_SIGNAL;
+    epoll_ctl(s.ep, EPOLL_CTL_ADD, s.sig_fd, &ev);
+
+    pthread_mutex_init(&s.pool.lock, NULL);
+    pthread_cond_init(&s.pool.ready, NULL);
+    int started = 0;
+    while (started < n_workers && pthread_create(&threads[started], NULL, worker, &s.pool) == 0) started++;
+
+    fprintf(stderr, "[Server] Listening on '%s' with %d worker thread(s). Ctrl+C stops.\n",
+            sock_path, started);
+
+    struct epoll_event events[MAX_EVENTS];
+    int running = started > 0;
+    while (running) {
+        int n = epoll_wait(s.ep, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void *tag = events[i].data.ptr;
+            if (tag == &TAG_LISTEN) { accept_clients(&s); continue; }
+            if (tag == &TAG_DONE) { jobs_done(&s); continue; }
+            if (tag == &TAG_SIGNAL) {
+                // Consumed here, or it would be delivered once the mask is restored
+                struct signalfd_siginfo si;
+                while (read(s.sig_fd, &si, sizeof(si)) == sizeof(si)) {}
+                running = 0;
+                break;
+            }
+            Client *c = tag;
+            if (c->fd < 0) continue;            // closed earlier in this round
+            if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) {
+                client_close(&s, c);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) client_read(&s, c);
+            else if (events[i].events & EPOLLOUT) client_service(&s, c);
+        }
+        reap_clients(&s);
+    }
+
+    // Shutdown: running jobs finish, queued ones are dropped
+    pthread_mutex_lock(&s.pool.lock);
+    s.pool.stop = 1;
+    pthread_cond_broadcast(&s.pool.ready);
+    pthread_mutex_unlock(&s.pool.lock);
+    for (int k = 0; k < started; k++) pthread_join(threads[k], NULL);
+
+    for (Job *j = s.pool.head, *next; j; j = next) { next = j->next; j->c->jobs--; free(j); }
+    for (Job *j = s.pool.done, *next; j; j = next) { next = j->next; j->c->jobs--; free(j); }
+    s.pool.head = s.pool.tail = s.pool.done = NULL;
+    while (s.clients) client_close(&s, s.clients);
+    reap_clients(&s);       // no job is left, so every client goes
+
+    fprintf(stderr, "[Server] Stopped: %lld requests from %lld client(s).\n", s.requests, s.n_clients);
+    close(s.listen_fd);
+    unlink(sock_path);
+    close(s.ep);
+    close(s.sig_fd);
+    close(s.pool.done_fd);
+    pthread_mutex_destroy(&s.pool.lock);
+    pthread_cond_destroy(&s.pool.ready);
+    free(threads);
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    return 0;
+}
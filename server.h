@@ -0,0 +1,32 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+// ============================================
+// Calculation server: Unix domain socket, one epoll event loop, a worker pool
+// ============================================
+// Local programs send batch-mode commands over a stream socket instead of starting main.out
+// for each one. One line each way:
+//   request   "<tool> k=v ...\n"             the batch syntax (batch.c), < BATCH_LINE_LEN bytes
+//   response  "line=<n> tool=<tool> ...\n"   what --batch prints for the same line
+// n counts the lines received on the connection from 1, so a client can pipeline any number
+// of requests and match the responses up by n. Blank and '#' lines get no response; an
+// over-long line gets error="line too long".
+//
+// Cheap tools run on the event loop in arrival order. Heavy ones (batch_heavy(): simulations,
+// sweeps, searches, file jobs) go to the worker pool and are answered when they finish, so
+// later cheap requests can overtake them. Every connection has its own Session (workbench and
+// in-memory history, see the wb and export commands), touched only by the event loop thread.
+
+#define SERVER_BACKLOG 128
+#define SERVER_IN_BUF (16 * 1024)       // unparsed request bytes kept per client
+#define SERVER_OUT_HIGH (256 * 1024)    // queued response bytes at which a client's reads pause
+#define SERVER_MAX_JOBS 64              // heavy jobs in flight per client before its reads pause
+
+/**
+ * @brief Serves on sock_path until SIGINT or SIGTERM, then removes the socket file.
+ * @param n_workers Worker threads for heavy jobs (< 1: one per CPU).
+ * @return 0 after a clean shutdown, -1 if the socket could not be set up (reason on stderr).
+ */
+int server_run(const char *sock_path, int n_workers);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+// ============================================
+// Session context: everything one user's run of the tools reads or changes
+// ============================================
+// The workbench values carry results from one tool into the next one's defaults (a resistor
+// picked in the LED tool is the default R of the divider tool, and so on). Every menu_item_N()
+// and batch command gets the session it works on; nothing is kept in globals, so independent
+// sessions can run on different threads at the same time without locking.
+
+#include "history.h"
+#include "eseries.h"
+#include "chart.h"
+
+typedef struct {
+    double voltage;     // V
+    double resistor;    // Ohm
+    double capacitor;   // F
+    double current;     // A
+    double vf;          // diode drop, V
+    double inductor;    // H
+    ESeries series;     // series resistors are snapped to
+    int chart_rows;     // strip chart height (time buckets)
+    int chart_width;    // strip chart bar width
+} Workbench;
+
+typedef struct {
+    Workbench wb;
+    History history;
+} Session;
+
+// Defaults: 10.0V, 4.7k, 1uF, 1mA, 0.7V, 10mH, E24
+#define WORKBENCH_INIT { 10.0, 4700.0, 1e-6, 0.001, 0.7, 10e-3, ESERIES_E24, \
+                         CHART_DEFAULT_ROWS, CHART_DEFAULT_WIDTH }
+#define SESSION_INIT { WORKBENCH_INIT, HISTORY_INIT }
+
+// Records and strings live in the history arena, so this is one release
+static inline void session_free(Session *s) {
+    history_free(&s->history);
+}
+
+#endif
@@ -0,0 +1,401 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sparse.h"
+
+// ============================================
+// Building matrices
+// ============================================
+
+void sp_triplets_init(SpTriplets *t, int n) {
+    t->n = n;
+    t->count = t->cap = 0;
+    t->row = t->col = NULL;
+}
+
+// Records the position of one entry. Returns its triplet index, or -1 on allocation failure.
+int sp_triplets_add(SpTriplets *t, int row, int col) {
+    if (t->count == t->cap) {
+        int cap = t->cap ? 2 * t->cap : 256;
+        int *r = realloc(t->row, (size_t)cap * sizeof(int));
+        if (!r) return -1;
+        t->row = r;
+        int *c = realloc(t->col, (size_t)cap * sizeof(int));
+        if (!c) return -1;
+        t->col = c;
+        t->cap = cap;
+    }
+    t->row[t->count] = row;
+    t->col[t->count] = col;
+    return t->count++;
+}
+
+void sp_triplets_free(SpTriplets *t) {
+    free(t->row); free(t->col);
+    sp_triplets_init(t, 0);
+}
+
+/**
+ * @brief Builds the CSC pattern of the triplets, duplicates merged and rows sorted per column.
+ *        Values start at zero.
+ * @param slot Receives, for every triplet, its index in a->val, so the caller can restamp new
+ *             values later without touching the structure.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int sp_compress(const SpTriplets *t, SpMatrix *a, int *slot) {
+    int n = t->n, m = t->count;
+    int *by_row = malloc((size_t)m * sizeof(int)), *order = malloc((size_t)m * sizeof(int));
+    int *cnt = calloc((size_t)n + 1, sizeof(int));
+    memset(a, 0, sizeof(*a));
+    a->colp = calloc((size_t)n + 1, sizeof(int));
+    if (!by_row || !order || !cnt || !a->colp) goto fail;
+
+    // Two stable counting sorts (by row, then by column) leave rows ascending in each column
+    for (int k = 0; k < m; k++) cnt[t->row[k] + 1]++;
+    for (int i = 0; i < n; i++) cnt[i + 1] += cnt[i];
+    for (int k = 0; k < m; k++) by_row[cnt[t->row[k]]++] = k;
+    memset(cnt, 0, ((size_t)n + 1) * sizeof(int));
+    for (int k = 0; k < m; k++) cnt[t->col[k] + 1]++;
+    for (int j = 0; j < n; j++) cnt[j + 1] += cnt[j];
+    for (int k = 0; k < m; k++) { int e = by_row[k]; order[cnt[t->col[e]]++] = e; }
+
+    a->rowi = malloc((size_t)(m ? m : 1) * sizeof(int));
+    if (!a->rowi) goto fail;
+    int nnz = 0, prev_col = -1, prev_row = -1;
+    for (int k = 0; k < m; k++) {
+        int e = order[k], r = t->row[e], c = t->col[e];
+        if (c != prev_col || r != prev_row) {
+            a->rowi[nnz++] = r;
+            a->colp[c + 1]++;
+            prev_col = c; prev_row = r;
+        }
+        slot[e] = nnz - 1;
+    }
+    for (int j = 0; j < n; j++) a->colp[j + 1] += a->colp[j];
+    a->n = n;
+    a->nnz = nnz;
+    a->val = calloc((size_t)(nnz ? nnz : 1), sizeof(double));
+    if (!a->val) goto fail;
+    free(by_row); free(order); free(cnt);
+    return 0;
+
+fail:
+    free(by_row); free(order); free(cnt);
+    sp_free(a);
+    return -1;
+}
+
+void sp_free(SpMatrix *a) {
+    free(a->colp); free(a->rowi); free(a->val);
+    memset(a, 0, sizeof(*a));
+}
+
+// ============================================
+// Fill-reducing order
+// ============================================
+// Minimum degree on the graph of A + A^T: repeatedly eliminate the vertex with the fewest
+// neighbours and join those neighbours into a clique (the fill the elimination would create).
+// Vertices sit in doubly linked degree buckets, so picking the minimum is O(1) amortised.
+
+typedef struct {
+    int *adj, deg, cap;
+} MdNode;
+
+static int md_add(MdNode *v, int u) {
+    if (v->deg == v->cap) {
+        int cap = v->cap ? 2 * v->cap : 4;
+        int *p = realloc(v->adj, (size_t)cap * sizeof(int));
+        if (!p) return -1;
+        v->adj = p;
+        v->cap = cap;
+    }
+    v->adj[v->deg++] = u;
+    return 0;
+}
+
+static int min_degree_order(const SpMatrix *a, int *q) {
+    int n = a->n, rc = -1;
+    MdNode *g = calloc((size_t)n, sizeof(MdNode));
+    int *head = malloc((size_t)n * sizeof(int)), *next = malloc((size_t)n * sizeof(int));
+    int *prev = malloc((size_t)n * sizeof(int)), *mark = calloc((size_t)n, sizeof(int));
+    if (!g || !head || !next || !prev || !mark) goto out;
+
+    // Symmetric pattern without the diagonal; mark[] stamps drop duplicates
+    int stamp = 0;
+    for (int j = 0; j < n; j++) {
+        for (int p = a->colp[j]; p < a->colp[j + 1]; p++) {
+            int i = a->rowi[p];
+            if (i == j) continue;
+            if (md_add(&g[i], j) || md_add(&g[j], i)) goto out;
+        }
+    }
+    for (int v = 0; v < n; v++) {
+        stamp++;
+        int d = 0;
+        for (int k = 0; k < g[v].deg; k++) {
+            int u = g[v].adj[k];
+            if (mark[u] != stamp) { mark[u] = stamp; g[v].adj[d++] = u; }
+        }
+        g[v].deg = d;
+    }
+
+    for (int d = 0; d < n; d++) head[d] = -1;
+    #define MD_INSERT(v) do { int d_ = g[v].deg; next[v] = head[d_]; prev[v] = -1; \
+                              if (head[d_] >= 0) { prev[head[d_]] = v; } head[d_] = v; } while (0)
+    #define MD_REMOVE(v) do { if (prev[v] >= 0) next[prev[v]] = next[v]; else head[g[v].deg] = next[v]; \
+                              if (next[v] >= 0) prev[next[v]] = prev[v]; } while (0)
+    for (int v = 0; v < n; v++) MD_INSERT(v);
+
+    int mindeg = 0;
+    for (int k = 0; k < n; k++) {
+        while (head[mindeg] < 0) mindeg++;
+        int v = head[mindeg];
+        MD_REMOVE(v);
+        q[k] = v;
+
+        for (int a_ = 0; a_ < g[v].deg; a_++) {
+            int u = g[v].adj[a_];
+            MD_REMOVE(u);
+            // adj(u) = adj(u) + adj(v) - {u, v}
+            stamp++;
+            int d = 0;
+            for (int b = 0; b < g[u].deg; b++) {
+                int w = g[u].adj[b];
+                if (w != v) { mark[w] = stamp; g[u].adj[d++] = w; }
+            }
+            g[u].deg = d;
+            mark[u] = stamp;
+            for (int b = 0; b < g[v].deg; b++) {
+                int w = g[v].adj[b];
+                if (mark[w] != stamp && md_add(&g[u], w)) goto out;
+            }
+            MD_INSERT(u);
+            if (g[u].deg < mindeg) mindeg = g[u].deg;
+        }
+        free(g[v].adj);
+        g[v].adj = NULL;
+        g[v].deg = 0;
+    }
+    #undef MD_INSERT
+    #undef MD_REMOVE
+    rc = 0;
+
+out:
+    if (g) for (int v = 0; v < n; v++) free(g[v].adj);
+    free(g); free(head); free(next); free(prev); free(mark);
+    return rc;
+}
+
+// ============================================
+// LU factorisation (left-looking, Gilbert-Peierls)
+// ============================================
+// Column k of L and U is the solution x = L \ A(:, q[k]) of a sparse triangular system whose
+// nonzero pattern is the set of rows reachable from A(:, q[k]) in the graph of L, found by a
+// depth-first search that also yields a valid (topological) elimination order.
+
+/**
+ * @brief Symbolic phase: the fill-reducing column order. Depends only on the pattern of a.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int splu_analyze(const SpMatrix *a, SpLu *lu) {
+    int n = a->n;
+    memset(lu, 0, sizeof(*lu));
+    lu->n = n;
+    lu->q = malloc((size_t)n * sizeof(int));
+    lu->pinv = malloc((size_t)n * sizeof(int));
+    lu->lp = malloc(((size_t)n + 1) * sizeof(int));
+    lu->up = malloc(((size_t)n + 1) * sizeof(int));
+    lu->work = calloc((size_t)n, sizeof(double));
+    lu->iwork = malloc(3 * (size_t)n * sizeof(int));
+    lu->lcap = lu->ucap = 4 * a->nnz + n;
+    lu->li = malloc((size_t)lu->lcap * sizeof(int));
+    lu->lx = malloc((size_t)lu->lcap * sizeof(double));
+    lu->ui = malloc((size_t)lu->ucap * sizeof(int));
+    lu->ux = malloc((size_t)lu->ucap * sizeof(double));
+    if (!lu->q || !lu->pinv || !lu->lp || !lu->up || !lu->work || !lu->iwork ||
+        !lu->li || !lu->lx || !lu->ui || !lu->ux || min_degree_order(a, lu->q) != 0) {
+        splu_free(lu);
+        return -1;
+    }
+    return 0;
+}
+
+// Grows L or U storage so at least `need` more entries fit
+static int lu_reserve(int **idx, double **val, int *cap, int used, int need) {
+    if (used + need <= *cap) return 0;
+    int cap_new = 2 * *cap + need;
+    int *i = realloc(*idx, (size_t)cap_new * sizeof(int));
+    if (!i) return -1;
+    *idx = i;
+    double *v = realloc(*val, (size_t)cap_new * sizeof(double));
+    if (!v) return -1;
+    *val = v;
+    *cap = cap_new;
+    return 0;
+}
+
+// Rows reachable from column `col` of A through the columns of L built so far, written to
+// xi[top .. n-1] in topological order. xi needs 2n ints (stack below, result above), mark n.
+static int lu_reach(const SpLu *lu, const SpMatrix *a, int col, int *xi, int *mark, int stamp) {
+    int n = lu->n, top = n;
+    int *pstack = xi + n;
+    for (int p = a->colp[col]; p < a->colp[col + 1]; p++) {
+        int start = a->rowi[p];
+        if (mark[start] == stamp) continue;
+        int head = 0;
+        xi[0] = start;
+        while (head >= 0) {
+            int j = xi[head], jcol = lu->pinv[j];
+            if (mark[j] != stamp) {
+                mark[j] = stamp;
+                pstack[head] = (jcol < 0) ? 0 : lu->lp[jcol];
+            }
+            int done = 1, end = (jcol < 0) ? 0 : lu->lp[jcol + 1];
+            for (int q = pstack[head]; q < end; q++) {
+                int i = lu->li[q];
+                if (mark[i] == stamp) continue;
+                pstack[head] = q;
+                xi[++head] = i;
+                done = 0;
+                break;
+            }
+            if (done) { head--; xi[--top] = j; }
+        }
+    }
+    return top;
+}
+
+/**
+ * @brief Numeric factorisation P A Q = L U with threshold partial pivoting (diagonal preferred).
+ *        Fixes the patterns of L and U and the pivot rows that splu_refactor() reuses.
+ * @return 0 on success, -1 if the matrix is structurally or numerically singular (or no memory).
+ */
+int splu_factor(const SpMatrix *a, SpLu *lu) {
+    int n = lu->n;
+    double *x = lu->work;
+    int *xi = lu->iwork, *mark = lu->iwork + 2 * n;
+    for (int i = 0; i < n; i++) { lu->pinv[i] = -1; mark[i] = -1; }
+    lu->lnz = lu->unz = 0;
+    lu->factored = 0;
+
+    for (int k = 0; k < n; k++) {
+        if (lu_reserve(&lu->li, &lu->lx, &lu->lcap, lu->lnz, n - k) ||
+            lu_reserve(&lu->ui, &lu->ux, &lu->ucap, lu->unz, k + 1)) return -1;
+        lu->lp[k] = lu->lnz;
+        lu->up[k] = lu->unz;
+        int col = lu->q[k];
+
+        // x = L \ A(:, col) over the reach only (rows of L are still original row numbers)
+        int top = lu_reach(lu, a, col, xi, mark, k);
+        for (int p = top; p < n; p++) x[xi[p]] = 0;
+        for (int p = a->colp[col]; p < a->colp[col + 1]; p++) x[a->rowi[p]] = a->val[p];
+        for (int p = top; p < n; p++) {
+            int j = xi[p], jcol = lu->pinv[j];
+            if (jcol < 0) continue;
+            double xj = x[j];
+            for (int q = lu->lp[jcol] + 1; q < lu->lp[jcol + 1]; q++) x[lu->li[q]] -= lu->lx[q] * xj;
+        }
+
+        // Rows already pivotal go to U (in reach order); the largest of the rest is the pivot
+        int ipiv = -1;
+        double big = -1;
+        for (int p = top; p < n; p++) {
+            int i = xi[p];
+            if (lu->pinv[i] < 0) {
+                if (fabs(x[i]) > big) { big = fabs(x[i]); ipiv = i; }
+            } else {
+                lu->ui[lu->unz] = lu->pinv[i];
+                lu->ux[lu->unz++] = x[i];
+            }
+        }
+        if (ipiv < 0 || big <= 0) return -1;
+        if (lu->pinv[col] < 0 && mark[col] == k && fabs(x[col]) >= big * SPLU_PIVOT_TOL) ipiv = col;
+
+        double pivot = x[ipiv];
+        lu->ui[lu->unz] = k;
+        lu->ux[lu->unz++] = pivot;
+        lu->pinv[ipiv] = k;
+        lu->li[lu->lnz] = ipiv;
+        lu->lx[lu->lnz++] = 1;
+        for (int p = top; p < n; p++) {
+            int i = xi[p];
+            if (lu->pinv[i] < 0) {
+                lu->li[lu->lnz] = i;
+                lu->lx[lu->lnz++] = x[i] / pivot;
+            }
+            x[i] = 0;
+        }
+    }
+    lu->lp[n] = lu->lnz;
+    lu->up[n] = lu->unz;
+    for (int p = 0; p < lu->lnz; p++) lu->li[p] = lu->pinv[lu->li[p]];
+    lu->factored = 1;
+    return 0;
+}
+
+/**
+ * @brief Refactors a matrix with the same pattern as the last splu_factor() call, reusing its
+ *        column order, pivot rows and L/U structure: no graph search, no pivot choice.
+ * @return 0 on success, -1 if a reused pivot became too small (call splu_factor() instead).
+ */
+int splu_refactor(const SpMatrix *a, SpLu *lu) {
+    if (!lu->factored) return -1;
+    int n = lu->n;
+    double *x = lu->work;   // indexed by pivot step
+
+    for (int k = 0; k < n; k++) {
+        int col = lu->q[k];
+        double colmax = 0;
+        for (int p = a->colp[col]; p < a->colp[col + 1]; p++) {
+            x[lu->pinv[a->rowi[p]]] = a->val[p];
+            if (fabs(a->val[p]) > colmax) colmax = fabs(a->val[p]);
+        }
+        int u_end = lu->up[k + 1] - 1;   // last entry is the diagonal
+        for (int p = lu->up[k]; p < u_end; p++) {
+            int j = lu->ui[p];
+            double xj = x[j];
+            lu->ux[p] = xj;
+            x[j] = 0;
+            for (int q = lu->lp[j] + 1; q < lu->lp[j + 1]; q++) x[lu->li[q]] -= lu->lx[q] * xj;
+        }
+        double pivot = x[k];
+        x[k] = 0;
+        if (!(fabs(pivot) > SPLU_REFACTOR_TOL * colmax)) {
+            lu->factored = 0;
+            return -1;
+        }
+        lu->ux[u_end] = pivot;
+        for (int q = lu->lp[k] + 1; q < lu->lp[k + 1]; q++) {
+            lu->lx[q] = x[lu->li[q]] / pivot;
+            x[lu->li[q]] = 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Solves A x = b in place using the last factorisation.
+ */
+void splu_solve(const SpLu *lu, double *b) {
+    int n = lu->n;
+    double *y = lu->work;
+    for (int i = 0; i < n; i++) y[lu->pinv[i]] = b[i];
+    for (int j = 0; j < n; j++) {
+        double yj = y[j];
+        if (yj == 0) continue;
+        for (int p = lu->lp[j] + 1; p < lu->lp[j + 1]; p++) y[lu->li[p]] -= lu->lx[p] * yj;
+    }
+    for (int j = n - 1; j >= 0; j--) {
+        int diag = lu->up[j + 1] - 1;
+        double yj = (y[j] /= lu->ux[diag]);
+        if (yj == 0) continue;
+        for (int p = lu->up[j]; p < diag; p++) y[lu->ui[p]] -= lu->ux[p] * yj;
+    }
+    for (int k = 0; k < n; k++) { b[lu->q[k]] = y[k]; y[k] = 0; }
+}
+
+void splu_free(SpLu *lu) {
+    free(lu->q); free(lu->pinv); free(lu->lp); free(lu->li); free(lu->lx);
+    free(lu->up); free(lu->ui); free(lu->ux); free(lu->work); free(lu->iwork);
+    memset(lu, 0, sizeof(*lu));
+}
@@ -0,0 +1,53 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+// ============================================
+// Sparse matrices (compressed sparse column) and a sparse LU for the netlist solver.
+// Split in the usual three phases so repeated solves only pay for what changed:
+//   splu_analyze   fill-reducing column order (minimum degree on A + A^T), pattern only
+//   splu_factor    numeric LU with threshold partial pivoting; fixes the L/U patterns
+//   splu_refactor  new values with the same pattern and pivots (sweeps, transient steps)
+// ============================================
+
+#define SPLU_PIVOT_TOL 0.001    // prefer the diagonal unless 1000x smaller than the column max
+#define SPLU_REFACTOR_TOL 1e-8  // refactor gives up if a reused pivot shrinks below this (relative)
+
+typedef struct {
+    int n, nnz;
+    int *colp;      // n + 1 column starts
+    int *rowi;      // nnz row indices (sorted within each column)
+    double *val;    // nnz values
+} SpMatrix;
+
+// Coordinate-form builder: entries may repeat (they are summed) and come in any order
+typedef struct {
+    int n, count, cap;
+    int *row, *col;
+} SpTriplets;
+
+typedef struct {
+    int n;
+    int *q;                 // column order: step k eliminates column q[k]
+    int *pinv;              // pinv[row] = pivot step of that row (-1 before factoring)
+    int *lp, *li, lnz, lcap;
+    double *lx;             // unit lower triangle, diagonal stored first in each column
+    int *up, *ui, unz, ucap;
+    double *ux;             // upper triangle, diagonal stored last, rows in elimination order
+    double *work;           // n doubles
+    int *iwork;             // 3n ints
+    int factored;
+} SpLu;
+
+void sp_triplets_init(SpTriplets *t, int n);
+int sp_triplets_add(SpTriplets *t, int row, int col);
+void sp_triplets_free(SpTriplets *t);
+int sp_compress(const SpTriplets *t, SpMatrix *a, int *slot);
+void sp_free(SpMatrix *a);
+
+int splu_analyze(const SpMatrix *a, SpLu *lu);
+int splu_factor(const SpMatrix *a, SpLu *lu);
+int splu_refactor(const SpMatrix *a, SpLu *lu);
+void splu_solve(const SpLu *lu, double *b);
+void splu_free(SpLu *lu);
+
+#endif
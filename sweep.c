@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "sweep.h"
+#include "circuits.h"
+
+// Points a worker takes from its own queue at a time
+#define SWEEP_CHUNK 16
+
+// ============================================
+// Axis parsing
+// ============================================
+// Accepted forms (values take engineering suffixes):
+//     4.7k                single value
+//     1k,2.2k,4.7k        explicit list
+//     10:1k:20            20 linearly spaced values
+//     10:1k:20log         20 log spaced values
+//     e24:100:10k         every E24 value in the range (e6 .. e192)
+
+static int axis_push(SweepAxis *ax, double v) {
+    if (ax->n >= SWEEP_MAX_AXIS) return -1;
+    ax->vals[ax->n++] = v;
+    return 0;
+}
+
+static int parse_field(const char *s, int len, double *out) {
+    if (len <= 0) return -1;
+    return eng_parse(s, (size_t)len, out) == ENG_OK ? 0 : -1;
+}
+
+/**
+ * @brief Parses an axis description into a freshly allocated value list.
+ * @return 0 on success, -1 on a malformed description (ax left empty).
+ */
+int sweep_parse_axis(const char *s, SweepAxis *ax) {
+    ax->n = 0;
+    ax->vals = malloc(SWEEP_MAX_AXIS * sizeof(double));
+    if (!ax->vals) return -1;
+
+    const char *first_colon = strchr(s, ':');
+    char series_name[8] = "";
+    if ((s[0] == 'e' || s[0] == 'E') && first_colon && first_colon - s < (long)sizeof(series_name)) {
+        memcpy(series_name, s, first_colon - s);
+        series_name[first_colon - s] = '\0';
+    }
+    int series = series_name[0] ? eseries_from_name(series_name) : -1;
+
+    if (series >= 0) {
+        const char *p = first_colon + 1, *colon = strchr(p, ':');
+        const double *base;
+        int n_base = eseries_values(series, &base);
+        double lo, hi;
+        if (!colon || parse_field(p, colon - p, &lo) || parse_field(colon + 1, strlen(colon + 1), &hi) ||
+            lo <= 0 || hi < lo) goto fail;
+        for (int d = (int)floor(log10(lo)); d <= (int)ceil(log10(hi)); d++) {
+            for (int i = 0; i < n_base; i++) {
+                double v = base[i] * pow(10, d);
+                if (v >= lo * (1 - 1e-9) && v <= hi * (1 + 1e-9) && axis_push(ax, v)) goto fail;
+            }
+        }
+    } else if (strchr(s, ':')) {
+        const char *c1 = strchr(s, ':'), *c2 = strchr(c1 + 1, ':');
+        double a, b;
+        char *end;
+        if (!c2 || parse_field(s, c1 - s, &a) || parse_field(c1 + 1, c2 - c1 - 1, &b)) goto fail;
+        long n = strtol(c2 + 1, &end, 10);
+        int log_spaced = (strcmp(end, "log") == 0);
+        if ((*end && !log_spaced) || n < 1 || n > SWEEP_MAX_AXIS) goto fail;
+        if (log_spaced && (a <= 0 || b <= 0)) goto fail;
+        for (long i = 0; i < n; i++) {
+            double f = (n == 1) ? 0 : (double)i / (n - 1);
+            axis_push(ax, log_spaced ? a * pow(b / a, f) : a + (b - a) * f);
+        }
+    } else {
+        const char *p = s;
+        for (;;) {
+            const char *comma = strchr(p, ',');
+            int len = comma ? (int)(comma - p) : (int)strlen(p);
+            double v;
+            if (parse_field(p, len, &v) || axis_push(ax, v)) goto fail;
+            if (!comma) break;
+            p = comma + 1;
+        }
+    }
+    if (ax->n > 0) return 0;
+
+fail:
+    sweep_free_axis(ax);
+    return -1;
+}
+
+void sweep_free_axis(SweepAxis *ax) {
+    free(ax->vals);
+    ax->vals = NULL; ax->n = 0;
+}
+
+// ============================================
+// Grid
+// ============================================
+
+// Components a topology does not have collapse to a single dummy value
+static const double AXIS_UNUSED_VAL = 0.0;
+static const SweepAxis AXIS_UNUSED = { (double *)&AXIS_UNUSED_VAL, 1 };
+
+static void effective_axes(const SweepSpec *spec, const SweepAxis *ax[4]) {
+    ax[0] = &spec->vs;
+    ax[1] = (spec->type == RLC_TYPE_LC) ? &AXIS_UNUSED : &spec->r;
+    ax[2] = (spec->type == RLC_TYPE_RC) ? &AXIS_UNUSED : &spec->l;
+    ax[3] = (spec->type == RLC_TYPE_RL) ? &AXIS_UNUSED : &spec->c;
+}
+
+long sweep_point_count(const SweepSpec *spec) {
+    const SweepAxis *ax[4];
+    effective_axes(spec, ax);
+    long n = 1;
+    for (int i = 0; i < 4; i++) {
+        n *= ax[i]->n;
+        if (n > SWEEP_MAX_POINTS) return -1;
+    }
+    return n;
+}
+
+// Decodes grid index -> circuit (C varies fastest) and simulates it
+static void sweep_point(const SweepSpec *spec, const SweepAxis *ax[4], long idx, SweepPoint *pt) {
+    RlcCircuit ckt;
+    ckt.type = spec->type;
+    ckt.c  = ax[3]->vals[idx % ax[3]->n]; idx /= ax[3]->n;
+    ckt.l  = ax[2]->vals[idx % ax[2]->n]; idx /= ax[2]->n;
+    ckt.r  = ax[1]->vals[idx % ax[1]->n]; idx /= ax[1]->n;
+    ckt.vs = ax[0]->vals[idx];
+    rlc_apply_safety(&ckt);
+
+    double t_total = spec->t_total > 0 ? spec->t_total : rlc_auto_time(&ckt);
+    if (spec->method == SWEEP_EXACT) {
+        rlc_simulate_analytic(&ckt, t_total, SIM_STEPS, NULL, &pt->stats);
+    } else if (spec->method == SWEEP_RK45) {
+        rlc_simulate_rk45(&ckt, t_total, SIM_STEPS, RK45_DEFAULT_RTOL, RK45_DEFAULT_ATOL,
+                          NULL, &pt->stats, NULL);
+    } else {
+        rlc_simulate_euler(&ckt, t_total, SIM_STEPS, NULL, &pt->stats);
+    }
+    pt->vs = ckt.vs; pt->r = ckt.r; pt->l = ckt.l; pt->c = ckt.c;
+    pt->t_total = t_total;
+}
+
+// ============================================
+// Work-stealing pool
+// ============================================
+// Each worker owns a range [lo, hi) of grid indices. It takes SWEEP_CHUNK
+// points at a time from the front; when its range runs dry it steals the
+// back half of another worker's range. Points vary a lot in cost (RK45,
+// stiff corners of the grid) so static partitioning alone leaves cores idle.
+
+typedef struct {
+    pthread_mutex_t lock;
+    long lo, hi;
+} SweepQueue;
+
+typedef struct {
+    const SweepSpec *spec;
+    const SweepAxis *ax[4];
+    SweepPoint *out;
+    SweepQueue *queues;
+    int n_workers;
+} SweepJob;
+
+typedef struct {
+    SweepJob *job;
+    int id;
+} SweepWorker;
+
+static int take_local(SweepQueue *q, long *lo, long *hi) {
+    int got = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->lo < q->hi) {
+        *lo = q->lo;
+        *hi = (q->hi - q->lo > SWEEP_CHUNK) ? q->lo + SWEEP_CHUNK : q->hi;
+        q->lo = *hi;
+        got = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return got;
+}
+
+static int steal(SweepJob *job, int self) {
+    for (int k = 1; k < job->n_workers; k++) {
+        SweepQueue *victim = &job->queues[(self + k) % job->n_workers];
+        long lo = 0, hi = 0;
+        pthread_mutex_lock(&victim->lock);
+        long left = victim->hi - victim->lo;
+        if (left > 0) {
+            hi = victim->hi;
+            lo = hi - (left + 1) / 2;
+            victim->hi = lo;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (hi > lo) {
+            SweepQueue *mine = &job->queues[self];
+            pthread_mutex_lock(&mine->lock);
+            mine->lo = lo; mine->hi = hi;
+            pthread_mutex_unlock(&mine->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *sweep_worker(void *arg) {
+    SweepWorker *w = arg;
+    SweepJob *job = w->job;
+    long lo, hi;
+    for (;;) {
+        while (take_local(&job->queues[w->id], &lo, &hi)) {
+            for (long i = lo; i < hi; i++) sweep_point(job->spec, job->ax, i, &job->out[i]);
+        }
+        if (!steal(job, w->id)) break;
+    }
+    return NULL;
+}
+
+int sweep_default_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/**
+ * @brief Simulates every grid point into out[] (length sweep_point_count()).
+ * @return 0 on success, -1 if the grid is empty/too large or memory ran out.
+ */
+int sweep_run(const SweepSpec *spec, int n_threads, SweepPoint *out) {
+    long total = sweep_point_count(spec);
+    if (total <= 0) return -1;
+    if (n_threads < 1) n_threads = 1;
+    if (n_threads > total) n_threads = (int)total;
+
+    SweepJob job;
+    job.spec = spec;
+    effective_axes(spec, job.ax);
+    job.out = out;
+    job.n_workers = n_threads;
+    job.queues = malloc(n_threads * sizeof(SweepQueue));
+    pthread_t *threads = malloc(n_threads * sizeof(pthread_t));
+    SweepWorker *workers = malloc(n_threads * sizeof(SweepWorker));
+    if (!job.queues || !threads || !workers) {
+        free(job.queues); free(threads); free(workers);
+        return -1;
+    }
+
+    // Even initial split; stealing evens out the rest
+    for (int i = 0; i < n_threads; i++) {
+        pthread_mutex_init(&job.queues[i].lock, NULL);
+        job.queues[i].lo = total * i / n_threads;
+        job.queues[i].hi = total * (i + 1) / n_threads;
+        workers[i].job = &job;
+        workers[i].id = i;
+    }
+
+    // Worker 0 runs on the calling thread
+    int started = 1;
+    for (int i = 1; i < n_threads; i++, started++) {
+        if (pthread_create(&threads[i], NULL, sweep_worker, &workers[i]) != 0) break;
+    }
+    sweep_worker(&workers[0]);
+    for (int i = 1; i < started; i++) pthread_join(threads[i], NULL);
+    // If some threads failed to start, worker 0 will have stolen their ranges
+
+    for (int i = 0; i < n_threads; i++) pthread_mutex_destroy(&job.queues[i].lock);
+    free(job.queues); free(threads); free(workers);
+    return 0;
+}
+
+// ============================================
+// Reporting
+// ============================================
+
+// Capacitor voltage overshoot above the final value Vs, in percent (0 for RL)
+double sweep_overshoot_pct(int type, const SweepPoint *p) {
+    if (type == RLC_TYPE_RL || p->vs == 0) return 0;
+    double os = (p->stats.max_vc - fabs(p->vs)) / fabs(p->vs) * 100.0;
+    return os > 0 ? os : 0;
+}
+
+// Writes one row per grid point. Returns 0 on success, -1 if the file could not be written.
+int sweep_write_csv(const char *path, int type, const SweepPoint *pts, long n) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return -1;
+    setvbuf(fp, NULL, _IOFBF, 1 << 16); // large blocks instead of one write per row
+    fprintf(fp, "vs,r,l,c,t_total,max_vc,max_il,max_ec,max_el,final_energy,overshoot_pct\n");
+    char row[12 * ENG_FMT_LEN];
+    for (long i = 0; i < n; i++) {
+        const SweepPoint *p = &pts[i];
+        const double v[10] = { p->vs, p->r, p->l, p->c, p->t_total,
+                               p->stats.max_vc, p->stats.max_il, p->stats.max_ec, p->stats.max_el,
+                               p->stats.final_energy };
+        size_t len = eng_format_many(v, 10, ENG_FMT_G, 6, ',', row, sizeof(row), NULL);
+        row[len++] = ',';
+        len += eng_format_g(sweep_overshoot_pct(type, p), 4, row + len, ENG_FMT_LEN);
+        row[len++] = '\n';
+        fwrite(row, 1, len, fp);
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
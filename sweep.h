@@ -0,0 +1,42 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "rlc.h"
+
+// ============================================
+// Multithreaded RLC parameter sweep
+// ============================================
+
+#define SWEEP_MAX_AXIS 4096        // values per axis
+#define SWEEP_MAX_POINTS 10000000L // whole grid
+
+// Integration method per point (same choices as the analyser)
+enum { SWEEP_EULER = 1, SWEEP_RK45, SWEEP_EXACT };
+
+typedef struct {
+    double *vals;
+    int n;
+} SweepAxis;
+
+typedef struct {
+    int type;                 // RLC_TYPE_*
+    SweepAxis vs, r, l, c;    // axes unused by the topology are ignored
+    double t_total;           // 0 = auto time per point
+    int method;               // SWEEP_*
+} SweepSpec;
+
+typedef struct {
+    double vs, r, l, c;
+    double t_total;
+    RlcStats stats;
+} SweepPoint;
+
+int sweep_parse_axis(const char *s, SweepAxis *ax);
+void sweep_free_axis(SweepAxis *ax);
+long sweep_point_count(const SweepSpec *spec);
+int sweep_default_threads(void);
+int sweep_run(const SweepSpec *spec, int n_threads, SweepPoint *out);
+double sweep_overshoot_pct(int type, const SweepPoint *p);
+int sweep_write_csv(const char *path, int type, const SweepPoint *pts, long n);
+
+#endif
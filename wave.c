@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "wave.h"
+#include "engfmt.h"
+
+static const char *TYPE_NAMES[] = { "", "rc", "rl", "lc", "rlc" };
+
+// The traced columns in a fixed order; NULL buffers are skipped
+static int wave_columns(const RlcTrace *trace, WaveColumn *cols) {
+    const WaveColumn all[4] = {
+        { "vc", "V", trace->vc }, { "il", "A", trace->il },
+        { "ec", "J", trace->ec }, { "el", "J", trace->el }
+    };
+    int n = 0;
+    for (int i = 0; i < 4; i++) if (all[i].data) cols[n++] = all[i];
+    return n;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w; len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int host_little_endian(void) {
+    const unsigned one = 1;
+    return *(const unsigned char *)&one == 1;
+}
+
+// ============================================
+// Writers
+// ============================================
+
+// One row per sample: t (when dt > 0), then each column. Rows are formatted into a large
+// buffer and flushed in WAVE_CSV_BUF writes.
+static int wave_write_csv(int fd, const WaveColumn *cols, int n_cols, int n, double dt) {
+    char *buf = malloc(WAVE_CSV_BUF);
+    if (!buf) return -1;
+    size_t len = 0;
+    int failed = 0;
+
+    if (dt > 0) len += snprintf(buf, WAVE_CSV_BUF, "t_s,");
+    for (int c = 0; c < n_cols; c++) len += snprintf(buf + len, WAVE_CSV_BUF - len, "%s_%s,", cols[c].name, cols[c].unit);
+    buf[len - 1] = '\n';
+
+    const size_t row_max = (WAVE_MAX_COLS + 1) * ENG_FMT_LEN;  // "%.9g" text plus separator per column
+    for (int i = 0; i < n && !failed; i++) {
+        if (len + row_max > WAVE_CSV_BUF) {
+            failed = write_all(fd, buf, len) != 0;
+            len = 0;
+        }
+        size_t row = len;
+        if (dt > 0) {
+            len += eng_format_g(i * dt, 9, buf + len, ENG_FMT_LEN);
+            buf[len++] = ',';
+        }
+        for (int c = 0; c < n_cols; c++) {
+            len += eng_format_g(cols[c].data[i], 9, buf + len, ENG_FMT_LEN);
+            buf[len++] = ',';
+        }
+        if (len > row) buf[len - 1] = '\n';
+    }
+    if (!failed && len) failed = write_all(fd, buf, len) != 0;
+    free(buf);
+    return failed ? -1 : 0;
+}
+
+// Text header padded to WAVE_HEADER_LEN, then each column as one large write
+static int wave_write_bin(int fd, const WaveColumn *cols, int n_cols, int n, double dt, const char *meta) {
+    char hdr[WAVE_HEADER_LEN];
+    memset(hdr, 0, sizeof(hdr));
+    size_t len = snprintf(hdr, sizeof(hdr), "%s\nsamples=%d\n", WAVE_MAGIC, n);
+    if (dt > 0) len += snprintf(hdr + len, sizeof(hdr) - len, "t0=0\ndt=%.17g\n", dt);
+    len += snprintf(hdr + len, sizeof(hdr) - len, "dtype=%s\nlayout=columns\noffset=%d\ncolumns=",
+                    host_little_endian() ? "<f8" : ">f8", WAVE_HEADER_LEN);
+    for (int c = 0; c < n_cols; c++) len += snprintf(hdr + len, sizeof(hdr) - len, "%s%s", c ? "," : "", cols[c].name);
+    len += snprintf(hdr + len, sizeof(hdr) - len, "\nunits=");
+    for (int c = 0; c < n_cols; c++) len += snprintf(hdr + len, sizeof(hdr) - len, "%s%s", c ? "," : "", cols[c].unit);
+    len += snprintf(hdr + len, sizeof(hdr) - len, "\n%s", meta ? meta : "");
+    if (len >= sizeof(hdr)) return -1;   // must stay NUL-terminated
+
+    if (write_all(fd, hdr, sizeof(hdr)) != 0) return -1;
+    for (int c = 0; c < n_cols; c++) {
+        if (write_all(fd, cols[c].data, (size_t)n * sizeof(double)) != 0) return -1;
+    }
+    return 0;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// ".bin" selects the binary format, anything else CSV
+int wave_format_from_path(const char *path) {
+    size_t n = strlen(path);
+    return (n >= 4 && strcmp(path + n - 4, ".bin") == 0) ? WAVE_FMT_BIN : WAVE_FMT_CSV;
+}
+
+/**
+ * @brief Writes n rows of the given columns as CSV or binary.
+ * @param path Output file, or "-" for stdout.
+ * @param dt Sample spacing of an implicit time axis (t = i * dt), or 0 when there is none.
+ * @param meta Extra "key=value\n" lines for the binary header (may be NULL).
+ * @return Number of rows written, or -1 on error.
+ */
+long wave_write(const char *path, int format, const WaveColumn *cols, int n_cols, int n,
+                double dt, const char *meta) {
+    if (n_cols < 1 || n_cols > WAVE_MAX_COLS || n < 1) return -1;
+    if (format != WAVE_FMT_CSV && format != WAVE_FMT_BIN) return -1;
+
+    int to_stdout = strcmp(path, "-") == 0;
+    int fd = to_stdout ? STDOUT_FILENO : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    if (to_stdout) fflush(stdout);   // keep earlier stdio output in order
+
+    int rc = (format == WAVE_FMT_BIN) ? wave_write_bin(fd, cols, n_cols, n, dt, meta)
+                                      : wave_write_csv(fd, cols, n_cols, n, dt);
+    if (!to_stdout && close(fd) != 0) rc = -1;
+    return rc < 0 ? -1 : n;
+}
+
+/**
+ * @brief Writes every stored sample of a transient run (sample i is at t = i * t_total / steps).
+ * @param method Integrator name recorded in the binary header.
+ * @return Number of samples written, or -1 on error.
+ */
+long wave_export(const char *path, int format, const RlcCircuit *ckt, const char *method,
+                 double t_total, int steps, const RlcTrace *trace) {
+    WaveColumn cols[4];
+    int n_cols = wave_columns(trace, cols);
+    if (n_cols == 0 || steps < 1) return -1;
+
+    char meta[256];
+    snprintf(meta, sizeof(meta), "kind=transient\ntype=%s\nmethod=%s\nvs=%.17g\nr=%.17g\nl=%.17g\nc=%.17g\n",
+             TYPE_NAMES[ckt->type], method, ckt->vs, ckt->r, ckt->l, ckt->c);
+    return wave_write(path, format, cols, n_cols, steps, t_total / steps, meta);
+}
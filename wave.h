@@ -0,0 +1,31 @@
+#ifndef WAVE_H
+#define WAVE_H
+
+// ============================================
+// Full-resolution RLC waveform export (CSV or raw float64 columns)
+// ============================================
+
+#include "rlc.h"
+
+// Binary layout: a NUL-padded text header of WAVE_HEADER_LEN bytes ("key=value" lines),
+// then one contiguous float64 block of `samples` values per column, in header order.
+// numpy: np.memmap(path, dtype=hdr["dtype"], mode="r", offset=WAVE_HEADER_LEN, shape=(n_cols, samples))
+#define WAVE_MAGIC "RLCWAVE 1"
+#define WAVE_HEADER_LEN 4096
+#define WAVE_CSV_BUF (256 * 1024)   // CSV output is flushed in writes of this size
+#define WAVE_MAX_COLS 8
+
+enum { WAVE_FMT_CSV = 1, WAVE_FMT_BIN };
+
+typedef struct {
+    const char *name, *unit;
+    const double *data;
+} WaveColumn;
+
+int wave_format_from_path(const char *path);
+long wave_write(const char *path, int format, const WaveColumn *cols, int n_cols, int n,
+                double dt, const char *meta);
+long wave_export(const char *path, int format, const RlcCircuit *ckt, const char *method,
+                 double t_total, int steps, const RlcTrace *trace);
+
+#endif